@@ -127,6 +127,8 @@ action fix_gravity_kokkos.cpp
 action fix_gravity_kokkos.h
 action fix_langevin_kokkos.cpp
 action fix_langevin_kokkos.h
+action fix_langevin_spin_kokkos.cpp fix_langevin_spin.cpp
+action fix_langevin_spin_kokkos.h fix_langevin_spin.h
 action fix_minimize_kokkos.cpp
 action fix_minimize_kokkos.h
 action fix_neigh_history_kokkos.cpp
@@ -141,10 +143,14 @@ action fix_nve_kokkos.cpp
 action fix_nve_kokkos.h
 action fix_nve_sphere_kokkos.cpp
 action fix_nve_sphere_kokkos.h
+action fix_nve_spin_kokkos.cpp fix_nve_spin.cpp
+action fix_nve_spin_kokkos.h fix_nve_spin.h
 action fix_nvt_kokkos.cpp
 action fix_nvt_kokkos.h
 action fix_nvt_sllod_kokkos.cpp
 action fix_nvt_sllod_kokkos.h
+action fix_precession_spin_kokkos.cpp fix_precession_spin.cpp
+action fix_precession_spin_kokkos.h fix_precession_spin.h
 action fix_property_atom_kokkos.cpp
 action fix_property_atom_kokkos.h
 action fix_qeq_reaxff_kokkos.cpp fix_qeq_reaxff.cpp
@@ -298,6 +304,10 @@ action pair_reaxff_kokkos.h pair_reaxff.h
 action pair_snap_kokkos.cpp pair_snap.cpp
 action pair_snap_kokkos.h pair_snap.h
 action pair_snap_kokkos_impl.h pair_snap.cpp
+action pair_spin_dmi_kokkos.cpp pair_spin_dmi.cpp
+action pair_spin_dmi_kokkos.h pair_spin_dmi.h
+action pair_spin_exchange_kokkos.cpp pair_spin_exchange.cpp
+action pair_spin_exchange_kokkos.h pair_spin_exchange.h
 action pair_sw_kokkos.cpp pair_sw.cpp
 action pair_sw_kokkos.h pair_sw.h
 action pair_vashishta_kokkos.cpp pair_vashishta.cpp
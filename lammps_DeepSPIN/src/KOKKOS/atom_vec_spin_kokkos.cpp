@@ -54,7 +54,7 @@ AtomVecSpinKokkos::AtomVecSpinKokkos(LAMMPS *lmp) : AtomVecKokkos(lmp)
   size_velocity = 3;
   size_data_atom = 9;
   size_data_vel = 4;
-  xcol_data = 4;
+  xcol_data = 3;
 
   atom->sp_flag = 1;
 
@@ -1068,13 +1068,13 @@ void AtomVecSpinKokkos::data_atom(double *coord, imageint imagetmp,
   if (type[nlocal] <= 0 || type[nlocal] > atom->ntypes)
     error->one(FLERR,"Invalid atom type in Atoms section of data file");
 
-  h_sp(nlocal,3) = utils::numeric(FLERR,values[2],true,lmp);
-  h_sp(nlocal,0) = utils::numeric(FLERR,values[6],true,lmp);
-  h_sp(nlocal,1) = utils::numeric(FLERR,values[7],true,lmp);
-  h_sp(nlocal,2) = utils::numeric(FLERR,values[8],true,lmp);
-  double inorm = 1.0/sqrt(sp[nlocal][0]*sp[nlocal][0] +
-                          sp[nlocal][1]*sp[nlocal][1] +
-                          sp[nlocal][2]*sp[nlocal][2]);
+  h_sp(nlocal,0) = utils::numeric(FLERR,values[5],true,lmp);
+  h_sp(nlocal,1) = utils::numeric(FLERR,values[6],true,lmp);
+  h_sp(nlocal,2) = utils::numeric(FLERR,values[7],true,lmp);
+  h_sp(nlocal,3) = utils::numeric(FLERR,values[8],true,lmp);
+  double inorm = 1.0/sqrt(h_sp(nlocal,0)*h_sp(nlocal,0) +
+                          h_sp(nlocal,1)*h_sp(nlocal,1) +
+                          h_sp(nlocal,2)*h_sp(nlocal,2));
   h_sp(nlocal,0) *= inorm;
   h_sp(nlocal,1) *= inorm;
   h_sp(nlocal,2) *= inorm;
@@ -1103,16 +1103,16 @@ void AtomVecSpinKokkos::data_atom(double *coord, imageint imagetmp,
 int AtomVecSpinKokkos::data_atom_hybrid(int nlocal, const std::vector<std::string> &values,
                                         int offset)
 {
-  h_sp(nlocal,3) = utils::numeric(FLERR,values[offset],true,lmp);
-  h_sp(nlocal,0) = utils::numeric(FLERR,values[offset+1],true,lmp);
-  h_sp(nlocal,1) = utils::numeric(FLERR,values[offset+2],true,lmp);
-  h_sp(nlocal,2) = utils::numeric(FLERR,values[offset+3],true,lmp);
-  double inorm = 1.0/sqrt(sp[nlocal][0]*sp[nlocal][0] +
-                          sp[nlocal][1]*sp[nlocal][1] +
-                          sp[nlocal][2]*sp[nlocal][2]);
-  sp[nlocal][0] *= inorm;
-  sp[nlocal][1] *= inorm;
-  sp[nlocal][2] *= inorm;
+  h_sp(nlocal,0) = utils::numeric(FLERR,values[offset],true,lmp);
+  h_sp(nlocal,1) = utils::numeric(FLERR,values[offset+1],true,lmp);
+  h_sp(nlocal,2) = utils::numeric(FLERR,values[offset+2],true,lmp);
+  h_sp(nlocal,3) = utils::numeric(FLERR,values[offset+3],true,lmp);
+  double inorm = 1.0/sqrt(h_sp(nlocal,0)*h_sp(nlocal,0) +
+                          h_sp(nlocal,1)*h_sp(nlocal,1) +
+                          h_sp(nlocal,2)*h_sp(nlocal,2));
+  h_sp(nlocal,0) *= inorm;
+  h_sp(nlocal,1) *= inorm;
+  h_sp(nlocal,2) *= inorm;
 
   return 4;
 }
@@ -1127,16 +1127,16 @@ void AtomVecSpinKokkos::pack_data(double **buf)
   for (int i = 0; i < nlocal; i++) {
     buf[i][0] = h_tag[i];
     buf[i][1] = h_type[i];
-    buf[i][2] = h_sp(i,0);
-    buf[i][3] = h_x(i,0);
-    buf[i][4] = h_x(i,1);
-    buf[i][5] = h_x(i,2);
-    buf[i][2] = h_sp(i,1);
-    buf[i][2] = h_sp(i,2);
-    buf[i][2] = h_sp(i,3);
-    buf[i][6] = (h_image[i] & IMGMASK) - IMGMAX;
-    buf[i][7] = (h_image[i] >> IMGBITS & IMGMASK) - IMGMAX;
-    buf[i][8] = (h_image[i] >> IMG2BITS) - IMGMAX;
+    buf[i][2] = h_x(i,0);
+    buf[i][3] = h_x(i,1);
+    buf[i][4] = h_x(i,2);
+    buf[i][5] = h_sp(i,0);
+    buf[i][6] = h_sp(i,1);
+    buf[i][7] = h_sp(i,2);
+    buf[i][8] = h_sp(i,3);
+    buf[i][9] = (h_image[i] & IMGMASK) - IMGMAX;
+    buf[i][10] = (h_image[i] >> IMGBITS & IMGMASK) - IMGMAX;
+    buf[i][11] = (h_image[i] >> IMG2BITS) - IMGMAX;
   }
 }
 
@@ -1146,10 +1146,10 @@ void AtomVecSpinKokkos::pack_data(double **buf)
 
 int AtomVecSpinKokkos::pack_data_hybrid(int i, double *buf)
 {
-  buf[0] = h_sp(i,3);
-  buf[1] = h_sp(i,0);
-  buf[2] = h_sp(i,1);
-  buf[3] = h_sp(i,2);
+  buf[0] = h_sp(i,0);
+  buf[1] = h_sp(i,1);
+  buf[2] = h_sp(i,2);
+  buf[3] = h_sp(i,3);
   return 4;
 }
 
@@ -1160,9 +1160,11 @@ int AtomVecSpinKokkos::pack_data_hybrid(int i, double *buf)
 void AtomVecSpinKokkos::write_data(FILE *fp, int n, double **buf)
 {
   for (int i = 0; i < n; i++)
-    fprintf(fp,"%d %d %-1.16e %-1.16e %-1.16e %-1.16e %d %d %d\n",
+    fprintf(fp,"%d %d %-1.16e %-1.16e %-1.16e %-1.16e %-1.16e %-1.16e "
+            "%-1.16e %d %d %d\n",
             (int) buf[i][0],(int) buf[i][1],buf[i][2],buf[i][3],buf[i][4],
-            buf[i][5],(int) buf[i][6],(int) buf[i][7],(int) buf[i][8]);
+            buf[i][5],buf[i][6],buf[i][7],buf[i][8],
+            (int) buf[i][9],(int) buf[i][10],(int) buf[i][11]);
 }
 
 /* ----------------------------------------------------------------------
@@ -0,0 +1,61 @@
+// clang-format off
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   https://www.lammps.org/, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#include "fix_langevin_spin_kokkos.h"
+
+#include "atom_kokkos.h"
+#include "atom_masks.h"
+
+using namespace LAMMPS_NS;
+
+/* ----------------------------------------------------------------------
+   the random field is drawn by fix nve/spin/kk in its update kernel,
+   this fix only holds the bath constants
+------------------------------------------------------------------------- */
+
+template<class DeviceType>
+FixLangevinSpinKokkos<DeviceType>::FixLangevinSpinKokkos(LAMMPS *lmp, int narg, char **arg) :
+  FixLangevinSpin(lmp, narg, arg)
+{
+  kokkosable = 1;
+  atomKK = (AtomKokkos *) atom;
+  execution_space = ExecutionSpaceFromDevice<DeviceType>::space;
+
+  datamask_read = EMPTY_MASK;
+  datamask_modify = EMPTY_MASK;
+}
+
+/* ---------------------------------------------------------------------- */
+
+template<class DeviceType>
+params_langevin_spin FixLangevinSpinKokkos<DeviceType>::get_params() const
+{
+  params_langevin_spin p;
+
+  p.groupbit = groupbit;
+  p.tdamp_flag = tdamp_flag;
+  p.temp_flag = temp_flag;
+  p.alpha_t = alpha_t;
+  p.sigma = sigma;
+  p.gil_factor = gil_factor;
+
+  return p;
+}
+
+namespace LAMMPS_NS {
+template class FixLangevinSpinKokkos<LMPDeviceType>;
+#ifdef LMP_KOKKOS_GPU
+template class FixLangevinSpinKokkos<LMPHostType>;
+#endif
+}
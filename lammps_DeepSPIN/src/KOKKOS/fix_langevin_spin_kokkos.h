@@ -0,0 +1,93 @@
+/* -*- c++ -*- ----------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   https://www.lammps.org/, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#ifdef FIX_CLASS
+// clang-format off
+FixStyle(langevin/spin/kk,FixLangevinSpinKokkos<LMPDeviceType>);
+FixStyle(langevin/spin/kk/device,FixLangevinSpinKokkos<LMPDeviceType>);
+FixStyle(langevin/spin/kk/host,FixLangevinSpinKokkos<LMPHostType>);
+// clang-format on
+#else
+
+// clang-format off
+#ifndef LMP_FIX_LANGEVIN_SPIN_KOKKOS_H
+#define LMP_FIX_LANGEVIN_SPIN_KOKKOS_H
+
+#include "fix_langevin_spin.h"
+#include "kokkos_type.h"
+#include "math_const.h"
+
+namespace LAMMPS_NS {
+
+// constants of the langevin bath of one spin, copied to the device
+// the same terms as FixLangevinSpin::compute_single_langevin()
+
+struct params_langevin_spin {
+  int groupbit;
+  int tdamp_flag,temp_flag;
+  double alpha_t,sigma,gil_factor;
+
+  // same mixing and deviates as FixLangevinSpin::random_field()
+
+  KOKKOS_INLINE_FUNCTION
+  static uint64_t mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  // key = FixLangevinSpin::sweep_key() of the current sweep
+
+  KOKKOS_INLINE_FUNCTION
+  void compute(const double *spi, double *fmi, tagint tag, uint64_t key) const {
+    if (tdamp_flag) {
+      const double cpx = fmi[1]*spi[2] - fmi[2]*spi[1];
+      const double cpy = fmi[2]*spi[0] - fmi[0]*spi[2];
+      const double cpz = fmi[0]*spi[1] - fmi[1]*spi[0];
+      fmi[0] -= alpha_t*cpx;
+      fmi[1] -= alpha_t*cpy;
+      fmi[2] -= alpha_t*cpz;
+    }
+    if (temp_flag) {
+      const double norm = 1.0/9007199254740992.0;
+      const uint64_t h = mix64(key ^ mix64((uint64_t) tag));
+      const double u0 = ((mix64(h) >> 11) + 1) * norm;
+      const double u1 = ((mix64(h + 1) >> 11) + 1) * norm;
+      const double u2 = ((mix64(h + 2) >> 11) + 1) * norm;
+      const double u3 = ((mix64(h + 3) >> 11) + 1) * norm;
+      const double r01 = sigma*sqrt(-2.0*log(u0));
+      const double r2 = sigma*sqrt(-2.0*log(u2));
+      fmi[0] += r01*cos(MathConst::MY_2PI*u1);
+      fmi[1] += r01*sin(MathConst::MY_2PI*u1);
+      fmi[2] += r2*cos(MathConst::MY_2PI*u3);
+      fmi[0] *= gil_factor;
+      fmi[1] *= gil_factor;
+      fmi[2] *= gil_factor;
+    }
+  }
+};
+
+template<class DeviceType>
+class FixLangevinSpinKokkos : public FixLangevinSpin {
+ public:
+  typedef DeviceType device_type;
+
+  FixLangevinSpinKokkos(class LAMMPS *, int, char **);
+
+  params_langevin_spin get_params() const;
+};
+
+}
+
+#endif
+#endif
@@ -0,0 +1,418 @@
+// clang-format off
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   https://www.lammps.org/, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#include "fix_nve_spin_kokkos.h"
+
+#include "atom_kokkos.h"
+#include "atom_masks.h"
+#include "comm.h"
+#include "error.h"
+#include "force.h"
+#include "modify.h"
+#include "pair.h"
+#include "timer.h"
+
+using namespace LAMMPS_NS;
+
+/* ----------------------------------------------------------------------
+   spins are always advanced by color (update color): all spins of one
+   color are advanced at once by a device kernel, after a single force
+   evaluation, the coloring itself and the spin comm stay on the host
+------------------------------------------------------------------------- */
+
+template<class DeviceType>
+FixNVESpinKokkos<DeviceType>::FixNVESpinKokkos(LAMMPS *lmp, int narg, char **arg) :
+  FixNVESpin(lmp, narg, arg)
+{
+  kokkosable = 1;
+  atomKK = (AtomKokkos *) atom;
+  execution_space = ExecutionSpaceFromDevice<DeviceType>::space;
+
+  datamask_read = X_MASK | V_MASK | F_MASK | MASK_MASK | RMASS_MASK | TYPE_MASK |
+    SP_MASK | FM_MASK;
+  datamask_modify = X_MASK | V_MASK | F_MASK | SP_MASK | FM_MASK | FML_MASK;
+
+  if (force_local_flag)
+    error->all(FLERR,"Fix nve/spin/kk does not support force local");
+  if (nrefresh > 1)
+    error->all(FLERR,"Fix nve/spin/kk does not support refresh");
+
+  color_flag = 1;
+  comm_forward = 6;
+
+  color_first = 0;
+  nprec_kk = 0;
+  langevin_kk = 0;
+}
+
+/* ---------------------------------------------------------------------- */
+
+template<class DeviceType>
+FixNVESpinKokkos<DeviceType>::~FixNVESpinKokkos()
+{
+  if (copymode) return;
+}
+
+/* ---------------------------------------------------------------------- */
+
+template<class DeviceType>
+void FixNVESpinKokkos<DeviceType>::init()
+{
+  FixNVESpin::init();
+
+  if (setforce_spin_flag)
+    error->all(FLERR,"Fix nve/spin/kk does not support fix setforce/spin");
+
+  // precession and langevin terms are added by the update kernel,
+  // so these fixes must provide their constants to the same device
+
+  nprec_kk = nprecspin;
+  d_prec = Kokkos::View<params_precession_spin*,DeviceType>("nve/spin:prec",MAX(nprecspin,1));
+  h_prec = Kokkos::create_mirror_view(d_prec);
+  for (int k = 0; k < nprecspin; k++)
+    if (!dynamic_cast<FixPrecessionSpinKokkos<DeviceType> *>(lockprecessionspin[k]))
+      error->all(FLERR,"Fix nve/spin/kk requires fix precession/spin/kk "
+                 "on the same execution space");
+
+  langevin_kk = 0;
+  if (nlangspin > 1)
+    error->all(FLERR,"Fix nve/spin/kk supports a single fix langevin/spin/kk");
+  if (nlangspin == 1) {
+    auto langKK = dynamic_cast<FixLangevinSpinKokkos<DeviceType> *>(locklangevinspin[0]);
+    if (!langKK)
+      error->all(FLERR,"Fix nve/spin/kk requires fix langevin/spin/kk "
+                 "on the same execution space");
+    lang = langKK->get_params();
+    langevin_kk = 1;
+
+    // the random field of a sweep of dts has the variance of a
+    // quarter timestep, divided by the number of substeps
+
+    lang.sigma *= sqrt((double) nsubstep);
+  }
+
+  atomKK->k_mass.modify<LMPHostType>();
+  atomKK->k_mass.sync<DeviceType>();
+}
+
+/* ---------------------------------------------------------------------- */
+
+template<class DeviceType>
+void FixNVESpinKokkos<DeviceType>::initial_integrate(int extend_vflag)
+{
+  // divide extend_vflag into true eflag and vflag
+
+  int eflag = extend_vflag / 10;
+  int vflag = extend_vflag % 10;
+
+  int nlocal = atomKK->nlocal;
+  if (igroup == atomKK->firstgroup) nlocal = atomKK->nfirst;
+
+  // update half v for all atoms
+
+  if (lattice_flag) {
+    atomKK->sync(execution_space,V_MASK | F_MASK | MASK_MASK | RMASS_MASK | TYPE_MASK);
+    v = atomKK->k_v.view<DeviceType>();
+    f = atomKK->k_f.view<DeviceType>();
+    rmass = atomKK->k_rmass.view<DeviceType>();
+    mass = atomKK->k_mass.view<DeviceType>();
+    type = atomKK->k_type.view<DeviceType>();
+    mask = atomKK->k_mask.view<DeviceType>();
+
+    copymode = 1;
+    if (atomKK->rmass)
+      Kokkos::parallel_for(Kokkos::RangePolicy<DeviceType, TagFixNVESpinVelocity<1> >(0,nlocal),*this);
+    else
+      Kokkos::parallel_for(Kokkos::RangePolicy<DeviceType, TagFixNVESpinVelocity<0> >(0,nlocal),*this);
+    copymode = 0;
+    atomKK->modified(execution_space,V_MASK);
+  }
+
+  // update half s for all atoms
+
+  nsweep = 0;
+  timer->sub_start(t_spin);
+  for (int n = 0; n < nsubstep; n++) AdvanceColoredSpinsKokkos(eflag, vflag);
+  timer->sub_stop(t_spin);
+
+  // update x for all particles
+
+  if (lattice_flag) {
+    atomKK->sync(execution_space,X_MASK | V_MASK | MASK_MASK);
+    x = atomKK->k_x.view<DeviceType>();
+    v = atomKK->k_v.view<DeviceType>();
+    mask = atomKK->k_mask.view<DeviceType>();
+
+    copymode = 1;
+    Kokkos::parallel_for(Kokkos::RangePolicy<DeviceType, TagFixNVESpinPosition>(0,nlocal),*this);
+    copymode = 0;
+    atomKK->modified(execution_space,X_MASK);
+  }
+
+  // update half s for all particles
+
+  timer->sub_start(t_spin);
+  for (int n = 0; n < nsubstep; n++) AdvanceColoredSpinsKokkos(eflag, vflag);
+  timer->sub_stop(t_spin);
+
+  // the spins of ghost atoms were last written on the host
+
+  atomKK->sync(execution_space,SP_MASK);
+}
+
+/* ---------------------------------------------------------------------- */
+
+template<class DeviceType>
+template<int RMass>
+KOKKOS_INLINE_FUNCTION
+void FixNVESpinKokkos<DeviceType>::operator()(TagFixNVESpinVelocity<RMass>, const int &i) const
+{
+  if (mask(i) & groupbit) {
+    const double dtfm = RMass ? dtf / rmass(i) : dtf / mass(type(i));
+    v(i,0) += dtfm * f(i,0);
+    v(i,1) += dtfm * f(i,1);
+    v(i,2) += dtfm * f(i,2);
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+
+template<class DeviceType>
+KOKKOS_INLINE_FUNCTION
+void FixNVESpinKokkos<DeviceType>::operator()(TagFixNVESpinPosition, const int &i) const
+{
+  if (mask(i) & groupbit) {
+    x(i,0) += dtv * v(i,0);
+    x(i,1) += dtv * v(i,1);
+    x(i,2) += dtv * v(i,2);
+  }
+}
+
+/* ----------------------------------------------------------------------
+   store the owned atoms of each color contiguously for the device,
+   in the order of the color_head/color_next lists of coloring()
+------------------------------------------------------------------------- */
+
+template<class DeviceType>
+void FixNVESpinKokkos<DeviceType>::ColorListsKokkos()
+{
+  int nlocal = atomKK->nlocal;
+  if ((int) k_color_list.extent(0) < MAX(nlocal,1))
+    k_color_list = DAT::tdual_int_1d("nve/spin:color_list",MAX(nlocal,1));
+
+  color_offset.assign(ncolors+1,0);
+  int n = 0;
+  for (int c = 0; c < ncolors; c++) {
+    color_offset[c] = n;
+    for (int i = color_head[c]; i >= 0; i = color_next[i])
+      k_color_list.h_view(n++) = i;
+  }
+  color_offset[ncolors] = n;
+
+  k_color_list.modify<LMPHostType>();
+  k_color_list.sync<DeviceType>();
+  d_color_list = k_color_list.view<DeviceType>();
+}
+
+/* ----------------------------------------------------------------------
+   advance all spins of half a timestep, color by color,
+   forward then backward through the colors (Suzuki-Trotter)
+   same sequence as FixNVESpin::AdvanceColoredSpins()
+------------------------------------------------------------------------- */
+
+template<class DeviceType>
+void FixNVESpinKokkos<DeviceType>::AdvanceColoredSpinsKokkos(int eflag, int vflag)
+{
+  if (color_stale) {
+    atomKK->sync(Host,X_MASK | TAG_MASK | MASK_MASK | TYPE_MASK);
+    coloring();
+    ColorListsKokkos();
+  }
+  grow_stamp();
+
+  comm->forward_comm();
+  for (int k = 0; k < 2*ncolors; k++) {
+    int c = (k < ncolors) ? k : 2*ncolors-1-k;
+
+    // the random fields are drawn in the update kernel from the sweep key
+
+    if (k == 0 || k == ncolors) {
+      if (langevin_kk) lang_key = locklangevinspin[0]->sweep_key(nsweep);
+      nsweep++;
+    }
+    ComputeForceKokkos(eflag, vflag);
+
+    // precession constants may depend on time, refresh them
+
+    for (int m = 0; m < nprec_kk; m++)
+      h_prec(m) = dynamic_cast<FixPrecessionSpinKokkos<DeviceType> *>(lockprecessionspin[m])->get_params();
+    Kokkos::deep_copy(d_prec,h_prec);
+
+    atomKK->sync(execution_space,SP_MASK | FM_MASK | MASK_MASK | TAG_MASK);
+    sp = atomKK->k_sp.view<DeviceType>();
+    fm = atomKK->k_fm.view<DeviceType>();
+    mask = atomKK->k_mask.view<DeviceType>();
+    tag = atomKK->k_tag.view<DeviceType>();
+
+    color_first = color_offset[c];
+    copymode = 1;
+    Kokkos::parallel_for(Kokkos::RangePolicy<DeviceType, TagFixNVESpinAdvance>(0,color_offset[c+1]-color_first),*this);
+    copymode = 0;
+    atomKK->modified(execution_space,SP_MASK | FM_MASK);
+
+    for (int i = color_head[c]; i >= 0; i = color_next[i])
+      spin_stamp[i] = nstamp;
+
+    atomKK->sync(Host,SP_MASK);
+    ForwardSpins();
+    atomKK->modified(Host,SP_MASK);
+  }
+}
+
+/* ----------------------------------------------------------------------
+   magnetic force of one spin of the current color,
+   as FixNVESpin::ComputeInteractionsSpin(), then its advance of dts,
+   as FixNVESpin::AdvanceSingleSpin()
+------------------------------------------------------------------------- */
+
+template<class DeviceType>
+KOKKOS_INLINE_FUNCTION
+void FixNVESpinKokkos<DeviceType>::operator()(TagFixNVESpinAdvance, const int &n) const
+{
+  const int i = d_color_list(color_first + n);
+  const double spi[4] = {sp(i,0),sp(i,1),sp(i,2),sp(i,3)};
+  double fmi[3] = {fm(i,0),fm(i,1),fm(i,2)};
+
+  for (int m = 0; m < nprec_kk; m++)
+    if (mask(i) & d_prec(m).groupbit) d_prec(m).compute(spi,fmi);
+
+  if (langevin_kk && (mask(i) & lang.groupbit))
+    lang.compute(spi,fmi,tag(i),lang_key);
+
+  fm(i,0) = fmi[0];
+  fm(i,1) = fmi[1];
+  fm(i,2) = fmi[2];
+
+  const double fm2 = (fmi[0]*fmi[0])+(fmi[1]*fmi[1])+(fmi[2]*fmi[2]);
+  const double energy = (spi[0]*fmi[0])+(spi[1]*fmi[1])+(spi[2]*fmi[2]);
+  const double dts2 = dts*dts;
+
+  double g[3];
+  g[0] = spi[0] + (fmi[1]*spi[2] - fmi[2]*spi[1])*dts;
+  g[1] = spi[1] + (fmi[2]*spi[0] - fmi[0]*spi[2])*dts;
+  g[2] = spi[2] + (fmi[0]*spi[1] - fmi[1]*spi[0])*dts;
+
+  g[0] += (fmi[0]*energy - 0.5*spi[0]*fm2)*0.5*dts2;
+  g[1] += (fmi[1]*energy - 0.5*spi[1]*fm2)*0.5*dts2;
+  g[2] += (fmi[2]*energy - 0.5*spi[2]*fm2)*0.5*dts2;
+
+  sp(i,0) = g[0] / (1.0 + 0.25*fm2*dts2);
+  sp(i,1) = g[1] / (1.0 + 0.25*fm2*dts2);
+  sp(i,2) = g[2] / (1.0 + 0.25*fm2*dts2);
+}
+
+/* ----------------------------------------------------------------------
+   compute f and fm before advancing the spins of one color,
+   as FixNVESpin::ComputeForceDP() with the forces cleared on the device
+------------------------------------------------------------------------- */
+
+template<class DeviceType>
+void FixNVESpinKokkos<DeviceType>::ComputeForceKokkos(int eflag, int vflag)
+{
+  timer->sub_start(t_force);
+
+  int nall = atomKK->nlocal;
+  if (force->newton) nall += atomKK->nghost;
+
+  atomKK->k_f.clear_sync_state();
+  atomKK->k_fm.clear_sync_state();
+  atomKK->k_fm_long.clear_sync_state();
+  f = atomKK->k_f.view<DeviceType>();
+  fm = atomKK->k_fm.view<DeviceType>();
+  fm_long = atomKK->k_fm_long.view<DeviceType>();
+
+  copymode = 1;
+  Kokkos::parallel_for(Kokkos::RangePolicy<DeviceType, TagFixNVESpinClear>(0,nall),*this);
+  copymode = 0;
+  atomKK->modified(execution_space,F_MASK | FM_MASK | FML_MASK);
+
+  if (modify->n_pre_force)
+    modify->pre_force(vflag);
+
+  atomKK->sync(force->pair->execution_space,force->pair->datamask_read);
+  force->pair->compute(eflag,vflag);
+  atomKK->modified(force->pair->execution_space,force->pair->datamask_modify);
+
+  if (modify->n_pre_reverse)
+    modify->pre_reverse(eflag,vflag);
+
+  if (force->newton)
+    comm->reverse_comm();
+
+  if (modify->n_post_force_any)
+    modify->post_force(vflag);
+  timer->sub_stop(t_force);
+}
+
+/* ---------------------------------------------------------------------- */
+
+template<class DeviceType>
+KOKKOS_INLINE_FUNCTION
+void FixNVESpinKokkos<DeviceType>::operator()(TagFixNVESpinClear, const int &i) const
+{
+  f(i,0) = 0.0;
+  f(i,1) = 0.0;
+  f(i,2) = 0.0;
+  fm(i,0) = 0.0;
+  fm(i,1) = 0.0;
+  fm(i,2) = 0.0;
+  fm_long(i,0) = 0.0;
+  fm_long(i,1) = 0.0;
+  fm_long(i,2) = 0.0;
+}
+
+/* ---------------------------------------------------------------------- */
+
+template<class DeviceType>
+void FixNVESpinKokkos<DeviceType>::final_integrate()
+{
+  if (!lattice_flag) return;
+
+  atomKK->sync(execution_space,V_MASK | F_MASK | MASK_MASK | RMASS_MASK | TYPE_MASK);
+  v = atomKK->k_v.view<DeviceType>();
+  f = atomKK->k_f.view<DeviceType>();
+  rmass = atomKK->k_rmass.view<DeviceType>();
+  mass = atomKK->k_mass.view<DeviceType>();
+  type = atomKK->k_type.view<DeviceType>();
+  mask = atomKK->k_mask.view<DeviceType>();
+  int nlocal = atomKK->nlocal;
+  if (igroup == atomKK->firstgroup) nlocal = atomKK->nfirst;
+
+  // update half v for all particles
+
+  copymode = 1;
+  if (atomKK->rmass)
+    Kokkos::parallel_for(Kokkos::RangePolicy<DeviceType, TagFixNVESpinVelocity<1> >(0,nlocal),*this);
+  else
+    Kokkos::parallel_for(Kokkos::RangePolicy<DeviceType, TagFixNVESpinVelocity<0> >(0,nlocal),*this);
+  copymode = 0;
+  atomKK->modified(execution_space,V_MASK);
+}
+
+namespace LAMMPS_NS {
+template class FixNVESpinKokkos<LMPDeviceType>;
+#ifdef LMP_KOKKOS_GPU
+template class FixNVESpinKokkos<LMPHostType>;
+#endif
+}
@@ -0,0 +1,103 @@
+/* -*- c++ -*- ----------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   https://www.lammps.org/, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#ifdef FIX_CLASS
+// clang-format off
+FixStyle(nve/spin/kk,FixNVESpinKokkos<LMPDeviceType>);
+FixStyle(nve/spin/kk/device,FixNVESpinKokkos<LMPDeviceType>);
+FixStyle(nve/spin/kk/host,FixNVESpinKokkos<LMPHostType>);
+// clang-format on
+#else
+
+// clang-format off
+#ifndef LMP_FIX_NVE_SPIN_KOKKOS_H
+#define LMP_FIX_NVE_SPIN_KOKKOS_H
+
+#include "fix_nve_spin.h"
+#include "kokkos_type.h"
+#include "fix_langevin_spin_kokkos.h"
+#include "fix_precession_spin_kokkos.h"
+
+#include <vector>
+
+namespace LAMMPS_NS {
+
+template<int RMass>
+struct TagFixNVESpinVelocity{};
+struct TagFixNVESpinPosition{};
+struct TagFixNVESpinClear{};
+struct TagFixNVESpinAdvance{};
+
+template<class DeviceType>
+class FixNVESpinKokkos : public FixNVESpin {
+ public:
+  typedef DeviceType device_type;
+  typedef ArrayTypes<DeviceType> AT;
+
+  FixNVESpinKokkos(class LAMMPS *, int, char **);
+  ~FixNVESpinKokkos() override;
+  void init() override;
+  void initial_integrate(int) override;
+  void final_integrate() override;
+
+  template<int RMass>
+  KOKKOS_INLINE_FUNCTION
+  void operator()(TagFixNVESpinVelocity<RMass>, const int&) const;
+
+  KOKKOS_INLINE_FUNCTION
+  void operator()(TagFixNVESpinPosition, const int&) const;
+
+  KOKKOS_INLINE_FUNCTION
+  void operator()(TagFixNVESpinClear, const int&) const;
+
+  KOKKOS_INLINE_FUNCTION
+  void operator()(TagFixNVESpinAdvance, const int&) const;
+
+ private:
+  void ColorListsKokkos();
+  void AdvanceColoredSpinsKokkos(int, int);
+  void ComputeForceKokkos(int, int);
+
+  typename AT::t_x_array x;
+  typename AT::t_v_array v;
+  typename AT::t_f_array f;
+  typename AT::t_sp_array sp;
+  typename AT::t_fm_array fm;
+  typename AT::t_fm_array fm_long;
+  typename AT::t_float_1d rmass;
+  typename AT::t_float_1d mass;
+  typename AT::t_int_1d type;
+  typename AT::t_int_1d mask;
+  typename AT::t_tagint_1d tag;
+
+  // owned atoms of each color, sorted by color, advanced together
+
+  DAT::tdual_int_1d k_color_list;
+  typename AT::t_int_1d d_color_list;
+  std::vector<int> color_offset;
+  int color_first;
+
+  // precession and langevin terms of each advanced spin
+
+  int nprec_kk;
+  Kokkos::View<params_precession_spin*,DeviceType> d_prec;
+  typename Kokkos::View<params_precession_spin*,DeviceType>::HostMirror h_prec;
+  int langevin_kk;
+  params_langevin_spin lang;
+  uint64_t lang_key;    // key of the random stream of the current sweep
+};
+
+}
+
+#endif
+#endif
@@ -0,0 +1,173 @@
+// clang-format off
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   https://www.lammps.org/, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#include "fix_precession_spin_kokkos.h"
+
+#include "atom_kokkos.h"
+#include "atom_masks.h"
+#include "memory_kokkos.h"
+#include "modify.h"
+#include "update.h"
+
+using namespace LAMMPS_NS;
+
+enum{CONSTANT,EQUAL};
+
+/* ---------------------------------------------------------------------- */
+
+template<class DeviceType>
+FixPrecessionSpinKokkos<DeviceType>::FixPrecessionSpinKokkos(LAMMPS *lmp, int narg, char **arg) :
+  FixPrecessionSpin(lmp, narg, arg)
+{
+  kokkosable = 1;
+  atomKK = (AtomKokkos *) atom;
+  execution_space = ExecutionSpaceFromDevice<DeviceType>::space;
+
+  datamask_read = SP_MASK | FM_MASK | MASK_MASK;
+  datamask_modify = FM_MASK;
+}
+
+/* ---------------------------------------------------------------------- */
+
+template<class DeviceType>
+FixPrecessionSpinKokkos<DeviceType>::~FixPrecessionSpinKokkos()
+{
+  if (copymode) return;
+
+  memoryKK->destroy_kokkos(k_emag,emag);
+  emag = nullptr;
+}
+
+/* ---------------------------------------------------------------------- */
+
+template<class DeviceType>
+void FixPrecessionSpinKokkos<DeviceType>::init()
+{
+  // emag is a Kokkos view, release it before the base class grows it
+  // with memory->grow() and drop that array, post_force() reallocates it
+
+  memoryKK->destroy_kokkos(k_emag,emag);
+  FixPrecessionSpin::init();
+  memory->destroy(emag);
+  emag = nullptr;
+  nlocal_max = 0;
+}
+
+/* ---------------------------------------------------------------------- */
+
+template<class DeviceType>
+void FixPrecessionSpinKokkos<DeviceType>::post_force(int /* vflag */)
+{
+  // update mag field with time (potential improvement)
+
+  if (varflag != CONSTANT) {
+    modify->clearstep_compute();
+    modify->addstep_compute(update->ntimestep + 1);
+    set_magneticprecession();           // update mag. field if time-dep.
+  }
+
+  const int nlocal = atom->nlocal;
+  if (nlocal_max < nlocal || !k_emag.d_view.data()) {
+    nlocal_max = MAX(nlocal_max,nlocal);
+    memoryKK->destroy_kokkos(k_emag,emag);
+    memoryKK->create_kokkos(k_emag,emag,nlocal_max,"precession/spin:emag");
+  }
+  d_emag = k_emag.view<DeviceType>();
+
+  atomKK->sync(execution_space,datamask_read);
+
+  sp = atomKK->k_sp.view<DeviceType>();
+  fm = atomKK->k_fm.view<DeviceType>();
+  mask = atomKK->k_mask.view<DeviceType>();
+  prec = get_params();
+
+  eflag = 0;
+  eprec = 0.0;
+  copymode = 1;
+  Kokkos::parallel_reduce(Kokkos::RangePolicy<DeviceType>(0,nlocal),*this,eprec);
+  copymode = 0;
+
+  atomKK->modified(execution_space,datamask_modify);
+  k_emag.template modify<DeviceType>();
+  k_emag.template sync<LMPHostType>();
+}
+
+/* ---------------------------------------------------------------------- */
+
+template<class DeviceType>
+KOKKOS_INLINE_FUNCTION
+void FixPrecessionSpinKokkos<DeviceType>::operator()(const int &i, double &eprec_kk) const
+{
+  d_emag(i) = 0.0;
+  if (mask(i) & prec.groupbit) {
+    const double spi[4] = {sp(i,0),sp(i,1),sp(i,2),sp(i,3)};
+    double fmi[3] = {0.0,0.0,0.0};
+    prec.compute(spi,fmi);
+    const double epreci = prec.energy(spi);
+    d_emag(i) += epreci;
+    eprec_kk += epreci;
+    fm(i,0) += fmi[0];
+    fm(i,1) += fmi[1];
+    fm(i,2) += fmi[2];
+  }
+}
+
+/* ----------------------------------------------------------------------
+   current precession constants, after set_magneticprecession()
+------------------------------------------------------------------------- */
+
+template<class DeviceType>
+params_precession_spin FixPrecessionSpinKokkos<DeviceType>::get_params() const
+{
+  params_precession_spin p;
+
+  p.groupbit = groupbit;
+  p.zeeman_flag = zeeman_flag;
+  p.stt_flag = stt_flag;
+  p.aniso_flag = aniso_flag;
+  p.cubic_flag = cubic_flag;
+  p.hexaniso_flag = hexaniso_flag;
+
+  p.hbar = hbar;
+  p.H_field = H_field;
+  p.nhx = nhx; p.nhy = nhy; p.nhz = nhz;
+  p.hx = hx; p.hy = hy; p.hz = hz;
+
+  p.stt_field = stt_field;
+  p.nsttx = nsttx; p.nstty = nstty; p.nsttz = nsttz;
+
+  p.Ka = Ka;
+  p.nax = nax; p.nay = nay; p.naz = naz;
+  p.Kax = Kax; p.Kay = Kay; p.Kaz = Kaz;
+
+  p.k1c = k1c; p.k2c = k2c;
+  p.k1ch = k1ch; p.k2ch = k2ch;
+  p.nc1x = nc1x; p.nc1y = nc1y; p.nc1z = nc1z;
+  p.nc2x = nc2x; p.nc2y = nc2y; p.nc2z = nc2z;
+  p.nc3x = nc3x; p.nc3y = nc3y; p.nc3z = nc3z;
+
+  p.K6 = K6; p.K6h = K6h;
+  p.n6x = n6x; p.n6y = n6y; p.n6z = n6z;
+  p.m6x = m6x; p.m6y = m6y; p.m6z = m6z;
+  p.l6x = l6x; p.l6y = l6y; p.l6z = l6z;
+
+  return p;
+}
+
+namespace LAMMPS_NS {
+template class FixPrecessionSpinKokkos<LMPDeviceType>;
+#ifdef LMP_KOKKOS_GPU
+template class FixPrecessionSpinKokkos<LMPHostType>;
+#endif
+}
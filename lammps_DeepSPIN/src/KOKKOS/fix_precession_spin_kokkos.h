@@ -0,0 +1,160 @@
+/* -*- c++ -*- ----------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   https://www.lammps.org/, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#ifdef FIX_CLASS
+// clang-format off
+FixStyle(precession/spin/kk,FixPrecessionSpinKokkos<LMPDeviceType>);
+FixStyle(precession/spin/kk/device,FixPrecessionSpinKokkos<LMPDeviceType>);
+FixStyle(precession/spin/kk/host,FixPrecessionSpinKokkos<LMPHostType>);
+// clang-format on
+#else
+
+// clang-format off
+#ifndef LMP_FIX_PRECESSION_SPIN_KOKKOS_H
+#define LMP_FIX_PRECESSION_SPIN_KOKKOS_H
+
+#include "fix_precession_spin.h"
+#include "kokkos_type.h"
+
+namespace LAMMPS_NS {
+
+// constants of the precession of one spin, copied to the device
+// the same terms as FixPrecessionSpin::post_force()
+
+struct params_precession_spin {
+  int groupbit;
+  int zeeman_flag,stt_flag,aniso_flag,cubic_flag,hexaniso_flag;
+  double hbar,H_field,nhx,nhy,nhz,hx,hy,hz;
+  double stt_field,nsttx,nstty,nsttz;
+  double Ka,nax,nay,naz,Kax,Kay,Kaz;
+  double k1c,k2c,k1ch,k2ch;
+  double nc1x,nc1y,nc1z,nc2x,nc2y,nc2z,nc3x,nc3y,nc3z;
+  double K6,K6h,n6x,n6y,n6z,m6x,m6y,m6z,l6x,l6y,l6z;
+
+  // add the precession of spin spi (with its norm in spi[3]) to fmi
+
+  KOKKOS_INLINE_FUNCTION
+  void compute(const double *spi, double *fmi) const {
+    if (zeeman_flag) {
+      fmi[0] += spi[3]*hx;
+      fmi[1] += spi[3]*hy;
+      fmi[2] += spi[3]*hz;
+    }
+    if (stt_flag) {
+      fmi[0] += 1.0*stt_field*( spi[1]*nsttz-spi[2]*nstty);
+      fmi[1] += 1.0*stt_field*(-spi[0]*nsttz+spi[2]*nsttx);
+      fmi[2] += 1.0*stt_field*( spi[0]*nstty-spi[1]*nsttx);
+    }
+    if (aniso_flag) {
+      const double scalar = nax*spi[0] + nay*spi[1] + naz*spi[2];
+      fmi[0] += scalar*Kax;
+      fmi[1] += scalar*Kay;
+      fmi[2] += scalar*Kaz;
+    }
+    if (cubic_flag) {
+      const double skx = spi[0]*nc1x+spi[1]*nc1y+spi[2]*nc1z;
+      const double sky = spi[0]*nc2x+spi[1]*nc2y+spi[2]*nc2z;
+      const double skz = spi[0]*nc3x+spi[1]*nc3y+spi[2]*nc3z;
+      const double skx2 = skx*skx;
+      const double sky2 = sky*sky;
+      const double skz2 = skz*skz;
+      const double four1 = 2.0*skx*(sky2+skz2);
+      const double four2 = 2.0*sky*(skx2+skz2);
+      const double four3 = 2.0*skz*(skx2+sky2);
+      const double six1 = 2.0*skx*sky2*skz2;
+      const double six2 = 2.0*sky*skx2*skz2;
+      const double six3 = 2.0*skz*skx2*sky2;
+      fmi[0] += k1ch*(nc1x*four1 + nc2x*four2 + nc3x*four3) +
+        k2ch*(nc1x*six1 + nc2x*six2 + nc3x*six3);
+      fmi[1] += k1ch*(nc1y*four1 + nc2y*four2 + nc3y*four3) +
+        k2ch*(nc1y*six1 + nc2y*six2 + nc3y*six3);
+      fmi[2] += k1ch*(nc1z*four1 + nc2z*four2 + nc3z*four3) +
+        k2ch*(nc1z*six1 + nc2z*six2 + nc3z*six3);
+    }
+    if (hexaniso_flag) {
+      const double s_x = l6x*spi[0]+l6y*spi[1]+l6z*spi[2];
+      const double s_y = m6x*spi[0]+m6y*spi[1]+m6z*spi[2];
+      const double phi = atan2(s_y,s_x);
+      const double ssint2 = s_x*s_x + s_y*s_y;
+      const double pf = 6.0 * K6h * ssint2*ssint2*sqrt(ssint2);
+      const double fm_x =  pf*cos(5*phi);
+      const double fm_y = -pf*sin(5*phi);
+      fmi[0] += fm_x*l6x+fm_y*m6x;
+      fmi[1] += fm_x*l6y+fm_y*m6y;
+      fmi[2] += fm_x*l6z+fm_y*m6z;
+    }
+  }
+
+  // precession energy of spin spi
+
+  KOKKOS_INLINE_FUNCTION
+  double energy(const double *spi) const {
+    double epreci = 0.0;
+    if (zeeman_flag)
+      epreci -= hbar*H_field*spi[3]*(nhx*spi[0]+nhy*spi[1]+nhz*spi[2]);
+    if (aniso_flag) {
+      const double scalar = nax*spi[0] + nay*spi[1] + naz*spi[2];
+      epreci -= Ka*scalar*scalar;
+    }
+    if (cubic_flag) {
+      const double skx = spi[0]*nc1x+spi[1]*nc1y+spi[2]*nc1z;
+      const double sky = spi[0]*nc2x+spi[1]*nc2y+spi[2]*nc2z;
+      const double skz = spi[0]*nc3x+spi[1]*nc3y+spi[2]*nc3z;
+      double energy = k1c*(skx*skx*sky*sky + sky*sky*skz*skz + skx*skx*skz*skz);
+      energy += k2c*skx*skx*sky*sky*skz*skz;
+      epreci -= energy;
+    }
+    if (hexaniso_flag) {
+      const double s_x = l6x*spi[0]+l6y*spi[1]+l6z*spi[2];
+      const double s_y = m6x*spi[0]+m6y*spi[1]+m6z*spi[2];
+      const double s_z = n6x*spi[0]+n6y*spi[1]+n6z*spi[2];
+      const double phi = atan2(s_y,s_z);
+      const double ssint2 = s_x*s_x + s_y*s_y;
+      epreci -= 2.0*K6 * ssint2*ssint2*ssint2*cos(6*phi);
+    }
+    return epreci;
+  }
+};
+
+template<class DeviceType>
+class FixPrecessionSpinKokkos : public FixPrecessionSpin {
+ public:
+  typedef DeviceType device_type;
+  typedef double value_type;
+  typedef ArrayTypes<DeviceType> AT;
+
+  FixPrecessionSpinKokkos(class LAMMPS *, int, char **);
+  ~FixPrecessionSpinKokkos() override;
+  void init() override;
+  void post_force(int) override;
+
+  params_precession_spin get_params() const;
+
+  KOKKOS_INLINE_FUNCTION
+  void operator()(const int&, double&) const;
+
+ private:
+  params_precession_spin prec;
+
+  typename AT::t_sp_array_randomread sp;
+  typename AT::t_fm_array fm;
+  typename AT::t_int_1d_randomread mask;
+
+  DAT::tdual_efloat_1d k_emag;
+  typename AT::t_efloat_1d d_emag;
+};
+
+}
+
+#endif
+#endif
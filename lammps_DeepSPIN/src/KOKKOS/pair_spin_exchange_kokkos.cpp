@@ -0,0 +1,360 @@
+// clang-format off
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   https://www.lammps.org/, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#include "pair_spin_exchange_kokkos.h"
+
+#include "atom_kokkos.h"
+#include "atom_masks.h"
+#include "error.h"
+#include "force.h"
+#include "kokkos.h"
+#include "memory_kokkos.h"
+#include "neigh_list_kokkos.h"
+#include "neigh_request.h"
+#include "neighbor.h"
+
+#include <cmath>
+
+using namespace LAMMPS_NS;
+
+/* ---------------------------------------------------------------------- */
+
+template<class DeviceType>
+PairSpinExchangeKokkos<DeviceType>::PairSpinExchangeKokkos(LAMMPS *lmp) :
+  PairSpinExchange(lmp)
+{
+  respa_enable = 0;
+
+  kokkosable = 1;
+  atomKK = (AtomKokkos *) atom;
+  execution_space = ExecutionSpaceFromDevice<DeviceType>::space;
+  datamask_read = X_MASK | F_MASK | TYPE_MASK | SP_MASK | FM_MASK | ENERGY_MASK | VIRIAL_MASK;
+  datamask_modify = F_MASK | FM_MASK | ENERGY_MASK | VIRIAL_MASK;
+}
+
+/* ---------------------------------------------------------------------- */
+
+template<class DeviceType>
+PairSpinExchangeKokkos<DeviceType>::~PairSpinExchangeKokkos()
+{
+  if (copymode) return;
+
+  memoryKK->destroy_kokkos(k_eatom,eatom);
+  memoryKK->destroy_kokkos(k_vatom,vatom);
+  memoryKK->destroy_kokkos(k_emag,emag);
+  eatom = nullptr;
+  vatom = nullptr;
+  emag = nullptr;
+}
+
+/* ----------------------------------------------------------------------
+   full neighbor list, each pair is visited from both of its atoms
+   the mechanical force of a pair is odd in i,j, so atom i takes both
+   halves of it and no force is written to j, this needs no atomics
+------------------------------------------------------------------------- */
+
+template<class DeviceType>
+void PairSpinExchangeKokkos<DeviceType>::compute(int eflag_in, int vflag_in)
+{
+  eflag = eflag_in;
+  vflag = vflag_in;
+
+  ev_init(eflag,vflag,0);
+
+  if (e_offset != 0 && e_offset != 1)
+    error->all(FLERR,"Illegal option in pair exchange/biquadratic command");
+  offset = (e_offset == 1) ? 1.0 : 0.0;
+
+  // reallocate per-atom arrays if necessary
+
+  if (eflag_atom) {
+    memoryKK->destroy_kokkos(k_eatom,eatom);
+    memoryKK->create_kokkos(k_eatom,eatom,maxeatom,"pair:eatom");
+    d_eatom = k_eatom.view<DeviceType>();
+  }
+  if (vflag_atom) {
+    memoryKK->destroy_kokkos(k_vatom,vatom);
+    memoryKK->create_kokkos(k_vatom,vatom,maxvatom,"pair:vatom");
+    d_vatom = k_vatom.view<DeviceType>();
+  }
+
+  const int nlocal = atom->nlocal;
+  if (nlocal_max < nlocal || !k_emag.d_view.data()) {
+    nlocal_max = MAX(nlocal_max,nlocal);
+    memoryKK->destroy_kokkos(k_emag,emag);
+    memoryKK->create_kokkos(k_emag,emag,nlocal_max,"pair/spin:emag");
+  }
+  d_emag = k_emag.view<DeviceType>();
+
+  atomKK->sync(execution_space,datamask_read);
+  k_params.template sync<DeviceType>();
+  if (eflag || vflag) atomKK->modified(execution_space,datamask_modify);
+  else atomKK->modified(execution_space,F_MASK | FM_MASK);
+
+  x = atomKK->k_x.view<DeviceType>();
+  f = atomKK->k_f.view<DeviceType>();
+  sp = atomKK->k_sp.view<DeviceType>();
+  fm = atomKK->k_fm.view<DeviceType>();
+  type = atomKK->k_type.view<DeviceType>();
+
+  NeighListKokkos<DeviceType>* k_list = static_cast<NeighListKokkos<DeviceType>*>(list);
+  d_ilist = k_list->d_ilist;
+  d_numneigh = k_list->d_numneigh;
+  d_neighbors = k_list->d_neighbors;
+  const int inum = list->inum;
+
+  copymode = 1;
+
+  EV_FLOAT ev;
+
+  if (lattice_flag) {
+    if (evflag)
+      Kokkos::parallel_reduce(Kokkos::RangePolicy<DeviceType, TagPairSpinExchangeCompute<1,1> >(0,inum),*this,ev);
+    else
+      Kokkos::parallel_for(Kokkos::RangePolicy<DeviceType, TagPairSpinExchangeCompute<0,1> >(0,inum),*this);
+  } else {
+    if (evflag)
+      Kokkos::parallel_reduce(Kokkos::RangePolicy<DeviceType, TagPairSpinExchangeCompute<1,0> >(0,inum),*this,ev);
+    else
+      Kokkos::parallel_for(Kokkos::RangePolicy<DeviceType, TagPairSpinExchangeCompute<0,0> >(0,inum),*this);
+  }
+
+  if (eflag_global) eng_vdwl += ev.evdwl;
+  if (vflag_global) {
+    virial[0] += ev.v[0];
+    virial[1] += ev.v[1];
+    virial[2] += ev.v[2];
+    virial[3] += ev.v[3];
+    virial[4] += ev.v[4];
+    virial[5] += ev.v[5];
+  }
+
+  if (eflag_atom) {
+    k_eatom.template modify<DeviceType>();
+    k_eatom.template sync<LMPHostType>();
+  }
+
+  if (vflag_atom) {
+    k_vatom.template modify<DeviceType>();
+    k_vatom.template sync<LMPHostType>();
+  }
+
+  // magnetic energies are read on the host by compute spin
+
+  k_emag.template modify<DeviceType>();
+  k_emag.template sync<LMPHostType>();
+
+  copymode = 0;
+}
+
+/* ---------------------------------------------------------------------- */
+
+template<class DeviceType>
+template<int EVFLAG, int LATTICE>
+KOKKOS_INLINE_FUNCTION
+void PairSpinExchangeKokkos<DeviceType>::operator()(TagPairSpinExchangeCompute<EVFLAG,LATTICE>,
+                                                    const int &ii, EV_FLOAT &ev) const
+{
+  const int i = d_ilist[ii];
+  const X_FLOAT xtmp = x(i,0);
+  const X_FLOAT ytmp = x(i,1);
+  const X_FLOAT ztmp = x(i,2);
+  const F_FLOAT spix = sp(i,0);
+  const F_FLOAT spiy = sp(i,1);
+  const F_FLOAT spiz = sp(i,2);
+  const int itype = type(i);
+  const int jnum = d_numneigh[i];
+
+  F_FLOAT fxtmp = 0.0;
+  F_FLOAT fytmp = 0.0;
+  F_FLOAT fztmp = 0.0;
+  F_FLOAT fmx = 0.0;
+  F_FLOAT fmy = 0.0;
+  F_FLOAT fmz = 0.0;
+  E_FLOAT emtmp = 0.0;
+
+  for (int jj = 0; jj < jnum; jj++) {
+    int j = d_neighbors(i,jj);
+    j &= NEIGHMASK;
+    const int jtype = type(j);
+    const params_spin_exchange &p = params(itype,jtype);
+
+    const X_FLOAT delx = xtmp - x(j,0);
+    const X_FLOAT dely = ytmp - x(j,1);
+    const X_FLOAT delz = ztmp - x(j,2);
+    const F_FLOAT rsq = delx*delx + dely*dely + delz*delz;
+
+    if (rsq > p.cut*p.cut) continue;
+
+    const F_FLOAT spjx = sp(j,0);
+    const F_FLOAT spjy = sp(j,1);
+    const F_FLOAT spjz = sp(j,2);
+
+    const F_FLOAT ra = rsq/p.J3/p.J3;
+    const F_FLOAT ex = exp(-ra);
+    F_FLOAT Jex = 4.0*p.J1_mag*ra;
+    Jex *= (1.0-p.J2*ra);
+    Jex *= ex;
+
+    fmx += Jex*spjx;
+    fmy += Jex*spjy;
+    fmz += Jex*spjz;
+
+    const F_FLOAT sdots = spix*spjx + spiy*spjy + spiz*spjz;
+    F_FLOAT fx = 0.0;
+    F_FLOAT fy = 0.0;
+    F_FLOAT fz = 0.0;
+    if (LATTICE) {
+      const F_FLOAT inorm = 1.0/sqrt(rsq);
+      const F_FLOAT iJ3 = 1.0/(p.J3*p.J3);
+      const F_FLOAT rm = rsq*iJ3;
+      const F_FLOAT rr = sqrt(rsq)*iJ3;
+      F_FLOAT Jex_mech = 1.0-rm-p.J2*rm*(2.0-rm);
+      Jex_mech *= 8.0*p.J1_mech*rr*exp(-rm);
+
+      // fi = -0.5*Jex_mech*(sdots-offset)*eij with eij = -del/r
+
+      const F_FLOAT fpair = 0.5*Jex_mech*(sdots-offset)*inorm;
+      fx = fpair*delx;
+      fy = fpair*dely;
+      fz = fpair*delz;
+      fxtmp += 2.0*fx;
+      fytmp += 2.0*fy;
+      fztmp += 2.0*fz;
+    }
+
+    E_FLOAT evdwl = 0.0;
+    if (eflag) {
+      Jex = 4.0*p.J1_mech*ra;
+      Jex *= (1.0-p.J2*ra);
+      Jex *= ex;
+      evdwl = -0.5*Jex*(sdots-offset);
+      emtmp += evdwl;
+    }
+
+    // the two visits of a pair tally as one ev_tally_xyz() with newton on
+
+    if (EVFLAG) {
+      if (eflag_global) ev.evdwl += evdwl;
+      if (eflag_atom) d_eatom(i) += evdwl;
+      if (vflag_either) {
+        const E_FLOAT v0 = delx*fx;
+        const E_FLOAT v1 = dely*fy;
+        const E_FLOAT v2 = delz*fz;
+        const E_FLOAT v3 = delx*fy;
+        const E_FLOAT v4 = delx*fz;
+        const E_FLOAT v5 = dely*fz;
+        if (vflag_global) {
+          ev.v[0] += v0;
+          ev.v[1] += v1;
+          ev.v[2] += v2;
+          ev.v[3] += v3;
+          ev.v[4] += v4;
+          ev.v[5] += v5;
+        }
+        if (vflag_atom) {
+          d_vatom(i,0) += v0;
+          d_vatom(i,1) += v1;
+          d_vatom(i,2) += v2;
+          d_vatom(i,3) += v3;
+          d_vatom(i,4) += v4;
+          d_vatom(i,5) += v5;
+        }
+      }
+    }
+  }
+
+  f(i,0) += fxtmp;
+  f(i,1) += fytmp;
+  f(i,2) += fztmp;
+  fm(i,0) += fmx;
+  fm(i,1) += fmy;
+  fm(i,2) += fmz;
+  d_emag(i) = emtmp;
+}
+
+/* ---------------------------------------------------------------------- */
+
+template<class DeviceType>
+template<int EVFLAG, int LATTICE>
+KOKKOS_INLINE_FUNCTION
+void PairSpinExchangeKokkos<DeviceType>::operator()(TagPairSpinExchangeCompute<EVFLAG,LATTICE>,
+                                                    const int &ii) const
+{
+  EV_FLOAT ev;
+  this->template operator()<EVFLAG,LATTICE>(TagPairSpinExchangeCompute<EVFLAG,LATTICE>(), ii, ev);
+}
+
+/* ---------------------------------------------------------------------- */
+
+template<class DeviceType>
+void PairSpinExchangeKokkos<DeviceType>::allocate()
+{
+  PairSpinExchange::allocate();
+
+  int n = atom->ntypes;
+  k_params = Kokkos::DualView<params_spin_exchange**,Kokkos::LayoutRight,DeviceType>("PairSpinExchange::params",n+1,n+1);
+  params = k_params.template view<DeviceType>();
+}
+
+/* ----------------------------------------------------------------------
+   init specific to this pair style
+------------------------------------------------------------------------- */
+
+template<class DeviceType>
+void PairSpinExchangeKokkos<DeviceType>::init_style()
+{
+  // emag is a Kokkos view, release it before the base class grows it
+  // with memory->grow() and drop that array, compute() reallocates it
+
+  memoryKK->destroy_kokkos(k_emag,emag);
+  PairSpinExchange::init_style();
+  memory->destroy(emag);
+  emag = nullptr;
+  nlocal_max = 0;
+
+  // adjust neighbor list request for KOKKOS, the list is always full
+
+  auto request = neighbor->find_request(this);
+  request->set_kokkos_host(std::is_same<DeviceType,LMPHostType>::value &&
+                           !std::is_same<DeviceType,LMPDeviceType>::value);
+  request->set_kokkos_device(std::is_same<DeviceType,LMPDeviceType>::value);
+}
+
+/* ----------------------------------------------------------------------
+   init for one type pair i,j and corresponding j,i
+------------------------------------------------------------------------- */
+
+template<class DeviceType>
+double PairSpinExchangeKokkos<DeviceType>::init_one(int i, int j)
+{
+  double cutone = PairSpinExchange::init_one(i,j);
+
+  k_params.h_view(i,j).cut     = cut_spin_exchange[i][j];
+  k_params.h_view(i,j).J1_mag  = J1_mag[i][j];
+  k_params.h_view(i,j).J1_mech = J1_mech[i][j];
+  k_params.h_view(i,j).J2      = J2[i][j];
+  k_params.h_view(i,j).J3      = J3[i][j];
+  k_params.h_view(j,i)         = k_params.h_view(i,j);
+  k_params.template modify<LMPHostType>();
+
+  return cutone;
+}
+
+namespace LAMMPS_NS {
+template class PairSpinExchangeKokkos<LMPDeviceType>;
+#ifdef LMP_KOKKOS_GPU
+template class PairSpinExchangeKokkos<LMPHostType>;
+#endif
+}
@@ -0,0 +1,94 @@
+/* -*- c++ -*- ----------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   https://www.lammps.org/, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#ifdef PAIR_CLASS
+// clang-format off
+PairStyle(spin/exchange/kk,PairSpinExchangeKokkos<LMPDeviceType>);
+PairStyle(spin/exchange/kk/device,PairSpinExchangeKokkos<LMPDeviceType>);
+PairStyle(spin/exchange/kk/host,PairSpinExchangeKokkos<LMPHostType>);
+// clang-format on
+#else
+
+// clang-format off
+#ifndef LMP_PAIR_SPIN_EXCHANGE_KOKKOS_H
+#define LMP_PAIR_SPIN_EXCHANGE_KOKKOS_H
+
+#include "pair_spin_exchange.h"
+#include "pair_kokkos.h"
+
+template<int EVFLAG, int LATTICE>
+struct TagPairSpinExchangeCompute{};
+
+namespace LAMMPS_NS {
+
+template<class DeviceType>
+class PairSpinExchangeKokkos : public PairSpinExchange {
+ public:
+  typedef DeviceType device_type;
+  typedef ArrayTypes<DeviceType> AT;
+  typedef EV_FLOAT value_type;
+
+  PairSpinExchangeKokkos(class LAMMPS *);
+  ~PairSpinExchangeKokkos() override;
+  void compute(int, int) override;
+  void init_style() override;
+  double init_one(int, int) override;
+
+  struct params_spin_exchange {
+    KOKKOS_INLINE_FUNCTION
+    params_spin_exchange() {cut=0;J1_mag=0;J1_mech=0;J2=0;J3=0;}
+    KOKKOS_INLINE_FUNCTION
+    params_spin_exchange(int /*i*/) {cut=0;J1_mag=0;J1_mech=0;J2=0;J3=0;}
+    F_FLOAT cut,J1_mag,J1_mech,J2,J3;
+  };
+
+  template<int EVFLAG, int LATTICE>
+  KOKKOS_INLINE_FUNCTION
+  void operator()(TagPairSpinExchangeCompute<EVFLAG,LATTICE>, const int&, EV_FLOAT&) const;
+
+  template<int EVFLAG, int LATTICE>
+  KOKKOS_INLINE_FUNCTION
+  void operator()(TagPairSpinExchangeCompute<EVFLAG,LATTICE>, const int&) const;
+
+ protected:
+  Kokkos::DualView<params_spin_exchange**,Kokkos::LayoutRight,DeviceType> k_params;
+  typename Kokkos::DualView<params_spin_exchange**,
+                            Kokkos::LayoutRight,DeviceType>::t_dev_const_um params;
+
+  typename AT::t_x_array_randomread x;
+  typename AT::t_f_array f;
+  typename AT::t_sp_array_randomread sp;
+  typename AT::t_fm_array fm;
+  typename AT::t_int_1d_randomread type;
+
+  DAT::tdual_efloat_1d k_eatom;
+  DAT::tdual_virial_array k_vatom;
+  typename AT::t_efloat_1d d_eatom;
+  typename AT::t_virial_array d_vatom;
+  DAT::tdual_efloat_1d k_emag;
+  typename AT::t_efloat_1d d_emag;
+
+  typename AT::t_neighbors_2d d_neighbors;
+  typename AT::t_int_1d_randomread d_ilist;
+  typename AT::t_int_1d_randomread d_numneigh;
+
+  int eflag,vflag;
+  double offset;
+
+  void allocate() override;
+};
+
+}
+
+#endif
+#endif
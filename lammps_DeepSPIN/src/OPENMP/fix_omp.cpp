@@ -21,6 +21,7 @@
 #include "thr_data.h"
 
 #include "atom.h"
+#include "atom_vec.h"
 #include "comm.h"
 #include "error.h"
 #include "force.h"
@@ -320,6 +321,12 @@ void FixOMP::pre_force(int)
     thr[tid]->init_force(nall,f,torque,erforce,desph,drho);
   } // end of omp parallel region
 
+  // the integrator skips force_clear() with fix omp, so clear the
+  // extra per-atom forces of the atom style here, e.g. fm of atom style spin
+
+  if (atom->avec->forceclearflag && nall)
+    atom->avec->force_clear(0,sizeof(double)*nall);
+
   _reduced = false;
 }
 
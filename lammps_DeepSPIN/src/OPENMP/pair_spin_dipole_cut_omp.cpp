@@ -0,0 +1,256 @@
+// clang-format off
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   https://www.lammps.org/, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   This software is distributed under the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#include "pair_spin_dipole_cut_omp.h"
+
+#include "atom.h"
+#include "comm.h"
+#include "force.h"
+#include "memory.h"
+#include "neigh_list.h"
+#include "suffix.h"
+
+#include <cmath>
+
+#include "omp_compat.h"
+using namespace LAMMPS_NS;
+
+/* ---------------------------------------------------------------------- */
+
+PairSpinDipoleCutOMP::PairSpinDipoleCutOMP(LAMMPS *lmp) :
+  PairSpinDipoleCut(lmp), ThrOMP(lmp, THR_PAIR)
+{
+  suffix_flag |= Suffix::OMP;
+  respa_enable = 0;
+}
+
+/* ---------------------------------------------------------------------- */
+
+void PairSpinDipoleCutOMP::compute(int eflag, int vflag)
+{
+  ev_init(eflag,vflag);
+
+  const int nall = atom->nlocal + atom->nghost;
+  const int nthreads = comm->nthreads;
+  const int inum = list->inum;
+
+  // grow emag before the threads fill it
+
+  if (nlocal_max < atom->nlocal) {
+    nlocal_max = atom->nlocal;
+    memory->grow(emag,nlocal_max,"pair/spin:emag");
+  }
+
+#if defined(_OPENMP)
+#pragma omp parallel LMP_DEFAULT_NONE LMP_SHARED(eflag,vflag)
+#endif
+  {
+    int ifrom, ito, tid;
+
+    loop_setup_thr(ifrom, ito, tid, inum, nthreads);
+    ThrData *thr = fix->get_thr(tid);
+    thr->timer(Timer::START);
+    ev_setup_thr(eflag, vflag, nall, eatom, vatom, nullptr, thr);
+
+    if (evflag) {
+      if (eflag) {
+        if (lattice_flag) eval<1,1,1>(ifrom, ito, thr);
+        else eval<1,1,0>(ifrom, ito, thr);
+      } else {
+        if (lattice_flag) eval<1,0,1>(ifrom, ito, thr);
+        else eval<1,0,0>(ifrom, ito, thr);
+      }
+    } else {
+      if (lattice_flag) eval<0,0,1>(ifrom, ito, thr);
+      else eval<0,0,0>(ifrom, ito, thr);
+    }
+
+    thr->timer(Timer::PAIR);
+    reduce_thr(this, eflag, vflag, thr);
+  } // end of omp parallel region
+}
+
+/* ----------------------------------------------------------------------
+   the neighbor list is full and newton pair is on, so fm[i] and emag[i]
+   of an owned atom i are only written by the thread owning i.
+   the cutoffs of the type pairs of i are hoisted out of the neighbor
+   loop, and compute_dipolar() and compute_dipolar_mech() are inlined.
+   the dipolar couplings of the pairs beyond the cutoff are zeroed so
+   that the loop accumulating into i is an omp simd loop, the reaction
+   forces on j are applied in a second loop.
+------------------------------------------------------------------------- */
+
+template <int EVFLAG, int EFLAG, int LATTICE>
+void PairSpinDipoleCutOMP::eval(int iifrom, int iito, ThrData * const thr)
+{
+  int i,ii,jj,jnum,itype,maxj_thr;
+  double xtmp,ytmp,ztmp,fxtmp,fytmp,fztmp,fmx,fmy,fmz,emtmp;
+  double spix,spiy,spiz,spiw;
+  double **fpair_thr;
+  int *ilist,*jlist,*numneigh,**firstneigh;
+
+  const auto * _noalias const x = (dbl3_t *) atom->x[0];
+  const auto * _noalias const sp = (dbl4_t *) atom->sp[0];
+  auto * _noalias const f = (dbl3_t *) thr->get_f()[0];
+  auto * _noalias const fm = (dbl3_t *) atom->fm[0];
+  const int * _noalias const type = atom->type;
+  const int nlocal = atom->nlocal;
+
+  ilist = list->ilist;
+  numneigh = list->numneigh;
+  firstneigh = list->firstneigh;
+
+  // pair forces and energies of the neighbors of one atom
+
+  maxj_thr = 1;
+  for (ii = iifrom; ii < iito; ++ii)
+    if (numneigh[ilist[ii]] > maxj_thr) maxj_thr = numneigh[ilist[ii]];
+  memory->create(fpair_thr,4,maxj_thr,"pair_thr:fpair_thr");
+  double * _noalias const fxj = fpair_thr[0];
+  double * _noalias const fyj = fpair_thr[1];
+  double * _noalias const fzj = fpair_thr[2];
+  double * _noalias const ej = fpair_thr[3];
+
+  // loop over neighbors of my atoms
+
+  for (ii = iifrom; ii < iito; ++ii) {
+
+    i = ilist[ii];
+    xtmp = x[i].x;
+    ytmp = x[i].y;
+    ztmp = x[i].z;
+    spix = sp[i].x;
+    spiy = sp[i].y;
+    spiz = sp[i].z;
+    spiw = sp[i].w;
+    itype = type[i];
+    jlist = firstneigh[i];
+    jnum = numneigh[i];
+
+    const double * _noalias const cut_i = cut_spin_long[itype];
+
+    fxtmp = fytmp = fztmp = 0.0;
+    fmx = fmy = fmz = 0.0;
+    emtmp = 0.0;
+
+#if defined(_OPENMP)
+#pragma omp simd reduction(+:fxtmp,fytmp,fztmp,fmx,fmy,fmz,emtmp)
+#endif
+    for (jj = 0; jj < jnum; jj++) {
+      const int j = jlist[jj] & NEIGHMASK;
+      const int jtype = type[j];
+
+      const double rijx = x[j].x - xtmp;
+      const double rijy = x[j].y - ytmp;
+      const double rijz = x[j].z - ztmp;
+      const double rsq = rijx*rijx + rijy*rijy + rijz*rijz;
+
+      // the cutoff is exclusive, as in compute()
+
+      const double inside = (rsq < cut_i[jtype]*cut_i[jtype]) ? 1.0 : 0.0;
+
+      const double spjx = sp[j].x;
+      const double spjy = sp[j].y;
+      const double spjz = sp[j].z;
+      const double gigj = inside*spiw*sp[j].w;
+
+      const double rinv = 1.0/sqrt(rsq);
+      const double r2inv = 1.0/rsq;
+      const double r3inv = r2inv*rinv;
+      const double eijx = rijx*rinv;
+      const double eijy = rijy*rinv;
+      const double eijz = rijz*rinv;
+
+      const double sjeij = spjx*eijx + spjy*eijy + spjz*eijz;
+      double pre = mub2mu0hbinv * gigj*r3inv;
+
+      const double fmix = pre * (3.0 * sjeij *eijx - spjx);
+      const double fmiy = pre * (3.0 * sjeij *eijy - spjy);
+      const double fmiz = pre * (3.0 * sjeij *eijz - spjz);
+      fmx += fmix;
+      fmy += fmiy;
+      fmz += fmiz;
+
+      double fx = 0.0, fy = 0.0, fz = 0.0;
+      if (LATTICE) {
+        const double sisj = spix*spjx + spiy*spjy + spiz*spjz;
+        const double sieij = spix*eijx + spiy*eijy + spiz*eijz;
+        const double bij = sisj - 5.0*sieij*sjeij;
+        pre = 0.5*3.0*mub2mu0*gigj*r2inv*r2inv;
+
+        fx = -pre * (eijx * bij + (sjeij*spix + sieij*spjx));
+        fy = -pre * (eijy * bij + (sjeij*spiy + sieij*spjy));
+        fz = -pre * (eijz * bij + (sjeij*spiz + sieij*spjz));
+        fxtmp += fx;
+        fytmp += fy;
+        fztmp += fz;
+      }
+
+      double evdwl = 0.0;
+      if (EFLAG) {
+        evdwl = -(spix*fmix + spiy*fmiy + spiz*fmiz);
+        evdwl *= 0.5*hbar;
+        emtmp += evdwl;
+      }
+
+      if (LATTICE || EVFLAG) {
+        fxj[jj] = fx;
+        fyj[jj] = fy;
+        fzj[jj] = fz;
+        ej[jj] = evdwl;
+      }
+    }
+
+    if (LATTICE || EVFLAG) {
+      for (jj = 0; jj < jnum; jj++) {
+        const int j = jlist[jj] & NEIGHMASK;
+        if (LATTICE) {
+          f[j].x -= fxj[jj];
+          f[j].y -= fyj[jj];
+          f[j].z -= fzj[jj];
+        }
+
+        // the displacement is tallied as x[j]-x[i], as in compute()
+
+        if (EVFLAG) {
+          const double rijx = x[j].x - xtmp;
+          const double rijy = x[j].y - ytmp;
+          const double rijz = x[j].z - ztmp;
+          const double rsq = rijx*rijx + rijy*rijy + rijz*rijz;
+          const double cut = cut_i[type[j]];
+          if (rsq >= cut*cut) continue;
+          ev_tally_xyz_thr(this,i,j,nlocal,/* newton_pair */ 1,
+                           ej[jj],0.0,fxj[jj],fyj[jj],fzj[jj],rijx,rijy,rijz,thr);
+        }
+      }
+    }
+
+    f[i].x += fxtmp;
+    f[i].y += fytmp;
+    f[i].z += fztmp;
+    fm[i].x += fmx;
+    fm[i].y += fmy;
+    fm[i].z += fmz;
+    emag[i] = emtmp;
+  }
+
+  memory->destroy(fpair_thr);
+}
+
+/* ---------------------------------------------------------------------- */
+
+double PairSpinDipoleCutOMP::memory_usage()
+{
+  double bytes = memory_usage_thr();
+  bytes += PairSpinDipoleCut::memory_usage();
+
+  return bytes;
+}
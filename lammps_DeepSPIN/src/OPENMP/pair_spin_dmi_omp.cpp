@@ -0,0 +1,334 @@
+// clang-format off
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   https://www.lammps.org/, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   This software is distributed under the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#include "pair_spin_dmi_omp.h"
+
+#include "atom.h"
+#include "comm.h"
+#include "force.h"
+#include "memory.h"
+#include "neigh_list.h"
+#include "suffix.h"
+
+#include <cmath>
+
+#include "omp_compat.h"
+using namespace LAMMPS_NS;
+
+/* ---------------------------------------------------------------------- */
+
+PairSpinDmiOMP::PairSpinDmiOMP(LAMMPS *lmp) :
+  PairSpinDmi(lmp), ThrOMP(lmp, THR_PAIR)
+{
+  suffix_flag |= Suffix::OMP;
+  respa_enable = 0;
+}
+
+/* ---------------------------------------------------------------------- */
+
+void PairSpinDmiOMP::compute(int eflag, int vflag)
+{
+  ev_init(eflag,vflag);
+
+  const int nall = atom->nlocal + atom->nghost;
+  const int nthreads = comm->nthreads;
+  const int inum = list->inum;
+
+  // grow emag before the threads fill it
+
+  if (nlocal_max < atom->nlocal) {
+    nlocal_max = atom->nlocal;
+    memory->grow(emag,nlocal_max,"pair/spin:emag");
+  }
+
+  // build the pair cache of a frozen lattice before the threads use it
+
+  int frozen = coeff_cache();
+
+#if defined(_OPENMP)
+#pragma omp parallel LMP_DEFAULT_NONE LMP_SHARED(eflag,vflag,frozen)
+#endif
+  {
+    int ifrom, ito, tid;
+
+    loop_setup_thr(ifrom, ito, tid, inum, nthreads);
+    ThrData *thr = fix->get_thr(tid);
+    thr->timer(Timer::START);
+    ev_setup_thr(eflag, vflag, nall, eatom, vatom, nullptr, thr);
+
+    if (frozen) {
+      if (evflag) {
+        if (eflag) eval_frozen<1,1>(ifrom, ito, thr);
+        else eval_frozen<1,0>(ifrom, ito, thr);
+      } else eval_frozen<0,0>(ifrom, ito, thr);
+    } else if (evflag) {
+      if (eflag) {
+        if (lattice_flag) eval<1,1,1>(ifrom, ito, thr);
+        else eval<1,1,0>(ifrom, ito, thr);
+      } else {
+        if (lattice_flag) eval<1,0,1>(ifrom, ito, thr);
+        else eval<1,0,0>(ifrom, ito, thr);
+      }
+    } else {
+      if (lattice_flag) eval<0,0,1>(ifrom, ito, thr);
+      else eval<0,0,0>(ifrom, ito, thr);
+    }
+
+    thr->timer(Timer::PAIR);
+    reduce_thr(this, eflag, vflag, thr);
+  } // end of omp parallel region
+}
+
+/* ----------------------------------------------------------------------
+   the neighbor list is full and newton pair is on, so fm[i] and emag[i]
+   of an owned atom i are only written by the thread owning i.
+   the dmi vectors of the type pairs of i are hoisted out of the
+   neighbor loop, and compute_dmi() and compute_dmi_mech() are inlined.
+   pairs beyond the cutoff are masked in the omp simd loop, which only
+   accumulates into i, the reaction forces on j and the tallies are done
+   in a second loop over the stored pair forces.
+------------------------------------------------------------------------- */
+
+template <int EVFLAG, int EFLAG, int LATTICE>
+void PairSpinDmiOMP::eval(int iifrom, int iito, ThrData * const thr)
+{
+  int i,ii,jj,jnum,itype,maxj_thr;
+  double xtmp,ytmp,ztmp,fxtmp,fytmp,fztmp,fmx,fmy,fmz,emtmp;
+  double spix,spiy,spiz;
+  double **fpair_thr;
+  int *ilist,*jlist,*numneigh,**firstneigh;
+
+  const auto * _noalias const x = (dbl3_t *) atom->x[0];
+  const auto * _noalias const sp = (dbl4_t *) atom->sp[0];
+  auto * _noalias const f = (dbl3_t *) thr->get_f()[0];
+  auto * _noalias const fm = (dbl3_t *) atom->fm[0];
+  const int * _noalias const type = atom->type;
+  const int nlocal = atom->nlocal;
+
+  ilist = list->ilist;
+  numneigh = list->numneigh;
+  firstneigh = list->firstneigh;
+
+  // pair forces and energies of the neighbors of one atom
+
+  maxj_thr = 1;
+  for (ii = iifrom; ii < iito; ++ii)
+    if (numneigh[ilist[ii]] > maxj_thr) maxj_thr = numneigh[ilist[ii]];
+  memory->create(fpair_thr,4,maxj_thr,"pair_thr:fpair_thr");
+  double * _noalias const fxj = fpair_thr[0];
+  double * _noalias const fyj = fpair_thr[1];
+  double * _noalias const fzj = fpair_thr[2];
+  double * _noalias const ej = fpair_thr[3];
+
+  // loop over neighbors of my atoms
+
+  for (ii = iifrom; ii < iito; ++ii) {
+
+    i = ilist[ii];
+    xtmp = x[i].x;
+    ytmp = x[i].y;
+    ztmp = x[i].z;
+    spix = sp[i].x;
+    spiy = sp[i].y;
+    spiz = sp[i].z;
+    itype = type[i];
+    jlist = firstneigh[i];
+    jnum = numneigh[i];
+
+    const double * _noalias const cut_i = cut_spin_dmi[itype];
+    const double * _noalias const v_dmx_i = v_dmx[itype];
+    const double * _noalias const v_dmy_i = v_dmy[itype];
+    const double * _noalias const v_dmz_i = v_dmz[itype];
+    const double * _noalias const vmech_dmx_i = vmech_dmx[itype];
+    const double * _noalias const vmech_dmy_i = vmech_dmy[itype];
+    const double * _noalias const vmech_dmz_i = vmech_dmz[itype];
+
+    fxtmp = fytmp = fztmp = 0.0;
+    fmx = fmy = fmz = 0.0;
+    emtmp = 0.0;
+
+#if defined(_OPENMP)
+#pragma omp simd reduction(+:fxtmp,fytmp,fztmp,fmx,fmy,fmz,emtmp)
+#endif
+    for (jj = 0; jj < jnum; jj++) {
+      const int j = jlist[jj] & NEIGHMASK;
+      const int jtype = type[j];
+
+      const double delx = xtmp - x[j].x;
+      const double dely = ytmp - x[j].y;
+      const double delz = ztmp - x[j].z;
+      const double rsq = delx*delx + dely*dely + delz*delz;
+
+      // a zero inverse distance beyond the cutoff zeroes all terms
+
+      const double inside = (rsq <= cut_i[jtype]*cut_i[jtype]) ? 1.0 : 0.0;
+
+      const double spjx = sp[j].x;
+      const double spjy = sp[j].y;
+      const double spjz = sp[j].z;
+
+      const double inorm = inside/sqrt(rsq);
+      const double eijx = -inorm*delx;
+      const double eijy = -inorm*dely;
+      const double eijz = -inorm*delz;
+
+      double dmix = eijy*v_dmz_i[jtype] - eijz*v_dmy_i[jtype];
+      double dmiy = eijz*v_dmx_i[jtype] - eijx*v_dmz_i[jtype];
+      double dmiz = eijx*v_dmy_i[jtype] - eijy*v_dmx_i[jtype];
+
+      const double fmix = -(dmiy*spjz - dmiz*spjy);
+      const double fmiy = -(dmiz*spjx - dmix*spjz);
+      const double fmiz = -(dmix*spjy - dmiy*spjx);
+      fmx += fmix;
+      fmy += fmiy;
+      fmz += fmiz;
+
+      double fx = 0.0, fy = 0.0, fz = 0.0;
+      if (LATTICE) {
+        dmix = vmech_dmx_i[jtype];
+        dmiy = vmech_dmy_i[jtype];
+        dmiz = vmech_dmz_i[jtype];
+
+        const double csx = (spiy*spjz - spiz*spjy);
+        const double csy = (spiz*spjx - spix*spjz);
+        const double csz = (spix*spjy - spiy*spjx);
+
+        // same components as compute_dmi_mech()
+
+        const double fpair = 0.5*inorm;
+        fx = fpair*(dmiy*csz - dmiz*csy);
+        fy = fpair*(dmiz*csx - dmix*csz);
+        fz = fpair*(dmix*csy - dmiy*csz);
+        fxtmp += fx;
+        fytmp += fy;
+        fztmp += fz;
+      }
+
+      double evdwl = 0.0;
+      if (EFLAG) {
+        evdwl = -(spix*fmix + spiy*fmiy + spiz*fmiz);
+        evdwl *= 0.5*hbar;
+        emtmp += evdwl;
+      }
+
+      if (LATTICE || EVFLAG) {
+        fxj[jj] = fx;
+        fyj[jj] = fy;
+        fzj[jj] = fz;
+        ej[jj] = evdwl;
+      }
+    }
+
+    if (LATTICE || EVFLAG) {
+      for (jj = 0; jj < jnum; jj++) {
+        const int j = jlist[jj] & NEIGHMASK;
+        if (LATTICE) {
+          f[j].x -= fxj[jj];
+          f[j].y -= fyj[jj];
+          f[j].z -= fzj[jj];
+        }
+
+        if (EVFLAG) {
+          const double delx = xtmp - x[j].x;
+          const double dely = ytmp - x[j].y;
+          const double delz = ztmp - x[j].z;
+          const double rsq = delx*delx + dely*dely + delz*delz;
+          const double cut = cut_i[type[j]];
+          if (rsq > cut*cut) continue;
+          ev_tally_xyz_thr(this,i,j,nlocal,/* newton_pair */ 1,
+                           ej[jj],0.0,fxj[jj],fyj[jj],fzj[jj],delx,dely,delz,thr);
+        }
+      }
+    }
+
+    f[i].x += fxtmp;
+    f[i].y += fytmp;
+    f[i].z += fztmp;
+    fm[i].x += fmx;
+    fm[i].y += fmy;
+    fm[i].z += fmz;
+    emag[i] = emtmp;
+  }
+
+  memory->destroy(fpair_thr);
+}
+
+/* ----------------------------------------------------------------------
+   frozen lattice, the dmi field of i is a sparse product of the
+   cached dmi vectors of its pairs with the neighbor spins
+------------------------------------------------------------------------- */
+
+template <int EVFLAG, int EFLAG>
+void PairSpinDmiOMP::eval_frozen(int iifrom, int iito, ThrData * const thr)
+{
+  int i,j,ii,kk,kfrom,kto;
+  double evdwl,fmix,fmiy,fmiz,fmx,fmy,fmz,emtmp;
+  double spix,spiy,spiz,spjx,spjy,spjz;
+
+  evdwl = 0.0;
+
+  const auto * _noalias const sp = (dbl4_t *) atom->sp[0];
+  auto * _noalias const fm = (dbl3_t *) atom->fm[0];
+  const int * _noalias const jp = jpair;
+  const dbl3_t * _noalias const dmi = (dbl3_t *) pcoeff;
+  const int nlocal = atom->nlocal;
+  const int * const ilist = list->ilist;
+
+  for (ii = iifrom; ii < iito; ++ii) {
+
+    i = ilist[ii];
+    spix = sp[i].x;
+    spiy = sp[i].y;
+    spiz = sp[i].z;
+    kfrom = firstpair[i];
+    kto = kfrom + numpair[i];
+
+    fmx = fmy = fmz = 0.0;
+    emtmp = 0.0;
+
+    for (kk = kfrom; kk < kto; kk++) {
+      j = jp[kk];
+      spjx = sp[j].x;
+      spjy = sp[j].y;
+      spjz = sp[j].z;
+
+      fmix = -(dmi[kk].y*spjz - dmi[kk].z*spjy);
+      fmiy = -(dmi[kk].z*spjx - dmi[kk].x*spjz);
+      fmiz = -(dmi[kk].x*spjy - dmi[kk].y*spjx);
+      fmx += fmix;
+      fmy += fmiy;
+      fmz += fmiz;
+
+      if (EFLAG) {
+        evdwl = -(spix*fmix + spiy*fmiy + spiz*fmiz);
+        evdwl *= 0.5*hbar;
+        emtmp += evdwl;
+      }
+
+      if (EVFLAG) ev_tally_xyz_thr(this,i,j,nlocal,/* newton_pair */ 1,
+                                   evdwl,0.0,0.0,0.0,0.0,0.0,0.0,0.0,thr);
+    }
+    fm[i].x += fmx;
+    fm[i].y += fmy;
+    fm[i].z += fmz;
+    emag[i] = emtmp;
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+
+double PairSpinDmiOMP::memory_usage()
+{
+  double bytes = memory_usage_thr();
+  bytes += PairSpinDmi::memory_usage();
+
+  return bytes;
+}
@@ -0,0 +1,285 @@
+// clang-format off
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   https://www.lammps.org/, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   This software is distributed under the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#include "pair_spin_exchange_biquadratic_omp.h"
+
+#include "atom.h"
+#include "comm.h"
+#include "error.h"
+#include "force.h"
+#include "memory.h"
+#include "neigh_list.h"
+#include "suffix.h"
+
+#include <cmath>
+
+#include "omp_compat.h"
+using namespace LAMMPS_NS;
+
+/* ---------------------------------------------------------------------- */
+
+PairSpinExchangeBiquadraticOMP::PairSpinExchangeBiquadraticOMP(LAMMPS *lmp) :
+  PairSpinExchangeBiquadratic(lmp), ThrOMP(lmp, THR_PAIR)
+{
+  suffix_flag |= Suffix::OMP;
+  respa_enable = 0;
+}
+
+/* ---------------------------------------------------------------------- */
+
+void PairSpinExchangeBiquadraticOMP::compute(int eflag, int vflag)
+{
+  ev_init(eflag,vflag);
+
+  const int nall = atom->nlocal + atom->nghost;
+  const int nthreads = comm->nthreads;
+  const int inum = list->inum;
+
+  if (e_offset != 0 && e_offset != 1)
+    error->all(FLERR,"Illegal option in pair exchange/biquadratic command");
+
+  // grow emag before the threads fill it
+
+  if (nlocal_max < atom->nlocal) {
+    nlocal_max = atom->nlocal;
+    memory->grow(emag,nlocal_max,"pair/spin:emag");
+  }
+
+#if defined(_OPENMP)
+#pragma omp parallel LMP_DEFAULT_NONE LMP_SHARED(eflag,vflag)
+#endif
+  {
+    int ifrom, ito, tid;
+
+    loop_setup_thr(ifrom, ito, tid, inum, nthreads);
+    ThrData *thr = fix->get_thr(tid);
+    thr->timer(Timer::START);
+    ev_setup_thr(eflag, vflag, nall, eatom, vatom, nullptr, thr);
+
+    if (evflag) {
+      if (eflag) {
+        if (lattice_flag) eval<1,1,1>(ifrom, ito, thr);
+        else eval<1,1,0>(ifrom, ito, thr);
+      } else {
+        if (lattice_flag) eval<1,0,1>(ifrom, ito, thr);
+        else eval<1,0,0>(ifrom, ito, thr);
+      }
+    } else {
+      if (lattice_flag) eval<0,0,1>(ifrom, ito, thr);
+      else eval<0,0,0>(ifrom, ito, thr);
+    }
+
+    thr->timer(Timer::PAIR);
+    reduce_thr(this, eflag, vflag, thr);
+  } // end of omp parallel region
+}
+
+/* ----------------------------------------------------------------------
+   the neighbor list is full and newton pair is on, so fm[i] and emag[i]
+   of an owned atom i are only written by the thread owning i.
+   the coefficients of the type pairs of i are hoisted out of the
+   neighbor loop, and the kernels of compute_exchange(),
+   compute_exchange_mech() and compute_energy() are inlined.
+   as in spin/exchange/omp, the omp simd loop masks the pairs beyond
+   the cutoff and a second loop applies the stored pair forces to j.
+------------------------------------------------------------------------- */
+
+template <int EVFLAG, int EFLAG, int LATTICE>
+void PairSpinExchangeBiquadraticOMP::eval(int iifrom, int iito, ThrData * const thr)
+{
+  int i,ii,jj,jnum,itype,maxj_thr;
+  double xtmp,ytmp,ztmp,fxtmp,fytmp,fztmp,fmx,fmy,fmz,emtmp;
+  double spix,spiy,spiz;
+  double **fpair_thr;
+  int *ilist,*jlist,*numneigh,**firstneigh;
+
+  const auto * _noalias const x = (dbl3_t *) atom->x[0];
+  const auto * _noalias const sp = (dbl4_t *) atom->sp[0];
+  auto * _noalias const f = (dbl3_t *) thr->get_f()[0];
+  auto * _noalias const fm = (dbl3_t *) atom->fm[0];
+  const int * _noalias const type = atom->type;
+  const int nlocal = atom->nlocal;
+  const double offset = (e_offset == 1) ? 1.0 : 0.0;
+
+  ilist = list->ilist;
+  numneigh = list->numneigh;
+  firstneigh = list->firstneigh;
+
+  // pair forces and energies of the neighbors of one atom
+
+  maxj_thr = 1;
+  for (ii = iifrom; ii < iito; ++ii)
+    if (numneigh[ilist[ii]] > maxj_thr) maxj_thr = numneigh[ilist[ii]];
+  memory->create(fpair_thr,4,maxj_thr,"pair_thr:fpair_thr");
+  double * _noalias const fxj = fpair_thr[0];
+  double * _noalias const fyj = fpair_thr[1];
+  double * _noalias const fzj = fpair_thr[2];
+  double * _noalias const ej = fpair_thr[3];
+
+  // loop over neighbors of my atoms
+
+  for (ii = iifrom; ii < iito; ++ii) {
+
+    i = ilist[ii];
+    xtmp = x[i].x;
+    ytmp = x[i].y;
+    ztmp = x[i].z;
+    spix = sp[i].x;
+    spiy = sp[i].y;
+    spiz = sp[i].z;
+    itype = type[i];
+    jlist = firstneigh[i];
+    jnum = numneigh[i];
+
+    const double * _noalias const cut_i = cut_spin_exchange[itype];
+    const double * _noalias const J1_mag_i = J1_mag[itype];
+    const double * _noalias const J1_mech_i = J1_mech[itype];
+    const double * _noalias const J2_i = J2[itype];
+    const double * _noalias const J3_i = J3[itype];
+    const double * _noalias const K1_mag_i = K1_mag[itype];
+    const double * _noalias const K1_mech_i = K1_mech[itype];
+    const double * _noalias const K2_i = K2[itype];
+    const double * _noalias const K3_i = K3[itype];
+
+    fxtmp = fytmp = fztmp = 0.0;
+    fmx = fmy = fmz = 0.0;
+    emtmp = 0.0;
+
+#if defined(_OPENMP)
+#pragma omp simd reduction(+:fxtmp,fytmp,fztmp,fmx,fmy,fmz,emtmp)
+#endif
+    for (jj = 0; jj < jnum; jj++) {
+      const int j = jlist[jj] & NEIGHMASK;
+      const int jtype = type[j];
+
+      const double delx = xtmp - x[j].x;
+      const double dely = ytmp - x[j].y;
+      const double delz = ztmp - x[j].z;
+      const double rsq = delx*delx + dely*dely + delz*delz;
+
+      // pairs beyond the cutoff contribute zero
+
+      const double inside = (rsq <= cut_i[jtype]*cut_i[jtype]) ? 1.0 : 0.0;
+
+      const double spjx = sp[j].x;
+      const double spjy = sp[j].y;
+      const double spjz = sp[j].z;
+      const double sdots = spix*spjx + spiy*spjy + spiz*spjz;
+
+      const double r2j = rsq/J3_i[jtype]/J3_i[jtype];
+      const double r2k = rsq/K3_i[jtype]/K3_i[jtype];
+      const double exj = inside*exp(-r2j);
+      const double exk = inside*exp(-r2k);
+
+      double Jex = 4.0*J1_mag_i[jtype]*r2j;
+      Jex *= (1.0-J2_i[jtype]*r2j);
+      Jex *= exj;
+
+      double Kex = 4.0*K1_mag_i[jtype]*r2k;
+      Kex *= (1.0-K2_i[jtype]*r2k);
+      Kex *= exk;
+
+      fmx += (Jex*spjx + 2.0*Kex*spjx*sdots);
+      fmy += (Jex*spjy + 2.0*Kex*spjy*sdots);
+      fmz += (Jex*spjz + 2.0*Kex*spjz*sdots);
+
+      double fx = 0.0, fy = 0.0, fz = 0.0;
+      if (LATTICE) {
+        const double r = sqrt(rsq);
+        const double inorm = 1.0/r;
+        const double iJ3 = 1.0/(J3_i[jtype]*J3_i[jtype]);
+        const double iK3 = 1.0/(K3_i[jtype]*K3_i[jtype]);
+        const double rja = rsq*iJ3;
+        const double rka = rsq*iK3;
+
+        double Jex_mech = 1.0-rja-J2_i[jtype]*rja*(2.0-rja);
+        Jex_mech *= 8.0*J1_mech_i[jtype]*r*iJ3*exp(-rja);
+
+        double Kex_mech = 1.0-rka-K2_i[jtype]*rka*(2.0-rka);
+        Kex_mech *= 8.0*K1_mech_i[jtype]*r*iK3*exp(-rka);
+
+        // fi = -0.5*(...)*eij with eij = -del/r
+
+        double fpair = Jex_mech*(sdots-offset) + Kex_mech*(sdots*sdots-offset);
+        fpair *= 0.5*inside*inorm;
+        fx = fpair*delx;
+        fy = fpair*dely;
+        fz = fpair*delz;
+        fxtmp += fx;
+        fytmp += fy;
+        fztmp += fz;
+      }
+
+      double evdwl = 0.0;
+      if (EFLAG) {
+        Jex = 4.0*J1_mech_i[jtype]*r2j;
+        Jex *= (1.0-J2_i[jtype]*r2j);
+        Jex *= exj;
+
+        Kex = 4.0*K1_mech_i[jtype]*r2k;
+        Kex *= (1.0-K2_i[jtype]*r2k);
+        Kex *= exk;
+
+        evdwl = -0.5*(Jex*(sdots-offset) + Kex*(sdots*sdots-offset));
+        emtmp += evdwl;
+      }
+
+      if (LATTICE || EVFLAG) {
+        fxj[jj] = fx;
+        fyj[jj] = fy;
+        fzj[jj] = fz;
+        ej[jj] = evdwl;
+      }
+    }
+
+    if (LATTICE || EVFLAG) {
+      for (jj = 0; jj < jnum; jj++) {
+        const int j = jlist[jj] & NEIGHMASK;
+        if (LATTICE) {
+          f[j].x -= fxj[jj];
+          f[j].y -= fyj[jj];
+          f[j].z -= fzj[jj];
+        }
+
+        if (EVFLAG) {
+          const double delx = xtmp - x[j].x;
+          const double dely = ytmp - x[j].y;
+          const double delz = ztmp - x[j].z;
+          const double rsq = delx*delx + dely*dely + delz*delz;
+          const double cut = cut_i[type[j]];
+          if (rsq > cut*cut) continue;
+          ev_tally_xyz_thr(this,i,j,nlocal,/* newton_pair */ 1,
+                           ej[jj],0.0,fxj[jj],fyj[jj],fzj[jj],delx,dely,delz,thr);
+        }
+      }
+    }
+
+    f[i].x += fxtmp;
+    f[i].y += fytmp;
+    f[i].z += fztmp;
+    fm[i].x += fmx;
+    fm[i].y += fmy;
+    fm[i].z += fmz;
+    emag[i] = emtmp;
+  }
+
+  memory->destroy(fpair_thr);
+}
+
+/* ---------------------------------------------------------------------- */
+
+double PairSpinExchangeBiquadraticOMP::memory_usage()
+{
+  double bytes = memory_usage_thr();
+  bytes += PairSpinExchangeBiquadratic::memory_usage();
+
+  return bytes;
+}
@@ -0,0 +1,265 @@
+// clang-format off
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   https://www.lammps.org/, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   This software is distributed under the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#include "pair_spin_magelec_omp.h"
+
+#include "atom.h"
+#include "comm.h"
+#include "force.h"
+#include "memory.h"
+#include "neigh_list.h"
+#include "suffix.h"
+
+#include <cmath>
+
+#include "omp_compat.h"
+using namespace LAMMPS_NS;
+
+/* ---------------------------------------------------------------------- */
+
+PairSpinMagelecOMP::PairSpinMagelecOMP(LAMMPS *lmp) :
+  PairSpinMagelec(lmp), ThrOMP(lmp, THR_PAIR)
+{
+  suffix_flag |= Suffix::OMP;
+  respa_enable = 0;
+}
+
+/* ---------------------------------------------------------------------- */
+
+void PairSpinMagelecOMP::compute(int eflag, int vflag)
+{
+  ev_init(eflag,vflag);
+
+  const int nall = atom->nlocal + atom->nghost;
+  const int nthreads = comm->nthreads;
+  const int inum = list->inum;
+
+  // grow emag before the threads fill it
+
+  if (nlocal_max < atom->nlocal) {
+    nlocal_max = atom->nlocal;
+    memory->grow(emag,nlocal_max,"pair/spin:emag");
+  }
+
+#if defined(_OPENMP)
+#pragma omp parallel LMP_DEFAULT_NONE LMP_SHARED(eflag,vflag)
+#endif
+  {
+    int ifrom, ito, tid;
+
+    loop_setup_thr(ifrom, ito, tid, inum, nthreads);
+    ThrData *thr = fix->get_thr(tid);
+    thr->timer(Timer::START);
+    ev_setup_thr(eflag, vflag, nall, eatom, vatom, nullptr, thr);
+
+    if (evflag) {
+      if (eflag) {
+        if (lattice_flag) eval<1,1,1>(ifrom, ito, thr);
+        else eval<1,1,0>(ifrom, ito, thr);
+      } else {
+        if (lattice_flag) eval<1,0,1>(ifrom, ito, thr);
+        else eval<1,0,0>(ifrom, ito, thr);
+      }
+    } else {
+      if (lattice_flag) eval<0,0,1>(ifrom, ito, thr);
+      else eval<0,0,0>(ifrom, ito, thr);
+    }
+
+    thr->timer(Timer::PAIR);
+    reduce_thr(this, eflag, vflag, thr);
+  } // end of omp parallel region
+}
+
+/* ----------------------------------------------------------------------
+   the neighbor list is full and newton pair is on, so fm[i] and emag[i]
+   of an owned atom i are only written by the thread owning i.
+   the magneto-electric coefficients of the type pairs of i are hoisted
+   out of the neighbor loop, and compute_magelec() and
+   compute_magelec_mech() are inlined.
+   the omp simd loop masks the pairs beyond the cutoff and only
+   accumulates into i, the pair forces it stores are subtracted from j
+   and tallied in a second loop.
+------------------------------------------------------------------------- */
+
+template <int EVFLAG, int EFLAG, int LATTICE>
+void PairSpinMagelecOMP::eval(int iifrom, int iito, ThrData * const thr)
+{
+  int i,ii,jj,jnum,itype,maxj_thr;
+  double xtmp,ytmp,ztmp,fxtmp,fytmp,fztmp,fmx,fmy,fmz,emtmp;
+  double spix,spiy,spiz;
+  double **fpair_thr;
+  int *ilist,*jlist,*numneigh,**firstneigh;
+
+  const auto * _noalias const x = (dbl3_t *) atom->x[0];
+  const auto * _noalias const sp = (dbl4_t *) atom->sp[0];
+  auto * _noalias const f = (dbl3_t *) thr->get_f()[0];
+  auto * _noalias const fm = (dbl3_t *) atom->fm[0];
+  const int * _noalias const type = atom->type;
+  const int nlocal = atom->nlocal;
+
+  ilist = list->ilist;
+  numneigh = list->numneigh;
+  firstneigh = list->firstneigh;
+
+  // pair forces and energies of the neighbors of one atom
+
+  maxj_thr = 1;
+  for (ii = iifrom; ii < iito; ++ii)
+    if (numneigh[ilist[ii]] > maxj_thr) maxj_thr = numneigh[ilist[ii]];
+  memory->create(fpair_thr,4,maxj_thr,"pair_thr:fpair_thr");
+  double * _noalias const fxj = fpair_thr[0];
+  double * _noalias const fyj = fpair_thr[1];
+  double * _noalias const fzj = fpair_thr[2];
+  double * _noalias const ej = fpair_thr[3];
+
+  // loop over neighbors of my atoms
+
+  for (ii = iifrom; ii < iito; ++ii) {
+
+    i = ilist[ii];
+    xtmp = x[i].x;
+    ytmp = x[i].y;
+    ztmp = x[i].z;
+    spix = sp[i].x;
+    spiy = sp[i].y;
+    spiz = sp[i].z;
+    itype = type[i];
+    jlist = firstneigh[i];
+    jnum = numneigh[i];
+
+    const double * _noalias const cut_i = cut_spin_magelec[itype];
+    const double * _noalias const ME_i = ME[itype];
+    const double * _noalias const ME_mech_i = ME_mech[itype];
+    const double * _noalias const v_mex_i = v_mex[itype];
+    const double * _noalias const v_mey_i = v_mey[itype];
+    const double * _noalias const v_mez_i = v_mez[itype];
+
+    fxtmp = fytmp = fztmp = 0.0;
+    fmx = fmy = fmz = 0.0;
+    emtmp = 0.0;
+
+#if defined(_OPENMP)
+#pragma omp simd reduction(+:fxtmp,fytmp,fztmp,fmx,fmy,fmz,emtmp)
+#endif
+    for (jj = 0; jj < jnum; jj++) {
+      const int j = jlist[jj] & NEIGHMASK;
+      const int jtype = type[j];
+
+      const double delx = xtmp - x[j].x;
+      const double dely = ytmp - x[j].y;
+      const double delz = ztmp - x[j].z;
+      const double rsq = delx*delx + dely*dely + delz*delz;
+
+      // pairs beyond the cutoff get zero coupling constants
+
+      const double inside = (rsq <= cut_i[jtype]*cut_i[jtype]) ? 1.0 : 0.0;
+
+      const double spjx = sp[j].x;
+      const double spjy = sp[j].y;
+      const double spjz = sp[j].z;
+
+      const double inorm = 1.0/sqrt(rsq);
+      const double eijx = -inorm*delx;
+      const double eijy = -inorm*dely;
+      const double eijz = -inorm*delz;
+
+      const double vx = v_mex_i[jtype];
+      const double vy = v_mey_i[jtype];
+      const double vz = v_mez_i[jtype];
+      const double me = inside*ME_i[jtype];
+
+      double mex = (vy*eijz - vz*eijy)*me;
+      double mey = (vz*eijx - vx*eijz)*me;
+      double mez = (vx*eijy - vy*eijx)*me;
+
+      const double fmix = spjy*mez - spjz*mey;
+      const double fmiy = spjz*mex - spjx*mez;
+      const double fmiz = spjx*mey - spjy*mex;
+      fmx += fmix;
+      fmy += fmiy;
+      fmz += fmiz;
+
+      double fx = 0.0, fy = 0.0, fz = 0.0;
+      if (LATTICE) {
+
+        // same components as compute_magelec_mech()
+
+        const double me_mech = inside*ME_mech_i[jtype];
+        mex = (spiy*spiz - spiz*spjy)*me_mech;
+        mey = (spiz*spix - spix*spjz)*me_mech;
+        mez = (spix*spiy - spiy*spjx)*me_mech;
+
+        fx = 0.5*(mey*vz - mez*vy);
+        fy = 0.5*(mez*vx - mex*vz);
+        fz = 0.5*(mex*vy - mey*vx);
+        fxtmp += fx;
+        fytmp += fy;
+        fztmp += fz;
+      }
+
+      double evdwl = 0.0;
+      if (EFLAG) {
+        evdwl = -(spix*fmix + spiy*fmiy + spiz*fmiz);
+        evdwl *= 0.5*hbar;
+        emtmp += evdwl;
+      }
+
+      if (LATTICE || EVFLAG) {
+        fxj[jj] = fx;
+        fyj[jj] = fy;
+        fzj[jj] = fz;
+        ej[jj] = evdwl;
+      }
+    }
+
+    if (LATTICE || EVFLAG) {
+      for (jj = 0; jj < jnum; jj++) {
+        const int j = jlist[jj] & NEIGHMASK;
+        if (LATTICE) {
+          f[j].x -= fxj[jj];
+          f[j].y -= fyj[jj];
+          f[j].z -= fzj[jj];
+        }
+
+        if (EVFLAG) {
+          const double delx = xtmp - x[j].x;
+          const double dely = ytmp - x[j].y;
+          const double delz = ztmp - x[j].z;
+          const double rsq = delx*delx + dely*dely + delz*delz;
+          const double cut = cut_i[type[j]];
+          if (rsq > cut*cut) continue;
+          ev_tally_xyz_thr(this,i,j,nlocal,/* newton_pair */ 1,
+                           ej[jj],0.0,fxj[jj],fyj[jj],fzj[jj],delx,dely,delz,thr);
+        }
+      }
+    }
+
+    f[i].x += fxtmp;
+    f[i].y += fytmp;
+    f[i].z += fztmp;
+    fm[i].x += fmx;
+    fm[i].y += fmy;
+    fm[i].z += fmz;
+    emag[i] = emtmp;
+  }
+
+  memory->destroy(fpair_thr);
+}
+
+/* ---------------------------------------------------------------------- */
+
+double PairSpinMagelecOMP::memory_usage()
+{
+  double bytes = memory_usage_thr();
+  bytes += PairSpinMagelec::memory_usage();
+
+  return bytes;
+}
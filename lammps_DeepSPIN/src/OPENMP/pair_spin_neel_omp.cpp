@@ -0,0 +1,400 @@
+// clang-format off
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   https://www.lammps.org/, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   This software is distributed under the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#include "pair_spin_neel_omp.h"
+
+#include "atom.h"
+#include "comm.h"
+#include "force.h"
+#include "memory.h"
+#include "neigh_list.h"
+#include "suffix.h"
+
+#include <cmath>
+
+#include "omp_compat.h"
+using namespace LAMMPS_NS;
+
+/* ---------------------------------------------------------------------- */
+
+PairSpinNeelOMP::PairSpinNeelOMP(LAMMPS *lmp) :
+  PairSpinNeel(lmp), ThrOMP(lmp, THR_PAIR)
+{
+  suffix_flag |= Suffix::OMP;
+  respa_enable = 0;
+}
+
+/* ---------------------------------------------------------------------- */
+
+void PairSpinNeelOMP::compute(int eflag, int vflag)
+{
+  ev_init(eflag,vflag);
+
+  const int nall = atom->nlocal + atom->nghost;
+  const int nthreads = comm->nthreads;
+  const int inum = list->inum;
+
+  // grow emag before the threads fill it
+
+  if (nlocal_max < atom->nlocal) {
+    nlocal_max = atom->nlocal;
+    memory->grow(emag,nlocal_max,"pair/spin:emag");
+  }
+
+#if defined(_OPENMP)
+#pragma omp parallel LMP_DEFAULT_NONE LMP_SHARED(eflag,vflag)
+#endif
+  {
+    int ifrom, ito, tid;
+
+    loop_setup_thr(ifrom, ito, tid, inum, nthreads);
+    ThrData *thr = fix->get_thr(tid);
+    thr->timer(Timer::START);
+    ev_setup_thr(eflag, vflag, nall, eatom, vatom, nullptr, thr);
+
+    if (evflag) {
+      if (eflag) {
+        if (lattice_flag) eval<1,1,1>(ifrom, ito, thr);
+        else eval<1,1,0>(ifrom, ito, thr);
+      } else {
+        if (lattice_flag) eval<1,0,1>(ifrom, ito, thr);
+        else eval<1,0,0>(ifrom, ito, thr);
+      }
+    } else {
+      if (lattice_flag) eval<0,0,1>(ifrom, ito, thr);
+      else eval<0,0,0>(ifrom, ito, thr);
+    }
+
+    thr->timer(Timer::PAIR);
+    reduce_thr(this, eflag, vflag, thr);
+  } // end of omp parallel region
+}
+
+/* ----------------------------------------------------------------------
+   the neighbor list is full and newton pair is on, so fm[i] and emag[i]
+   of an owned atom i are only written by the thread owning i.
+   the neel coefficients of the type pairs of i are hoisted out of the
+   neighbor loop, and compute_neel(), compute_neel_mech() and
+   compute_neel_energy() are inlined, sharing the scalar products.
+   the gaussian factors of the pairs beyond the cutoff are zeroed, so
+   the loop over j has no branch and only accumulates into i, and is an
+   omp simd loop. a second loop applies the stored pair forces to j.
+------------------------------------------------------------------------- */
+
+template <int EVFLAG, int EFLAG, int LATTICE>
+void PairSpinNeelOMP::eval(int iifrom, int iito, ThrData * const thr)
+{
+  int i,ii,jj,jnum,itype,maxj_thr;
+  double xtmp,ytmp,ztmp,spi[3];
+  double fxtmp,fytmp,fztmp,fmx,fmy,fmz,emtmp;
+  double **fpair_thr;
+  int *ilist,*jlist,*numneigh,**firstneigh;
+
+  const auto * _noalias const x = (dbl3_t *) atom->x[0];
+  const auto * _noalias const sp = (dbl4_t *) atom->sp[0];
+  auto * _noalias const f = (dbl3_t *) thr->get_f()[0];
+  auto * _noalias const fm = (dbl3_t *) atom->fm[0];
+  const int * _noalias const type = atom->type;
+  const int nlocal = atom->nlocal;
+
+  ilist = list->ilist;
+  numneigh = list->numneigh;
+  firstneigh = list->firstneigh;
+
+  // pair forces and energies of the neighbors of one atom
+
+  maxj_thr = 1;
+  for (ii = iifrom; ii < iito; ++ii)
+    if (numneigh[ilist[ii]] > maxj_thr) maxj_thr = numneigh[ilist[ii]];
+  memory->create(fpair_thr,4,maxj_thr,"pair_thr:fpair_thr");
+  double * _noalias const fxj = fpair_thr[0];
+  double * _noalias const fyj = fpair_thr[1];
+  double * _noalias const fzj = fpair_thr[2];
+  double * _noalias const ej = fpair_thr[3];
+
+  // loop over neighbors of my atoms
+
+  for (ii = iifrom; ii < iito; ++ii) {
+
+    i = ilist[ii];
+    xtmp = x[i].x;
+    ytmp = x[i].y;
+    ztmp = x[i].z;
+    spi[0] = sp[i].x;
+    spi[1] = sp[i].y;
+    spi[2] = sp[i].z;
+    itype = type[i];
+    jlist = firstneigh[i];
+    jnum = numneigh[i];
+
+    const double * _noalias const cut_i = cut_spin_neel[itype];
+    const double * _noalias const g1_i = g1[itype];
+    const double * _noalias const g1_mech_i = g1_mech[itype];
+    const double * _noalias const g2_i = g2[itype];
+    const double * _noalias const g3_i = g3[itype];
+    const double * _noalias const q1_i = q1[itype];
+    const double * _noalias const q1_mech_i = q1_mech[itype];
+    const double * _noalias const q2_i = q2[itype];
+    const double * _noalias const q3_i = q3[itype];
+
+    fxtmp = fytmp = fztmp = 0.0;
+    fmx = fmy = fmz = 0.0;
+    emtmp = 0.0;
+
+#if defined(_OPENMP)
+#pragma omp simd reduction(+:fxtmp,fytmp,fztmp,fmx,fmy,fmz,emtmp)
+#endif
+    for (jj = 0; jj < jnum; jj++) {
+      const int j = jlist[jj] & NEIGHMASK;
+      const int jtype = type[j];
+      double rij[3],eij[3],spj[3];
+
+      rij[0] = x[j].x - xtmp;
+      rij[1] = x[j].y - ytmp;
+      rij[2] = x[j].z - ztmp;
+      const double rsq = rij[0]*rij[0] + rij[1]*rij[1] + rij[2]*rij[2];
+      const double inside = (rsq <= cut_i[jtype]*cut_i[jtype]) ? 1.0 : 0.0;
+
+      spj[0] = sp[j].x;
+      spj[1] = sp[j].y;
+      spj[2] = sp[j].z;
+
+      const double drij = sqrt(rsq);
+      const double inorm = 1.0/drij;
+      eij[0] = rij[0]*inorm;
+      eij[1] = rij[1]*inorm;
+      eij[2] = rij[2]*inorm;
+
+      const double eij_si = eij[0]*spi[0] + eij[1]*spi[1] + eij[2]*spi[2];
+      const double eij_sj = eij[0]*spj[0] + eij[1]*spj[1] + eij[2]*spj[2];
+      const double si_sj = spi[0]*spj[0] + spi[1]*spj[1] + spi[2]*spj[2];
+      const double eij_si_2 = eij_si*eij_si;
+      const double eij_sj_2 = eij_sj*eij_sj;
+      const double eij_si_3 = eij_si*eij_si_2;
+      const double eij_sj_3 = eij_sj*eij_sj_2;
+
+      // neel's functions, as in compute_neel()
+      // pairs beyond the cutoff get zero gaussian factors
+
+      const double rag = rsq/g3_i[jtype]/g3_i[jtype];
+      const double exg = inside*exp(-rag);
+      double gr = 4.0*g1_i[jtype]*rag;
+      gr *= (1.0-g2_i[jtype]*rag);
+      gr *= exg;
+
+      const double raq = rsq/q3_i[jtype]/q3_i[jtype];
+      const double exq = inside*exp(-raq);
+      double qr = 4.0*q1_i[jtype]*raq;
+      qr *= (1.0-q2_i[jtype]*raq);
+      qr *= exq;
+
+      double g1r = (gr + 12.0*qr/35.0);
+      double q1r = 9.0*qr/5.0;
+      double q2r = -2.0*qr/5.0;
+
+      // pseudo-dipolar component
+
+      double pdx = g1r*(eij_sj*eij[0] - spj[0]/3.0);
+      double pdy = g1r*(eij_sj*eij[1] - spj[1]/3.0);
+      double pdz = g1r*(eij_sj*eij[2] - spj[2]/3.0);
+
+      // pseudo-quadrupolar components
+
+      double pq1x = -(eij_si_2 - si_sj/3.0)*spj[0]/3.0;
+      double pq1y = -(eij_si_2 - si_sj/3.0)*spj[1]/3.0;
+      double pq1z = -(eij_si_2 - si_sj/3.0)*spj[2]/3.0;
+
+      pq1x += (eij_sj_2-si_sj/3.0)*(2.0*eij_si*eij[0] - spj[0]/3.0);
+      pq1y += (eij_sj_2-si_sj/3.0)*(2.0*eij_si*eij[1] - spj[1]/3.0);
+      pq1z += (eij_sj_2-si_sj/3.0)*(2.0*eij_si*eij[2] - spj[2]/3.0);
+
+      pq1x *= q1r;
+      pq1y *= q1r;
+      pq1z *= q1r;
+
+      double pq2x = 3.0*eij_si_2*eij_sj*eij[0] + eij_sj_3*eij[0];
+      double pq2y = 3.0*eij_si_2*eij_sj*eij[1] + eij_sj_3*eij[1];
+      double pq2z = 3.0*eij_si_2*eij_sj*eij[2] + eij_sj_3*eij[2];
+
+      pq2x *= q2r;
+      pq2y *= q2r;
+      pq2z *= q2r;
+
+      fmx += pdx + pq1x + pq2x;
+      fmy += pdy + pq1y + pq2y;
+      fmz += pdz + pq1z + pq2z;
+
+      double fx = 0.0, fy = 0.0, fz = 0.0;
+      if (LATTICE) {
+
+        // pseudo-dipolar component, as in compute_neel_mech()
+
+        const double g_mech = inside*g1_mech_i[jtype];
+        const double ig3 = 1.0/(g3_i[jtype]*g3_i[jtype]);
+
+        double ra = rsq*ig3;
+        double rr = drij*ig3;
+
+        double gij = 4.0*g_mech*ra;
+        gij *= (1.0-g2_i[jtype]*ra);
+        gij *= exp(-ra);
+
+        double dgij = 1.0-ra-g2_i[jtype]*ra*(2.0-ra);
+        dgij *= 8.0*g_mech*rr*exp(-ra);
+
+        double pdt1 = (dgij-2.0*gij/drij)*eij_si*eij_sj;
+        pdt1 -= si_sj*dgij/3.0;
+        double pdt2 = eij_sj*gij/drij;
+        double pdt3 = eij_si*gij/drij;
+        pdx = -(pdt1*eij[0] + pdt2*spi[0] + pdt3*spj[0]);
+        pdy = -(pdt1*eij[1] + pdt2*spi[1] + pdt3*spj[1]);
+        pdz = -(pdt1*eij[2] + pdt2*spi[2] + pdt3*spj[2]);
+
+        // pseudo-quadrupolar component
+
+        const double q_mech = inside*q1_mech_i[jtype];
+        const double iq3 = 1.0/(q3_i[jtype]*q3_i[jtype]);
+
+        ra = rsq*iq3;
+        rr = drij*iq3;
+
+        double q1ij = 4.0*q_mech*ra;
+        q1ij *= (1.0-q2_i[jtype]*ra);
+        q1ij *= exp(-ra);
+        double q2ij = -2.0*q1ij/9.0;
+
+        double dq1ij = 1.0-ra-q2_i[jtype]*ra*(2.0-ra);
+        dq1ij *= 8.0*q_mech*rr*exp(-ra);
+        double dq2ij = -2.0*dq1ij/9.0;
+
+        double pqt1 = eij_si_2 - si_sj/3.0;
+        double pqt2 = eij_sj_2 - si_sj/3.0;
+        pq1x = dq1ij * pqt1 * pqt2 * eij[0];
+        pq1y = dq1ij * pqt1 * pqt2 * eij[1];
+        pq1z = dq1ij * pqt1 * pqt2 * eij[2];
+
+        const double si_sj_2 = si_sj*si_sj;
+        double pqt3 = 2.0*eij_si*(eij_sj_2-si_sj/3.0)/drij;
+        double pqt4 = 2.0*eij_sj*(eij_si_2-si_sj/3.0)/drij;
+        pq1x += q1ij*(pqt3*spi[0] + pqt4*spj[0]);
+        pq1y += q1ij*(pqt3*spi[1] + pqt4*spj[1]);
+        pq1z += q1ij*(pqt3*spi[2] + pqt4*spj[2]);
+        double pqt7 = 4.0*eij_si_2*eij_sj_2/drij;
+        double pqt8 = 2.0*si_sj_2*eij_sj/(3.0*drij);
+        double pqt9 = 2.0*si_sj_2*eij_si/(3.0*drij);
+        pq1x -= q1ij*(pqt7 + pqt8 + pqt9)*eij[0];
+        pq1y -= q1ij*(pqt7 + pqt8 + pqt9)*eij[1];
+        pq1z -= q1ij*(pqt7 + pqt8 + pqt9)*eij[2];
+
+        double pqt10 = eij_sj*eij_si_3;
+        double pqt11 = eij_si*eij_sj_3;
+        pq2x = dq2ij*(pqt10 + pqt11)*eij[0];
+        pq2y = dq2ij*(pqt10 + pqt11)*eij[1];
+        pq2z = dq2ij*(pqt10 + pqt11)*eij[2];
+
+        double pqt12 = eij_si_3/drij;
+        double pqt13 = eij_sj_3/drij;
+        double pqt14 = 3.0*eij_sj*eij_si_2/drij;
+        double pqt15 = 3.0*eij_si*eij_sj_2/drij;
+        pq2x += q2ij*((pqt12+pqt15)*spj[0]+(pqt13+pqt14)*spi[0]);
+        pq2y += q2ij*((pqt12+pqt15)*spj[1]+(pqt13+pqt14)*spi[1]);
+        pq2z += q2ij*((pqt12+pqt15)*spj[2]+(pqt13+pqt14)*spi[2]);
+        double pqt16 = 4.0*eij_sj*eij_si_3/drij;
+        double pqt17 = 4.0*eij_si*eij_sj_3/drij;
+        pq2x -= q2ij*(pqt16 + pqt17)*eij[0];
+        pq2y -= q2ij*(pqt16 + pqt17)*eij[1];
+        pq2z -= q2ij*(pqt16 + pqt17)*eij[2];
+
+        fx = 0.5*(pdx + pq1x + pq2x);
+        fy = 0.5*(pdy + pq1y + pq2y);
+        fz = 0.5*(pdz + pq1z + pq2z);
+        fxtmp += fx;
+        fytmp += fy;
+        fztmp += fz;
+      }
+
+      double evdwl = 0.0;
+      if (EFLAG) {
+
+        // as in compute_neel_energy(), with the mechanical coefficients
+
+        gr = 4.0*g1_mech_i[jtype]*rag;
+        gr *= (1.0-g2_i[jtype]*rag);
+        gr *= exg;
+
+        qr = 4.0*q1_mech_i[jtype]*raq;
+        qr *= (1.0-q2_i[jtype]*raq);
+        qr *= exq;
+
+        g1r = (gr + 12.0*qr/35.0);
+        q1r = 9.0*qr/5.0;
+        q2r = -2.0*qr/5.0;
+
+        evdwl = g1r*(eij_si*eij_sj-si_sj/3.0);
+        evdwl += q1r*(eij_si_2-si_sj/3.0)*(eij_sj_2-si_sj/3.0);
+        evdwl += q2r*(eij_si*eij_sj_3+eij_sj*eij_si_3);
+        evdwl *= -0.5;
+        emtmp += evdwl;
+      }
+
+      if (LATTICE || EVFLAG) {
+        fxj[jj] = fx;
+        fyj[jj] = fy;
+        fzj[jj] = fz;
+        ej[jj] = evdwl;
+      }
+    }
+
+    if (LATTICE || EVFLAG) {
+      for (jj = 0; jj < jnum; jj++) {
+        const int j = jlist[jj] & NEIGHMASK;
+        if (LATTICE) {
+          f[j].x -= fxj[jj];
+          f[j].y -= fyj[jj];
+          f[j].z -= fzj[jj];
+        }
+
+        // the displacement is tallied as x[j]-x[i], as in compute()
+
+        if (EVFLAG) {
+          const double rijx = x[j].x - xtmp;
+          const double rijy = x[j].y - ytmp;
+          const double rijz = x[j].z - ztmp;
+          const double rsq = rijx*rijx + rijy*rijy + rijz*rijz;
+          const double cut = cut_i[type[j]];
+          if (rsq > cut*cut) continue;
+          ev_tally_xyz_thr(this,i,j,nlocal,/* newton_pair */ 1,
+                           ej[jj],0.0,fxj[jj],fyj[jj],fzj[jj],rijx,rijy,rijz,thr);
+        }
+      }
+    }
+
+    f[i].x += fxtmp;
+    f[i].y += fytmp;
+    f[i].z += fztmp;
+    fm[i].x += fmx;
+    fm[i].y += fmy;
+    fm[i].z += fmz;
+    emag[i] = emtmp;
+  }
+
+  memory->destroy(fpair_thr);
+}
+
+/* ---------------------------------------------------------------------- */
+
+double PairSpinNeelOMP::memory_usage()
+{
+  double bytes = memory_usage_thr();
+  bytes += PairSpinNeel::memory_usage();
+
+  return bytes;
+}
@@ -47,10 +47,18 @@ ComputeSpin::ComputeSpin(LAMMPS *lmp, int narg, char **arg) :
 {
   if ((narg != 3) && (narg != 4)) error->all(FLERR,"Illegal compute compute/spin command");
 
+  if (!atom->sp_flag) error->all(FLERR,"Compute compute/spin requires atom/spin style");
+
   vector_flag = 1;
   size_vector = 6;
   extvector = 0;
 
+  // magnetic energies are only tallied on timesteps where energies are
+  // requested, per-atom energies for pair styles such as deepmd
+
+  peatomflag = 1;
+  timeflag = 1;
+
   // initialize the magnetic interaction flags
 
   pair_spin_flag = 0;
@@ -78,62 +86,40 @@ void ComputeSpin::init()
   hbar = force->hplanck/MY_2PI;
   kb = force->boltz;
   npairs = npairspin = 0;
+  long_spin_flag = 0;
   precession_spin_flag = 0;
 
-  // set ptrs on Pair/Spin styles
-
-  // loop 1: obtain # of Pairs, and # of Pair/Spin styles
-
-  PairHybrid *hybrid = dynamic_cast<PairHybrid *>(force->pair_match("^hybrid",0));
-  if (force->pair_match("^spin",0,0)) {        // only one Pair/Spin style
-    pair = force->pair_match("^spin",0,0);
-    if (hybrid == nullptr) npairs = 1;
-    else npairs = hybrid->nstyles;
-    npairspin = 1;
-  } else if (force->pair_match("^spin",0,1)) { // more than one Pair/Spin style
-    pair = force->pair_match("^spin",0,1);
-    if (hybrid == nullptr) npairs = 1;
-    else npairs = hybrid->nstyles;
-    for (int i = 0; i<npairs; i++) {
-      if (force->pair_match("^spin",0,i)) {
-        npairspin ++;
-      }
-    }
-  }
+  // set ptrs on Pair/Spin styles, the sub-styles of a hybrid pair style
+  // pair_match() counts the instances of a sub-style from 1, so it cannot
+  // enumerate different spin sub-styles
 
-  // init length of vector of ptrs to Pair/Spin styles
-
-  if (npairspin > 0) {
-    spin_pairs = new PairSpin*[npairspin];
-  }
-
-  // loop 2: fill vector with ptrs to Pair/Spin styles
-
-  int count = 0;
-  if (npairspin == 1) {
-    count = 1;
-    spin_pairs[0] = dynamic_cast<PairSpin *>( force->pair_match("^spin",0,0));
-  } else if (npairspin > 1) {
-    for (int i = 0; i<npairs; i++) {
-      if (force->pair_match("^spin",0,i)) {
-        spin_pairs[count] = dynamic_cast<PairSpin *>( force->pair_match("^spin",0,i));
-        count++;
-      }
+  delete [] spin_pairs;
+  spin_pairs = nullptr;
+  pair = nullptr;
+
+  auto hybrid = dynamic_cast<PairHybrid *>(force->pair_match("^hybrid",0));
+  if (hybrid) {
+    npairs = hybrid->nstyles;
+    spin_pairs = new PairSpin*[npairs];
+    for (int i = 0; i < npairs; i++) {
+      auto spin_pair = dynamic_cast<PairSpin *>(hybrid->styles[i]);
+      if (spin_pair) spin_pairs[npairspin++] = spin_pair;
+      if (utils::strmatch(hybrid->keywords[i],"^spin/long")) long_spin_flag = 1;
+    }
+  } else if (force->pair) {
+    npairs = 1;
+    auto spin_pair = dynamic_cast<PairSpin *>(force->pair);
+    if (spin_pair) {
+      spin_pairs = new PairSpin*[1];
+      spin_pairs[npairspin++] = spin_pair;
     }
+    if (force->pair_match("^spin/long",0)) long_spin_flag = 1;
   }
+  if (npairspin > 0) pair = spin_pairs[0];
 
-  if (count != npairspin)
-    error->all(FLERR,"Incorrect number of spin pair styles");
+  // set pair/spin flag
 
-  // set pair/spin and long/spin flags
-
-  if (npairspin >= 1) pair_spin_flag = 1;
-
-  for (int i = 0; i<npairs; i++) {
-    if (force->pair_match("^spin/long",0,i)) {
-      long_spin_flag = 1;
-    }
-  }
+  pair_spin_flag = (npairspin > 0) ? 1 : 0;
 
   // ptrs FixPrecessionSpin classes
 
@@ -151,22 +137,19 @@ void ComputeSpin::init()
 void ComputeSpin::compute_vector()
 {
   int i;
-  int countsp, countsptot;
-  double mag[4], magtot[4];
-  double magenergy, magenergytot;
-  double tempnum, tempnumtot;
-  double tempdenom, tempdenomtot;
+  double sums[7], sumsall[7];
   double spintemperature;
 
   invoked_vector = update->ntimestep;
 
-  countsp = countsptot = 0.0;
-  mag[0] = mag[1] = mag[2] = mag[3] = 0.0;
-  magtot[0] = magtot[1] = magtot[2] = magtot[3] = 0.0;
-  magenergy = magenergytot = 0.0;
-  tempnum = tempnumtot = 0.0;
-  tempdenom = tempdenomtot = 0.0;
-  spintemperature = 0.0;
+  if (update->eflag_atom != invoked_vector)
+    error->all(FLERR,"Per-atom energy was not tallied on needed timestep");
+
+  // local sums: magnetization, magnetic energy, numerator and
+  // denominator of the spin temperature, # of spins
+  // packed for a single reduction
+
+  for (i = 0; i < 7; i++) sums[i] = 0.0;
 
   int *mask = atom->mask;
   double **sp = atom->sp;
@@ -175,68 +158,64 @@ void ComputeSpin::compute_vector()
 
   int nlocal = atom->nlocal;
 
+  int dim;
+  double *pair_emag = nullptr;
+  if (force->pair) pair_emag = (double *) force->pair->extract("emag",dim);
+
   // compute total magnetization and magnetic energy
   // compute spin temperature (Nurdin et al., Phys. Rev. E 61, 2000)
 
   for (i = 0; i < nlocal; i++) {
-    if (mask[i] & groupbit) {
-      if (atom->sp_flag) {
-
-        // compute first moment
+    if (!(mask[i] & groupbit)) continue;
 
-        mag[0] += sp[i][0];
-        mag[1] += sp[i][1];
-        mag[2] += sp[i][2];
+    // compute first moment
 
-        // update magnetic precession energies
+    sums[0] += sp[i][0];
+    sums[1] += sp[i][1];
+    sums[2] += sp[i][2];
 
-        if (precession_spin_flag) {
-          magenergy += lockprecessionspin->emag[i];
-        }
+    // update magnetic precession energies
 
-        // update magnetic pair interactions
+    if (precession_spin_flag) {
+      sums[3] += lockprecessionspin->emag[i];
+    }
 
-        if (pair_spin_flag) {
-          for (int k = 0; k < npairspin; k++) {
-            magenergy += spin_pairs[k]->emag[i];
-          }
-        }
+    // update magnetic pair interactions
 
-        tx = sp[i][1]*fm[i][2]-sp[i][2]*fm[i][1];
-        ty = sp[i][2]*fm[i][0]-sp[i][0]*fm[i][2];
-        tz = sp[i][0]*fm[i][1]-sp[i][1]*fm[i][0];
-        tempnum += tx*tx+ty*ty+tz*tz;
-        tempdenom += sp[i][0]*fm[i][0]+fm[i][1]*sp[i][1]+sp[i][2]*fm[i][2];
-        countsp++;
+    if (pair_spin_flag) {
+      for (int k = 0; k < npairspin; k++) {
+        sums[3] += spin_pairs[k]->emag[i];
       }
     }
-    else error->all(FLERR,"Compute compute/spin requires atom/spin style");
+
+    // magnetic energies of the pseudo atoms of pair deepmd
+
+    if (pair_emag) sums[3] += pair_emag[i];
+
+    tx = sp[i][1]*fm[i][2]-sp[i][2]*fm[i][1];
+    ty = sp[i][2]*fm[i][0]-sp[i][0]*fm[i][2];
+    tz = sp[i][0]*fm[i][1]-sp[i][1]*fm[i][0];
+    sums[4] += tx*tx+ty*ty+tz*tz;
+    sums[5] += sp[i][0]*fm[i][0]+fm[i][1]*sp[i][1]+sp[i][2]*fm[i][2];
+    sums[6] += 1.0;
   }
 
-  MPI_Allreduce(mag,magtot,4,MPI_DOUBLE,MPI_SUM,world);
-  MPI_Allreduce(&magenergy,&magenergytot,1,MPI_DOUBLE,MPI_SUM,world);
-  MPI_Allreduce(&tempnum,&tempnumtot,1,MPI_DOUBLE,MPI_SUM,world);
-  MPI_Allreduce(&tempdenom,&tempdenomtot,1,MPI_DOUBLE,MPI_SUM,world);
-  MPI_Allreduce(&countsp,&countsptot,1,MPI_INT,MPI_SUM,world);
+  MPI_Allreduce(sums,sumsall,7,MPI_DOUBLE,MPI_SUM,world);
 
   // compute average magnetization
 
-  double scale = 1.0/countsptot;
-  magtot[0] *= scale;
-  magtot[1] *= scale;
-  magtot[2] *= scale;
-  magtot[3] = sqrt((magtot[0]*magtot[0])+(magtot[1]*magtot[1])+(magtot[2]*magtot[2]));
+  double scale = 1.0/sumsall[6];
+  vector[0] = sumsall[0]*scale;
+  vector[1] = sumsall[1]*scale;
+  vector[2] = sumsall[2]*scale;
+  vector[3] = sqrt((vector[0]*vector[0])+(vector[1]*vector[1])+(vector[2]*vector[2]));
 
   // compute spin temperature
 
-  spintemperature = hbar*tempnumtot;
-  spintemperature /= (2.0*kb*tempdenomtot);
+  spintemperature = hbar*sumsall[4];
+  spintemperature /= (2.0*kb*sumsall[5]);
 
-  vector[0] = magtot[0];
-  vector[1] = magtot[1];
-  vector[2] = magtot[2];
-  vector[3] = magtot[3];
-  vector[4] = magenergytot;
+  vector[4] = sumsall[3];
   vector[5] = spintemperature;
 }
 
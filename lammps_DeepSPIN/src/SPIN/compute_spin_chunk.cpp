@@ -0,0 +1,295 @@
+// clang-format off
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   https://www.lammps.org/, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#include "compute_spin_chunk.h"
+
+#include "atom.h"
+#include "compute_chunk_atom.h"
+#include "error.h"
+#include "fix_precession_spin.h"
+#include "force.h"
+#include "math_const.h"
+#include "memory.h"
+#include "modify.h"
+#include "pair_hybrid.h"
+#include "pair_spin.h"
+#include "update.h"
+
+#include <cmath>
+#include <cstring>
+
+using namespace LAMMPS_NS;
+using namespace MathConst;
+
+// per-chunk sums: spin vector, # of spins, magnetic energy,
+// numerator and denominator of the spin temperature
+
+enum{SX,SY,SZ,COUNT,EMAG,TNUM,TDENOM,NSUM};
+
+/* ---------------------------------------------------------------------- */
+
+ComputeSpinChunk::ComputeSpinChunk(LAMMPS *lmp, int narg, char **arg) :
+  Compute(lmp, narg, arg),
+  idchunk(nullptr), spin_pairs(nullptr), sums(nullptr), sumsall(nullptr), spin(nullptr)
+{
+  if (narg != 4) error->all(FLERR,"Illegal compute spin/chunk command");
+
+  if (!atom->sp_flag)
+    error->all(FLERR,"Compute spin/chunk requires atom/spin style");
+
+  array_flag = 1;
+  size_array_cols = 6;
+  size_array_rows = 0;
+  size_array_rows_variable = 1;
+  extarray = 0;
+
+  // ID of compute chunk/atom
+
+  idchunk = utils::strdup(arg[3]);
+
+  // magnetic energies are only tallied on timesteps where energies are
+  // requested, per-atom energies for pair styles such as deepmd
+
+  peatomflag = 1;
+  timeflag = 1;
+
+  ComputeSpinChunk::init();
+
+  // chunk-based data
+
+  nchunk = 1;
+  maxchunk = 0;
+  allocate();
+}
+
+/* ---------------------------------------------------------------------- */
+
+ComputeSpinChunk::~ComputeSpinChunk()
+{
+  delete [] idchunk;
+  delete [] spin_pairs;
+  memory->destroy(sums);
+  memory->destroy(sumsall);
+  memory->destroy(spin);
+}
+
+/* ---------------------------------------------------------------------- */
+
+void ComputeSpinChunk::init()
+{
+  int icompute = modify->find_compute(idchunk);
+  if (icompute < 0)
+    error->all(FLERR,"Chunk/atom compute does not exist for compute spin/chunk");
+  cchunk = dynamic_cast<ComputeChunkAtom *>( modify->compute[icompute]);
+  if (strcmp(cchunk->style,"chunk/atom") != 0)
+    error->all(FLERR,"Compute spin/chunk does not use chunk/atom compute");
+
+  hbar = force->hplanck/MY_2PI;
+  kb = force->boltz;
+
+  // ptrs on Pair/Spin styles, the sub-styles of a hybrid pair style
+
+  delete [] spin_pairs;
+  spin_pairs = nullptr;
+  npairspin = 0;
+
+  auto hybrid = dynamic_cast<PairHybrid *>(force->pair_match("^hybrid",0));
+  if (hybrid) {
+    spin_pairs = new PairSpin*[hybrid->nstyles];
+    for (int i = 0; i < hybrid->nstyles; i++) {
+      auto pair = dynamic_cast<PairSpin *>(hybrid->styles[i]);
+      if (pair) spin_pairs[npairspin++] = pair;
+    }
+  } else if (force->pair) {
+    auto pair = dynamic_cast<PairSpin *>(force->pair);
+    if (pair) {
+      spin_pairs = new PairSpin*[1];
+      spin_pairs[npairspin++] = pair;
+    }
+  }
+
+  // ptr on FixPrecessionSpin class
+
+  precession_spin_flag = 0;
+  for (int iforce = 0; iforce < modify->nfix; iforce++) {
+    if (utils::strmatch(modify->fix[iforce]->style,"^precession/spin")) {
+      precession_spin_flag = 1;
+      lockprecessionspin = dynamic_cast<FixPrecessionSpin *>( modify->fix[iforce]);
+    }
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+
+void ComputeSpinChunk::compute_array()
+{
+  int i,index;
+  double tx,ty,tz;
+
+  invoked_array = update->ntimestep;
+
+  if (update->eflag_atom != invoked_array)
+    error->all(FLERR,"Per-atom energy was not tallied on needed timestep");
+
+  // compute chunk/atom assigns atoms to chunk IDs
+  // extract ichunk index vector from compute
+  // ichunk = 1 to Nchunk for included atoms, 0 for excluded atoms
+
+  nchunk = cchunk->setup_chunks();
+  cchunk->compute_ichunk();
+  int *ichunk = cchunk->ichunk;
+
+  if (nchunk > maxchunk) allocate();
+  size_array_rows = nchunk;
+
+  // zero local per-chunk values
+
+  for (i = 0; i < nchunk; i++)
+    for (int m = 0; m < NSUM; m++) sums[i][m] = 0.0;
+
+  double **sp = atom->sp;
+  double **fm = atom->fm;
+  int *mask = atom->mask;
+  int nlocal = atom->nlocal;
+
+  int dim;
+  double *pair_emag = nullptr;
+  if (force->pair) pair_emag = (double *) force->pair->extract("emag",dim);
+
+  // sum spins, magnetic energies and spin temperature terms of each chunk
+  // spin temperature from Nurdin et al., Phys. Rev. E 61, 2000
+
+  for (i = 0; i < nlocal; i++) {
+    if (!(mask[i] & groupbit)) continue;
+    index = ichunk[i]-1;
+    if (index < 0) continue;
+
+    double *sum = sums[index];
+    sum[SX] += sp[i][0];
+    sum[SY] += sp[i][1];
+    sum[SZ] += sp[i][2];
+    sum[COUNT] += 1.0;
+
+    if (precession_spin_flag) sum[EMAG] += lockprecessionspin->emag[i];
+    for (int k = 0; k < npairspin; k++) sum[EMAG] += spin_pairs[k]->emag[i];
+    if (pair_emag) sum[EMAG] += pair_emag[i];
+
+    tx = sp[i][1]*fm[i][2]-sp[i][2]*fm[i][1];
+    ty = sp[i][2]*fm[i][0]-sp[i][0]*fm[i][2];
+    tz = sp[i][0]*fm[i][1]-sp[i][1]*fm[i][0];
+    sum[TNUM] += tx*tx+ty*ty+tz*tz;
+    sum[TDENOM] += sp[i][0]*fm[i][0]+sp[i][1]*fm[i][1]+sp[i][2]*fm[i][2];
+  }
+
+  MPI_Allreduce(&sums[0][0],&sumsall[0][0],NSUM*nchunk,MPI_DOUBLE,MPI_SUM,world);
+
+  // average magnetization, its norm, magnetic energy and spin temperature
+
+  for (i = 0; i < nchunk; i++) {
+    double *sum = sumsall[i];
+    if (sum[COUNT] > 0.0) {
+      double scale = 1.0/sum[COUNT];
+      spin[i][0] = sum[SX]*scale;
+      spin[i][1] = sum[SY]*scale;
+      spin[i][2] = sum[SZ]*scale;
+    } else spin[i][0] = spin[i][1] = spin[i][2] = 0.0;
+    spin[i][3] = sqrt(spin[i][0]*spin[i][0] + spin[i][1]*spin[i][1] +
+                      spin[i][2]*spin[i][2]);
+    spin[i][4] = sum[EMAG];
+    if (sum[TDENOM] != 0.0) spin[i][5] = hbar*sum[TNUM]/(2.0*kb*sum[TDENOM]);
+    else spin[i][5] = 0.0;
+  }
+}
+
+/* ----------------------------------------------------------------------
+   lock methods: called by fix ave/time
+   these methods insure vector/array size is locked for Nfreq epoch
+     by passing lock info along to compute chunk/atom
+------------------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------------
+   increment lock counter
+------------------------------------------------------------------------- */
+
+void ComputeSpinChunk::lock_enable()
+{
+  cchunk->lockcount++;
+}
+
+/* ----------------------------------------------------------------------
+   decrement lock counter in compute chunk/atom, it if still exists
+------------------------------------------------------------------------- */
+
+void ComputeSpinChunk::lock_disable()
+{
+  int icompute = modify->find_compute(idchunk);
+  if (icompute >= 0) {
+    cchunk = dynamic_cast<ComputeChunkAtom *>( modify->compute[icompute]);
+    cchunk->lockcount--;
+  }
+}
+
+/* ----------------------------------------------------------------------
+   calculate and return # of chunks = length of vector/array
+------------------------------------------------------------------------- */
+
+int ComputeSpinChunk::lock_length()
+{
+  nchunk = cchunk->setup_chunks();
+  return nchunk;
+}
+
+/* ----------------------------------------------------------------------
+   set the lock from startstep to stopstep
+------------------------------------------------------------------------- */
+
+void ComputeSpinChunk::lock(Fix *fixptr, bigint startstep, bigint stopstep)
+{
+  cchunk->lock(fixptr,startstep,stopstep);
+}
+
+/* ----------------------------------------------------------------------
+   unset the lock
+------------------------------------------------------------------------- */
+
+void ComputeSpinChunk::unlock(Fix *fixptr)
+{
+  cchunk->unlock(fixptr);
+}
+
+/* ----------------------------------------------------------------------
+   free and reallocate per-chunk arrays
+------------------------------------------------------------------------- */
+
+void ComputeSpinChunk::allocate()
+{
+  memory->destroy(sums);
+  memory->destroy(sumsall);
+  memory->destroy(spin);
+  maxchunk = nchunk;
+  memory->create(sums,maxchunk,NSUM,"spin/chunk:sums");
+  memory->create(sumsall,maxchunk,NSUM,"spin/chunk:sumsall");
+  memory->create(spin,maxchunk,6,"spin/chunk:spin");
+  array = spin;
+}
+
+/* ----------------------------------------------------------------------
+   memory usage of local data
+------------------------------------------------------------------------- */
+
+double ComputeSpinChunk::memory_usage()
+{
+  double bytes = (double) maxchunk * (2*NSUM+6) * sizeof(double);
+  return bytes;
+}
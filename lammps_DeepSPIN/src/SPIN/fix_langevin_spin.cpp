@@ -25,12 +25,11 @@
 #include "fix_langevin_spin.h"
 
 #include "atom.h"
-#include "comm.h"
 #include "error.h"
 #include "force.h"
 #include "math_const.h"
+#include "memory.h"
 #include "modify.h"
-#include "random_mars.h"
 #include "respa.h"
 #include "update.h"
 
@@ -44,7 +43,7 @@ using namespace MathConst;
 /* ---------------------------------------------------------------------- */
 
 FixLangevinSpin::FixLangevinSpin(LAMMPS *lmp, int narg, char **arg) :
-  Fix(lmp, narg, arg), random(nullptr)
+  Fix(lmp, narg, arg), rfield(nullptr)
 {
   if (narg != 6) error->all(FLERR,"Illegal langevin/spin command");
 
@@ -68,17 +67,20 @@ FixLangevinSpin::FixLangevinSpin(LAMMPS *lmp, int narg, char **arg) :
     temp_flag = 1;
   }
 
-  // initialize Marsaglia RNG with processor-unique seed
+  if (seed <= 0) error->all(FLERR,"Illegal langevin/spin command");
 
-  // random = new RanPark(lmp,seed + comm->me);
-  random = new RanMars(lmp,seed + comm->me);
+  // random fields are drawn by random_field() for each sweep
+
+  nmax = 0;
 }
 
 /* ---------------------------------------------------------------------- */
 
 FixLangevinSpin::~FixLangevinSpin()
 {
-  delete random;
+  if (copymode) return;
+
+  memory->destroy(rfield);
 }
 
 /* ---------------------------------------------------------------------- */
@@ -98,11 +100,16 @@ void FixLangevinSpin::init()
   int flag_force = 0;
   int flag_lang = 0;
   for (int i = 0; i < modify->nfix; i++) {
-     if (strcmp("precession/spin",modify->fix[i]->style)==0) flag_force = MAX(flag_force,i);
-     if (strcmp("langevin/spin",modify->fix[i]->style)==0) flag_lang = i;
+     if (utils::strmatch(modify->fix[i]->style,"^precession/spin")) flag_force = MAX(flag_force,i);
+     if (utils::strmatch(modify->fix[i]->style,"^langevin/spin")) flag_lang = i;
   }
   if (flag_force >= flag_lang) error->all(FLERR,"Fix langevin/spin has to come after all other spin fixes");
 
+  // the random field of a spin is keyed on its atom ID
+
+  if (temp_flag && atom->tag_enable == 0)
+    error->all(FLERR,"Fix langevin/spin requires atoms with IDs");
+
   gil_factor = 1.0/(1.0+(alpha_t)*(alpha_t));
   dts = 0.25 * update->dt;
 
@@ -142,17 +149,13 @@ void FixLangevinSpin::add_tdamping(double spi[3], double fmi[3])
 
 /* ---------------------------------------------------------------------- */
 
-void FixLangevinSpin::add_temperature(double fmi[3])
+void FixLangevinSpin::add_temperature(int i, double fmi[3])
 {
-  double rx = sigma*random->gaussian();
-  double ry = sigma*random->gaussian();
-  double rz = sigma*random->gaussian();
-
   // adding the random field
 
-  fmi[0] += rx;
-  fmi[1] += ry;
-  fmi[2] += rz;
+  fmi[0] += rfield[i][0];
+  fmi[1] += rfield[i][1];
+  fmi[2] += rfield[i][2];
 
   // adding gilbert's prefactor
 
@@ -168,6 +171,81 @@ void FixLangevinSpin::compute_single_langevin(int i, double spi[3], double fmi[3
   int *mask = atom->mask;
   if (mask[i] & groupbit) {
     if (tdamp_flag) add_tdamping(spi,fmi);
-    if (temp_flag) add_temperature(fmi);
+    if (temp_flag) add_temperature(i,fmi);
   }
 }
+
+/* ----------------------------------------------------------------------
+   splitmix64 finalizer, a bijective mixing of the 64 bits of z
+------------------------------------------------------------------------- */
+
+static inline uint64_t mix64(uint64_t z)
+{
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+/* ----------------------------------------------------------------------
+   key of the random stream of a sweep, from the seed and the timestep
+   a sweep advances every spin once, nve/spin does 4 sweeps per timestep
+------------------------------------------------------------------------- */
+
+uint64_t FixLangevinSpin::sweep_key(int sweep)
+{
+  uint64_t key = mix64((uint64_t) seed);
+  key = mix64(key + (uint64_t) update->ntimestep);
+  return mix64(key + (uint64_t) sweep);
+}
+
+/* ----------------------------------------------------------------------
+   draw the random field of all owned spins for one sweep
+   counter-based: the field of a spin only depends on the seed, its tag,
+   the timestep and the sweep, not on the order of the updates or the
+   number of procs, so all fields of a sweep are drawn in one batch
+   scale = spin timestep of the sweep in units of dts
+------------------------------------------------------------------------- */
+
+void FixLangevinSpin::random_field(int sweep, double scale)
+{
+  if (!temp_flag) return;
+
+  if (atom->nmax > nmax) {
+    nmax = atom->nmax;
+    memory->destroy(rfield);
+    memory->create(rfield,nmax,3,"langevin/spin:rfield");
+  }
+
+  const uint64_t key = sweep_key(sweep);
+  const double twopi = MY_2PI;
+  const double norm = 1.0/9007199254740992.0;    // 2^-53
+  const double sigma_s = sigma/sqrt(scale);
+  tagint *tag = atom->tag;
+  const int nlocal = atom->nlocal;
+
+  for (int i = 0; i < nlocal; i++) {
+    const uint64_t h = mix64(key ^ mix64((uint64_t) tag[i]));
+
+    // 4 uniform deviates in (0,1], 3 gaussian deviates by Box-Muller
+
+    const double u0 = ((mix64(h) >> 11) + 1) * norm;
+    const double u1 = ((mix64(h + 1) >> 11) + 1) * norm;
+    const double u2 = ((mix64(h + 2) >> 11) + 1) * norm;
+    const double u3 = ((mix64(h + 3) >> 11) + 1) * norm;
+    const double r01 = sigma_s*sqrt(-2.0*log(u0));
+    const double r2 = sigma_s*sqrt(-2.0*log(u2));
+
+    rfield[i][0] = r01*cos(twopi*u1);
+    rfield[i][1] = r01*sin(twopi*u1);
+    rfield[i][2] = r2*cos(twopi*u3);
+  }
+}
+
+/* ----------------------------------------------------------------------
+   memory usage of local atom-based arrays
+------------------------------------------------------------------------- */
+
+double FixLangevinSpin::memory_usage()
+{
+  return (double)nmax*3*sizeof(double);
+}
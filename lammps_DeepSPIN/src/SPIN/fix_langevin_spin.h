@@ -22,6 +22,8 @@ FixStyle(langevin/spin,FixLangevinSpin);
 
 #include "fix.h"
 
+#include <cstdint>
+
 namespace LAMMPS_NS {
 
 class FixLangevinSpin : public Fix {
@@ -34,8 +36,11 @@ class FixLangevinSpin : public Fix {
   void init() override;
   void setup(int) override;
   void add_tdamping(double *, double *);    // add transverse damping
-  void add_temperature(double[3]);
+  void add_temperature(int, double *);      // add random field of spin i
   void compute_single_langevin(int, double *, double *);
+  void random_field(int, double = 1.0);     // draw random fields of a sweep
+  uint64_t sweep_key(int);
+  double memory_usage() override;
 
  protected:
   double alpha_t;       // transverse mag. damping
@@ -45,8 +50,10 @@ class FixLangevinSpin : public Fix {
   double gil_factor;    // gilbert's prefactor
 
   int nlevels_respa;
-  class RanMars *random;
   int seed;
+
+  int nmax;          // length of rfield
+  double **rfield;   // random field of each spin in the current sweep
 };
 
 }    // namespace LAMMPS_NS
@@ -41,6 +41,14 @@ using namespace LAMMPS_NS;
 using namespace FixConst;
 
 enum{SINGLE_PROC_DIRECT,SINGLE_PROC_MAP,MULTI_PROC};
+enum{COORDTAG=1,FORCETAG,ENERGYTAG};
+
+// packed values per NEB atom in the inter-replica exchange
+// CSIZE = tag,x,sp   FSIZE = f,fm   USIZE = x,sp prev + x,sp,f,fm next
+
+static constexpr int CSIZE = 7;
+static constexpr int FSIZE = 6;
+static constexpr int USIZE = 18;
 
 #define BUFSIZE 8
 
@@ -49,11 +57,9 @@ enum{SINGLE_PROC_DIRECT,SINGLE_PROC_MAP,MULTI_PROC};
 FixNEBSpin::FixNEBSpin(LAMMPS *lmp, int narg, char **arg) :
   Fix(lmp, narg, arg), id_pe(nullptr), pe(nullptr), nlenall(nullptr), xprev(nullptr),
   xnext(nullptr), fnext(nullptr), spprev(nullptr), spnext(nullptr), fmnext(nullptr), springF(nullptr),
-  tangent(nullptr), xsend(nullptr), xrecv(nullptr), fsend(nullptr), frecv(nullptr), spsend(nullptr),
-  sprecv(nullptr), fmsend(nullptr), fmrecv(nullptr), tagsend(nullptr), tagrecv(nullptr),
-  xsendall(nullptr), xrecvall(nullptr), fsendall(nullptr), frecvall(nullptr), spsendall(nullptr),
-  sprecvall(nullptr), fmsendall(nullptr), fmrecvall(nullptr), tagsendall(nullptr), tagrecvall(nullptr),
-  counts(nullptr), displacements(nullptr)
+  tangent(nullptr), ilocal(nullptr), csend(nullptr), fsend(nullptr), unpack(nullptr),
+  csendall(nullptr), fsendall(nullptr), cprev(nullptr), cnext(nullptr), fnextall(nullptr),
+  unpackall(nullptr), counts(nullptr), sizes(nullptr), displacements(nullptr)
 {
 
   if (narg < 4) error->all(FLERR,"Illegal fix neb/spin command");
@@ -129,7 +135,10 @@ FixNEBSpin::FixNEBSpin(LAMMPS *lmp, int narg, char **arg) :
   // initialize local storage
 
   maxlocal = -1;
+  maxneb = -1;
   ntotal = -1;
+  posted = 0;
+  nrequest = 0;
 }
 
 /* ---------------------------------------------------------------------- */
@@ -149,29 +158,20 @@ FixNEBSpin::~FixNEBSpin()
   memory->destroy(spnext);
   memory->destroy(fmnext);
   memory->destroy(springF);
-  memory->destroy(xsend);
-  memory->destroy(xrecv);
+  memory->destroy(ilocal);
+  memory->destroy(csend);
   memory->destroy(fsend);
-  memory->destroy(frecv);
-  memory->destroy(spsend);
-  memory->destroy(sprecv);
-  memory->destroy(fmsend);
-  memory->destroy(fmrecv);
-  memory->destroy(tagsend);
-  memory->destroy(tagrecv);
-
-  memory->destroy(xsendall);
-  memory->destroy(xrecvall);
+  memory->destroy(unpack);
+
+  memory->destroy(csendall);
   memory->destroy(fsendall);
-  memory->destroy(frecvall);
-  memory->destroy(spsendall);
-  memory->destroy(sprecvall);
-  memory->destroy(fmsendall);
-  memory->destroy(fmrecvall);
-  memory->destroy(tagsendall);
-  memory->destroy(tagrecvall);
+  memory->destroy(cprev);
+  memory->destroy(cnext);
+  memory->destroy(fnextall);
+  memory->destroy(unpackall);
 
   memory->destroy(counts);
+  memory->destroy(sizes);
   memory->destroy(displacements);
 
   if (NEBLongRange) {
@@ -185,6 +185,7 @@ FixNEBSpin::~FixNEBSpin()
 int FixNEBSpin::setmask()
 {
   int mask = 0;
+  mask |= MIN_PRE_FORCE;
   mask |= MIN_POST_FORCE;
   return mask;
 }
@@ -223,20 +224,11 @@ void FixNEBSpin::init()
 
   if (atom->nmax > maxlocal) reallocate();
 
-  if (cmode == MULTI_PROC && counts == nullptr) {
-    memory->create(xsendall,ntotal,3,"neb:xsendall");
-    memory->create(xrecvall,ntotal,3,"neb:xrecvall");
-    memory->create(fsendall,ntotal,3,"neb:fsendall");
-    memory->create(frecvall,ntotal,3,"neb:frecvall");
-    memory->create(tagsendall,ntotal,"neb:tagsendall");
-    memory->create(tagrecvall,ntotal,"neb:tagrecvall");
-    memory->create(spsendall,ntotal,3,"neb:xsendall");
-    memory->create(sprecvall,ntotal,3,"neb:xrecvall");
-    memory->create(fmsendall,ntotal,3,"neb:fsendall");
-    memory->create(fmrecvall,ntotal,3,"neb:frecvall");
-    memory->create(counts,nprocs,"neb:counts");
-    memory->create(displacements,nprocs,"neb:displacements");
-  }
+  if (nebatoms > maxneb) reallocate_neb();
+
+  // no exchange is in flight before the first force evaluation
+
+  posted = 0;
 }
 
 /* ---------------------------------------------------------------------- */
@@ -250,6 +242,17 @@ void FixNEBSpin::min_setup(int vflag)
   pe->addstep(update->ntimestep+1);
 }
 
+/* ----------------------------------------------------------------------
+   coords and spins do not change during the force evaluation
+   post their exchange with the adjacent replicas now, complete it
+   in min_post_force()
+------------------------------------------------------------------------- */
+
+void FixNEBSpin::min_pre_force(int /*vflag*/)
+{
+  inter_replica_post();
+}
+
 /* ---------------------------------------------------------------------- */
 
 void FixNEBSpin::min_post_force(int /*vflag*/)
@@ -263,19 +266,26 @@ void FixNEBSpin::min_post_force(int /*vflag*/)
 
   vprev = vnext = veng = pe->compute_scalar();
 
-  if (ireplica < nreplica-1 && me == 0)
-    MPI_Send(&veng,1,MPI_DOUBLE,procnext,0,uworld);
-  if (ireplica > 0 && me == 0)
-    MPI_Recv(&vprev,1,MPI_DOUBLE,procprev,0,uworld,MPI_STATUS_IGNORE);
+  // min_setup() is not preceded by min_pre_force()
+
+  if (!posted) inter_replica_post();
 
-  if (ireplica > 0 && me == 0)
-    MPI_Send(&veng,1,MPI_DOUBLE,procprev,0,uworld);
-  if (ireplica < nreplica-1 && me == 0)
-    MPI_Recv(&vnext,1,MPI_DOUBLE,procnext,0,uworld,MPI_STATUS_IGNORE);
+  // post the exchange of energies with adjacent replicas
+  // inter_replica_comm() waits for it along with the atoms
 
-  if (cmode == MULTI_PROC) {
-    MPI_Bcast(&vprev,1,MPI_DOUBLE,0,world);
-    MPI_Bcast(&vnext,1,MPI_DOUBLE,0,world);
+  if (me == 0) {
+    if (ireplica > 0) {
+      MPI_Irecv(&vrecv[0],1,MPI_DOUBLE,procprev,ENERGYTAG,uworld,
+                &requests[nrequest++]);
+      MPI_Isend(&veng,1,MPI_DOUBLE,procprev,ENERGYTAG,uworld,
+                &requests[nrequest++]);
+    }
+    if (ireplica < nreplica-1) {
+      MPI_Irecv(&vrecv[1],1,MPI_DOUBLE,procnext,ENERGYTAG,uworld,
+                &requests[nrequest++]);
+      MPI_Isend(&veng,1,MPI_DOUBLE,procnext,ENERGYTAG,uworld,
+                &requests[nrequest++]);
+    }
   }
 
   if (FreeEndFinal && ireplica == nreplica-1 && (update->ntimestep == 0))
@@ -294,6 +304,10 @@ void FixNEBSpin::min_post_force(int /*vflag*/)
 
   inter_replica_comm();
 
+  if (nprocs > 1) MPI_Bcast(vrecv,2,MPI_DOUBLE,0,world);
+  if (ireplica > 0) vprev = vrecv[0];
+  if (ireplica < nreplica-1) vnext = vrecv[1];
+
   // trigger potential energy computation on next timestep
 
   pe->addstep(update->ntimestep+1);
@@ -661,289 +675,245 @@ double FixNEBSpin::geodesic_distance(double spi[3], double spj[3])
 }
 
 /* ----------------------------------------------------------------------
-   send/recv NEB atoms to/from adjacent replicas
-   received atoms matching my local atoms are stored in xprev,xnext
-   replicas 0 and N-1 send but do not receive any atoms
+   pack tag,x,sp of my NEB atoms and post their exchange with the
+   adjacent replicas, only the root proc of each replica sends and recvs
+   multiple procs per replica: MPI_Gatherv NEB atoms to the root proc
 ------------------------------------------------------------------------- */
 
-void FixNEBSpin::inter_replica_comm()
+void FixNEBSpin::inter_replica_post()
 {
-  int i,m;
-  MPI_Request request;
-  MPI_Request requests[2];
-  MPI_Status statuses[2];
+  int i;
 
   // reallocate memory if necessary
 
   if (atom->nmax > maxlocal) reallocate();
 
   double **x = atom->x;
-  double **f = atom->f;
   double **sp = atom->sp;
-  double **fm = atom->fm;
   tagint *tag = atom->tag;
   int *mask = atom->mask;
   int nlocal = atom->nlocal;
 
-  // -----------------------------------------------------
-  // 3 cases: two for single proc per replica
-  //          one for multiple procs per replica
-  // -----------------------------------------------------
-
+  nsend = 0;
+  for (i = 0; i < nlocal; i++)
+    if (mask[i] & groupbit) {
+      double *buf = &csend[CSIZE*nsend];
+      ilocal[nsend] = i;
+      buf[0] = ubuf(tag[i]).d;
+      buf[1] = x[i][0];
+      buf[2] = x[i][1];
+      buf[3] = x[i][2];
+      buf[4] = sp[i][0];
+      buf[5] = sp[i][1];
+      buf[6] = sp[i][2];
+      nsend++;
+    }
 
-  // case 1 => to be done
+  double *cmine = csend;
+  if (nprocs > 1) {
+    MPI_Gather(&nsend,1,MPI_INT,counts,1,MPI_INT,0,world);
+    if (me == 0) layout(CSIZE);
+    MPI_Gatherv(csend,CSIZE*nsend,MPI_DOUBLE,
+                csendall,sizes,displacements,MPI_DOUBLE,0,world);
+    cmine = csendall;
+  }
 
-  // single proc per replica
-  // all atoms are NEB atoms and no atom sorting
-  // direct comm of x -> xprev and x -> xnext
+  // both neighbors get the same buffer
+  // replicas 0 and N-1 send but receive from one side only
 
-  if (cmode == SINGLE_PROC_DIRECT) {
+  nrequest = 0;
+  if (me == 0) {
     if (ireplica > 0) {
-      MPI_Irecv(xprev[0],3*nlocal,MPI_DOUBLE,procprev,0,uworld,&request);
-      MPI_Irecv(spprev[0],3*nlocal,MPI_DOUBLE,procprev,0,uworld,&request);
-    }
-    if (ireplica < nreplica-1) {
-      MPI_Send(x[0],3*nlocal,MPI_DOUBLE,procnext,0,uworld);
-      MPI_Send(sp[0],3*nlocal,MPI_DOUBLE,procnext,0,uworld);
+      MPI_Irecv(cprev,CSIZE*nebatoms,MPI_DOUBLE,procprev,COORDTAG,uworld,
+                &requests[nrequest++]);
+      MPI_Isend(cmine,CSIZE*nebatoms,MPI_DOUBLE,procprev,COORDTAG,uworld,
+                &requests[nrequest++]);
     }
-    if (ireplica > 0) MPI_Wait(&request,MPI_STATUS_IGNORE);
     if (ireplica < nreplica-1) {
-      MPI_Irecv(xnext[0],3*nlocal,MPI_DOUBLE,procnext,0,uworld,&request);
-      MPI_Irecv(spnext[0],3*nlocal,MPI_DOUBLE,procnext,0,uworld,&request);
+      MPI_Irecv(cnext,CSIZE*nebatoms,MPI_DOUBLE,procnext,COORDTAG,uworld,
+                &requests[nrequest++]);
+      MPI_Isend(cmine,CSIZE*nebatoms,MPI_DOUBLE,procnext,COORDTAG,uworld,
+                &requests[nrequest++]);
     }
-    if (ireplica > 0) {
-      MPI_Send(x[0],3*nlocal,MPI_DOUBLE,procprev,0,uworld);
-      MPI_Send(sp[0],3*nlocal,MPI_DOUBLE,procprev,0,uworld);
-    }
-    if (ireplica < nreplica-1) MPI_Wait(&request,MPI_STATUS_IGNORE);
+  }
 
-    if (ireplica < nreplica-1) {
-      MPI_Irecv(fnext[0],3*nlocal,MPI_DOUBLE,procnext,0,uworld,&request);
-      MPI_Irecv(fmnext[0],3*nlocal,MPI_DOUBLE,procnext,0,uworld,&request);
-    }
-    if (ireplica > 0) {
-      MPI_Send(f[0],3*nlocal,MPI_DOUBLE,procprev,0,uworld);
-      MPI_Send(fm[0],3*nlocal,MPI_DOUBLE,procprev,0,uworld);
-    }
-    if (ireplica < nreplica-1) MPI_Wait(&request,MPI_STATUS_IGNORE);
+  posted = 1;
+}
 
-    return;
+/* ----------------------------------------------------------------------
+   send f,fm of NEB atoms to the previous replica and complete the
+   exchange posted by inter_replica_post()
+   received atoms matching my local atoms are stored in xprev,xnext
+   single proc per replica: atom->map() matches received atoms,
+     or their order if all atoms are NEB atoms and no atom sorting
+   multiple procs per replica: root proc remaps received atoms by tag
+     to the order gathered from its procs, and MPI_Scatterv them back
+------------------------------------------------------------------------- */
+
+void FixNEBSpin::inter_replica_comm()
+{
+  int i,j,k,m;
+  MPI_Status statuses[10];
+
+  double **f = atom->f;
+  double **fm = atom->fm;
+  int nlocal = atom->nlocal;
+
+  for (k = 0; k < nsend; k++) {
+    double *buf = &fsend[FSIZE*k];
+    i = ilocal[k];
+    buf[0] = f[i][0];
+    buf[1] = f[i][1];
+    buf[2] = f[i][2];
+    buf[3] = fm[i][0];
+    buf[4] = fm[i][1];
+    buf[5] = fm[i][2];
   }
 
-  // single proc per replica
-  // but only some atoms are NEB atoms or atom sorting is enabled
-  // send atom IDs and coords of only NEB atoms to prev/next proc
-  // recv procs use atom->map() to match received coords to owned atoms
+  double *fmine = fsend;
+  if (nprocs > 1) {
+    if (me == 0) layout(FSIZE);
+    MPI_Gatherv(fsend,FSIZE*nsend,MPI_DOUBLE,
+                fsendall,sizes,displacements,MPI_DOUBLE,0,world);
+    fmine = fsendall;
+  }
 
-  if (cmode == SINGLE_PROC_MAP) {
-    m = 0;
-    for (i = 0; i < nlocal; i++)
-      if (mask[i] & groupbit) {
-        tagsend[m] = tag[i];
-        xsend[m][0] = x[i][0];
-        xsend[m][1] = x[i][1];
-        xsend[m][2] = x[i][2];
-        fsend[m][0] = f[i][0];
-        fsend[m][1] = f[i][1];
-        fsend[m][2] = f[i][2];
-        spsend[m][0] = sp[i][0];
-        spsend[m][1] = sp[i][1];
-        spsend[m][2] = sp[i][2];
-        fmsend[m][0] = fm[i][0];
-        fmsend[m][1] = fm[i][1];
-        fmsend[m][2] = fm[i][2];
-        m++;
-      }
+  // f,fm are only needed by the previous replica
+  // their order is the one of tag,x,sp sent by inter_replica_post()
+
+  if (me == 0) {
+    if (ireplica > 0)
+      MPI_Isend(fmine,FSIZE*nebatoms,MPI_DOUBLE,procprev,FORCETAG,uworld,
+                &requests[nrequest++]);
+    if (ireplica < nreplica-1)
+      MPI_Irecv(fnextall,FSIZE*nebatoms,MPI_DOUBLE,procnext,FORCETAG,uworld,
+                &requests[nrequest++]);
+    MPI_Waitall(nrequest,requests,statuses);
+  }
+  nrequest = 0;
+  posted = 0;
 
-    if (ireplica > 0) {
-      MPI_Irecv(xrecv[0],3*nebatoms,MPI_DOUBLE,procprev,0,uworld,&requests[0]);
-      MPI_Irecv(sprecv[0],3*nebatoms,MPI_DOUBLE,procprev,0,uworld,&requests[0]);
-      MPI_Irecv(tagrecv,nebatoms,MPI_LMP_TAGINT,procprev,0,uworld,&requests[1]);
-    }
-    if (ireplica < nreplica-1) {
-      MPI_Send(xsend[0],3*nebatoms,MPI_DOUBLE,procnext,0,uworld);
-      MPI_Send(spsend[0],3*nebatoms,MPI_DOUBLE,procnext,0,uworld);
-      MPI_Send(tagsend,nebatoms,MPI_LMP_TAGINT,procnext,0,uworld);
-    }
+  // single proc per replica
 
+  if (nprocs == 1) {
     if (ireplica > 0) {
-      MPI_Waitall(2,requests,statuses);
-      for (i = 0; i < nebatoms; i++) {
-        m = atom->map(tagrecv[i]);
-        xprev[m][0] = xrecv[i][0];
-        xprev[m][1] = xrecv[i][1];
-        xprev[m][2] = xrecv[i][2];
-        spprev[m][0] = sprecv[i][0];
-        spprev[m][1] = sprecv[i][1];
-        spprev[m][2] = sprecv[i][2];
+      for (j = 0; j < nebatoms; j++) {
+        double *buf = &cprev[CSIZE*j];
+        if (cmode == SINGLE_PROC_DIRECT) m = j;
+        else m = atom->map((tagint) ubuf(buf[0]).i);
+        if (m < 0 || m >= nlocal)
+          error->one(FLERR,"Fix neb/spin atoms differ between replicas");
+        xprev[m][0] = buf[1];
+        xprev[m][1] = buf[2];
+        xprev[m][2] = buf[3];
+        spprev[m][0] = buf[4];
+        spprev[m][1] = buf[5];
+        spprev[m][2] = buf[6];
       }
     }
     if (ireplica < nreplica-1) {
-      MPI_Irecv(xrecv[0],3*nebatoms,MPI_DOUBLE,procnext,0,uworld,&requests[0]);
-      MPI_Irecv(frecv[0],3*nebatoms,MPI_DOUBLE,procnext,0,uworld,&requests[0]);
-      MPI_Irecv(sprecv[0],3*nebatoms,MPI_DOUBLE,procnext,0,uworld,&requests[0]);
-      MPI_Irecv(fmrecv[0],3*nebatoms,MPI_DOUBLE,procnext,0,uworld,&requests[0]);
-      MPI_Irecv(tagrecv,nebatoms,MPI_LMP_TAGINT,procnext,0,uworld,&requests[1]);
-    }
-    if (ireplica > 0) {
-      MPI_Send(xsend[0],3*nebatoms,MPI_DOUBLE,procprev,0,uworld);
-      MPI_Send(fsend[0],3*nebatoms,MPI_DOUBLE,procprev,0,uworld);
-      MPI_Send(spsend[0],3*nebatoms,MPI_DOUBLE,procprev,0,uworld);
-      MPI_Send(fmsend[0],3*nebatoms,MPI_DOUBLE,procprev,0,uworld);
-      MPI_Send(tagsend,nebatoms,MPI_LMP_TAGINT,procprev,0,uworld);
-    }
-
-    if (ireplica < nreplica-1) {
-      MPI_Waitall(2,requests,statuses);
-      for (i = 0; i < nebatoms; i++) {
-        m = atom->map(tagrecv[i]);
-        xnext[m][0] = xrecv[i][0];
-        xnext[m][1] = xrecv[i][1];
-        xnext[m][2] = xrecv[i][2];
-        fnext[m][0] = frecv[i][0];
-        fnext[m][1] = frecv[i][1];
-        fnext[m][2] = frecv[i][2];
-        spnext[m][0] = sprecv[i][0];
-        spnext[m][1] = sprecv[i][1];
-        spnext[m][2] = sprecv[i][2];
-        fmnext[m][0] = fmrecv[i][0];
-        fmnext[m][1] = fmrecv[i][1];
-        fmnext[m][2] = fmrecv[i][2];
+      for (j = 0; j < nebatoms; j++) {
+        double *buf = &cnext[CSIZE*j];
+        double *fbuf = &fnextall[FSIZE*j];
+        if (cmode == SINGLE_PROC_DIRECT) m = j;
+        else m = atom->map((tagint) ubuf(buf[0]).i);
+        if (m < 0 || m >= nlocal)
+          error->one(FLERR,"Fix neb/spin atoms differ between replicas");
+        xnext[m][0] = buf[1];
+        xnext[m][1] = buf[2];
+        xnext[m][2] = buf[3];
+        spnext[m][0] = buf[4];
+        spnext[m][1] = buf[5];
+        spnext[m][2] = buf[6];
+        fnext[m][0] = fbuf[0];
+        fnext[m][1] = fbuf[1];
+        fnext[m][2] = fbuf[2];
+        fmnext[m][0] = fbuf[3];
+        fmnext[m][1] = fbuf[4];
+        fmnext[m][2] = fbuf[5];
       }
     }
-
     return;
   }
 
   // multiple procs per replica
-  // MPI_Gather all coords and atom IDs to root proc of each replica
-  // send to root of adjacent replicas
-  // bcast within each replica
-  // each proc extracts info for atoms it owns via atom->map()
+  // tagpos = position of each NEB atom of my replica in csendall
 
-  m = 0;
-  for (i = 0; i < nlocal; i++)
-    if (mask[i] & groupbit) {
-      tagsend[m] = tag[i];
-      xsend[m][0] = x[i][0];
-      xsend[m][1] = x[i][1];
-      xsend[m][2] = x[i][2];
-      fsend[m][0] = f[i][0];
-      fsend[m][1] = f[i][1];
-      fsend[m][2] = f[i][2];
-      spsend[m][0] = sp[i][0];
-      spsend[m][1] = sp[i][1];
-      spsend[m][2] = sp[i][2];
-      fmsend[m][0] = fm[i][0];
-      fmsend[m][1] = fm[i][1];
-      fmsend[m][2] = fm[i][2];
-      m++;
-    }
+  if (me == 0) {
+    tagpos.clear();
+    tagpos.reserve(nebatoms);
+    for (k = 0; k < nebatoms; k++)
+      tagpos[(tagint) ubuf(csendall[CSIZE*k]).i] = k;
 
-  MPI_Gather(&m,1,MPI_INT,counts,1,MPI_INT,0,world);
-  displacements[0] = 0;
-  for (i = 0; i < nprocs-1; i++)
-    displacements[i+1] = displacements[i] + counts[i];
-  MPI_Gatherv(tagsend,m,MPI_LMP_TAGINT,
-              tagsendall,counts,displacements,MPI_LMP_TAGINT,0,world);
-  for (i = 0; i < nprocs; i++) counts[i] *= 3;
-  for (i = 0; i < nprocs-1; i++)
-    displacements[i+1] = displacements[i] + counts[i];
-  if (xsend) {
-    MPI_Gatherv(xsend[0],3*m,MPI_DOUBLE,
-                xsendall[0],counts,displacements,MPI_DOUBLE,0,world);
-    MPI_Gatherv(fsend[0],3*m,MPI_DOUBLE,
-                fsendall[0],counts,displacements,MPI_DOUBLE,0,world);
-  } else {
-    MPI_Gatherv(nullptr,3*m,MPI_DOUBLE,
-                xsendall[0],counts,displacements,MPI_DOUBLE,0,world);
-    MPI_Gatherv(nullptr,3*m,MPI_DOUBLE,
-                fsendall[0],counts,displacements,MPI_DOUBLE,0,world);
-  }
-  if (spsend) {
-    MPI_Gatherv(spsend[0],3*m,MPI_DOUBLE,
-                spsendall[0],counts,displacements,MPI_DOUBLE,0,world);
-    MPI_Gatherv(fmsend[0],3*m,MPI_DOUBLE,
-                fmsendall[0],counts,displacements,MPI_DOUBLE,0,world);
-  } else {
-    MPI_Gatherv(nullptr,3*m,MPI_DOUBLE,
-                spsendall[0],counts,displacements,MPI_DOUBLE,0,world);
-    MPI_Gatherv(nullptr,3*m,MPI_DOUBLE,
-                fmsendall[0],counts,displacements,MPI_DOUBLE,0,world);
+    if (ireplica > 0) {
+      for (j = 0; j < nebatoms; j++) {
+        double *buf = &cprev[CSIZE*j];
+        auto pos = tagpos.find((tagint) ubuf(buf[0]).i);
+        if (pos == tagpos.end())
+          error->one(FLERR,"Fix neb/spin atoms differ between replicas");
+        double *dst = &unpackall[USIZE*pos->second];
+        for (m = 0; m < 6; m++) dst[m] = buf[m+1];
+      }
+    }
+    if (ireplica < nreplica-1) {
+      for (j = 0; j < nebatoms; j++) {
+        double *buf = &cnext[CSIZE*j];
+        double *fbuf = &fnextall[FSIZE*j];
+        auto pos = tagpos.find((tagint) ubuf(buf[0]).i);
+        if (pos == tagpos.end())
+          error->one(FLERR,"Fix neb/spin atoms differ between replicas");
+        double *dst = &unpackall[USIZE*pos->second];
+        for (m = 0; m < 6; m++) dst[m+6] = buf[m+1];
+        for (m = 0; m < 6; m++) dst[m+12] = fbuf[m];
+      }
+    }
+    layout(USIZE);
   }
 
-  if (ireplica > 0 && me == 0) {
-    MPI_Irecv(xrecvall[0],3*nebatoms,MPI_DOUBLE,procprev,0,uworld,&requests[0]);
-    MPI_Irecv(sprecvall[0],3*nebatoms,MPI_DOUBLE,procprev,0,uworld,&requests[0]);
-    MPI_Irecv(tagrecvall,nebatoms,MPI_LMP_TAGINT,procprev,0,uworld,
-              &requests[1]);
-  }
-  if (ireplica < nreplica-1 && me == 0) {
-    MPI_Send(xsendall[0],3*nebatoms,MPI_DOUBLE,procnext,0,uworld);
-    MPI_Send(spsendall[0],3*nebatoms,MPI_DOUBLE,procnext,0,uworld);
-    MPI_Send(tagsendall,nebatoms,MPI_LMP_TAGINT,procnext,0,uworld);
-  }
+  MPI_Scatterv(unpackall,sizes,displacements,MPI_DOUBLE,
+               unpack,USIZE*nsend,MPI_DOUBLE,0,world);
+
+  // received values are in the order of my packed NEB atoms
 
-  if (ireplica > 0) {
-    if (me == 0) MPI_Waitall(2,requests,statuses);
-
-    MPI_Bcast(tagrecvall,nebatoms,MPI_INT,0,world);
-    MPI_Bcast(xrecvall[0],3*nebatoms,MPI_DOUBLE,0,world);
-    MPI_Bcast(sprecvall[0],3*nebatoms,MPI_DOUBLE,0,world);
-
-    for (i = 0; i < nebatoms; i++) {
-      m = atom->map(tagrecvall[i]);
-      if (m < 0 || m >= nlocal) continue;
-      xprev[m][0] = xrecvall[i][0];
-      xprev[m][1] = xrecvall[i][1];
-      xprev[m][2] = xrecvall[i][2];
-      spprev[m][0] = sprecvall[i][0];
-      spprev[m][1] = sprecvall[i][1];
-      spprev[m][2] = sprecvall[i][2];
+  for (k = 0; k < nsend; k++) {
+    double *buf = &unpack[USIZE*k];
+    i = ilocal[k];
+    if (ireplica > 0) {
+      xprev[i][0] = buf[0];
+      xprev[i][1] = buf[1];
+      xprev[i][2] = buf[2];
+      spprev[i][0] = buf[3];
+      spprev[i][1] = buf[4];
+      spprev[i][2] = buf[5];
+    }
+    if (ireplica < nreplica-1) {
+      xnext[i][0] = buf[6];
+      xnext[i][1] = buf[7];
+      xnext[i][2] = buf[8];
+      spnext[i][0] = buf[9];
+      spnext[i][1] = buf[10];
+      spnext[i][2] = buf[11];
+      fnext[i][0] = buf[12];
+      fnext[i][1] = buf[13];
+      fnext[i][2] = buf[14];
+      fmnext[i][0] = buf[15];
+      fmnext[i][1] = buf[16];
+      fmnext[i][2] = buf[17];
     }
   }
+}
 
-  if (ireplica < nreplica-1 && me == 0) {
-    MPI_Irecv(xrecvall[0],3*nebatoms,MPI_DOUBLE,procnext,0,uworld,&requests[0]);
-    MPI_Irecv(frecvall[0],3*nebatoms,MPI_DOUBLE,procnext,0,uworld,&requests[0]);
-    MPI_Irecv(sprecvall[0],3*nebatoms,MPI_DOUBLE,procnext,0,uworld,&requests[0]);
-    MPI_Irecv(sprecvall[0],3*nebatoms,MPI_DOUBLE,procnext,0,uworld,&requests[0]);
-    MPI_Irecv(tagrecvall,nebatoms,MPI_LMP_TAGINT,procnext,0,uworld,
-              &requests[1]);
-  }
-  if (ireplica > 0 && me == 0) {
-    MPI_Send(xsendall[0],3*nebatoms,MPI_DOUBLE,procprev,0,uworld);
-    MPI_Send(fsendall[0],3*nebatoms,MPI_DOUBLE,procprev,0,uworld);
-    MPI_Send(spsendall[0],3*nebatoms,MPI_DOUBLE,procprev,0,uworld);
-    MPI_Send(fmsendall[0],3*nebatoms,MPI_DOUBLE,procprev,0,uworld);
-    MPI_Send(tagsendall,nebatoms,MPI_LMP_TAGINT,procprev,0,uworld);
-  }
+/* ----------------------------------------------------------------------
+   sizes,displacements of MPI_Gatherv/Scatterv on root proc
+   for n values per NEB atom, from the gathered # of atoms per proc
+------------------------------------------------------------------------- */
 
-  if (ireplica < nreplica-1) {
-    if (me == 0) MPI_Waitall(2,requests,statuses);
-
-    MPI_Bcast(tagrecvall,nebatoms,MPI_INT,0,world);
-    MPI_Bcast(xrecvall[0],3*nebatoms,MPI_DOUBLE,0,world);
-    MPI_Bcast(frecvall[0],3*nebatoms,MPI_DOUBLE,0,world);
-    MPI_Bcast(sprecvall[0],3*nebatoms,MPI_DOUBLE,0,world);
-    MPI_Bcast(fmrecvall[0],3*nebatoms,MPI_DOUBLE,0,world);
-
-    for (i = 0; i < nebatoms; i++) {
-      m = atom->map(tagrecvall[i]);
-      if (m < 0 || m >= nlocal) continue;
-      xnext[m][0] = xrecvall[i][0];
-      xnext[m][1] = xrecvall[i][1];
-      xnext[m][2] = xrecvall[i][2];
-      fnext[m][0] = frecvall[i][0];
-      fnext[m][1] = frecvall[i][1];
-      fnext[m][2] = frecvall[i][2];
-      spnext[m][0] = sprecvall[i][0];
-      spnext[m][1] = sprecvall[i][1];
-      spnext[m][2] = sprecvall[i][2];
-      fmnext[m][0] = fmrecvall[i][0];
-      fmnext[m][1] = fmrecvall[i][1];
-      fmnext[m][2] = fmrecvall[i][2];
-    }
+void FixNEBSpin::layout(int n)
+{
+  displacements[0] = 0;
+  for (int i = 0; i < nprocs; i++) {
+    sizes[i] = n*counts[i];
+    if (i) displacements[i] = displacements[i-1] + sizes[i-1];
   }
 }
 
@@ -974,27 +944,16 @@ void FixNEBSpin::reallocate()
   memory->create(spnext,maxlocal,3,"neb:xnext");
   memory->create(fmnext,maxlocal,3,"neb:fnext");
 
-  if (cmode != SINGLE_PROC_DIRECT) {
-    memory->destroy(xsend);
-    memory->destroy(fsend);
-    memory->destroy(xrecv);
-    memory->destroy(frecv);
-    memory->destroy(spsend);
-    memory->destroy(fmsend);
-    memory->destroy(sprecv);
-    memory->destroy(fmrecv);
-    memory->destroy(tagsend);
-    memory->destroy(tagrecv);
-    memory->create(xsend,maxlocal,3,"neb:xsend");
-    memory->create(fsend,maxlocal,3,"neb:fsend");
-    memory->create(xrecv,maxlocal,3,"neb:xrecv");
-    memory->create(frecv,maxlocal,3,"neb:frecv");
-    memory->create(spsend,maxlocal,3,"neb:xsend");
-    memory->create(fmsend,maxlocal,3,"neb:fsend");
-    memory->create(sprecv,maxlocal,3,"neb:xrecv");
-    memory->create(fmrecv,maxlocal,3,"neb:frecv");
-    memory->create(tagsend,maxlocal,"neb:tagsend");
-    memory->create(tagrecv,maxlocal,"neb:tagrecv");
+  memory->destroy(ilocal);
+  memory->destroy(csend);
+  memory->destroy(fsend);
+  memory->create(ilocal,maxlocal,"neb:ilocal");
+  memory->create(csend,CSIZE*maxlocal,"neb:csend");
+  memory->create(fsend,FSIZE*maxlocal,"neb:fsend");
+
+  if (nprocs > 1) {
+    memory->destroy(unpack);
+    memory->create(unpack,USIZE*maxlocal,"neb:unpack");
   }
 
   if (NEBLongRange) {
@@ -1002,3 +961,35 @@ void FixNEBSpin::reallocate()
     memory->create(nlenall,nreplica,"neb:nlenall");
   }
 }
+
+/* ----------------------------------------------------------------------
+   reallocate buffers of the root proc of my replica for all NEB atoms
+------------------------------------------------------------------------- */
+
+void FixNEBSpin::reallocate_neb()
+{
+  maxneb = nebatoms;
+  if (me) return;
+
+  memory->destroy(cprev);
+  memory->destroy(cnext);
+  memory->destroy(fnextall);
+  memory->create(cprev,CSIZE*maxneb,"neb:cprev");
+  memory->create(cnext,CSIZE*maxneb,"neb:cnext");
+  memory->create(fnextall,FSIZE*maxneb,"neb:fnextall");
+
+  if (nprocs > 1) {
+    memory->destroy(csendall);
+    memory->destroy(fsendall);
+    memory->destroy(unpackall);
+    memory->create(csendall,CSIZE*maxneb,"neb:csendall");
+    memory->create(fsendall,FSIZE*maxneb,"neb:fsendall");
+    memory->create(unpackall,USIZE*maxneb,"neb:unpackall");
+
+    if (counts == nullptr) {
+      memory->create(counts,nprocs,"neb:counts");
+      memory->create(sizes,nprocs,"neb:sizes");
+      memory->create(displacements,nprocs,"neb:displacements");
+    }
+  }
+}
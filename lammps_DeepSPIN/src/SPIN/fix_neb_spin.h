@@ -22,6 +22,8 @@ FixStyle(neb/spin,FixNEBSpin);
 
 #include "fix.h"
 
+#include <unordered_map>
+
 namespace LAMMPS_NS {
 
 class FixNEBSpin : public Fix {
@@ -34,6 +36,7 @@ class FixNEBSpin : public Fix {
   int setmask() override;
   void init() override;
   void min_setup(int) override;
+  void min_pre_force(int) override;
   void min_post_force(int) override;
 
  private:
@@ -59,24 +62,36 @@ class FixNEBSpin : public Fix {
   double **spprev, **spnext, **fmnext;
   double **springF;
   double **tangent;
-  double **xsend, **xrecv;      // coords to send/recv to/from other replica
-  double **fsend, **frecv;      // coords to send/recv to/from other replica
-  double **spsend, **sprecv;    // sp to send/recv to/from other replica
-  double **fmsend, **fmrecv;    // fm to send/recv to/from other replica
-  tagint *tagsend, *tagrecv;    // ditto for atom IDs
 
-  // info gathered from all procs in my replica
-  double **xsendall, **xrecvall;      // coords to send/recv to/from other replica
-  double **fsendall, **frecvall;      // force to send/recv to/from other replica
-  double **spsendall, **sprecvall;    // sp to send/recv to/from other replica
-  double **fmsendall, **fmrecvall;    // fm to send/recv to/from other replica
-  tagint *tagsendall, *tagrecvall;    // ditto for atom IDs
+  // inter-replica exchange, posted in min_pre_force() so that it
+  // overlaps the force evaluation, completed in min_post_force()
+
+  int posted;                // 1 if coords were sent for this force eval
+  int nsend;                 // # of my NEB atoms packed in csend
+  int *ilocal;               // local indices of packed NEB atoms
+  double *csend, *fsend;     // my packed tag,x,sp and f,fm
+  double *unpack;            // values scattered to me from my root
+
+  // buffers for the root proc of each replica, size of nebatoms
+
+  int maxneb;
+  double *csendall, *fsendall;    // gathered from all procs in my replica
+  double *cprev, *cnext;          // tag,x,sp recv from prev/next replica
+  double *fnextall;               // f,fm recv from next replica
+  double *unpackall;              // remapped to the order of my procs
+  double vrecv[2];                // energies of prev/next replica
+  int nrequest;
+  MPI_Request requests[10];
 
-  int *counts, *displacements;    // used for MPI_Gather
+  int *counts, *sizes, *displacements;    // used for MPI_Gatherv/Scatterv
+  std::unordered_map<tagint, int> tagpos;    // tag -> gathered position
 
   double geodesic_distance(double *, double *);
+  void inter_replica_post();
   void inter_replica_comm();
   void reallocate();
+  void reallocate_neb();
+  void layout(int);
 };
 
 }    // namespace LAMMPS_NS
@@ -36,12 +36,18 @@
 #include "force.h"
 #include "memory.h"
 #include "modify.h"
+#include "neigh_list.h"
+#include "neigh_request.h"
 #include "neighbor.h"
 #include "pair_hybrid.h"
 #include "pair_spin.h"
+#include "timer.h"
 #include "update.h"
 
+#include <cmath>
+#include <cstdint>
 #include <cstring>
+#include <vector>
 
 using namespace LAMMPS_NS;
 using namespace FixConst;
@@ -62,14 +68,26 @@ static const char cite_fix_nve_spin[] =
 
 enum{NONE};
 
+// coloring priority of an atom, tags are scrambled so that atoms created
+// in spatial order do not form long chains that serialize the coloring
+// the map is a bijection, so no two atoms share a priority
+
+static inline uint64_t color_priority(tagint tag)
+{
+  uint64_t h = (uint64_t) tag * 0x9E3779B97F4A7C15ULL;
+  return h ^ (h >> 31);
+}
+
 /* ---------------------------------------------------------------------- */
 
 FixNVESpin::FixNVESpin(LAMMPS *lmp, int narg, char **arg) :
   Fix(lmp, narg, arg),
-  pair(nullptr), spin_pairs(nullptr), locklangevinspin(nullptr),
+  fm_pair(nullptr), pair(nullptr), spin_pairs(nullptr), locklangevinspin(nullptr),
   locksetforcespin(nullptr), lockprecessionspin(nullptr),
   rsec(nullptr), stack_head(nullptr), stack_foot(nullptr),
-  backward_stacks(nullptr), forward_stacks(nullptr)
+  backward_stacks(nullptr), forward_stacks(nullptr), sector_nmax(nullptr), spin_stamp(nullptr),
+  list(nullptr), color(nullptr), color_head(nullptr), color_next(nullptr),
+  t_spin(-1), t_force(-1), t_color(-1)
 {
   if (lmp->citeme) lmp->citeme->add(cite_fix_nve_spin);
 
@@ -78,6 +96,19 @@ FixNVESpin::FixNVESpin(LAMMPS *lmp, int narg, char **arg) :
   time_integrate = 1;
   sector_flag = NONE;
   lattice_flag = 1;
+  force_local_flag = 0;
+  color_flag = 0;
+  comm_mode = COMM_COLOR;
+  nstamp = 0;
+  nmax_stamp = 0;
+  nsec_user = 0;
+  nsubstep = 1;
+  nrefresh = 1;
+  nforce_call = 0;
+  nmax_pair = 0;
+  color_stale = 1;
+  ncolors = 0;
+  nmax_color = 0;
   nlocal_max = 0;
   npairs = 0;
   npairspin = 0;
@@ -115,9 +146,51 @@ FixNVESpin::FixNVESpin(LAMMPS *lmp, int narg, char **arg) :
         lattice_flag = 1;
       else error->all(FLERR,"Illegal fix/nve/spin command");
       iarg += 2;
+    } else if (strcmp(arg[iarg],"force") == 0) {
+      if (iarg+2 > narg) error->all(FLERR,"Illegal fix/nve/spin command");
+      const std::string forcearg = arg[iarg+1];
+      if (forcearg == "full") force_local_flag = 0;
+      else if (forcearg == "local") force_local_flag = 1;
+      else error->all(FLERR,"Illegal fix/nve/spin command");
+      iarg += 2;
+    } else if (strcmp(arg[iarg],"update") == 0) {
+      if (iarg+2 > narg) error->all(FLERR,"Illegal fix/nve/spin command");
+      const std::string updatearg = arg[iarg+1];
+      if (updatearg == "sequential") color_flag = 0;
+      else if (updatearg == "color") color_flag = 1;
+      else error->all(FLERR,"Illegal fix/nve/spin command");
+      iarg += 2;
+    } else if (strcmp(arg[iarg],"sectors") == 0) {
+      if (iarg+2 > narg) error->all(FLERR,"Illegal fix/nve/spin command");
+      if (strcmp(arg[iarg+1],"auto") == 0) nsec_user = 0;
+      else {
+        nsec_user = utils::inumeric(FLERR,arg[iarg+1],false,lmp);
+        if (nsec_user < 2) error->all(FLERR,"Illegal fix/nve/spin command");
+      }
+      iarg += 2;
+    } else if (strcmp(arg[iarg],"substeps") == 0) {
+      if (iarg+2 > narg) error->all(FLERR,"Illegal fix/nve/spin command");
+      nsubstep = utils::inumeric(FLERR,arg[iarg+1],false,lmp);
+      if (nsubstep < 1) error->all(FLERR,"Illegal fix/nve/spin command");
+      iarg += 2;
+    } else if (strcmp(arg[iarg],"refresh") == 0) {
+      if (iarg+2 > narg) error->all(FLERR,"Illegal fix/nve/spin command");
+      nrefresh = utils::inumeric(FLERR,arg[iarg+1],false,lmp);
+      if (nrefresh < 1) error->all(FLERR,"Illegal fix/nve/spin command");
+      iarg += 2;
     } else error->all(FLERR,"Illegal fix/nve/spin command");
   }
 
+  // refresh skips full force evaluations, there are none with force local
+
+  if (force_local_flag && nrefresh > 1)
+    error->all(FLERR,"Fix nve/spin refresh requires force full");
+
+  // colors of ghost atoms are communicated while coloring, spins of the
+  // atoms just advanced during sector or color sweeps
+
+  if (color_flag || sector_flag) comm_forward = 6;
+
   // check if the atom/spin style is defined
 
   if (!atom->sp_flag)
@@ -136,17 +209,26 @@ FixNVESpin::FixNVESpin(LAMMPS *lmp, int narg, char **arg) :
   maglangevin_flag = 0;
   tdamp_flag = temp_flag = 0;
   setforce_spin_flag = 0;
+  nsweep = 0;
 }
 
 /* ---------------------------------------------------------------------- */
 
 FixNVESpin::~FixNVESpin()
 {
+  if (copymode) return;
+
   memory->destroy(rsec);
   memory->destroy(stack_head);
   memory->destroy(stack_foot);
+  memory->destroy(sector_nmax);
   memory->destroy(forward_stacks);
   memory->destroy(backward_stacks);
+  memory->destroy(color);
+  memory->destroy(color_head);
+  memory->destroy(color_next);
+  memory->destroy(spin_stamp);
+  memory->destroy(fm_pair);
   delete [] spin_pairs;
   delete [] locklangevinspin;
   delete [] lockprecessionspin;
@@ -172,9 +254,15 @@ void FixNVESpin::init()
 
   dtv = update->dt;
   dtf = 0.5 * update->dt * force->ftm2v;
-  dts = 0.25 * update->dt;
+  dts = 0.25 * update->dt / nsubstep;
   npairs = npairspin = 0;
 
+  // these are charged to Modify, report them separately
+
+  t_spin = timer->add_sub("nve/spin advance");
+  t_force = timer->add_sub("nve/spin force");
+  t_color = timer->add_sub("nve/spin coloring");
+
   // set ptrs on Pair/Spin styles
 
   // loop 1: obtain # of Pairs, and # of Pair/Spin styles
@@ -221,6 +309,31 @@ void FixNVESpin::init()
   if (count1 != npairspin)
     error->all(FLERR,"Incorrect number of spin pair styles");
 
+  // local force updates need the magnetic force of a single spin
+
+  if (force_local_flag && !force->pair->single_spin_enable)
+    error->all(FLERR,"Fix nve/spin force local requires a pair style "
+               "with single-spin evaluation");
+
+  // colored updates need an occasional full list over the spin cutoff
+  // the list is used until the next reneighboring, so it includes the skin
+
+  if (color_flag) {
+    double skin = neighbor->skin;
+    double cutcolor = spin_cutoff() + skin;
+    if (cutcolor == skin)
+      error->all(FLERR,"Fix nve/spin update color requires a spin cutoff");
+
+    double cutghost = MAX(force->pair->cutforce+skin,comm->cutghostuser);
+    if (cutcolor > cutghost)
+      error->all(FLERR,"Fix nve/spin update color cutoff exceeds ghost atom "
+                 "range - use comm_modify cutoff command");
+
+    auto req = neighbor->add_request(this, NeighConst::REQ_FULL | NeighConst::REQ_OCCASIONAL);
+    req->set_cutoff(cutcolor);
+    color_stale = 1;
+  }
+
   // set pair/spin and long/spin flags
 
   if (npairspin >= 1) pair_spin_flag = 1;
@@ -310,23 +423,31 @@ void FixNVESpin::init()
   // setting the sector variables/lists
 
   nsectors = 0;
-  memory->create(rsec,3,"nve/spin:rsec");
+  memory->grow(rsec,3,"nve/spin:rsec");
 
-  // perform the sectoring operation
+  // perform the sectoring operation, not needed for colored updates
 
-  if (sector_flag) sectoring();
+  if (sector_flag && !color_flag) sectoring();
 
   // init. size of stacking lists (sectoring)
 
   nlocal_max = atom->nlocal;
   memory->grow(stack_head,nsectors,"nve/spin:stack_head");
   memory->grow(stack_foot,nsectors,"nve/spin:stack_foot");
+  memory->grow(sector_nmax,nsectors,"nve/spin:sector_nmax");
   memory->grow(backward_stacks,nlocal_max,"nve/spin:backward_stacks");
   memory->grow(forward_stacks,nlocal_max,"nve/spin:forward_stacks");
 }
 
 /* ---------------------------------------------------------------------- */
 
+void FixNVESpin::init_list(int /*id*/, NeighList *ptr)
+{
+  list = ptr;
+}
+
+/* ---------------------------------------------------------------------- */
+
 void FixNVESpin::initial_integrate(int extend_vflag)
 {
   double dtfm;
@@ -361,48 +482,10 @@ void FixNVESpin::initial_integrate(int extend_vflag)
 
   // update half s for all atoms
 
-  if (sector_flag) {                            // sectoring seq. update
-    for (int j = 0; j < nsectors; j++) {        // advance quarter s for nlocal
-      comm->forward_comm();
-      int i = stack_foot[j];
-      while (i >= 0) {
-        if (mask[i] & groupbit) {
-          ComputeForceDP(eflag, vflag);
-          ComputeInteractionsSpin(i);
-          AdvanceSingleSpin(i);
-          i = forward_stacks[i];
-        }
-      }
-    }
-    for (int j = nsectors-1; j >= 0; j--) {     // advance quarter s for nlocal
-      comm->forward_comm();
-      int i = stack_head[j];
-      while (i >= 0) {
-        if (mask[i] & groupbit) {
-          ComputeForceDP(eflag, vflag);
-          ComputeInteractionsSpin(i);
-          AdvanceSingleSpin(i);
-          i = backward_stacks[i];
-        }
-      }
-    }
-  } else if (sector_flag == 0) {                // serial seq. update
-    comm->forward_comm();                       // comm. positions of ghost atoms
-    for (int i = 0; i < nlocal; i++) {           // advance quarter s for nlocal
-      if (mask[i] & groupbit) {
-        ComputeForceDP(eflag, vflag);
-        ComputeInteractionsSpin(i);
-        AdvanceSingleSpin(i);
-      }
-    }
-    for (int i = nlocal-1; i >= 0; i--) {        // advance quarter s for nlocal
-      if (mask[i] & groupbit) {
-        ComputeForceDP(eflag, vflag);
-        ComputeInteractionsSpin(i);
-        AdvanceSingleSpin(i);
-      }
-    }
-  } else error->all(FLERR,"Illegal fix nve/spin command");
+  nsweep = 0;
+  timer->sub_start(t_spin);
+  AdvanceSpins(eflag, vflag);
+  timer->sub_stop(t_spin);
 
   // update x for all particles
 
@@ -418,49 +501,58 @@ void FixNVESpin::initial_integrate(int extend_vflag)
 
   // update half s for all particles
 
-  if (sector_flag) {                            // sectoring seq. update
-    for (int j = 0; j < nsectors; j++) {        // advance quarter s for nlocal
-      comm->forward_comm();
-      int i = stack_foot[j];
-      while (i >= 0) {
+  timer->sub_start(t_spin);
+  AdvanceSpins(eflag, vflag);
+  timer->sub_stop(t_spin);
+}
+
+/* ----------------------------------------------------------------------
+   advance all spins of half a timestep, in nsubstep substeps of
+   a forward and a backward sweep, each advancing every spin of dts
+---------------------------------------------------------------------- */
+
+void FixNVESpin::AdvanceSpins(int eflag, int vflag)
+{
+  int *mask = atom->mask;
+  int nlocal = atom->nlocal;
+  if (igroup == atom->firstgroup) nlocal = atom->nfirst;
+
+  // positions changed since the last half step, the first advance
+  // always evaluates the forces
+
+  nforce_call = 0;
+
+  for (int n = 0; n < nsubstep; n++) {
+    if (color_flag) {                             // colored seq. update
+      AdvanceColoredSpins(eflag, vflag);
+    } else if (sector_flag) {                     // sectoring seq. update
+      comm->forward_comm();                       // comm. positions of ghost atoms
+      NextSweep();
+      for (int j = 0; j < nsectors; j++)          // advance quarter s for nlocal
+        AdvanceSector(j, 1, eflag, vflag);
+      NextSweep();
+      for (int j = nsectors-1; j >= 0; j--)       // advance quarter s for nlocal
+        AdvanceSector(j, 0, eflag, vflag);
+    } else if (sector_flag == 0) {                // serial seq. update
+      comm->forward_comm();                       // comm. positions of ghost atoms
+      NextSweep();
+      for (int i = 0; i < nlocal; i++) {          // advance quarter s for nlocal
         if (mask[i] & groupbit) {
-          ComputeForceDP(eflag, vflag);
+          if (!force_local_flag) RefreshForceDP(eflag, vflag);
           ComputeInteractionsSpin(i);
           AdvanceSingleSpin(i);
-          i = forward_stacks[i];
         }
       }
-    }
-    for (int j = nsectors-1; j >= 0; j--) {     // advance quarter s for nlocal
-      comm->forward_comm();
-      int i = stack_head[j];
-      while (i >= 0) {
+      NextSweep();
+      for (int i = nlocal-1; i >= 0; i--) {       // advance quarter s for nlocal
         if (mask[i] & groupbit) {
-          ComputeForceDP(eflag, vflag);
+          if (!force_local_flag) RefreshForceDP(eflag, vflag);
           ComputeInteractionsSpin(i);
           AdvanceSingleSpin(i);
-          i = backward_stacks[i];
         }
       }
-    }
-  } else if (sector_flag == 0) {                // serial seq. update
-    comm->forward_comm();                       // comm. positions of ghost atoms
-    for (int i = 0; i < nlocal; i++) {           // advance quarter s for nlocal-1
-      if (mask[i] & groupbit) {
-        ComputeForceDP(eflag, vflag);
-        ComputeInteractionsSpin(i);
-        AdvanceSingleSpin(i);
-      }
-    }
-    for (int i = nlocal-1; i >= 0; i--) {        // advance quarter s for nlocal-1
-      if (mask[i] & groupbit) {
-        ComputeForceDP(eflag, vflag);
-        ComputeInteractionsSpin(i);
-        AdvanceSingleSpin(i);
-      }
-    }
-  } else error->all(FLERR,"Illegal fix nve/spin command");
-
+    } else error->all(FLERR,"Illegal fix nve/spin command");
+  }
 }
 
 /* ----------------------------------------------------------------------
@@ -481,6 +573,8 @@ void FixNVESpin::pre_neighbor()
   double **x = atom->x;
   int nlocal = atom->nlocal;
 
+  color_stale = 1;                              // neighbors changed, recolor
+
   if (nlocal_max < nlocal) {                    // grow linked lists if necessary
     nlocal_max = nlocal;
     memory->grow(backward_stacks,nlocal_max,"nve/spin:backward_stacks");
@@ -492,24 +586,91 @@ void FixNVESpin::pre_neighbor()
     stack_foot[j] = -1;
   }
 
+  if (nsectors == 0) return;
+
   int nseci;
-  for (int j = 0; j < nsectors; j++) {          // stacking backward order
-    for (int i = 0; i < nlocal; i++) {
-      nseci = coords2sector(x[i]);
-      if (j != nseci) continue;
-      backward_stacks[i] = stack_head[j];
-      stack_head[j] = i;
-    }
+  for (int i = 0; i < nlocal; i++) {            // stacking backward order
+    nseci = coords2sector(x[i]);
+    backward_stacks[i] = stack_head[nseci];
+    stack_head[nseci] = i;
+  }
+  for (int i = nlocal-1; i >= 0; i--) {         // stacking forward order
+    nseci = coords2sector(x[i]);
+    forward_stacks[i] = stack_foot[nseci];
+    stack_foot[nseci] = i;
   }
-  for (int j = nsectors-1; j >= 0; j--) {       // stacking forward order
-    for (int i = nlocal-1; i >= 0; i--) {
-      nseci = coords2sector(x[i]);
-      if (j != nseci) continue;
-      forward_stacks[i] = stack_foot[j];
-      stack_foot[j] = i;
+
+  // largest # of group atoms in each sector over all procs
+
+  int *mask = atom->mask;
+  std::vector<int> count(nsectors,0);
+  for (int i = 0; i < nlocal; i++)
+    if (mask[i] & groupbit) count[coords2sector(x[i])]++;
+  MPI_Allreduce(count.data(),sector_nmax,nsectors,MPI_INT,MPI_MAX,world);
+
+}
+
+/* ----------------------------------------------------------------------
+   advance the spins of sector j, in forward or backward stacking order
+   a full force evaluation communicates, so all procs call it as many
+   times as sector j has atoms on the proc where it is most populated
+   ghost atoms must be current, the new spins are sent afterwards
+---------------------------------------------------------------------- */
+
+void FixNVESpin::AdvanceSector(int j, int forward, int eflag, int vflag)
+{
+  int *mask = atom->mask;
+  int *next = forward ? forward_stacks : backward_stacks;
+  int i = forward ? stack_foot[j] : stack_head[j];
+
+  grow_stamp();
+
+  if (force_local_flag) {
+    for (; i >= 0; i = next[i]) {
+      if (!(mask[i] & groupbit)) continue;
+      ComputeInteractionsSpin(i);
+      AdvanceSingleSpin(i);
+      spin_stamp[i] = nstamp;
+    }
+  } else {
+    for (int k = 0; k < sector_nmax[j]; k++) {
+      while (i >= 0 && !(mask[i] & groupbit)) i = next[i];
+      RefreshForceDP(eflag, vflag);
+      if (i < 0) continue;
+      ComputeInteractionsSpin(i);
+      AdvanceSingleSpin(i);
+      spin_stamp[i] = nstamp;
+      i = next[i];
     }
   }
 
+  ForwardSpins();
+}
+
+/* ----------------------------------------------------------------------
+   send the spins advanced since the last call to the ghost atoms
+   only the atoms stamped with nstamp are packed, so the halo traffic
+   of a sweep is that of one spin per atom instead of a full forward comm
+---------------------------------------------------------------------- */
+
+void FixNVESpin::ForwardSpins()
+{
+  comm_mode = COMM_SPIN;
+  comm->forward_comm(this);
+  comm_mode = COMM_COLOR;
+  nstamp++;
+}
+
+/* ----------------------------------------------------------------------
+   grow the per-atom stamps of advanced spins to the owned+ghost atoms
+---------------------------------------------------------------------- */
+
+void FixNVESpin::grow_stamp()
+{
+  if (atom->nmax <= nmax_stamp) return;
+  memory->grow(spin_stamp,atom->nmax,"nve/spin:spin_stamp");
+  for (int i = nmax_stamp; i < atom->nmax; i++) spin_stamp[i] = -1;
+  nmax_stamp = atom->nmax;
 }
 
 /* ----------------------------------------------------------------------
@@ -529,10 +690,22 @@ void FixNVESpin::ComputeInteractionsSpin(int i)
   spi[1] = sp[i][1];
   spi[2] = sp[i][2];
 
-  //fmi[0] = fmi[1] = fmi[2] = 0.0;
-  fmi[0] = fm[i][0];
-  fmi[1] = fm[i][1];
-  fmi[2] = fm[i][2];
+  // with local force updates, only the pair contribution to spin i is
+  // recomputed, otherwise fm[i] comes from the full ComputeForceDP() call
+  // or from the copy of its last call, if it is not refreshed every time
+
+  if (force_local_flag) {
+    fmi[0] = fmi[1] = fmi[2] = 0.0;
+    force->pair->compute_single_spin(i,fmi);
+  } else if (nrefresh > 1) {
+    fmi[0] = fm_pair[i][0];
+    fmi[1] = fm_pair[i][1];
+    fmi[2] = fm_pair[i][2];
+  } else {
+    fmi[0] = fm[i][0];
+    fmi[1] = fm[i][1];
+    fmi[2] = fm[i][2];
+  }
 
   // update magnetic pair interactions
   /*
@@ -572,13 +745,16 @@ void FixNVESpin::ComputeInteractionsSpin(int i)
 }
 
 /* ----------------------------------------------------------------------
-   divide each domain into 8 sectors
+   divide each domain into nsec[0]*nsec[1]*nsec[2] sectors
+   all procs advance the sectors of same index at once, these are
+   (nsec-1) sector widths apart along each dimension, which must
+   exceed the spin cutoff
 ---------------------------------------------------------------------- */
 
 void FixNVESpin::sectoring()
 {
   int sec[3];
-  double sublo[3],subhi[3];
+  double sublo[3],subhi[3],rs[3];
 
   if (domain->triclinic == 1){
      double* sublotmp = domain->sublo_lamda;
@@ -598,46 +774,45 @@ void FixNVESpin::sectoring()
      }
   }
 
-  const double rsx = subhi[0] - sublo[0];
-  const double rsy = subhi[1] - sublo[1];
-  const double rsz = subhi[2] - sublo[2];
-
-  // extract larger cutoff from PairSpin styles
+  for (int dim = 0; dim < 3; dim++) rs[dim] = subhi[dim] - sublo[dim];
 
-  double rv, cutoff;
-  rv = cutoff = 0.0;
-  int dim = 0;
-  for (int i = 0; i < npairspin ; i++) {
-    cutoff = *((double *) spin_pairs[i]->extract("cut",dim));
-    rv = MAX(rv,cutoff);
-  }
+  // largest cutoff of the PairSpin styles or spin cutoff of the pair style
 
+  double rv = spin_cutoff();
   if (rv == 0.0)
    error->all(FLERR,"Illegal sectoring operation");
 
-  double rax = rsx/rv;
-  double ray = rsy/rv;
-  double raz = rsz/rv;
-
-  sec[0] = 1;
-  sec[1] = 1;
-  sec[2] = 1;
-  if (rax >= 2.0) sec[0] = 2;
-  if (ray >= 2.0) sec[1] = 2;
-  if (raz >= 2.0) sec[2] = 2;
-
-  nsectors = sec[0]*sec[1]*sec[2];
+  double cutghost = MAX(force->pair->cutforce+neighbor->skin,comm->cutghostuser);
+  if (rv > cutghost)
+    error->all(FLERR,"Fix nve/spin sectoring cutoff exceeds ghost atom "
+               "range - use comm_modify cutoff command");
+
+  // auto = fewest sectors with (n-1)*rs/n >= rv, n >= 2
+  // the same counts are used on all procs, as sectors are swept together
+
+  int flag = 0;
+  for (int dim = 0; dim < 3; dim++) {
+    if (nsec_user) sec[dim] = nsec_user;
+    else if (rs[dim] > rv)
+      sec[dim] = MAX(2,static_cast<int>(ceil(rs[dim]/(rs[dim]-rv))));
+    else {
+      sec[dim] = 2;
+      flag = 1;
+    }
+  }
+  MPI_Allreduce(sec,nsec,3,MPI_INT,MPI_MAX,world);
 
-  if (sector_flag == 1 && nsectors != 8)
-    error->all(FLERR,"Illegal sectoring operation");
+  for (int dim = 0; dim < 3; dim++) {
+    rsec[dim] = rs[dim]/nsec[dim];
+    if ((nsec[dim]-1)*rsec[dim] < rv) flag = 1;
+  }
 
-  rsec[0] = rsx;
-  rsec[1] = rsy;
-  rsec[2] = rsz;
-  if (sec[0] == 2) rsec[0] = rsx/2.0;
-  if (sec[1] == 2) rsec[1] = rsy/2.0;
-  if (sec[2] == 2) rsec[2] = rsz/2.0;
+  int flagall;
+  MPI_Allreduce(&flag,&flagall,1,MPI_INT,MPI_MAX,world);
+  if (flagall)
+    error->all(FLERR,"Fix nve/spin sectors are too small for the spin cutoff");
 
+  nsectors = nsec[0]*nsec[1]*nsec[2];
 }
 
 /* ----------------------------------------------------------------------
@@ -654,15 +829,222 @@ int FixNVESpin::coords2sector(double *x)
     sublo[dim]=sublotmp[dim];
   }
 
-  seci[0] = x[0] > (sublo[0] + rsec[0]);
-  seci[1] = x[1] > (sublo[1] + rsec[1]);
-  seci[2] = x[2] > (sublo[2] + rsec[2]);
+  for (int dim = 0; dim < 3; dim++) {
+    seci[dim] = static_cast<int>((x[dim] - sublo[dim]) / rsec[dim]);
+    seci[dim] = MAX(0,MIN(seci[dim],nsec[dim]-1));
+  }
 
-  nseci = (seci[0] + 2*seci[1] + 4*seci[2]);
+  nseci = seci[0] + nsec[0]*(seci[1] + nsec[1]*seci[2]);
 
   return nseci;
 }
 
+/* ----------------------------------------------------------------------
+   largest distance over which two spins see each other's update,
+   from the PairSpin styles and the spin cutoff of other pair styles
+---------------------------------------------------------------------- */
+
+double FixNVESpin::spin_cutoff()
+{
+  double rv = 0.0;
+  int dim = 0;
+  for (int i = 0; i < npairspin; i++)
+    rv = MAX(rv,*((double *) spin_pairs[i]->extract("cut",dim)));
+
+  if (force->pair) {
+    auto ptr = (double *) force->pair->extract("cut_spin",dim);
+    if (ptr) rv = MAX(rv,*ptr);
+  }
+
+  return rv;
+}
+
+/* ----------------------------------------------------------------------
+   color the graph of spins closer than the spin cutoff
+   spins of one color can be advanced after a single force evaluation
+   distributed greedy coloring (Jones-Plassmann): an atom takes the lowest
+   color free among its neighbors once all uncolored neighbors have a
+   lower priority, ghost colors are updated by forward comm each round
+---------------------------------------------------------------------- */
+
+void FixNVESpin::coloring()
+{
+  int i,j,ii,jj,inum,jnum,ci,cj;
+  int *ilist,*jlist,*numneigh,**firstneigh;
+
+  tagint *tag = atom->tag;
+  int *mask = atom->mask;
+  int nlocal = atom->nlocal;
+  int nall = nlocal + atom->nghost;
+
+  timer->sub_start(t_color);
+  if (atom->nmax > nmax_color) {
+    nmax_color = atom->nmax;
+    memory->destroy(color);
+    memory->destroy(color_next);
+    memory->create(color,nmax_color,"nve/spin:color");
+    memory->create(color_next,nmax_color,"nve/spin:color_next");
+  }
+
+  neighbor->build_one(list);
+
+  inum = list->inum;
+  ilist = list->ilist;
+  numneigh = list->numneigh;
+  firstneigh = list->firstneigh;
+
+  // -1 = not yet colored, -2 = outside the group, never advanced
+
+  for (i = 0; i < nall; i++) color[i] = (mask[i] & groupbit) ? -1 : -2;
+
+  // forbidden[c] = last atom which found color c among its neighbors
+
+  std::vector<int> forbidden;
+  int nuncolored,nuncolored_all;
+
+  while (true) {
+    nuncolored = 0;
+    for (ii = 0; ii < inum; ii++) {
+      i = ilist[ii];
+      if (color[i] != -1) continue;
+      jlist = firstneigh[i];
+      jnum = numneigh[i];
+
+      uint64_t ipriority = color_priority(tag[i]);
+      for (jj = 0; jj < jnum; jj++) {
+        j = jlist[jj] & NEIGHMASK;
+        if (tag[j] == tag[i]) continue;
+        if (color[j] == -1 && color_priority(tag[j]) > ipriority) break;
+      }
+      if (jj < jnum) {
+        nuncolored++;
+        continue;
+      }
+
+      for (jj = 0; jj < jnum; jj++) {
+        j = jlist[jj] & NEIGHMASK;
+        if (tag[j] == tag[i]) continue;
+        cj = color[j];
+        if (cj < 0) continue;
+        if (cj >= (int) forbidden.size()) forbidden.resize(cj+1,-1);
+        forbidden[cj] = i;
+      }
+      ci = 0;
+      while (ci < (int) forbidden.size() && forbidden[ci] == i) ci++;
+      color[i] = ci;
+    }
+
+    comm->forward_comm(this);
+    MPI_Allreduce(&nuncolored,&nuncolored_all,1,MPI_INT,MPI_SUM,world);
+    if (nuncolored_all == 0) break;
+  }
+
+  // store in linked lists the owned atoms of each color
+
+  int maxcolor = -1;
+  for (i = 0; i < nlocal; i++) maxcolor = MAX(maxcolor,color[i]);
+  MPI_Allreduce(&maxcolor,&ncolors,1,MPI_INT,MPI_MAX,world);
+  ncolors++;
+
+  memory->destroy(color_head);
+  memory->create(color_head,MAX(ncolors,1),"nve/spin:color_head");
+  for (ci = 0; ci < ncolors; ci++) color_head[ci] = -1;
+  for (i = nlocal-1; i >= 0; i--) {
+    if (color[i] < 0) continue;
+    color_next[i] = color_head[color[i]];
+    color_head[color[i]] = i;
+  }
+
+  color_stale = 0;
+  timer->sub_stop(t_color);
+}
+
+/* ----------------------------------------------------------------------
+   advance all spins of half a timestep, color by color,
+   forward then backward through the colors (Suzuki-Trotter)
+   one force evaluation per color instead of one per spin
+---------------------------------------------------------------------- */
+
+void FixNVESpin::AdvanceColoredSpins(int eflag, int vflag)
+{
+  if (color_stale) coloring();
+  grow_stamp();
+
+  comm->forward_comm();
+  for (int k = 0; k < 2*ncolors; k++) {
+    int c = (k < ncolors) ? k : 2*ncolors-1-k;
+    if (k == 0 || k == ncolors) NextSweep();
+    if (!force_local_flag) RefreshForceDP(eflag, vflag);
+    int i = color_head[c];
+    while (i >= 0) {
+      ComputeInteractionsSpin(i);
+      AdvanceSingleSpin(i);
+      spin_stamp[i] = nstamp;
+      i = color_next[i];
+    }
+    ForwardSpins();
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+
+int FixNVESpin::pack_forward_comm(int n, int *list, double *buf,
+                                  int /*pbc_flag*/, int * /*pbc*/)
+{
+  int m = 0;
+  if (comm_mode == COMM_COLOR) {
+    for (int i = 0; i < n; i++)
+      buf[m++] = ubuf(color[list[i]]).d;
+    return m;
+  }
+
+  // advanced spins only: count, then (position in list, spin) per atom
+
+  if (n == 0) return 0;
+  double **sp = atom->sp;
+  int nsend = 0;
+  m = 1;
+  for (int i = 0; i < n; i++) {
+    int j = list[i];
+    if (spin_stamp[j] != nstamp) continue;
+    buf[m++] = ubuf(i).d;
+    buf[m++] = sp[j][0];
+    buf[m++] = sp[j][1];
+    buf[m++] = sp[j][2];
+    buf[m++] = sp[j][3];
+    nsend++;
+  }
+  buf[0] = ubuf(nsend).d;
+  return m;
+}
+
+/* ---------------------------------------------------------------------- */
+
+void FixNVESpin::unpack_forward_comm(int n, int first, double *buf)
+{
+  int m = 0;
+  if (comm_mode == COMM_COLOR) {
+    int last = first + n;
+    for (int i = first; i < last; i++)
+      color[i] = (int) ubuf(buf[m++]).i;
+    return;
+  }
+
+  // received ghosts are stamped too, so later swaps pass them on
+
+  if (n == 0) return;
+  double **sp = atom->sp;
+  int nrecv = (int) ubuf(buf[m++]).i;
+  for (int k = 0; k < nrecv; k++) {
+    int i = first + (int) ubuf(buf[m++]).i;
+    sp[i][0] = buf[m++];
+    sp[i][1] = buf[m++];
+    sp[i][2] = buf[m++];
+    sp[i][3] = buf[m++];
+    spin_stamp[i] = nstamp;
+  }
+}
+
 /* ----------------------------------------------------------------------
    advance the spin i of a timestep dts
 ---------------------------------------------------------------------- */
@@ -726,6 +1108,24 @@ void FixNVESpin::AdvanceSingleSpin(int i)
 
 }
 
+/* ----------------------------------------------------------------------
+   start a new sweep advancing every spin once,
+   the langevin/spin fixes draw the random fields of all spins for it
+   scale = spin timestep of the sweep in units of dts
+---------------------------------------------------------------------- */
+
+void FixNVESpin::NextSweep(double scale)
+{
+  // random_field() takes it in units of a quarter timestep
+
+  if (maglangevin_flag) {
+    const double dtsweep = scale * dts / (0.25 * update->dt);
+    for (int k = 0; k < nlangspin; k++)
+      locklangevinspin[k]->random_field(nsweep,dtsweep);
+  }
+  nsweep++;
+}
+
 /* ---------------------------------------------------------------------- */
 
 void FixNVESpin::final_integrate()
@@ -759,11 +1159,12 @@ void FixNVESpin::final_integrate()
 
 /* ----------------------------------------------------------------------
    compute f and fm by DeePMD before advancing spin
+   positions and spins of ghost atoms are kept current by the callers
 ---------------------------------------------------------------------- */
 
 void FixNVESpin::ComputeForceDP(int eflag, int vflag)
 {
-  comm->forward_comm();
+  timer->sub_start(t_force);
 
   size_t nbytes;
   int nlocal = atom->nlocal;
@@ -772,6 +1173,7 @@ void FixNVESpin::ComputeForceDP(int eflag, int vflag)
     if (force->newton) 
       nbytes += sizeof(double) * atom->nghost;
     if (nbytes) {
+      memset(&atom->f[0][0],0,3*nbytes);
       if (atom->torque_flag) 
         memset(&atom->torque[0][0],0,3*nbytes);
       atom->avec->force_clear(0,nbytes);
@@ -780,6 +1182,7 @@ void FixNVESpin::ComputeForceDP(int eflag, int vflag)
   else {
     nbytes = sizeof(double) * atom->nfirst;
     if (nbytes) {
+      memset(&atom->f[0][0],0,3*nbytes);
       if (atom->torque_flag) 
         memset(&atom->torque[0][0],0,3*nbytes);
       atom->avec->force_clear(0,nbytes);
@@ -787,8 +1190,9 @@ void FixNVESpin::ComputeForceDP(int eflag, int vflag)
     if (force->newton) {
       nbytes = sizeof(double) * atom->nghost;
       if (nbytes) {
+        memset(&atom->f[nlocal][0],0,3*nbytes);
         if (atom->torque_flag) 
-          memset(&atom->torque[0][0],0,3*nbytes);
+          memset(&atom->torque[nlocal][0],0,3*nbytes);
         atom->avec->force_clear(nlocal,nbytes);
       }
     }
@@ -807,4 +1211,39 @@ void FixNVESpin::ComputeForceDP(int eflag, int vflag)
   
   if (modify->n_post_force_any) 
     modify->post_force(vflag);
-}
\ No newline at end of file
+  timer->sub_stop(t_force);
+}
+
+/* ----------------------------------------------------------------------
+   compute f and fm by DeePMD before advancing a spin or a set of spins,
+   only every nrefresh calls of a half step: in between, the spins move
+   in the magnetic field of the last evaluation, stored in fm_pair,
+   plus the precession and langevin terms of their current orientation
+   all procs make the same sequence of calls, so they skip the same ones
+---------------------------------------------------------------------- */
+
+void FixNVESpin::RefreshForceDP(int eflag, int vflag)
+{
+  if (nrefresh == 1) {
+    ComputeForceDP(eflag, vflag);
+    return;
+  }
+
+  if (nforce_call++ % nrefresh) return;
+
+  ComputeForceDP(eflag, vflag);
+
+  if (atom->nmax > nmax_pair) {
+    nmax_pair = atom->nmax;
+    memory->destroy(fm_pair);
+    memory->create(fm_pair,nmax_pair,3,"nve/spin:fm_pair");
+  }
+
+  double **fm = atom->fm;
+  int nlocal = atom->nlocal;
+  for (int i = 0; i < nlocal; i++) {
+    fm_pair[i][0] = fm[i][0];
+    fm_pair[i][1] = fm[i][1];
+    fm_pair[i][2] = fm[i][2];
+  }
+}
@@ -32,15 +32,29 @@ class FixNVESpin : public Fix {
   ~FixNVESpin() override;
   int setmask() override;
   void init() override;
+  void init_list(int, class NeighList *) override;
   void initial_integrate(int) override;
   void final_integrate() override;
 
   void ComputeInteractionsSpin(int);    // compute and advance single spin functions
   void ComputeForceDP(int, int);
+  void RefreshForceDP(int, int);
+  void AdvanceSpins(int, int);
   void AdvanceSingleSpin(int);
+  void NextSweep(double = 1.0);
 
   void sectoring();    // sectoring operation functions
   int coords2sector(double *);
+  void AdvanceSector(int, int, int, int);
+  void ForwardSpins();
+  void grow_stamp();
+
+  void coloring();    // graph coloring operation functions
+  void AdvanceColoredSpins(int, int);
+  double spin_cutoff();
+
+  int pack_forward_comm(int, int *, double *, int, int *) override;
+  void unpack_forward_comm(int, int, double *) override;
 
   void setup_pre_neighbor() override;
   void pre_neighbor() override;
@@ -48,12 +62,26 @@ class FixNVESpin : public Fix {
   int lattice_flag;    // lattice_flag = 0 if spins only
                        // lattice_flag = 1 if spin-lattice calc.
 
+  int force_local_flag;    // force_local_flag = 0 if full force call per spin
+                           // force_local_flag = 1 if single-spin pair call
+
  protected:
   int sector_flag;    // sector_flag = 0  if serial algorithm
                       // sector_flag = 1  if parallel algorithm
 
+  int color_flag;    // color_flag = 0 if spins advanced one at a time
+                     // color_flag = 1 if spins advanced by color
+
+  int nsec_user;    // sectors per dimension, 0 = auto
+
   double dtv, dtf, dts;    // velocity, force, and spin timesteps
 
+  int nsubstep;       // # of spin substeps per half timestep
+  int nrefresh;       // # of spin advances per full force evaluation
+  int nforce_call;    // # of RefreshForceDP() calls in this half step
+  int nmax_pair;      // size of fm_pair
+  double **fm_pair;   // magnetic force of the last full force evaluation
+
   int nlocal_max;    // max value of nlocal (for size of lists)
 
   int pair_spin_flag;          // magnetic pair flags
@@ -73,6 +101,7 @@ class FixNVESpin : public Fix {
 
   int nlangspin;
   class FixLangevinSpin **locklangevinspin;
+  int nsweep;    // # of sweeps over all spins in this timestep
 
   // pointers to fix setforce/spin styles
 
@@ -87,7 +116,8 @@ class FixNVESpin : public Fix {
   // sectoring variables
 
   int nsectors;
-  double *rsec;
+  int nsec[3];     // # of sectors along each dimension
+  double *rsec;    // sector widths
 
   // stacking variables for sectoring algorithm
 
@@ -95,6 +125,31 @@ class FixNVESpin : public Fix {
   int *stack_foot;         // index of first atom in forward_stacks
   int *backward_stacks;    // index of next atom in backward stack
   int *forward_stacks;     // index of next atom in forward stack
+  int *sector_nmax;        // max # of group atoms of each sector over procs
+
+  // spin-only forward comm of the spins advanced in a sector or color
+
+  enum { COMM_COLOR, COMM_SPIN };
+  int comm_mode;      // what pack/unpack_forward_comm() exchange
+  int nstamp;         // stamp of the spins advanced since the last comm
+  int nmax_stamp;     // size of spin_stamp
+  int *spin_stamp;    // stamp of the last advance of each atom
+
+  // graph coloring variables
+
+  class NeighList *list;    // occasional full list over the spin cutoff
+  int color_stale;          // 1 if coloring must be redone
+  int ncolors;              // # of colors over all procs
+  int nmax_color;           // size of per-atom coloring arrays
+  int *color;               // color of each owned and ghost atom
+  int *color_head;          // index of first atom of each color
+  int *color_next;          // index of next atom with the same color
+
+  // sub-timers of the spin integration
+
+  int t_spin;               // spin half steps, incl. force evaluations
+  int t_force;              // ComputeForceDP()
+  int t_color;              // coloring()
 };
 
 }    // namespace LAMMPS_NS
@@ -0,0 +1,296 @@
+// clang-format off
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   https://www.lammps.org/, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#include "fix_nve_spin_midpoint.h"
+
+#include "atom.h"
+#include "comm.h"
+#include "error.h"
+#include "memory.h"
+#include "timer.h"
+#include "update.h"
+
+#include <cstring>
+
+using namespace LAMMPS_NS;
+
+/* ----------------------------------------------------------------------
+   args of the fix without the keywords of this style, which are
+   parsed here and not by FixNVESpin
+------------------------------------------------------------------------- */
+
+static std::vector<char *> base_args(int narg, char **arg)
+{
+  std::vector<char *> args;
+  for (int iarg = 0; iarg < narg; iarg++) {
+    if ((iarg >= 3) && (iarg+1 < narg) &&
+        ((strcmp(arg[iarg],"iterations") == 0) ||
+         (strcmp(arg[iarg],"tolerance") == 0))) iarg++;
+    else args.push_back(arg[iarg]);
+  }
+  return args;
+}
+
+/* ---------------------------------------------------------------------- */
+
+FixNVESpinMidpoint::FixNVESpinMidpoint(LAMMPS *lmp, int narg, char **arg) :
+  FixNVESpinMidpoint(lmp, narg, arg, base_args(narg, arg)) {}
+
+/* ---------------------------------------------------------------------- */
+
+FixNVESpinMidpoint::FixNVESpinMidpoint(LAMMPS *lmp, int narg, char **arg,
+                                       std::vector<char *> args) :
+  FixNVESpin(lmp, args.size(), args.data()), sp_old(nullptr), sp_new(nullptr)
+{
+  midpoint_iter = 10;
+  midpoint_tol = 1.0e-8;
+
+  for (int iarg = 3; iarg < narg; iarg++) {
+    if (strcmp(arg[iarg],"iterations") == 0) {
+      if (iarg+2 > narg) error->all(FLERR,"Illegal fix/nve/spin/midpoint command");
+      midpoint_iter = utils::inumeric(FLERR,arg[iarg+1],false,lmp);
+      if (midpoint_iter < 1) error->all(FLERR,"Illegal fix/nve/spin/midpoint command");
+      iarg++;
+    } else if (strcmp(arg[iarg],"tolerance") == 0) {
+      if (iarg+2 > narg) error->all(FLERR,"Illegal fix/nve/spin/midpoint command");
+      midpoint_tol = utils::numeric(FLERR,arg[iarg+1],false,lmp);
+      if (midpoint_tol <= 0.0) error->all(FLERR,"Illegal fix/nve/spin/midpoint command");
+      iarg++;
+    }
+  }
+
+  // all spins are advanced at once, there is no update order
+
+  if (color_flag || nsec_user || nrefresh > 1)
+    error->all(FLERR,"Fix nve/spin/midpoint does not support the "
+               "update, sectors and refresh keywords");
+
+  sector_flag = 0;
+  comm_forward = 0;
+
+  scalar_flag = 1;
+  global_freq = 1;
+  extscalar = 0;
+
+  nmax_mid = 0;
+  nforce = 0;
+  warn_flag = 0;
+}
+
+/* ---------------------------------------------------------------------- */
+
+FixNVESpinMidpoint::~FixNVESpinMidpoint()
+{
+  memory->destroy(sp_old);
+  memory->destroy(sp_new);
+}
+
+/* ---------------------------------------------------------------------- */
+
+void FixNVESpinMidpoint::init()
+{
+  FixNVESpin::init();
+
+  dtm = 0.5 * update->dt / nsubstep;
+  warn_flag = 0;
+}
+
+/* ---------------------------------------------------------------------- */
+
+void FixNVESpinMidpoint::initial_integrate(int extend_vflag)
+{
+  double dtfm;
+
+  double **x = atom->x;
+  double **v = atom->v;
+  double **f = atom->f;
+  double *rmass = atom->rmass;
+  double *mass = atom->mass;
+  int nlocal = atom->nlocal;
+  if (igroup == atom->firstgroup) nlocal = atom->nfirst;
+  int *type = atom->type;
+  int *mask = atom->mask;
+
+  // divide extend_vflag into true eflag and vflag
+
+  int eflag = extend_vflag / 10;
+  int vflag = extend_vflag % 10;
+
+  // update half v for all atoms
+
+  if (lattice_flag) {
+    for (int i = 0; i < nlocal; i++) {
+      if (mask[i] & groupbit) {
+        if (rmass) dtfm = dtf / rmass[i];
+        else dtfm = dtf / mass[type[i]];
+        v[i][0] += dtfm * f[i][0];
+        v[i][1] += dtfm * f[i][1];
+        v[i][2] += dtfm * f[i][2];
+      }
+    }
+  }
+
+  // update half s for all atoms
+
+  nsweep = 0;
+  nforce = 0;
+  timer->sub_start(t_spin);
+  for (int n = 0; n < nsubstep; n++) AdvanceSpinsMidpoint(eflag, vflag);
+  timer->sub_stop(t_spin);
+
+  // update x for all particles
+
+  if (lattice_flag) {
+    for (int i = 0; i < nlocal; i++) {
+      if (mask[i] & groupbit) {
+        x[i][0] += dtv * v[i][0];
+        x[i][1] += dtv * v[i][1];
+        x[i][2] += dtv * v[i][2];
+      }
+    }
+  }
+
+  // update half s for all particles
+
+  timer->sub_start(t_spin);
+  for (int n = 0; n < nsubstep; n++) AdvanceSpinsMidpoint(eflag, vflag);
+  timer->sub_stop(t_spin);
+}
+
+/* ----------------------------------------------------------------------
+   advance all spins at once of half a timestep by the implicit midpoint
+   rule s1 = s0 + dtm * fm(sm) x sm, with sm = (s0+s1)/2
+   for a given field, s1 is the Cayley rotation of s0 (as computed by
+   AdvanceSingleSpin()), so the norm of the spins is conserved exactly
+   the field at the midpoint is found by fixed-point iterations, each
+   costs one force evaluation of the whole system
+------------------------------------------------------------------------- */
+
+void FixNVESpinMidpoint::AdvanceSpinsMidpoint(int eflag, int vflag)
+{
+  double **sp = atom->sp;
+  double **fm = atom->fm;
+  int *mask = atom->mask;
+  int nlocal = atom->nlocal;
+
+  if (atom->nmax > nmax_mid) {
+    nmax_mid = atom->nmax;
+    memory->destroy(sp_old);
+    memory->destroy(sp_new);
+    memory->create(sp_old,nmax_mid,3,"nve/spin/midpoint:sp_old");
+    memory->create(sp_new,nmax_mid,3,"nve/spin/midpoint:sp_new");
+  }
+
+  for (int i = 0; i < nlocal; i++) {
+    if (!(mask[i] & groupbit)) continue;
+    sp_old[i][0] = sp_new[i][0] = sp[i][0];
+    sp_old[i][1] = sp_new[i][1] = sp[i][1];
+    sp_old[i][2] = sp_new[i][2] = sp[i][2];
+  }
+
+  // one random field for the whole advance, which spans dtm/dts sweeps
+
+  NextSweep(dtm/dts);
+
+  // the first iteration is an explicit step with the field at s0
+
+  const double dtm2 = dtm*dtm;
+  const double tol2 = midpoint_tol*midpoint_tol;
+  double dmax,dmaxall;
+  int iter;
+
+  for (iter = 0; iter < midpoint_iter; iter++) {
+
+    // spins at the midpoint of the current estimate
+
+    for (int i = 0; i < nlocal; i++) {
+      if (!(mask[i] & groupbit)) continue;
+      sp[i][0] = 0.5*(sp_old[i][0] + sp_new[i][0]);
+      sp[i][1] = 0.5*(sp_old[i][1] + sp_new[i][1]);
+      sp[i][2] = 0.5*(sp_old[i][2] + sp_new[i][2]);
+    }
+    comm->forward_comm();
+
+    if (!force_local_flag) ComputeForceDP(eflag, vflag);
+    nforce++;
+
+    dmax = 0.0;
+    for (int i = 0; i < nlocal; i++) {
+      if (!(mask[i] & groupbit)) continue;
+      ComputeInteractionsSpin(i);
+
+      const double *s = sp_old[i];
+      const double *h = fm[i];
+      const double fm2 = h[0]*h[0] + h[1]*h[1] + h[2]*h[2];
+      const double energy = s[0]*h[0] + s[1]*h[1] + s[2]*h[2];
+      const double scale = 1.0/(1.0 + 0.25*fm2*dtm2);
+      double g[3];
+
+      g[0] = s[0] + (h[1]*s[2] - h[2]*s[1])*dtm;
+      g[1] = s[1] + (h[2]*s[0] - h[0]*s[2])*dtm;
+      g[2] = s[2] + (h[0]*s[1] - h[1]*s[0])*dtm;
+      g[0] += (h[0]*energy - 0.5*s[0]*fm2)*0.5*dtm2;
+      g[1] += (h[1]*energy - 0.5*s[1]*fm2)*0.5*dtm2;
+      g[2] += (h[2]*energy - 0.5*s[2]*fm2)*0.5*dtm2;
+      g[0] *= scale;
+      g[1] *= scale;
+      g[2] *= scale;
+
+      const double dx = g[0] - sp_new[i][0];
+      const double dy = g[1] - sp_new[i][1];
+      const double dz = g[2] - sp_new[i][2];
+      dmax = MAX(dmax,dx*dx + dy*dy + dz*dz);
+
+      sp_new[i][0] = g[0];
+      sp_new[i][1] = g[1];
+      sp_new[i][2] = g[2];
+    }
+
+    MPI_Allreduce(&dmax,&dmaxall,1,MPI_DOUBLE,MPI_MAX,world);
+    if (dmaxall <= tol2) break;
+  }
+
+  if (iter == midpoint_iter && !warn_flag) {
+    if (comm->me == 0)
+      error->warning(FLERR,"Fix nve/spin/midpoint did not converge in {} "
+                     "iterations on step {}",midpoint_iter,update->ntimestep);
+    warn_flag = 1;
+  }
+
+  for (int i = 0; i < nlocal; i++) {
+    if (!(mask[i] & groupbit)) continue;
+    sp[i][0] = sp_new[i][0];
+    sp[i][1] = sp_new[i][1];
+    sp[i][2] = sp_new[i][2];
+  }
+  comm->forward_comm();
+}
+
+/* ----------------------------------------------------------------------
+   # of force evaluations in the last timestep
+------------------------------------------------------------------------- */
+
+double FixNVESpinMidpoint::compute_scalar()
+{
+  return (double) nforce;
+}
+
+/* ----------------------------------------------------------------------
+   memory usage of local atom-based arrays
+------------------------------------------------------------------------- */
+
+double FixNVESpinMidpoint::memory_usage()
+{
+  return (double)nmax_mid*6*sizeof(double);
+}
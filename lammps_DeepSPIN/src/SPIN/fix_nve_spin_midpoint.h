@@ -0,0 +1,57 @@
+/* -*- c++ -*- ----------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   https://www.lammps.org/, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#ifdef FIX_CLASS
+// clang-format off
+FixStyle(nve/spin/midpoint,FixNVESpinMidpoint);
+// clang-format on
+#else
+
+#ifndef LMP_FIX_NVE_SPIN_MIDPOINT_H
+#define LMP_FIX_NVE_SPIN_MIDPOINT_H
+
+#include "fix_nve_spin.h"
+
+#include <vector>
+
+namespace LAMMPS_NS {
+
+class FixNVESpinMidpoint : public FixNVESpin {
+ public:
+  FixNVESpinMidpoint(class LAMMPS *, int, char **);
+  ~FixNVESpinMidpoint() override;
+  void init() override;
+  void initial_integrate(int) override;
+  double compute_scalar() override;
+  double memory_usage() override;
+
+ protected:
+  int midpoint_iter;     // max # of fixed-point iterations
+  double midpoint_tol;   // convergence tolerance on the spins
+  double dtm;            // spin timestep of a midpoint advance, dt/(2*nsubstep)
+  int nmax_mid;          // length of the per-atom arrays
+  double **sp_old;       // spins at the start of the advance
+  double **sp_new;       // current estimate of the advanced spins
+  int nforce;            // # of force evaluations in the last timestep
+  int warn_flag;         // 1 if non-convergence was already reported
+
+  void AdvanceSpinsMidpoint(int, int);
+
+ private:
+  FixNVESpinMidpoint(class LAMMPS *, int, char **, std::vector<char *>);
+};
+
+}    // namespace LAMMPS_NS
+
+#endif
+#endif
@@ -33,6 +33,7 @@
 #include "math_const.h"
 #include "memory.h"
 #include "modify.h"
+#include "output.h"
 #include "respa.h"
 #include "update.h"
 #include "variable.h"
@@ -65,7 +66,7 @@ FixPrecessionSpin::FixPrecessionSpin(LAMMPS *lmp, int narg, char **arg) :
   magstr = nullptr;
   magfieldstyle = CONSTANT;
 
-  H_field = 0.0;
+  H_fieldT = H_field = 0.0;
   nhx = nhy = nhz = 0.0;
   hx = hy = hz = 0.0;
   stt_field = 0.0;
@@ -89,7 +90,7 @@ FixPrecessionSpin::FixPrecessionSpin(LAMMPS *lmp, int narg, char **arg) :
     if (strcmp(arg[iarg],"zeeman") == 0) {
       if (iarg+4 > narg) error->all(FLERR,"Illegal fix precession/spin command");
       zeeman_flag = 1;
-      H_field = utils::numeric(FLERR,arg[iarg+1],false,lmp);
+      H_fieldT = utils::numeric(FLERR,arg[iarg+1],false,lmp);
       nhx = utils::numeric(FLERR,arg[iarg+2],false,lmp);
       nhy = utils::numeric(FLERR,arg[iarg+3],false,lmp);
       nhz = utils::numeric(FLERR,arg[iarg+4],false,lmp);
@@ -232,6 +233,7 @@ FixPrecessionSpin::FixPrecessionSpin(LAMMPS *lmp, int narg, char **arg) :
 
   degree2rad = MY_PI/180.0;
   time_origin = update->ntimestep;
+  field_stamp = -1;
 
   eflag = 0;
   eprec = 0.0;
@@ -241,6 +243,8 @@ FixPrecessionSpin::FixPrecessionSpin(LAMMPS *lmp, int narg, char **arg) :
 
 FixPrecessionSpin::~FixPrecessionSpin()
 {
+  if (copymode) return;
+
   delete [] magstr;
   memory->destroy(emag);
 }
@@ -264,9 +268,10 @@ void FixPrecessionSpin::init()
   const double mub = 5.78901e-5;                // in eV/T
   const double gyro = 2.0*mub/hbar;             // in rad.THz/T
 
-  // convert field quantities to rad.THz
+  // convert field quantities to rad.THz, from the input values so that
+  // they are not converted again by the init() of a later run
 
-  H_field *= gyro;
+  H_field = H_fieldT*gyro;
   Kah = Ka/hbar;
   k1ch = k1c/hbar;
   k2ch = k2c/hbar;
@@ -287,6 +292,7 @@ void FixPrecessionSpin::init()
 
   varflag = CONSTANT;
   if (magfieldstyle != CONSTANT) varflag = EQUAL;
+  field_stamp = -1;
 
   // set magnetic field components
 
@@ -322,19 +328,17 @@ void FixPrecessionSpin::min_setup(int vflag)
 
 void FixPrecessionSpin::post_force(int /* vflag */)
 {
-  // update mag field with time (potential improvement)
+  // update mag field with time, once per timestep, as nve/spin
+  // calls post_force() before each of its spin advances
 
-  if (varflag != CONSTANT) {
+  if (varflag != CONSTANT && field_stamp != update->ntimestep) {
     modify->clearstep_compute();
     modify->addstep_compute(update->ntimestep + 1);
     set_magneticprecession();           // update mag. field if time-dep.
+    field_stamp = update->ntimestep;
   }
 
-  int *mask = atom->mask;
-  double **fm = atom->fm;
-  double **sp = atom->sp;
   const int nlocal = atom->nlocal;
-  double spi[4], fmi[3], epreci;
 
   // checking size of emag
 
@@ -343,50 +347,136 @@ void FixPrecessionSpin::post_force(int /* vflag */)
     memory->grow(emag,nlocal_max,"pair/spin:emag");
   }
 
-  eflag = 0;
-  eprec = 0.0;
-  for (int i = 0; i < nlocal; i++) {
-    emag[i] = 0.0;
-    if (mask[i] & groupbit) {
-      epreci = 0.0;
-      spi[0] = sp[i][0];
-      spi[1] = sp[i][1];
-      spi[2] = sp[i][2];
-      spi[3] = sp[i][3];
-      fmi[0] = fmi[1] = fmi[2] = 0.0;
-
-      if (zeeman_flag) {          // compute Zeeman interaction
-        compute_zeeman(i,fmi);
-        epreci -= compute_zeeman_energy(spi);
+  // energies are only computed when thermo output or a compute may use
+  // them, eprec and emag keep the values of the last such call otherwise
+
+  const bigint ntimestep = update->ntimestep;
+  const int evflag = update->setupflag || (update->eflag_global == ntimestep) ||
+    (update->eflag_atom == ntimestep) || (output->next_thermo == ntimestep);
+  const int other = stt_flag || cubic_flag || hexaniso_flag;
+
+  if (evflag) {
+    eflag = 0;
+    eprec = 0.0;
+    if (zeeman_flag) {
+      if (aniso_flag) {
+        if (other) eval<1,1,1,1>();
+        else eval<1,1,1,0>();
+      } else {
+        if (other) eval<1,1,0,1>();
+        else eval<1,1,0,0>();
       }
-
-      if (stt_flag) {             // compute Spin Transfer Torque
-        compute_stt(spi,fmi);
-        epreci -= compute_stt_energy(spi);
+    } else {
+      if (aniso_flag) {
+        if (other) eval<1,0,1,1>();
+        else eval<1,0,1,0>();
+      } else {
+        if (other) eval<1,0,0,1>();
+        else eval<1,0,0,0>();
       }
-
-      if (aniso_flag) {           // compute magnetic anisotropy
-        compute_anisotropy(spi,fmi);
-        epreci -= compute_anisotropy_energy(spi);
+    }
+  } else {
+    if (zeeman_flag) {
+      if (aniso_flag) {
+        if (other) eval<0,1,1,1>();
+        else eval<0,1,1,0>();
+      } else {
+        if (other) eval<0,1,0,1>();
+        else eval<0,1,0,0>();
+      }
+    } else {
+      if (aniso_flag) {
+        if (other) eval<0,0,1,1>();
+        else eval<0,0,1,0>();
+      } else {
+        if (other) eval<0,0,0,1>();
+        else eval<0,0,0,0>();
       }
+    }
+  }
+}
+
+/* ----------------------------------------------------------------------
+   add the precession of all spins of the group to fm
+   the Zeeman and uniaxial terms, the most common, are inlined in a loop
+   over the contiguous sp and fm arrays that the compiler can vectorize,
+   the other terms (OTHER) call their single-spin functions
+------------------------------------------------------------------------- */
+
+template <int EFLAG, int ZEEMAN, int ANISO, int OTHER>
+void FixPrecessionSpin::eval()
+{
+  const int nlocal = atom->nlocal;
+  if (nlocal == 0) return;
 
-      if (cubic_flag) {           // compute cubic anisotropy
+  const double * _noalias const sp = &atom->sp[0][0];
+  double * _noalias const fm = &atom->fm[0][0];
+  const int * _noalias const mask = atom->mask;
+  double * _noalias const em = emag;
+  const int gbit = groupbit;
+
+  const double zx = hx, zy = hy, zz = hz;
+  const double ze = hbar*H_field;
+  const double zex = nhx, zey = nhy, zez = nhz;
+  const double ax = nax, ay = nay, az = naz;
+  const double kx = Kax, ky = Kay, kz = Kaz;
+  const double ka = Ka;
+
+  double esum = 0.0;
+
+  for (int i = 0; i < nlocal; i++) {
+    if (EFLAG) em[i] = 0.0;
+    if (!(mask[i] & gbit)) continue;
+
+    const double sx = sp[4*i+0];
+    const double sy = sp[4*i+1];
+    const double sz = sp[4*i+2];
+    const double smag = sp[4*i+3];
+    double fx = 0.0, fy = 0.0, fz = 0.0;
+    double epreci = 0.0;
+
+    if (ZEEMAN) {
+      fx += smag*zx;
+      fy += smag*zy;
+      fz += smag*zz;
+      if (EFLAG) epreci -= ze*smag*(zex*sx + zey*sy + zez*sz);
+    }
+
+    if (ANISO) {
+      const double scalar = ax*sx + ay*sy + az*sz;
+      fx += scalar*kx;
+      fy += scalar*ky;
+      fz += scalar*kz;
+      if (EFLAG) epreci -= ka*scalar*scalar;
+    }
+
+    if (OTHER) {
+      double spi[4] = {sx, sy, sz, smag};
+      double fmi[3] = {0.0, 0.0, 0.0};
+      if (stt_flag) compute_stt(spi,fmi);
+      if (cubic_flag) {
         compute_cubic(spi,fmi);
-        epreci -= compute_cubic_energy(spi);
+        if (EFLAG) epreci -= compute_cubic_energy(spi);
       }
-
-      if (hexaniso_flag) {        // compute hexagonal anisotropy
+      if (hexaniso_flag) {
         compute_hexaniso(spi,fmi);
-        epreci -= compute_hexaniso_energy(spi);
+        if (EFLAG) epreci -= compute_hexaniso_energy(spi);
       }
+      fx += fmi[0];
+      fy += fmi[1];
+      fz += fmi[2];
+    }
 
-      emag[i] += epreci;
-      eprec += epreci;
-      fm[i][0] += fmi[0];
-      fm[i][1] += fmi[1];
-      fm[i][2] += fmi[2];
+    if (EFLAG) {
+      em[i] = epreci;
+      esum += epreci;
     }
+    fm[3*i+0] += fx;
+    fm[3*i+1] += fy;
+    fm[3*i+2] += fz;
   }
+
+  if (EFLAG) eprec += esum;
 }
 
 /* ---------------------------------------------------------------------- */
@@ -81,6 +81,7 @@ class FixPrecessionSpin : public Fix {
   int time_origin;
   int eflag;
   double eprec, eprec_all;
+  bigint field_stamp;    // timestep of the last update of the fields
 
   int varflag;
   int magfieldstyle;
@@ -89,7 +90,8 @@ class FixPrecessionSpin : public Fix {
 
   // zeeman field intensity and direction
 
-  double H_field;
+  double H_fieldT;    // field in T
+  double H_field;     // field in rad.THz
   double nhx, nhy, nhz;
   double hx, hy, hz;    // temp. force variables
 
@@ -122,6 +124,8 @@ class FixPrecessionSpin : public Fix {
   double l6x, l6y, l6z;    // =(m x n)
 
   void set_magneticprecession();
+
+  template <int EFLAG, int ZEEMAN, int ANISO, int OTHER> void eval();
 };
 
 }    // namespace LAMMPS_NS
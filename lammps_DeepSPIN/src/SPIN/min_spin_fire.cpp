@@ -0,0 +1,389 @@
+// clang-format off
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   https://www.lammps.org/, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+/* ------------------------------------------------------------------------
+   FIRE minimization of the spins, following min_style fire:
+   Guenole, Noehring, Vaid, Houlle, Xie, Prakash, Bitzek,
+   Comput Mater Sci, 175, 109584 (2020).
+   The spins move along geodesics of the unit sphere, and their
+   velocities are transported along with them.
+------------------------------------------------------------------------- */
+
+#include "min_spin_fire.h"
+
+#include "atom.h"
+#include "comm.h"
+#include "error.h"
+#include "fix_minimize.h"
+#include "math_const.h"
+#include "output.h"
+#include "timer.h"
+#include "universe.h"
+#include "update.h"
+
+#include <cmath>
+#include <cstring>
+
+using namespace LAMMPS_NS;
+using namespace MathConst;
+
+// EPS_ENERGY = minimum normalization for energy tolerance
+
+#define EPS_ENERGY 1.0e-8
+
+/* ---------------------------------------------------------------------- */
+
+MinSpinFire::MinSpinFire(LAMMPS *lmp) : Min(lmp), vs(nullptr)
+{
+  maxrot = MY_2PI / (100.0);
+}
+
+/* ---------------------------------------------------------------------- */
+
+void MinSpinFire::init()
+{
+  Min::init();
+
+  // simple parameters validation
+
+  if (tmax < tmin) error->all(FLERR,"tmax has to be larger than tmin");
+  if (dtgrow < 1.0) error->all(FLERR,"dtgrow has to be larger than 1.0");
+  if (dtshrink > 1.0) error->all(FLERR,"dtshrink has to be smaller than 1.0");
+  if (integrator != 0)
+    error->all(FLERR,"min/spin/fire only supports the eulerimplicit integrator");
+
+  // the reference spin timestep is set from the torques in the 1st iterate()
+
+  dt = dts0 = dtv = 0.0;
+  alpha = alpha0;
+  last_negative = ntimestep_start = update->ntimestep;
+  vdotf_negatif = 0;
+
+  // the end replicas of a GNEB calc. do not move
+  // reductions are done on the universe when running multi-replica
+
+  factor = 1.0;
+  comm_fire = world;
+  if (update->multireplica == 1) {
+    comm_fire = universe->uworld;
+    if (universe->iworld == 0 || universe->iworld == universe->nworlds-1)
+      factor = 0.0;
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+
+void MinSpinFire::setup_style()
+{
+  double **v = atom->v;
+  int nlocal = atom->nlocal;
+
+  // check if the atom/spin style is defined
+
+  if (!atom->sp_flag)
+    error->all(FLERR,"min/spin/fire requires atom/spin style");
+
+  // print the parameters used within fire into the log
+
+  const char *s2[] = {"no","yes"};
+
+  if (comm->me == 0 && logfile) {
+      fprintf(logfile,"  Parameters for spin/fire: \n"
+      "    maxrot delaystep dtgrow dtshrink alpha0 alphashrink tmax tmin "
+      "   halfstepback \n"
+      "    %6g %9i %6g %8g %6g %11g %4g %4g %15s \n",
+      maxrot, delaystep, dtgrow, dtshrink, alpha0, alphashrink, tmax, tmin,
+      s2[halfstepback_flag]);
+  }
+
+  for (int i = 0; i < nlocal; i++)
+    v[i][0] = v[i][1] = v[i][2] = 0.0;
+
+  // per-atom spin velocities, migrate with the atoms
+
+  fix_minimize->add_vector(3);
+}
+
+/* ---------------------------------------------------------------------- */
+
+int MinSpinFire::modify_param(int narg, char **arg)
+{
+  if (strcmp(arg[0],"discrete_factor") == 0) {
+    if (narg < 2) error->all(FLERR,"Illegal min_modify command");
+    double discrete_factor;
+    discrete_factor = utils::numeric(FLERR,arg[1],false,lmp);
+    maxrot = MY_2PI / (10 * discrete_factor);
+    return 2;
+  }
+  return 0;
+}
+
+/* ----------------------------------------------------------------------
+   set current vector lengths and pointers
+   called after atoms have migrated
+------------------------------------------------------------------------- */
+
+void MinSpinFire::reset_vectors()
+{
+  // atomic dof
+
+  nvec = 3 * atom->nlocal;
+  if (nvec) xvec = atom->x[0];
+  if (nvec) fvec = atom->f[0];
+
+  vs = fix_minimize->request_vector(0);
+}
+
+/* ----------------------------------------------------------------------
+   minimization via FIRE dynamics of the spins on the unit sphere
+------------------------------------------------------------------------- */
+
+int MinSpinFire::iterate(int maxiter)
+{
+  bigint ntimestep;
+  double fs[3];
+  double vmax,vsq,dtvone,dtf;
+  double scale1 = 0.0, scale2 = 0.0;
+  double fmdotfm,fmsq;
+  double sums[3],sums_all[3];
+  int flag,flagall;
+
+  // reference spin timestep, from the largest precession frequency as
+  // in min_style spin: a first step of dts0 from rest rotates a spin
+  // by at most maxrot
+
+  if (dts0 == 0.0) {
+    int nlocal = atom->nlocal;
+    double **fm = atom->fm;
+    double fmaxsqone = 0.0, fmaxsqall;
+    for (int i = 0; i < nlocal; i++)
+      fmaxsqone = MAX(fmaxsqone,fm[i][0]*fm[i][0]+fm[i][1]*fm[i][1]+fm[i][2]*fm[i][2]);
+    MPI_Allreduce(&fmaxsqone,&fmaxsqall,1,MPI_DOUBLE,MPI_MAX,comm_fire);
+    if (fmaxsqall == 0.0)
+      error->all(FLERR,"Incorrect fmaxsqall calculation");
+
+    dt = dts0 = maxrot / sqrt(fmaxsqall);
+    dtmax = tmax * dts0;
+    dtmin = tmin * dts0;
+    for (int i = 0; i < 3*nlocal; i++) vs[i] = 0.0;
+  }
+
+  for (int iter = 0; iter < maxiter; iter++) {
+
+    if (timer->check_timeout(niter))
+      return TIMEOUT;
+
+    ntimestep = ++update->ntimestep;
+    niter++;
+
+    int nlocal = atom->nlocal;
+    double **sp = atom->sp;
+
+    // v dot f, v dot v and f dot f in a single reduction
+    // over this replica, or over all replicas
+
+    sums[0] = sums[1] = sums[2] = 0.0;
+    for (int i = 0; i < nlocal; i++) {
+      double *v = &vs[3*i];
+      spin_force(i,fs);
+      sums[0] += v[0]*fs[0] + v[1]*fs[1] + v[2]*fs[2];
+      sums[1] += v[0]*v[0] + v[1]*v[1] + v[2]*v[2];
+      sums[2] += fs[0]*fs[0] + fs[1]*fs[1] + fs[2]*fs[2];
+    }
+    MPI_Allreduce(sums,sums_all,3,MPI_DOUBLE,MPI_SUM,comm_fire);
+    double vdotfall = sums_all[0];
+
+    // if (v dot f) > 0:
+    // v = (1-alpha) v + alpha |v| Fhat, done within the integration
+    // if more than delaystep since v dot f was negative:
+    // increase timestep and decrease alpha
+
+    if (vdotfall > 0.0) {
+      vdotf_negatif = 0;
+      scale1 = 1.0 - alpha;
+      if (sums_all[2] <= 1e-20) scale2 = 0.0;
+      else scale2 = alpha * sqrt(sums_all[1]/sums_all[2]);
+
+      if (ntimestep - last_negative > delaystep) {
+        dt = MIN(dt*dtgrow,dtmax);
+        alpha *= alphashrink;
+      }
+
+    // else (v dot f) <= 0
+    // if more than delaystep since starting the relaxation:
+    // reset alpha and decrease timestep
+    // half step back along the geodesics, and reset velocities: v = 0
+
+    } else {
+      last_negative = ntimestep;
+      int delayflag = 1;
+      if (ntimestep - ntimestep_start < delaystep && delaystep_start_flag)
+        delayflag = 0;
+      if (delayflag) {
+        alpha = alpha0;
+        if (dt*dtshrink >= dtmin) dt *= dtshrink;
+      }
+
+      // stopping criterion while stuck in a local bassin of the PES
+
+      vdotf_negatif++;
+      if (max_vdotf_negatif > 0 && vdotf_negatif > max_vdotf_negatif)
+        return MAXVDOTF;
+
+      // inertia correction, back by half of the last rotations
+
+      if (halfstepback_flag)
+        for (int i = 0; i < nlocal; i++) advance(i,-0.5*dtv,sp[i]);
+
+      for (int i = 0; i < 3*nlocal; i++) vs[i] = 0.0;
+
+      if (halfstepback_flag) {
+        energy_force(0);
+        neval++;
+        nlocal = atom->nlocal;
+        sp = atom->sp;
+      }
+    }
+
+    // semi-implicit Euler integration on the unit sphere
+    // kick and mix the velocities, then limit the timestep of the
+    // rotations so no spin rotates further than maxrot
+
+    dtf = dt / dts0;
+    vmax = 0.0;
+    for (int i = 0; i < nlocal; i++) {
+      double *v = &vs[3*i];
+      spin_force(i,fs);
+      v[0] += dtf * fs[0];
+      v[1] += dtf * fs[1];
+      v[2] += dtf * fs[2];
+      if (vdotfall > 0.0) {
+        v[0] = scale1*v[0] + scale2*fs[0];
+        v[1] = scale1*v[1] + scale2*fs[1];
+        v[2] = scale1*v[2] + scale2*fs[2];
+      }
+      vsq = v[0]*v[0] + v[1]*v[1] + v[2]*v[2];
+      vmax = MAX(vmax,vsq);
+    }
+    vmax = sqrt(vmax);
+    dtvone = dt;
+    if (dtvone*vmax > maxrot) dtvone = maxrot/vmax;
+    MPI_Allreduce(&dtvone,&dtv,1,MPI_DOUBLE,MPI_MIN,comm_fire);
+
+    for (int i = 0; i < nlocal; i++) advance(i,dtv,sp[i]);
+
+    eprevious = ecurrent;
+    ecurrent = energy_force(0);
+    neval++;
+
+    // energy tolerance criterion
+    // only check after delaystep elapsed since velocties reset to 0
+    // sync across replicas if running multi-replica minimization
+
+    if (update->etol > 0.0 && ntimestep-last_negative > delaystep) {
+      if (update->multireplica == 0) {
+        if (fabs(ecurrent-eprevious) <
+            update->etol * 0.5*(fabs(ecurrent) + fabs(eprevious) + EPS_ENERGY))
+          return ETOL;
+      } else {
+        if (fabs(ecurrent-eprevious) <
+            update->etol * 0.5*(fabs(ecurrent) + fabs(eprevious) + EPS_ENERGY))
+          flag = 0;
+        else flag = 1;
+        MPI_Allreduce(&flag,&flagall,1,MPI_INT,MPI_SUM,universe->uworld);
+        if (flagall == 0) return ETOL;
+      }
+    }
+
+    // magnetic torque tolerance criterion
+    // sync across replicas if running multi-replica minimization
+
+    fmdotfm = fmsq = 0.0;
+    if (update->ftol > 0.0) {
+      if (normstyle == MAX) fmsq = max_torque();        // max torque norm
+      else if (normstyle == INF) fmsq = inf_torque();   // inf torque norm
+      else if (normstyle == TWO) fmsq = total_torque(); // Euclidean torque 2-norm
+      else error->all(FLERR,"Illegal min_modify command");
+      fmdotfm = fmsq*fmsq;
+      if (update->multireplica == 0) {
+        if (fmdotfm < update->ftol*update->ftol) return FTOL;
+      } else {
+        if (fmdotfm < update->ftol*update->ftol) flag = 0;
+        else flag = 1;
+        MPI_Allreduce(&flag,&flagall,1,MPI_INT,MPI_SUM,universe->uworld);
+        if (flagall == 0) return FTOL;
+      }
+    }
+
+    // output for thermo, dump, restart files
+
+    if (output->next == ntimestep) {
+      timer->stamp();
+      output->write(ntimestep);
+      timer->stamp(Timer::OUTPUT);
+    }
+  }
+
+  return MAXITER;
+}
+
+/* ----------------------------------------------------------------------
+   driving force of spin i: its precession vector projected
+   on the tangent plane of the unit sphere at sp[i]
+---------------------------------------------------------------------- */
+
+void MinSpinFire::spin_force(int i, double *fs)
+{
+  double *sp = atom->sp[i];
+  double *fm = atom->fm[i];
+
+  double fmdots = fm[0]*sp[0] + fm[1]*sp[1] + fm[2]*sp[2];
+  fs[0] = factor * (fm[0] - fmdots*sp[0]);
+  fs[1] = factor * (fm[1] - fmdots*sp[1]);
+  fs[2] = factor * (fm[2] - fmdots*sp[2]);
+}
+
+/* ----------------------------------------------------------------------
+   move spin i along the geodesic tangent to its velocity, by an
+   angle dts*|v|, and transport the velocity with it
+   norm preserving for both the spin and the velocity
+---------------------------------------------------------------------- */
+
+void MinSpinFire::advance(int i, double dts, double *s)
+{
+  double *v = &vs[3*i];
+
+  // remove the normal component left by the rounding errors
+
+  double vdots = v[0]*s[0] + v[1]*s[1] + v[2]*s[2];
+  v[0] -= vdots*s[0];
+  v[1] -= vdots*s[1];
+  v[2] -= vdots*s[2];
+
+  double vnorm = sqrt(v[0]*v[0] + v[1]*v[1] + v[2]*v[2]);
+  if (vnorm == 0.0) return;
+
+  double theta = dts*vnorm;
+  double cost = cos(theta);
+  double sint = sin(theta);
+  double s0[3] = {s[0], s[1], s[2]};
+
+  s[0] = cost*s0[0] + sint*v[0]/vnorm;
+  s[1] = cost*s0[1] + sint*v[1]/vnorm;
+  s[2] = cost*s0[2] + sint*v[2]/vnorm;
+
+  v[0] = cost*v[0] - sint*vnorm*s0[0];
+  v[1] = cost*v[1] - sint*vnorm*s0[1];
+  v[2] = cost*v[2] - sint*vnorm*s0[2];
+}
@@ -0,0 +1,58 @@
+/* -*- c++ -*- ----------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   https://www.lammps.org/, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#ifdef MINIMIZE_CLASS
+// clang-format off
+MinimizeStyle(spin/fire, MinSpinFire);
+// clang-format on
+#else
+
+#ifndef LMP_MIN_SPIN_FIRE_H
+#define LMP_MIN_SPIN_FIRE_H
+
+#include "min.h"
+
+namespace LAMMPS_NS {
+
+class MinSpinFire : public Min {
+ public:
+  MinSpinFire(class LAMMPS *);
+
+  void init() override;
+  void setup_style() override;
+  int modify_param(int, char **) override;
+  void reset_vectors() override;
+  int iterate(int) override;
+
+ private:
+  double dt, dtmax, dtmin;    // fictitious timestep and its bounds
+  double dts0;                // reference spin timestep, also the inertia
+  double dtv;                 // timestep of the last rotations
+  double alpha;
+  double maxrot;              // max rotation angle of a spin in one step
+  double factor;              // 0.0 for the end replicas of a GNEB calc.
+  bigint last_negative, ntimestep_start;
+  int vdotf_negatif;
+
+  double *vs;    // per-atom tangent spin velocities, stored by fix_minimize
+
+  MPI_Comm comm_fire;    // world or universe->uworld for multi-replica
+
+  void spin_force(int, double *);
+  void advance(int, double, double *);
+};
+
+}    // namespace LAMMPS_NS
+
+#endif
+#endif
@@ -0,0 +1,562 @@
+// clang-format off
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   https://www.lammps.org/, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+/* ------------------------------------------------------------------------
+   L-BFGS minimization of the positions and spins together, the spins
+   are rotated as in min_style spin/lbfgs:
+   Ivanov, A. V., Uzdin, V. M., & Jónsson, H. (2019). Fast and Robust
+   Algorithm for the Minimisation of the Energy of Spin Systems. arXiv
+   preprint arXiv:1904.02669.
+------------------------------------------------------------------------- */
+
+#include "min_spin_lattice.h"
+
+#include "atom.h"
+#include "error.h"
+#include "fix_minimize.h"
+#include "force.h"
+#include "math_const.h"
+#include "memory.h"
+#include "output.h"
+#include "pair_hybrid.h"
+#include "pair_spin.h"
+#include "timer.h"
+#include "update.h"
+
+#include <cmath>
+#include <cstring>
+
+using namespace LAMMPS_NS;
+using namespace MathConst;
+
+// EPS_ENERGY = minimum normalization for energy tolerance
+
+#define EPS_ENERGY 1.0e-8
+
+#define DELAYSTEP 5
+
+/* ---------------------------------------------------------------------- */
+
+MinSpinLattice::MinSpinLattice(LAMMPS *lmp) :
+  Min(lmp), g_old(nullptr), g_cur(nullptr), p_s(nullptr), ds(nullptr), dy(nullptr),
+  rho(nullptr), gram(nullptr), gram_row(nullptr), gram_row_all(nullptr), coeff(nullptr),
+  alpha(nullptr)
+{
+  maxepsrot = MY_2PI / (100.0);
+  num_mem = 3;
+}
+
+/* ---------------------------------------------------------------------- */
+
+MinSpinLattice::~MinSpinLattice()
+{
+  delete [] ds;
+  delete [] dy;
+  memory->destroy(rho);
+  memory->destroy(gram);
+  memory->destroy(gram_row);
+  memory->destroy(gram_row_all);
+  memory->destroy(coeff);
+  memory->destroy(alpha);
+}
+
+/* ---------------------------------------------------------------------- */
+
+void MinSpinLattice::init()
+{
+  local_iter = 0;
+
+  Min::init();
+
+  last_negative = update->ntimestep;
+
+  delete [] ds;
+  delete [] dy;
+  ds = new double*[num_mem];
+  dy = new double*[num_mem];
+
+  nbasis = 2*num_mem + 1;
+  memory->grow(rho,num_mem,"min/spin/lattice:rho");
+  memory->grow(gram,nbasis,nbasis,"min/spin/lattice:gram");
+  memory->grow(gram_row,3*nbasis,"min/spin/lattice:gram_row");
+  memory->grow(gram_row_all,3*nbasis,"min/spin/lattice:gram_row_all");
+  memory->grow(coeff,nbasis,"min/spin/lattice:coeff");
+  memory->grow(alpha,num_mem,"min/spin/lattice:alpha");
+}
+
+/* ---------------------------------------------------------------------- */
+
+void MinSpinLattice::setup_style()
+{
+  double **v = atom->v;
+  int nlocal = atom->nlocal;
+
+  // check if the atom/spin style is defined
+
+  if (!atom->sp_flag)
+    error->all(FLERR,"min spin/lattice requires atom/spin style");
+  if (update->multireplica)
+    error->all(FLERR,"min spin/lattice does not support multi-replica runs");
+
+  for (int i = 0; i < nlocal; i++)
+    v[i][0] = v[i][1] = v[i][2] = 0.0;
+
+  // the spin pair styles only compute the mechanical forces on a moving
+  // lattice, switch it on for the minimization and restore it in cleanup()
+
+  spin_pairs.clear();
+  lattice_flag_saved.clear();
+  auto hybrid = dynamic_cast<PairHybrid *>(force->pair);
+  if (hybrid) {
+    for (int m = 0; m < hybrid->nstyles; m++) {
+      auto spin_pair = dynamic_cast<PairSpin *>(hybrid->styles[m]);
+      if (spin_pair) spin_pairs.push_back(spin_pair);
+    }
+  } else {
+    auto spin_pair = dynamic_cast<PairSpin *>(force->pair);
+    if (spin_pair) spin_pairs.push_back(spin_pair);
+  }
+  for (auto &spin_pair : spin_pairs) {
+    lattice_flag_saved.push_back(spin_pair->lattice_flag);
+    spin_pair->lattice_flag = 1;
+  }
+
+  // memory for g_old, g_cur, p_s, ds and dy of each atom
+
+  for (int k = 0; k < 3 + 2*num_mem; k++)
+    fix_minimize->add_vector(6);
+}
+
+/* ---------------------------------------------------------------------- */
+
+void MinSpinLattice::cleanup()
+{
+  Min::cleanup();
+
+  for (std::size_t m = 0; m < spin_pairs.size(); m++)
+    spin_pairs[m]->lattice_flag = lattice_flag_saved[m];
+  spin_pairs.clear();
+  lattice_flag_saved.clear();
+}
+
+/* ---------------------------------------------------------------------- */
+
+int MinSpinLattice::modify_param(int narg, char **arg)
+{
+  if (strcmp(arg[0],"discrete_factor") == 0) {
+    if (narg < 2) error->all(FLERR,"Illegal min_modify command");
+    double discrete_factor;
+    discrete_factor = utils::numeric(FLERR,arg[1],false,lmp);
+    maxepsrot = MY_2PI / (10 * discrete_factor);
+    return 2;
+  }
+  return 0;
+}
+
+/* ----------------------------------------------------------------------
+   set current vector lengths and pointers
+   called after atoms have migrated
+------------------------------------------------------------------------- */
+
+void MinSpinLattice::reset_vectors()
+{
+  // atomic dof
+
+  nvec = 3 * atom->nlocal;
+  if (nvec) xvec = atom->x[0];
+  if (nvec) fvec = atom->f[0];
+
+  g_old = fix_minimize->request_vector(0);
+  g_cur = fix_minimize->request_vector(1);
+  p_s = fix_minimize->request_vector(2);
+  for (int k = 0; k < num_mem; k++) {
+    ds[k] = fix_minimize->request_vector(3 + k);
+    dy[k] = fix_minimize->request_vector(3 + num_mem + k);
+  }
+}
+
+/* ----------------------------------------------------------------------
+   minimization of the positions and spins by L-BFGS
+   one energy and force evaluation per iteration
+------------------------------------------------------------------------- */
+
+int MinSpinLattice::iterate(int maxiter)
+{
+  bigint ntimestep;
+  double fdotf,fmdotfm,fmsq;
+
+  for (int iter = 0; iter < maxiter; iter++) {
+
+    if (timer->check_timeout(niter))
+      return TIMEOUT;
+
+    ntimestep = ++update->ntimestep;
+    niter++;
+
+    // forces and magnetic forces of the current positions and spins,
+    // then move both along the search direction
+
+    eprevious = ecurrent;
+    ecurrent = energy_force(0);
+    calc_gradient();
+    calc_search_direction();
+    advance();
+    neval++;
+
+    // energy tolerance criterion
+    // only check after DELAYSTEP elapsed since velocties reset to 0
+
+    if (update->etol > 0.0 && ntimestep-last_negative > DELAYSTEP) {
+      if (fabs(ecurrent-eprevious) <
+          update->etol * 0.5*(fabs(ecurrent) + fabs(eprevious) + EPS_ENERGY))
+        return ETOL;
+    }
+
+    // force tolerance criterion, on both the forces and magnetic torques
+
+    fdotf = fmdotfm = fmsq = 0.0;
+    if (update->ftol > 0.0) {
+      if (normstyle == MAX) {
+        fdotf = fnorm_max();
+        fmsq = max_torque();
+      } else if (normstyle == INF) {
+        fdotf = fnorm_inf();
+        fmsq = inf_torque();
+      } else if (normstyle == TWO) {
+        fdotf = fnorm_sqr();
+        fmsq = total_torque();
+      } else error->all(FLERR,"Illegal min_modify command");
+      fmdotfm = fmsq*fmsq;
+      if (fdotf < update->ftol*update->ftol &&
+          fmdotfm < update->ftol*update->ftol) return FTOL;
+    }
+
+    // output for thermo, dump, restart files
+
+    if (output->next == ntimestep) {
+      timer->stamp();
+      output->write(ntimestep);
+      timer->stamp(Timer::OUTPUT);
+    }
+  }
+
+  return MAXITER;
+}
+
+/* ----------------------------------------------------------------------
+   calculate gradients, -f for the positions and the gradient of
+   min_style spin/lbfgs for the rotations of the spins
+---------------------------------------------------------------------- */
+
+void MinSpinLattice::calc_gradient()
+{
+  int nlocal = atom->nlocal;
+  double **sp = atom->sp;
+  double **fm = atom->fm;
+  double **f = atom->f;
+  double hbar = force->hplanck/MY_2PI;
+
+  for (int i = 0; i < nlocal; i++) {
+    g_cur[6 * i + 0] = -f[i][0];
+    g_cur[6 * i + 1] = -f[i][1];
+    g_cur[6 * i + 2] = -f[i][2];
+    g_cur[6 * i + 3] = (fm[i][0]*sp[i][1] - fm[i][1]*sp[i][0]) * hbar;
+    g_cur[6 * i + 4] = -(fm[i][2]*sp[i][0] - fm[i][0]*sp[i][2]) * hbar;
+    g_cur[6 * i + 5] = (fm[i][1]*sp[i][2] - fm[i][2]*sp[i][1]) * hbar;
+  }
+}
+
+/* ----------------------------------------------------------------------
+   search direction:
+   Limited-memory BFGS, two-loop recursion on the Gram matrix of
+   the basis {ds, dy, g_cur}, as in MinSpinLBFGS
+---------------------------------------------------------------------- */
+
+void MinSpinLattice::calc_search_direction()
+{
+  int n = 6 * atom->nlocal;
+  int m_index = local_iter % num_mem; // memory index
+  int c_ind = 0;
+  double dot,beta;
+  double scaling;
+
+  if (local_iter == 0) {         // steepest descent direction
+
+    scaling = maximum_step(g_cur);
+
+    for (int i = 0; i < n; i++) {
+      p_s[i] = -g_cur[i] * scaling;
+      g_old[i] = g_cur[i];
+      for (int k = 0; k < num_mem; k++) {
+        ds[k][i] = 0.0;
+        dy[k][i] = 0.0;
+      }
+    }
+    for (int k = 0; k < num_mem; k++)
+      rho[k] = 0.0;
+    for (int k = 0; k < nbasis; k++)
+      for (int l = 0; l < nbasis; l++)
+        gram[k][l] = 0.0;
+
+  } else {
+    for (int i = 0; i < n; i++) {
+      ds[m_index][i] = p_s[i];
+      dy[m_index][i] = g_cur[i] - g_old[i];
+    }
+
+    // rows of the Gram matrix for the new ds, dy and g_cur
+
+    const int irow[3] = {m_index, num_mem + m_index, nbasis - 1};
+    for (int r = 0; r < 3; r++) {
+      const double *u = basis(irow[r]);
+      for (int l = 0; l < nbasis; l++) {
+        const double *w = basis(l);
+        dot = 0.0;
+        for (int i = 0; i < n; i++) dot += u[i] * w[i];
+        gram_row[r * nbasis + l] = dot;
+      }
+    }
+    MPI_Allreduce(gram_row,gram_row_all,3*nbasis,MPI_DOUBLE,MPI_SUM,world);
+
+    for (int r = 0; r < 3; r++)
+      for (int l = 0; l < nbasis; l++)
+        gram[irow[r]][l] = gram[l][irow[r]] = gram_row_all[r * nbasis + l];
+
+    double dyds = gram[m_index][num_mem + m_index];
+    if (fabs(dyds) > 1.0e-60) rho[m_index] = 1.0 / dyds;
+    else rho[m_index] = 1.0e60;
+
+    // negative curvature, restart from steepest descent
+
+    if (rho[m_index] < 0.0) {
+      local_iter = 0;
+      last_negative = update->ntimestep;
+      return calc_search_direction();
+    }
+
+    for (int l = 0; l < nbasis; l++) coeff[l] = 0.0;
+    coeff[nbasis - 1] = 1.0;
+
+    for (int k = num_mem - 1; k > -1; k--) {
+      // this loop should run from the newest memory to the oldest one.
+
+      c_ind = (k + m_index + 1) % num_mem;
+      dot = 0.0;
+      for (int l = 0; l < nbasis; l++) dot += gram[c_ind][l] * coeff[l];
+      alpha[c_ind] = rho[c_ind] * dot;
+      coeff[num_mem + c_ind] -= alpha[c_ind];
+    }
+
+    double devis = rho[m_index] * gram[num_mem + m_index][num_mem + m_index];
+
+    if (fabs(devis) > 1.0e-60) {
+      for (int l = 0; l < nbasis; l++) coeff[l] /= devis;
+    } else {
+      for (int l = 0; l < nbasis; l++) coeff[l] *= 1.0e60;
+    }
+
+    for (int k = 0; k < num_mem; k++) {
+      // this loop should run from the oldest memory to the newest one.
+
+      c_ind = (k + m_index + 1) % num_mem;
+      dot = 0.0;
+      for (int l = 0; l < nbasis; l++) dot += gram[num_mem + c_ind][l] * coeff[l];
+      beta = rho[c_ind] * dot;
+      coeff[c_ind] += alpha[c_ind] - beta;
+    }
+
+    for (int i = 0; i < n; i++) {
+      dot = 0.0;
+      for (int k = 0; k < num_mem; k++)
+        dot += coeff[k] * ds[k][i] + coeff[num_mem + k] * dy[k][i];
+      p_s[i] = dot + coeff[nbasis - 1] * g_cur[i];
+    }
+
+    scaling = maximum_step(p_s);
+    for (int i = 0; i < n; i++) {
+      p_s[i] = - p_s[i] * scaling;
+      g_old[i] = g_cur[i];
+    }
+  }
+  local_iter++;
+}
+
+/* ----------------------------------------------------------------------
+   vector k of the basis of the search direction: ds, dy and g_cur
+---------------------------------------------------------------------- */
+
+double *MinSpinLattice::basis(int k)
+{
+  if (k < num_mem) return ds[k];
+  if (k < 2 * num_mem) return dy[k - num_mem];
+  return g_cur;
+}
+
+/* ----------------------------------------------------------------------
+   move the atoms and rotate the spins along the search direction
+   the spin part of the stored vectors of an atom is transported
+   along with its spin, by the same rotation
+---------------------------------------------------------------------- */
+
+void MinSpinLattice::advance()
+{
+  int nlocal = atom->nlocal;
+  double **x = atom->x;
+  double **sp = atom->sp;
+  double rot_mat[9]; // exponential of matrix made of search direction
+  double s_new[3];
+
+  for (int i = 0; i < nlocal; i++) {
+    x[i][0] += p_s[6 * i + 0];
+    x[i][1] += p_s[6 * i + 1];
+    x[i][2] += p_s[6 * i + 2];
+
+    rodrigues_rotation(p_s + 6 * i + 3, rot_mat);
+
+    // rotate spins
+
+    vm3(rot_mat, sp[i], s_new);
+    for (int j = 0; j < 3; j++) sp[i][j] = s_new[j];
+
+    // transport the history to the tangent space of the new spin
+
+    transport(rot_mat, g_old + 6 * i + 3);
+    transport(rot_mat, p_s + 6 * i + 3);
+    for (int k = 0; k < num_mem; k++) {
+      transport(rot_mat, ds[k] + 6 * i + 3);
+      transport(rot_mat, dy[k] + 6 * i + 3);
+    }
+  }
+}
+
+/* ----------------------------------------------------------------------
+   scaling of the step, such that the rms rotation of the spins is at
+   most maxepsrot and the rms displacement of the atoms at most dmax
+---------------------------------------------------------------------- */
+
+double MinSpinLattice::maximum_step(double *p)
+{
+  double sums[3],sums_global[3];
+  double scaling = 1.0;
+  int nlocal = atom->nlocal;
+
+  // squared norms of the displacements and rotations and # of atoms,
+  // in a single reduction
+
+  sums[0] = sums[1] = 0.0;
+  for (int i = 0; i < nlocal; i++) {
+    for (int j = 0; j < 3; j++) {
+      sums[0] += p[6 * i + j] * p[6 * i + j];
+      sums[1] += p[6 * i + 3 + j] * p[6 * i + 3 + j];
+    }
+  }
+  sums[2] = nlocal;
+  MPI_Allreduce(sums,sums_global,3,MPI_DOUBLE,MPI_SUM,world);
+
+  if (sums_global[0] > 0.0)
+    scaling = MIN(scaling,dmax * sqrt(sums_global[2] / sums_global[0]));
+  if (sums_global[1] > 0.0)
+    scaling = MIN(scaling,maxepsrot * sqrt(sums_global[2] / sums_global[1]));
+
+  return scaling;
+}
+
+/* ----------------------------------------------------------------------
+  calculate 3x3 matrix exponential using Rodrigues' formula,
+  see MinSpinLBFGS::rodrigues_rotation()
+------------------------------------------------------------------------- */
+
+void MinSpinLattice::rodrigues_rotation(const double *upp_tr, double *out)
+{
+  double theta,A,B,D,x,y,z;
+  double s1,s2,s3,a1,a2,a3;
+
+  if (fabs(upp_tr[0]) < 1.0e-40 &&
+      fabs(upp_tr[1]) < 1.0e-40 &&
+      fabs(upp_tr[2]) < 1.0e-40) {
+
+    // if upp_tr is zero, return unity matrix
+    for (int k = 0; k < 3; k++)
+      for (int m = 0; m < 3; m++)
+        out[3 * k + m] = (m == k) ? 1.0 : 0.0;
+    return;
+  }
+
+  theta = sqrt(upp_tr[0] * upp_tr[0] +
+               upp_tr[1] * upp_tr[1] +
+               upp_tr[2] * upp_tr[2]);
+
+  A = cos(theta);
+  B = sin(theta);
+  D = 1 - A;
+  x = upp_tr[0]/theta;
+  y = upp_tr[1]/theta;
+  z = upp_tr[2]/theta;
+
+  // diagonal elements of U
+
+  out[0] = A + z * z * D;
+  out[4] = A + y * y * D;
+  out[8] = A + x * x * D;
+
+  // off diagonal of U
+
+  s1 = -y * z *D;
+  s2 = x * z * D;
+  s3 = -x * y * D;
+
+  a1 = x * B;
+  a2 = y * B;
+  a3 = z * B;
+
+  out[1] = s1 + a1;
+  out[3] = s1 - a1;
+  out[2] = s2 + a2;
+  out[6] = s2 - a2;
+  out[5] = s3 + a3;
+  out[7] = s3 - a3;
+}
+
+/* ----------------------------------------------------------------------
+  out = vector^T x m,
+  m -- 3x3 matrix , v -- 3-d vector
+------------------------------------------------------------------------- */
+
+void MinSpinLattice::vm3(const double *m, const double *v, double *out)
+{
+  for (int i = 0; i < 3; i++) {
+    out[i] = 0.0;
+    for (int j = 0; j < 3; j++)
+      out[i] += *(m + 3 * j + i) * v[j];
+  }
+}
+
+/* ----------------------------------------------------------------------
+  transport the vector (x,y,z) of upper triangular elements of a skew
+  matrix with the rotation m of the spin: its rotation axis (-z,y,-x)
+  is rotated as the spin
+------------------------------------------------------------------------- */
+
+void MinSpinLattice::transport(const double *m, double *v)
+{
+  double axis[3],axis_new[3];
+
+  axis[0] = -v[2];
+  axis[1] = v[1];
+  axis[2] = -v[0];
+  vm3(m, axis, axis_new);
+  v[0] = -axis_new[2];
+  v[1] = axis_new[1];
+  v[2] = -axis_new[0];
+}
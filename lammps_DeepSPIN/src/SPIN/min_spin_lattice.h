@@ -0,0 +1,85 @@
+/* -*- c++ -*- ----------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   https://www.lammps.org/, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#ifdef MINIMIZE_CLASS
+// clang-format off
+MinimizeStyle(spin/lattice, MinSpinLattice);
+// clang-format on
+#else
+
+#ifndef LMP_MIN_SPIN_LATTICE_H
+#define LMP_MIN_SPIN_LATTICE_H
+
+#include "min.h"
+
+#include <vector>
+
+namespace LAMMPS_NS {
+
+class MinSpinLattice : public Min {
+ public:
+  MinSpinLattice(class LAMMPS *);
+  ~MinSpinLattice() override;
+  void init() override;
+  void setup_style() override;
+  void cleanup() override;
+  int modify_param(int, char **) override;
+  void reset_vectors() override;
+  int iterate(int) override;
+
+ private:
+  int local_iter;      // # of iterations since the last steepest descent
+  double maxepsrot;    // max rms rotation of the spins in one step
+
+  // per-atom vectors stored by fix_minimize, so they migrate with the
+  // atoms, 6 values per atom: 3 for x, then 3 for the rotation of sp
+
+  double *g_old;    // gradient at previous step
+  double *g_cur;    // current gradient
+  double *p_s;      // search direction
+  double **ds;      // change of the variables between two iterations
+  double **dy;      // change of the gradients between two iterations
+
+  int num_mem;    // number of stored steps
+  double *rho;    // estimation of curvature
+
+  // two-loop recursion on the Gram matrix of the basis {ds, dy, g_cur},
+  // as in MinSpinLBFGS
+
+  int nbasis;
+  double **gram;
+  double *gram_row, *gram_row_all;
+  double *coeff;
+  double *alpha;
+
+  bigint last_negative;
+
+  // spin pair styles, with their lattice_flag before the minimization
+
+  std::vector<class PairSpin *> spin_pairs;
+  std::vector<int> lattice_flag_saved;
+
+  void calc_gradient();
+  void calc_search_direction();
+  void advance();
+  double maximum_step(double *);
+  double *basis(int);
+  void rodrigues_rotation(const double *, double *);
+  void vm3(const double *, const double *, double *);
+  void transport(const double *, double *);
+};
+
+}    // namespace LAMMPS_NS
+
+#endif
+#endif
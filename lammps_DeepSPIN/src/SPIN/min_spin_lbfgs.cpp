@@ -28,9 +28,11 @@
 #include "citeme.h"
 #include "comm.h"
 #include "error.h"
+#include "fix_store.h"
 #include "force.h"
 #include "math_const.h"
 #include "memory.h"
+#include "modify.h"
 #include "output.h"
 #include "timer.h"
 #include "universe.h"
@@ -58,13 +60,22 @@ static const char cite_minstyle_spin_lbfgs[] =
 
 #define DELAYSTEP 5
 
+// per-atom vectors of the history, 3 values each, ds[k] and dy[k] follow
+
+enum{G_OLD,G_CUR,P_S,S_LAST,SP_COPY,NVEC};
+
+// global state: # of stored iterations, timestep of the last update and
+// 1 once the history holds an update, rho[num_mem] and the Gram matrix follow
+
+enum{LOCAL_ITER,LAST_STEP,HAVE_HISTORY,NSTATE};
+
 /* ---------------------------------------------------------------------- */
 
 MinSpinLBFGS::MinSpinLBFGS(LAMMPS *lmp) :
-  Min(lmp), g_old(nullptr), g_cur(nullptr), p_s(nullptr), rho(nullptr), ds(nullptr), dy(nullptr), sp_copy(nullptr)
+  Min(lmp), fix_history(nullptr), hist(nullptr), fix_state(nullptr), state(nullptr), rho(nullptr),
+  gram(nullptr), gram_row(nullptr), gram_row_all(nullptr), coeff(nullptr), alpha(nullptr)
 {
   if (lmp->citeme) lmp->citeme->add(cite_minstyle_spin_lbfgs);
-  nlocal_max = 0;
 
   // nreplica = number of partitions
   // ireplica = which world I am in universe
@@ -81,14 +92,18 @@ MinSpinLBFGS::MinSpinLBFGS(LAMMPS *lmp) :
 
 MinSpinLBFGS::~MinSpinLBFGS()
 {
-    memory->destroy(g_old);
-    memory->destroy(g_cur);
-    memory->destroy(p_s);
-    memory->destroy(ds);
-    memory->destroy(dy);
-    memory->destroy(rho);
-    if (use_line_search)
-      memory->destroy(sp_copy);
+    delete [] gram;
+    memory->destroy(gram_row);
+    memory->destroy(gram_row_all);
+    memory->destroy(coeff);
+    memory->destroy(alpha);
+
+    // check nfix in case all fixes have already been deleted
+
+    if (modify->nfix) {
+      modify->delete_fix(modify->find_fix("SPIN_LBFGS_HISTORY"));
+      modify->delete_fix(modify->find_fix("SPIN_LBFGS_STATE"));
+    }
 }
 
 /* ---------------------------------------------------------------------- */
@@ -96,7 +111,7 @@ MinSpinLBFGS::~MinSpinLBFGS()
 void MinSpinLBFGS::init()
 {
   num_mem = 3;
-  local_iter = 0;
+  nbasis = 2*num_mem + 1;
   der_e_cur = 0.0;
   der_e_pr = 0.0;
 
@@ -118,18 +133,35 @@ void MinSpinLBFGS::init()
 
   last_negative = update->ntimestep;
 
-  // allocate tables
+  // create the fix STORE styles of the history and of the global state
+  // kept from a previous minimization, or reset from a restart file
+
+  fix_history = dynamic_cast<FixStore *>(modify->get_fix_by_id("SPIN_LBFGS_HISTORY"));
+  if (!fix_history)
+    fix_history = dynamic_cast<FixStore *>(
+      modify->add_fix(fmt::format("SPIN_LBFGS_HISTORY all STORE peratom 1 {}",
+                                  3*(NVEC + 2*num_mem))));
+
+  fix_state = dynamic_cast<FixStore *>(modify->get_fix_by_id("SPIN_LBFGS_STATE"));
+  if (!fix_state)
+    fix_state = dynamic_cast<FixStore *>(
+      modify->add_fix(fmt::format("SPIN_LBFGS_STATE all STORE global {} 1",
+                                  NSTATE + num_mem + nbasis*nbasis)));
+
+  state = fix_state->vstore;
+  rho = state + NSTATE;
+  delete [] gram;
+  gram = new double*[nbasis];
+  for (int k = 0; k < nbasis; k++)
+    gram[k] = state + NSTATE + num_mem + k*nbasis;
+  local_iter = static_cast<int>(state[LOCAL_ITER]);
 
-  nlocal_max = atom->nlocal;
-  memory->grow(g_old,3*nlocal_max,"min/spin/lbfgs:g_old");
-  memory->grow(g_cur,3*nlocal_max,"min/spin/lbfgs:g_cur");
-  memory->grow(p_s,3*nlocal_max,"min/spin/lbfgs:p_s");
-  memory->grow(rho,num_mem,"min/spin/lbfgs:rho");
-  memory->grow(ds,num_mem,3*nlocal_max,"min/spin/lbfgs:ds");
-  memory->grow(dy,num_mem,3*nlocal_max,"min/spin/lbfgs:dy");
-  if (use_line_search)
-    memory->grow(sp_copy,nlocal_max,3,"min/spin/lbfgs:sp_copy");
+  // allocate tables
 
+  memory->grow(gram_row,3*nbasis,"min/spin/lbfgs:gram_row");
+  memory->grow(gram_row_all,3*nbasis,"min/spin/lbfgs:gram_row_all");
+  memory->grow(coeff,nbasis,"min/spin/lbfgs:coeff");
+  memory->grow(alpha,num_mem,"min/spin/lbfgs:alpha");
 }
 
 /* ---------------------------------------------------------------------- */
@@ -146,6 +178,47 @@ void MinSpinLBFGS::setup_style()
 
   for (int i = 0; i < nlocal; i++)
     v[i][0] = v[i][1] = v[i][2] = 0.0;
+
+  // continue from the stored history if it is still valid
+
+  hist = fix_history->astore;
+  if (local_iter > 0 && resume_history()) {
+    if (comm->me == 0)
+      utils::logmesg(lmp,"  Resuming spin/lbfgs from {} stored iterations\n",local_iter);
+  } else local_iter = 0;
+  state[LOCAL_ITER] = local_iter;
+}
+
+/* ----------------------------------------------------------------------
+   return 1 if the stored history applies to the current spins:
+   a single replica, a history written by an update, unchanged
+   timestep, and spins equal to those after the last update, 0 otherwise
+------------------------------------------------------------------------- */
+
+int MinSpinLBFGS::resume_history()
+{
+  if (update->multireplica) return 0;
+
+  // fix STORE zero-fills, so a new state has no history at step 0
+
+  if (state[HAVE_HISTORY] != 1.0) return 0;
+  if (state[LAST_STEP] != (double) update->ntimestep) return 0;
+
+  double **sp = atom->sp;
+  int nlocal = atom->nlocal;
+
+  // squared distance to the spins after the last update
+
+  double dsq = 0.0, dsqall;
+  for (int i = 0; i < nlocal; i++)
+    for (int j = 0; j < 3; j++) {
+      double d = sp[i][j] - hist[i][3*S_LAST+j];
+      dsq += d*d;
+    }
+  MPI_Allreduce(&dsq,&dsqall,1,MPI_DOUBLE,MPI_SUM,world);
+
+  if (dsqall <= 1.0e-20 * atom->natoms) return 1;
+  return 0;
 }
 
 /* ---------------------------------------------------------------------- */
@@ -180,6 +253,8 @@ void MinSpinLBFGS::reset_vectors()
 
   if (nvec) xvec = atom->x[0];
   if (nvec) fvec = atom->f[0];
+
+  hist = fix_history->astore;
 }
 
 /* ----------------------------------------------------------------------
@@ -188,26 +263,11 @@ void MinSpinLBFGS::reset_vectors()
 
 int MinSpinLBFGS::iterate(int maxiter)
 {
-  int nlocal = atom->nlocal;
   bigint ntimestep;
   double fmdotfm,fmsq;
   int flag, flagall;
-  double **sp = atom->sp;
   double der_e_cur_tmp = 0.0;
 
-  if (nlocal_max < nlocal) {
-    nlocal_max = nlocal;
-    local_iter = 0;
-    memory->grow(g_old,3*nlocal_max,"min/spin/lbfgs:g_old");
-    memory->grow(g_cur,3*nlocal_max,"min/spin/lbfgs:g_cur");
-    memory->grow(p_s,3*nlocal_max,"min/spin/lbfgs:p_s");
-    memory->grow(rho,num_mem,"min/spin/lbfgs:rho");
-    memory->grow(ds,num_mem,3*nlocal_max,"min/spin/lbfgs:ds");
-    memory->grow(dy,num_mem,3*nlocal_max,"min/spin/lbfgs:dy");
-    if (use_line_search)
-      memory->grow(sp_copy,nlocal_max,3,"min/spin/lbfgs:sp_copy");
-  }
-
   for (int iter = 0; iter < maxiter; iter++) {
 
     if (timer->check_timeout(niter))
@@ -229,17 +289,17 @@ int MinSpinLBFGS::iterate(int maxiter)
       }
 
       calc_search_direction();
-      der_e_cur = 0.0;
-      for (int i = 0; i < 3 * nlocal; i++)
-        der_e_cur += g_cur[i] * p_s[i];
+      der_e_cur = dot_local(G_CUR,P_S);
       MPI_Allreduce(&der_e_cur,&der_e_cur_tmp,1,MPI_DOUBLE,MPI_SUM,world);
       der_e_cur = der_e_cur_tmp;
       if (update->multireplica == 1) {
         MPI_Allreduce(&der_e_cur_tmp,&der_e_cur,1,MPI_DOUBLE,MPI_SUM,universe->uworld);
       }
+      int nlocal = atom->nlocal;
+      double **sp = atom->sp;
       for (int i = 0; i < nlocal; i++)
         for (int j = 0; j < 3; j++)
-      sp_copy[i][j] = sp[i][j];
+          hist[i][3*SP_COPY+j] = sp[i][j];
 
       eprevious = ecurrent;
       der_e_pr = der_e_cur;
@@ -325,9 +385,10 @@ void MinSpinLBFGS::calc_gradient()
   // loop on all spins on proc.
 
   for (int i = 0; i < nlocal; i++) {
-    g_cur[3 * i + 0] = (fm[i][0]*sp[i][1] - fm[i][1]*sp[i][0]) * hbar;
-    g_cur[3 * i + 1] = -(fm[i][2]*sp[i][0] - fm[i][0]*sp[i][2]) * hbar;
-    g_cur[3 * i + 2] = (fm[i][1]*sp[i][2] - fm[i][2]*sp[i][1]) * hbar;
+    double *g_cur = &hist[i][3*G_CUR];
+    g_cur[0] = (fm[i][0]*sp[i][1] - fm[i][1]*sp[i][0]) * hbar;
+    g_cur[1] = -(fm[i][2]*sp[i][0] - fm[i][0]*sp[i][2]) * hbar;
+    g_cur[2] = (fm[i][1]*sp[i][2] - fm[i][2]*sp[i][1]) * hbar;
   }
 }
 
@@ -336,27 +397,20 @@ void MinSpinLBFGS::calc_gradient()
    Limited-memory BFGS.
    See Jorge Nocedal and Stephen J. Wright 'Numerical
    Optimization' Second Edition, 2006 (p. 177)
+   the two-loop recursion is done on the coefficients of the search
+   direction in the basis {ds, dy, g_cur}, from the Gram matrix of the
+   basis, as in Chen et al., 'Large-scale L-BFGS using MapReduce', NIPS
+   2014, so all dot products of an iteration take a single reduction
 ---------------------------------------------------------------------- */
 
 void MinSpinLBFGS::calc_search_direction()
 {
   int nlocal = atom->nlocal;
-
-  double dyds = 0.0;
-  double sq = 0.0;
-  double yy = 0.0;
-  double yr = 0.0;
   double beta = 0.0;
-
-  double dyds_global = 0.0;
-  double sq_global = 0.0;
-  double yy_global = 0.0;
-  double yr_global = 0.0;
+  double dot = 0.0;
 
   int m_index = local_iter % num_mem; // memory index
   int c_ind = 0;
-  double *q;
-  double *alpha;
 
   double factor;
   double scaling = 1.0;
@@ -375,34 +429,54 @@ void MinSpinLBFGS::calc_search_direction()
 
     //if no line search then calculate maximum rotation
     if (use_line_search == 0)
-      scaling = maximum_rotation(g_cur);
-
-    for (int i = 0; i < 3 * nlocal; i++) {
-      p_s[i] = -g_cur[i] * factor * scaling;;
-      g_old[i] = g_cur[i]  * factor;
-      for (int k = 0; k < num_mem; k++) {
-        ds[k][i] = 0.0;
-        dy[k][i] = 0.0;
+      scaling = maximum_rotation(G_CUR);
+
+    for (int i = 0; i < nlocal; i++) {
+      double *h = hist[i];
+      for (int j = 0; j < 3; j++) {
+        h[3*P_S+j] = -h[3*G_CUR+j] * factor * scaling;
+        h[3*G_OLD+j] = h[3*G_CUR+j] * factor;
       }
+      for (int k = 0; k < 2 * num_mem; k++)
+        for (int j = 0; j < 3; j++) h[3*(NVEC+k)+j] = 0.0;
     }
     for (int k = 0; k < num_mem; k++)
       rho[k] = 0.0;
+    for (int k = 0; k < nbasis; k++)
+      for (int l = 0; l < nbasis; l++)
+        gram[k][l] = 0.0;
 
     } else {
-    dyds = 0.0;
-    for (int i = 0; i < 3 * nlocal; i++) {
-      ds[m_index][i] = p_s[i];
-      dy[m_index][i] = g_cur[i] - g_old[i];
-      dyds += ds[m_index][i] * dy[m_index][i];
-    }
-    MPI_Allreduce(&dyds, &dyds_global, 1, MPI_DOUBLE, MPI_SUM, world);
-
-    if (nreplica > 1) {
-      dyds_global *= factor;
-      dyds = dyds_global;
-      MPI_Allreduce(&dyds, &dyds_global, 1,MPI_DOUBLE,MPI_SUM,universe->uworld);
+    const int ids = basis(m_index);
+    const int idy = basis(num_mem + m_index);
+    for (int i = 0; i < nlocal; i++) {
+      double *h = hist[i];
+      for (int j = 0; j < 3; j++) {
+        h[3*ids+j] = h[3*P_S+j];
+        h[3*idy+j] = h[3*G_CUR+j] - h[3*G_OLD+j];
+      }
     }
 
+    // rows of the Gram matrix for the new ds, dy and g_cur
+    // the others are kept from the previous iterations
+    // end points of multiple replica do not contribute to any of the
+    // products, as in the former per-product reductions: their ds and
+    // g_old are zero, but dy = g_cur is not and would enter dy.dy
+
+    const int irow[3] = {m_index, num_mem + m_index, nbasis - 1};
+    for (int r = 0; r < 3; r++)
+      for (int l = 0; l < nbasis; l++)
+        gram_row[r * nbasis + l] = factor * dot_local(basis(irow[r]),basis(l));
+    if (nreplica > 1)
+      MPI_Allreduce(gram_row,gram_row_all,3*nbasis,MPI_DOUBLE,MPI_SUM,universe->uworld);
+    else
+      MPI_Allreduce(gram_row,gram_row_all,3*nbasis,MPI_DOUBLE,MPI_SUM,world);
+
+    for (int r = 0; r < 3; r++)
+      for (int l = 0; l < nbasis; l++)
+        gram[irow[r]][l] = gram[l][irow[r]] = gram_row_all[r * nbasis + l];
+
+    double dyds_global = gram[m_index][num_mem + m_index];
     if (fabs(dyds_global) > 1.0e-60) rho[m_index] = 1.0 / dyds_global;
     else rho[m_index] = 1.0e60;
 
@@ -410,13 +484,11 @@ void MinSpinLBFGS::calc_search_direction()
       local_iter = 0;
       return calc_search_direction();
     }
-    q = (double *) calloc(3*nlocal, sizeof(double));
-    alpha = (double *) calloc(num_mem, sizeof(double));
-    // set the q vector
 
-    for (int i = 0; i < 3 * nlocal; i++) {
-      q[i] = g_cur[i];
-    }
+    // set the q vector to g_cur
+
+    for (int l = 0; l < nbasis; l++) coeff[l] = 0.0;
+    coeff[nbasis - 1] = 1.0;
 
     // loop over last m indecies
     for (int k = num_mem - 1; k > -1; k--) {
@@ -424,90 +496,105 @@ void MinSpinLBFGS::calc_search_direction()
 
       c_ind = (k + m_index + 1) % num_mem;
 
-      // dot product between dg and q
+      // dot product between ds and q
 
-      sq = 0.0;
-      for (int i = 0; i < 3 * nlocal; i++) {
-        sq += ds[c_ind][i] * q[i];
-      }
-      MPI_Allreduce(&sq,&sq_global,1,MPI_DOUBLE,MPI_SUM,world);
-      if (nreplica > 1) {
-        sq_global *= factor;
-        sq = sq_global;
-        MPI_Allreduce(&sq,&sq_global,1,MPI_DOUBLE,MPI_SUM,universe->uworld);
-      }
+      dot = 0.0;
+      for (int l = 0; l < nbasis; l++) dot += gram[c_ind][l] * coeff[l];
 
       // update alpha
 
-      alpha[c_ind] = rho[c_ind] * sq_global;
+      alpha[c_ind] = rho[c_ind] * dot;
 
       // update q
 
-      for (int i = 0; i < 3 * nlocal; i++) {
-        q[i] -= alpha[c_ind] * dy[c_ind][i];
-      }
+      coeff[num_mem + c_ind] -= alpha[c_ind];
     }
 
     // dot product between dg with itself
-    yy = 0.0;
-    for (int i = 0; i < 3 * nlocal; i++) {
-      yy += dy[m_index][i] * dy[m_index][i];
-    }
-    MPI_Allreduce(&yy,&yy_global,1,MPI_DOUBLE,MPI_SUM,world);
-    if (nreplica > 1) {
-      yy_global *= factor;
-      yy = yy_global;
-      MPI_Allreduce(&yy,&yy_global,1,MPI_DOUBLE,MPI_SUM,universe->uworld);
-    }
+
+    double yy_global = gram[num_mem + m_index][num_mem + m_index];
 
     // calculate now search direction
 
     double devis = rho[m_index] * yy_global;
 
     if (fabs(devis) > 1.0e-60) {
-      for (int i = 0; i < 3 * nlocal; i++) {
-        p_s[i] = factor * q[i] / devis;
-      }
+      for (int l = 0; l < nbasis; l++) coeff[l] *= factor / devis;
     }else{
-      for (int i = 0; i < 3 * nlocal; i++) {
-        p_s[i] = factor * q[i] * 1.0e60;
-      }
+      for (int l = 0; l < nbasis; l++) coeff[l] *= factor * 1.0e60;
     }
 
     for (int k = 0; k < num_mem; k++) {
       // this loop should run from the oldest memory to the newest one.
 
-      if (local_iter < num_mem) c_ind = k;
-      else c_ind = (k + m_index + 1) % num_mem;
+      c_ind = (k + m_index + 1) % num_mem;
 
-      // dot product between p and da
-      yr = 0.0;
-      for (int i = 0; i < 3 * nlocal; i++) {
-        yr += dy[c_ind][i] * p_s[i];
-      }
+      // dot product between dy and p
 
-      MPI_Allreduce(&yr,&yr_global,1,MPI_DOUBLE,MPI_SUM,world);
-      if (nreplica > 1) {
-        yr_global *= factor;
-        yr = yr_global;
-        MPI_Allreduce(&yr,&yr_global,1,MPI_DOUBLE,MPI_SUM,universe->uworld);
-      }
+      dot = 0.0;
+      for (int l = 0; l < nbasis; l++) dot += gram[num_mem + c_ind][l] * coeff[l];
+
+      beta = rho[c_ind] * dot;
+      coeff[c_ind] += alpha[c_ind] - beta;
+    }
+
+    // search direction from its coefficients
 
-      beta = rho[c_ind] * yr_global;
-      for (int i = 0; i < 3 * nlocal; i++) {
-        p_s[i] += ds[c_ind][i] * (alpha[c_ind] - beta);
+    for (int i = 0; i < nlocal; i++) {
+      double *h = hist[i];
+      for (int j = 0; j < 3; j++) {
+        dot = 0.0;
+        for (int k = 0; k < num_mem; k++)
+          dot += coeff[k] * h[3*basis(k)+j] + coeff[num_mem + k] * h[3*basis(num_mem + k)+j];
+        h[3*P_S+j] = dot + coeff[nbasis - 1] * h[3*G_CUR+j];
       }
     }
+
     if (use_line_search == 0)
-      scaling = maximum_rotation(p_s);
-    for (int i = 0; i < 3 * nlocal; i++) {
-      p_s[i] = - factor * p_s[i] * scaling;
-      g_old[i] = g_cur[i] * factor;
+      scaling = maximum_rotation(P_S);
+    for (int i = 0; i < nlocal; i++) {
+      double *h = hist[i];
+      for (int j = 0; j < 3; j++) {
+        h[3*P_S+j] = - factor * h[3*P_S+j] * scaling;
+        h[3*G_OLD+j] = h[3*G_CUR+j] * factor;
+      }
     }
-    free(q);
-    free(alpha);
   }
   local_iter++;
+
+  // global state goes with the history, e.g. into restart files
+
+  state[LOCAL_ITER] = local_iter;
+  state[LAST_STEP] = update->ntimestep;
+  state[HAVE_HISTORY] = 1.0;
+}
+
+/* ----------------------------------------------------------------------
+   per-atom vector of the history holding vector k of the basis of the
+   search direction: ds, dy and g_cur
+---------------------------------------------------------------------- */
+
+int MinSpinLBFGS::basis(int k)
+{
+  if (k < 2 * num_mem) return NVEC + k;
+  return G_CUR;
+}
+
+/* ----------------------------------------------------------------------
+   dot product of two per-atom vectors of the history on this proc
+---------------------------------------------------------------------- */
+
+double MinSpinLBFGS::dot_local(int a, int b)
+{
+  int nlocal = atom->nlocal;
+  double dot = 0.0;
+
+  for (int i = 0; i < nlocal; i++) {
+    const double *u = &hist[i][3*a];
+    const double *w = &hist[i][3*b];
+    for (int j = 0; j < 3; j++) dot += u[j] * w[j];
+  }
+  return dot;
 }
 
 /* ----------------------------------------------------------------------
@@ -524,12 +611,12 @@ void MinSpinLBFGS::advance_spins()
   // loop on all spins on proc.
 
   for (int i = 0; i < nlocal; i++) {
-    rodrigues_rotation(p_s + 3 * i, rot_mat);
+    rodrigues_rotation(&hist[i][3*P_S], rot_mat);
 
     // rotate spins
 
     vm3(rot_mat, sp[i], s_new);
-    for (int j = 0; j < 3; j++) sp[i][j] = s_new[j];
+    for (int j = 0; j < 3; j++) sp[i][j] = hist[i][3*S_LAST+j] = s_new[j];
   }
 }
 
@@ -628,7 +715,7 @@ void MinSpinLBFGS::make_step(double c, double *energy_and_der)
 
     // scale the search direction
 
-    for (int j = 0; j < 3; j++) p_scaled[j] = c * p_s[3 * i + j];
+    for (int j = 0; j < 3; j++) p_scaled[j] = c * hist[i][3*P_S+j];
 
     // calculate rotation matrix
 
@@ -637,16 +724,13 @@ void MinSpinLBFGS::make_step(double c, double *energy_and_der)
     // rotate spins
 
     vm3(rot_mat, sp[i], s_new);
-    for (int j = 0; j < 3; j++) sp[i][j] = s_new[j];
+    for (int j = 0; j < 3; j++) sp[i][j] = hist[i][3*S_LAST+j] = s_new[j];
   }
 
   ecurrent = energy_force(0);
   calc_gradient();
   neval++;
-  der_e_cur = 0.0;
-  for (int i = 0; i < 3 * nlocal; i++) {
-    der_e_cur += g_cur[i] * p_s[i];
-  }
+  der_e_cur = dot_local(G_CUR,P_S);
   MPI_Allreduce(&der_e_cur,&der_e_cur_tmp, 1, MPI_DOUBLE, MPI_SUM, world);
   der_e_cur = der_e_cur_tmp;
   if (update->multireplica == 1) {
@@ -666,8 +750,6 @@ int MinSpinLBFGS::calc_and_make_step(double a, double b, int index)
 {
   double e_and_d[2] = {0.0,0.0};
   double alpha,c1,c2,c3;
-  double **sp = atom->sp;
-  int nlocal = atom->nlocal;
 
   make_step(b,e_and_d);
   ecurrent = e_and_d[0];
@@ -676,9 +758,9 @@ int MinSpinLBFGS::calc_and_make_step(double a, double b, int index)
 
   if (adescent(eprevious,e_and_d[0]) || index == 5) {
     MPI_Bcast(&b,1,MPI_DOUBLE,0,world);
-    for (int i = 0; i < 3 * nlocal; i++) {
-      p_s[i] = b * p_s[i];
-    }
+    int nlocal = atom->nlocal;
+    for (int i = 0; i < nlocal; i++)
+      for (int j = 0; j < 3; j++) hist[i][3*P_S+j] *= b;
     return 1;
   }
   else{
@@ -701,8 +783,10 @@ int MinSpinLBFGS::calc_and_make_step(double a, double b, int index)
 
     if (alpha < 0.0) alpha = r/2.0;
 
+    int nlocal = atom->nlocal;
+    double **sp = atom->sp;
     for (int i = 0; i < nlocal; i++) {
-      for (int j = 0; j < 3; j++) sp[i][j] = sp_copy[i][j];
+      for (int j = 0; j < 3; j++) sp[i][j] = hist[i][3*SP_COPY+j];
     }
     calc_and_make_step(0.0, alpha, index);
    }
@@ -724,27 +808,23 @@ int MinSpinLBFGS::adescent(double phi_0, double phi_j) {
     return 0;
 }
 
-double MinSpinLBFGS::maximum_rotation(double *p)
+double MinSpinLBFGS::maximum_rotation(int p)
 {
-  double norm2,norm2_global,scaling,alpha;
+  double scaling,alpha;
+  double sums[2],sums_global[2];
   int nlocal = atom->nlocal;
-  int ntotal = 0;
 
-  norm2 = 0.0;
-  for (int i = 0; i < 3 * nlocal; i++) norm2 += p[i] * p[i];
+  // squared norm of per-atom vector p and # of spins, in a single reduction
 
-  MPI_Allreduce(&norm2,&norm2_global,1,MPI_DOUBLE,MPI_SUM,world);
-  if (nreplica > 1) {
-    norm2 = norm2_global;
-    MPI_Allreduce(&norm2,&norm2_global,1,MPI_DOUBLE,MPI_SUM,universe->uworld);
-  }
-  MPI_Allreduce(&nlocal,&ntotal,1,MPI_INT,MPI_SUM,world);
-  if (nreplica > 1) {
-    nlocal = ntotal;
-    MPI_Allreduce(&nlocal,&ntotal,1,MPI_INT,MPI_SUM,universe->uworld);
-  }
+  sums[0] = dot_local(p,p);
+  sums[1] = nlocal;
+
+  if (nreplica > 1)
+    MPI_Allreduce(sums,sums_global,2,MPI_DOUBLE,MPI_SUM,universe->uworld);
+  else
+    MPI_Allreduce(sums,sums_global,2,MPI_DOUBLE,MPI_SUM,world);
 
-  scaling = (maxepsrot * sqrt((double) ntotal / norm2_global));
+  scaling = (maxepsrot * sqrt(sums_global[1] / sums_global[0]));
 
   if (scaling < 1.0) alpha = scaling;
   else alpha = 1.0;
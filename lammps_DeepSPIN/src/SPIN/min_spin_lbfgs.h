@@ -37,16 +37,12 @@ class MinSpinLBFGS : public Min {
  private:
   int local_iter;            // for neb
   int use_line_search;       // use line search or not.
-  int nlocal_max;            // max value of nlocal (for size of lists)
   int ireplica, nreplica;    // for neb
   double der_e_cur;          // current derivative along search dir.
   double der_e_pr;           // previous derivative along search dir.
   double maxepsrot;
   double *spvec;    // variables for atomic dof, as 1d vector
   double *fmvec;    // variables for atomic dof, as 1d vector
-  double *g_old;    // gradient vector at previous step
-  double *g_cur;    // current gradient vector
-  double *p_s;      // search direction vector
 
   void advance_spins();
   void calc_gradient();
@@ -56,13 +52,39 @@ class MinSpinLBFGS : public Min {
   void make_step(double, double *);
   int calc_and_make_step(double, double, int);
   int adescent(double, double);
-  double maximum_rotation(double *);
+  double maximum_rotation(int);
+  int resume_history();
+
+  // per-atom history, stored by fix STORE so it migrates with the atoms
+  // and is written to restart files: 3 values per atom for each of
+  // g_old, g_cur, p_s, s_last, sp_copy, then ds[num_mem], dy[num_mem]
+
+  class FixStore *fix_history;
+  double **hist;
+
+  // global state, also stored by fix STORE: local_iter, timestep of
+  // the last update, a flag set by the first update, rho[num_mem]
+  // and the Gram matrix
+
+  class FixStore *fix_state;
+  double *state;
 
   double *rho;         // estimation of curvature
-  double **ds;         // change in rotation matrix between two iterations, da
-  double **dy;         // change in gradients between two iterations, dg
-  double **sp_copy;    // copy of the spins
   int num_mem;         // number of stored steps
+
+  // the search direction is a combination of the basis {ds, dy, g_cur},
+  // the two-loop recursion runs on its Gram matrix, whose new rows are
+  // obtained by a single reduction per iteration
+
+  int nbasis;          // 2*num_mem + 1 vectors in the basis
+  double **gram;       // Gram matrix of the basis, rows in state
+  double *gram_row;    // new rows of the Gram matrix, local and summed
+  double *gram_row_all;
+  double *coeff;       // coefficients of the search direction in the basis
+  double *alpha;       // alpha coefficients of the two-loop recursion
+
+  int basis(int);
+  double dot_local(int, int);
   bigint last_negative;
 };
 
@@ -26,12 +26,14 @@
 
 #include "atom.h"
 #include "comm.h"
+#include "domain.h"
 #include "error.h"
 #include "fix_nve_spin.h"
 #include "force.h"
 #include "math_const.h"
 #include "memory.h"
 #include "modify.h"
+#include "neigh_list.h"
 #include "neigh_request.h"
 #include "neighbor.h"
 #include "pair.h"
@@ -44,13 +46,31 @@ using namespace MathConst;
 
 /* ---------------------------------------------------------------------- */
 
-PairSpin::PairSpin(LAMMPS *lmp) : Pair(lmp), emag(nullptr)
+PairSpin::PairSpin(LAMMPS *lmp) : Pair(lmp), emag(nullptr),
+  firstpair(nullptr), numpair(nullptr), jpair(nullptr), pcoeff(nullptr)
 {
   hbar = force->hplanck/MY_2PI;
   single_enable = 0;
   respa_enable = 0;
   no_virial_fdotr_compute = 1;
   lattice_flag = 0;
+
+  ncoeff = 0;
+  cache_flag = 0;
+  cache_stamp = -1;
+  nmax_cache = maxpair = 0;
+}
+
+/* ---------------------------------------------------------------------- */
+
+PairSpin::~PairSpin()
+{
+  if (copymode) return;
+
+  memory->destroy(firstpair);
+  memory->destroy(numpair);
+  memory->destroy(jpair);
+  memory->destroy(pcoeff);
 }
 
 /* ----------------------------------------------------------------------
@@ -100,8 +120,108 @@ void PairSpin::init_style()
   else if (fixes.size() > 1)
     error->warning(FLERR,"Using multiple instances of fix nve/spin or neb/spin");
 
+  // the pair coefficients are only cached in a run with a single fix
+  // nve/spin and a frozen lattice, when no other fix moves the atoms
+
+  cache_flag = 0;
+  if ((update->whichflag == 1) && (fixes.size() == 1) && !lattice_flag
+      && !domain->deform_flag) {
+    cache_flag = 1;
+    for (const auto &ifix : modify->get_fix_list())
+      if (ifix->time_integrate && (ifix != fixes.front())) cache_flag = 0;
+  }
+
   // init. size of energy stacking lists
 
   nlocal_max = atom->nlocal;
   memory->grow(emag,nlocal_max,"pair/spin:emag");
+
+  // atoms may have been displaced since the last run
+
+  cache_stamp = -1;
+}
+
+/* ----------------------------------------------------------------------
+   cache the coefficients of all pairs within the cutoff
+   only while fix nve/spin keeps the lattice frozen, positions then change
+   only when the neighbor lists are rebuilt, and the pair field of a spin
+   is a sparse product of the cached coefficients with the neighbor spins
+   return 1 if the cache is valid, 0 if it is not used
+------------------------------------------------------------------------- */
+
+int PairSpin::coeff_cache()
+{
+  if (!cache_flag || (ncoeff == 0)) return 0;
+  if (cache_stamp == neighbor->lastcall) return 1;
+
+  int i,j,ii,jj,jnum,npair;
+  double xi[3],del[3],rsq;
+  int *jlist;
+
+  double **x = atom->x;
+  const int nlocal = atom->nlocal;
+  const int inum = list->inum;
+  int *ilist = list->ilist;
+  int *numneigh = list->numneigh;
+  int **firstneigh = list->firstneigh;
+
+  if (atom->nmax > nmax_cache) {
+    nmax_cache = atom->nmax;
+    memory->destroy(firstpair);
+    memory->destroy(numpair);
+    memory->create(firstpair,nmax_cache,"pair/spin:firstpair");
+    memory->create(numpair,nmax_cache,"pair/spin:numpair");
+  }
+
+  npair = 0;
+  for (ii = 0; ii < inum; ii++) npair += numneigh[ilist[ii]];
+  if (npair > maxpair) {
+    maxpair = npair;
+    memory->destroy(jpair);
+    memory->destroy(pcoeff);
+    memory->create(jpair,maxpair,"pair/spin:jpair");
+    memory->create(pcoeff,maxpair*ncoeff,"pair/spin:pcoeff");
+  }
+
+  for (i = 0; i < nlocal; i++) numpair[i] = 0;
+
+  npair = 0;
+  for (ii = 0; ii < inum; ii++) {
+    i = ilist[ii];
+    xi[0] = x[i][0];
+    xi[1] = x[i][1];
+    xi[2] = x[i][2];
+    jlist = firstneigh[i];
+    jnum = numneigh[i];
+    firstpair[i] = npair;
+
+    for (jj = 0; jj < jnum; jj++) {
+      j = jlist[jj];
+      j &= NEIGHMASK;
+
+      del[0] = xi[0] - x[j][0];
+      del[1] = xi[1] - x[j][1];
+      del[2] = xi[2] - x[j][2];
+      rsq = del[0]*del[0] + del[1]*del[1] + del[2]*del[2];
+
+      if (cache_pair(i,j,rsq,del,&pcoeff[npair*ncoeff])) jpair[npair++] = j;
+    }
+    numpair[i] = npair - firstpair[i];
+  }
+
+  cache_stamp = neighbor->lastcall;
+  return 1;
+}
+
+/* ----------------------------------------------------------------------
+   memory usage of the pair coefficient cache
+------------------------------------------------------------------------- */
+
+double PairSpin::memory_usage()
+{
+  double bytes = Pair::memory_usage();
+  bytes += (double)2*nmax_cache*sizeof(int);
+  bytes += (double)maxpair*sizeof(int);
+  bytes += (double)maxpair*ncoeff*sizeof(double);
+  return bytes;
 }
@@ -23,6 +23,7 @@ class PairSpin : public Pair {
 
  public:
   PairSpin(class LAMMPS *);
+  ~PairSpin() override;
 
   void settings(int, char **) override;
   void coeff(int, char **) override {}
@@ -32,15 +33,32 @@ class PairSpin : public Pair {
 
   void compute(int, int) override {}
   virtual void compute_single_pair(int, double *) {}
+  double memory_usage() override;
 
   // storing magnetic energies
 
   int nlocal_max;    // max nlocal (for list size)
   double *emag;      // energy list
 
+  int lattice_flag;    // flag for mech force computation
+
  protected:
   double hbar;         // Planck constant (eV.ps.rad-1)
-  int lattice_flag;    // flag for mech force computation
+
+  // coefficients of each neighbor pair, cached while the lattice is frozen
+
+  int ncoeff;               // coefficients per pair, 0 if no cache
+  int cache_flag;           // 1 if the atoms only move at reneighboring
+  bigint cache_stamp;       // neighbor->lastcall of the cached pairs
+  int nmax_cache;           // length of per-atom cache arrays
+  int maxpair;              // max # of cached pairs
+  int *firstpair;           // index of first cached pair of each atom
+  int *numpair;             // # of cached pairs of each atom
+  int *jpair;               // neighbor atom of each cached pair
+  double *pcoeff;           // ncoeff coefficients of each cached pair
+
+  int coeff_cache();
+  virtual int cache_pair(int, int, double, double *, double *) { return 0; }
 
   virtual void allocate() {}
 };
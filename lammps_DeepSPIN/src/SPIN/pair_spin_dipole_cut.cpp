@@ -437,7 +437,7 @@ void PairSpinDipoleCut::write_restart(FILE *fp)
     for (j = i; j <= atom->ntypes; j++) {
       fwrite(&setflag[i][j],sizeof(int),1,fp);
       if (setflag[i][j]) {
-        fwrite(&cut_spin_long[i][j],sizeof(int),1,fp);
+        fwrite(&cut_spin_long[i][j],sizeof(double),1,fp);
       }
     }
   }
@@ -461,7 +461,7 @@ void PairSpinDipoleCut::read_restart(FILE *fp)
       MPI_Bcast(&setflag[i][j],1,MPI_INT,0,world);
       if (setflag[i][j]) {
         if (me == 0) {
-          utils::sfread(FLERR,&cut_spin_long[i][j],sizeof(int),1,fp,nullptr,error);
+          utils::sfread(FLERR,&cut_spin_long[i][j],sizeof(double),1,fp,nullptr,error);
         }
         MPI_Bcast(&cut_spin_long[i][j],1,MPI_DOUBLE,0,world);
       }
@@ -40,6 +40,8 @@ using namespace LAMMPS_NS;
 
 PairSpinDmi::~PairSpinDmi()
 {
+  if (copymode) return;
+
   if (allocated) {
     memory->destroy(setflag);
     memory->destroy(cut_spin_dmi);
@@ -197,6 +199,13 @@ void PairSpinDmi::compute(int eflag, int vflag)
     memory->grow(emag,nlocal_max,"pair/spin:emag");
   }
 
+  // frozen lattice, use the cached dmi vectors
+
+  if (coeff_cache()) {
+    compute_frozen(eflag);
+    return;
+  }
+
   // dmi computation
   // loop over all atoms
 
@@ -299,6 +308,21 @@ void PairSpinDmi::compute_single_pair(int ii, double fmi[3])
   numneigh = list->numneigh;
   firstneigh = list->firstneigh;
 
+  // frozen lattice, the cached pairs of ii are within the cutoff
+
+  if (coeff_cache()) {
+    const int kfrom = firstpair[ii];
+    const int kto = kfrom + numpair[ii];
+    for (int kk = kfrom; kk < kto; kk++) {
+      j = jpair[kk];
+      const double *dmi = &pcoeff[3*kk];
+      fmi[0] -= (dmi[1]*sp[j][2] - dmi[2]*sp[j][1]);
+      fmi[1] -= (dmi[2]*sp[j][0] - dmi[0]*sp[j][2]);
+      fmi[2] -= (dmi[0]*sp[j][1] - dmi[1]*sp[j][0]);
+    }
+    return;
+  }
+
   // check if interaction applies to type of ii
 
   itype = type[ii];
@@ -361,6 +385,88 @@ void PairSpinDmi::compute_single_pair(int ii, double fmi[3])
   }
 }
 
+/* ----------------------------------------------------------------------
+   frozen lattice, no mechanical forces, the dmi field and energy
+   of each spin come from the cached dmi vectors of its pairs
+------------------------------------------------------------------------- */
+
+void PairSpinDmi::compute_frozen(int eflag)
+{
+  int i,j,ii,kk,kfrom,kto;
+  double evdwl;
+  double spi[3], spj[3], fmi[3];
+  double *dmi;
+
+  double **fm = atom->fm;
+  double **sp = atom->sp;
+  int nlocal = atom->nlocal;
+  int newton_pair = force->newton_pair;
+  int inum = list->inum;
+  int *ilist = list->ilist;
+
+  for (ii = 0; ii < inum; ii++) {
+    i = ilist[ii];
+    spi[0] = sp[i][0];
+    spi[1] = sp[i][1];
+    spi[2] = sp[i][2];
+    emag[i] = 0.0;
+
+    kfrom = firstpair[i];
+    kto = kfrom + numpair[i];
+    for (kk = kfrom; kk < kto; kk++) {
+      j = jpair[kk];
+      spj[0] = sp[j][0];
+      spj[1] = sp[j][1];
+      spj[2] = sp[j][2];
+
+      dmi = &pcoeff[3*kk];
+      fmi[0] = -(dmi[1]*spj[2] - dmi[2]*spj[1]);
+      fmi[1] = -(dmi[2]*spj[0] - dmi[0]*spj[2]);
+      fmi[2] = -(dmi[0]*spj[1] - dmi[1]*spj[0]);
+
+      fm[i][0] += fmi[0];
+      fm[i][1] += fmi[1];
+      fm[i][2] += fmi[2];
+
+      if (eflag) {
+        evdwl = -(spi[0]*fmi[0] + spi[1]*fmi[1] + spi[2]*fmi[2]);
+        evdwl *= 0.5*hbar;
+        emag[i] += evdwl;
+
+        if (evflag) ev_tally_xyz(i,j,nlocal,newton_pair,
+            evdwl,0.0,0.0,0.0,0.0,0.0,0.0,0.0);
+      }
+    }
+  }
+}
+
+/* ----------------------------------------------------------------------
+   cache the dmi vector of the pair i,j, rotated along eij
+   return 0 if the pair is beyond the cutoff
+------------------------------------------------------------------------- */
+
+int PairSpinDmi::cache_pair(int i, int j, double rsq, double *del, double *coeff)
+{
+  int *type = atom->type;
+  int itype, jtype;
+  double eij[3], inorm;
+  itype = type[i];
+  jtype = type[j];
+
+  if (rsq > cut_spin_dmi[itype][jtype]*cut_spin_dmi[itype][jtype]) return 0;
+
+  inorm = 1.0/sqrt(rsq);
+  eij[0] = -inorm*del[0];
+  eij[1] = -inorm*del[1];
+  eij[2] = -inorm*del[2];
+
+  coeff[0] = eij[1]*v_dmz[itype][jtype] - eij[2]*v_dmy[itype][jtype];
+  coeff[1] = eij[2]*v_dmx[itype][jtype] - eij[0]*v_dmz[itype][jtype];
+  coeff[2] = eij[0]*v_dmy[itype][jtype] - eij[1]*v_dmx[itype][jtype];
+
+  return 1;
+}
+
 /* ----------------------------------------------------------------------
    compute the dmi interaction between spin i and spin j
 ------------------------------------------------------------------------- */
@@ -26,7 +26,7 @@ namespace LAMMPS_NS {
 
 class PairSpinDmi : public PairSpin {
  public:
-  PairSpinDmi(LAMMPS *lmp) : PairSpin(lmp) {}
+  PairSpinDmi(LAMMPS *lmp) : PairSpin(lmp) { ncoeff = 3; }
   ~PairSpinDmi() override;
   void settings(int, char **) override;
   void coeff(int, char **) override;
@@ -38,6 +38,7 @@ class PairSpinDmi : public PairSpin {
 
   void compute_dmi(int, int, double *, double *, double *);
   void compute_dmi_mech(int, int, double, double *, double *, double *, double *);
+  void compute_frozen(int);
 
   void write_restart(FILE *) override;
   void read_restart(FILE *) override;
@@ -52,6 +53,7 @@ class PairSpinDmi : public PairSpin {
   double **vmech_dmx, **vmech_dmy, **vmech_dmz;    // dmi mech direction
   double **cut_spin_dmi;                           // cutoff distance dmi
 
+  int cache_pair(int, int, double, double *, double *) override;
   void allocate() override;
 };
 
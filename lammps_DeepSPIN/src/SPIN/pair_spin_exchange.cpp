@@ -42,12 +42,15 @@ PairSpinExchange::PairSpinExchange(LAMMPS *lmp) :
   PairSpin(lmp)
 {
   e_offset = 0;
+  ncoeff = 2;
 }
 
 /* ---------------------------------------------------------------------- */
 
 PairSpinExchange::~PairSpinExchange()
 {
+  if (copymode) return;
+
   if (allocated) {
     memory->destroy(setflag);
     memory->destroy(cut_spin_exchange);
@@ -202,6 +205,13 @@ void PairSpinExchange::compute(int eflag, int vflag)
     memory->grow(emag,nlocal_max,"pair/spin:emag");
   }
 
+  // frozen lattice, use the cached exchange couplings
+
+  if (coeff_cache()) {
+    compute_frozen(eflag);
+    return;
+  }
+
   // computation of the exchange interaction
   // loop over atoms and their neighbors
 
@@ -302,6 +312,21 @@ void PairSpinExchange::compute_single_pair(int ii, double fmi[3])
   numneigh = list->numneigh;
   firstneigh = list->firstneigh;
 
+  // frozen lattice, the cached pairs of ii are within the cutoff
+
+  if (coeff_cache()) {
+    const int kfrom = firstpair[ii];
+    const int kto = kfrom + numpair[ii];
+    for (int kk = kfrom; kk < kto; kk++) {
+      j = jpair[kk];
+      const double Jex = pcoeff[2*kk];
+      fmi[0] += Jex*sp[j][0];
+      fmi[1] += Jex*sp[j][1];
+      fmi[2] += Jex*sp[j][2];
+    }
+    return;
+  }
+
   // check if interaction applies to type of ii
 
   itype = type[ii];
@@ -359,6 +384,85 @@ void PairSpinExchange::compute_single_pair(int ii, double fmi[3])
   }
 }
 
+/* ----------------------------------------------------------------------
+   frozen lattice, no mechanical forces, the exchange field and energy
+   of each spin come from the cached couplings of its pairs
+------------------------------------------------------------------------- */
+
+void PairSpinExchange::compute_frozen(int eflag)
+{
+  int i,j,ii,kk,kfrom,kto;
+  double evdwl,Jex,sdots;
+  double spi[3];
+
+  double **fm = atom->fm;
+  double **sp = atom->sp;
+  int nlocal = atom->nlocal;
+  int newton_pair = force->newton_pair;
+  int inum = list->inum;
+  int *ilist = list->ilist;
+
+  for (ii = 0; ii < inum; ii++) {
+    i = ilist[ii];
+    spi[0] = sp[i][0];
+    spi[1] = sp[i][1];
+    spi[2] = sp[i][2];
+    emag[i] = 0.0;
+
+    kfrom = firstpair[i];
+    kto = kfrom + numpair[i];
+    for (kk = kfrom; kk < kto; kk++) {
+      j = jpair[kk];
+
+      Jex = pcoeff[2*kk];
+      fm[i][0] += Jex*sp[j][0];
+      fm[i][1] += Jex*sp[j][1];
+      fm[i][2] += Jex*sp[j][2];
+
+      if (eflag) {
+        Jex = pcoeff[2*kk+1];
+        sdots = (spi[0]*sp[j][0]+spi[1]*sp[j][1]+spi[2]*sp[j][2]);
+        if (e_offset == 1) evdwl = -0.5*Jex*(sdots-1.0);
+        else evdwl = -0.5*Jex*sdots;
+        emag[i] += evdwl;
+
+        if (evflag) ev_tally_xyz(i,j,nlocal,newton_pair,
+            evdwl,0.0,0.0,0.0,0.0,0.0,0.0,0.0);
+      }
+    }
+  }
+}
+
+/* ----------------------------------------------------------------------
+   cache the couplings of the pair i,j: the field coupling from J1_mag
+   and the energy coupling from J1_mech
+   return 0 if the pair is beyond the cutoff
+------------------------------------------------------------------------- */
+
+int PairSpinExchange::cache_pair(int i, int j, double rsq, double * /*del*/, double *coeff)
+{
+  int *type = atom->type;
+  int itype, jtype;
+  double ra, ex;
+  itype = type[i];
+  jtype = type[j];
+
+  if (rsq > cut_spin_exchange[itype][jtype]*cut_spin_exchange[itype][jtype]) return 0;
+
+  ra = rsq/J3[itype][jtype]/J3[itype][jtype];
+  ex = exp(-ra);
+
+  coeff[0] = 4.0*J1_mag[itype][jtype]*ra;
+  coeff[0] *= (1.0-J2[itype][jtype]*ra);
+  coeff[0] *= ex;
+
+  coeff[1] = 4.0*J1_mech[itype][jtype]*ra;
+  coeff[1] *= (1.0-J2[itype][jtype]*ra);
+  coeff[1] *= ex;
+
+  return 1;
+}
+
 /* ----------------------------------------------------------------------
    compute exchange interaction between spins i and j
 ------------------------------------------------------------------------- */
@@ -39,6 +39,7 @@ class PairSpinExchange : public PairSpin {
   void compute_exchange(int, int, double, double *, double *);
   void compute_exchange_mech(int, int, double, double *, double *, double *, double *);
   double compute_energy(int, int, double, double *, double *);
+  void compute_frozen(int);
 
   void write_restart(FILE *) override;
   void read_restart(FILE *) override;
@@ -54,6 +55,7 @@ class PairSpinExchange : public PairSpin {
   double **J2, **J3;             // J1 in eV, J2 adim, J3 in Ang
   double **cut_spin_exchange;    // cutoff distance exchange
 
+  int cache_pair(int, int, double, double *, double *) override;
   void allocate() override;
 };
 
@@ -137,6 +137,7 @@ double PairSpinNeel::init_one(int i, int j)
 {
   if (setflag[i][j] == 0) error->all(FLERR,"All pair coeffs are not set");
 
+  cut_spin_neel[j][i] = cut_spin_neel[i][j];
   g1[j][i] = g1[i][j];
   g1_mech[j][i] = g1_mech[i][j];
   g2[j][i] = g2[i][j];
@@ -1,6 +1,7 @@
 #!/bin/bash
 
-source ./env.sh
+# DEEPMD_ENV picks another environment, e.g. env_ref.sh
+source ./${DEEPMD_ENV:-env.sh}
 
 # Install/unInstall package files in LAMMPS
 # mode = 0/1/2 for uninstall/install/update
@@ -33,6 +34,10 @@ action() {
 # all package files with no dependencies
 
 for file in *.cpp *.h; do
+	if (echo " $NNP_SKIP " | grep -q " $file "); then
+		rm -f ../$file
+		continue
+	fi
 	test -f ${file} && action $file
 done
 
@@ -42,16 +47,16 @@ if (test $1 = 1); then
 
 	if (test -e ../Makefile.package); then
 		sed -i -e "s|^PKG_INC =[ \t].*|& $NNP_INC|" ../Makefile.package
-		sed -i -e "s|^PKG_PATH =[ \t].*|& $NNP_PATH|" ../Makefile.package
-		sed -i -e "s|^PKG_LIB =[ \t].*|& $NNP_LIB|" ../Makefile.package
+		test -n "$NNP_PATH" && sed -i -e "s|^PKG_PATH =[ \t].*|& $NNP_PATH|" ../Makefile.package
+		test -n "$NNP_LIB" && sed -i -e "s|^PKG_LIB =[ \t].*|& $NNP_LIB|" ../Makefile.package
 	fi
 
 elif (test $mode = 0); then
 
 	if (test -e ../Makefile.package); then
 		sed -i -e "s|$NNP_INC||g" ../Makefile.package
-		sed -i -e "s|$NNP_PATH||g" ../Makefile.package
-		sed -i -e "s|$NNP_LIB||g" ../Makefile.package
+		test -n "$NNP_PATH" && sed -i -e "s|$NNP_PATH||g" ../Makefile.package
+		test -n "$NNP_LIB" && sed -i -e "s|$NNP_LIB||g" ../Makefile.package
 	fi
 
 fi
@@ -36,7 +36,6 @@ ComputeDeeptensorAtom::ComputeDeeptensorAtom(LAMMPS *lmp, int narg, char **arg)
 
   // initialize deeptensor
   int gpu_rank = dp.get_node_rank();
-  std::string model_file_content = dp.get_file_content(model_file);
   dt.init(model_file, gpu_rank);
   sel_types = dt.sel_types();
   std::sort(sel_types.begin(), sel_types.end());
@@ -0,0 +1,487 @@
+// reference stand-in for the parts of the deepmd-kit C++ API used by
+// pair_style deepmd, without TensorFlow. selected at build time with
+// -DDEEPMD_REF (see env_ref.sh). the model is an analytic many-body
+// potential with smooth cutoff, so the lammps side of the spin pipeline
+// (extended system, force/fm scatter, model deviation, fix nve/spin)
+// can be tested and benchmarked on any machine.
+//
+// model files are plain text, one keyword and its values per line,
+// "#" starts a comment:
+//
+//   rcut        5.0               cutoff of the model
+//   type_map    Fe Fe_spin        names of all types, pseudo types last
+//   ntypes_spin 1                 # of real types carrying a spin
+//   alpha       1.4               Morse decay
+//   r0          2.5               Morse equilibrium distance
+//   beta        1.0               decay of the embedding density
+//   depth       0.4 0.1           Morse depth of each type
+//   embed       1.0 0.5           embedding strength of each type
+//   weight      1.0 0.2           density contributed by each type
+//
+// with s(r) = (1 - (r/rcut)^2)^2 the energy of atom i is
+//
+//   E_i = 1/2 sum_j sqrt(D_i D_j) (e^(-2a(r-r0)) - 2 e^(-a(r-r0))) s(r)
+//         - C_i (sqrt(1 + rho_i) - 1),
+//   rho_i = sum_j W_j e^(-b(r-r0)) s(r)
+//
+// the pseudo atoms of spin systems are ordinary atoms of the pseudo types,
+// so the energy depends on the spins through their positions. as in
+// DeepSPIN models, the force of a real atom includes the force on its
+// pseudo atom, which moves with it, while the entry of the pseudo atom
+// keeps the force on the pseudo atom alone. within the locals and within
+// the ghosts, the k-th atom of a spin type is the host of the k-th atom
+// of its pseudo type, which matches the extended system of pair deepmd.
+
+#ifndef LMP_DEEPMD_REF_H
+#define LMP_DEEPMD_REF_H
+
+#include <cassert>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace deepmd {
+
+typedef double ENERGYTYPE;
+
+struct deepmd_exception : public std::runtime_error {
+ public:
+  deepmd_exception() : runtime_error("DeePMD-kit Error!") {}
+  deepmd_exception(const std::string &msg)
+      : runtime_error(std::string("DeePMD-kit Error: ") + msg) {}
+};
+
+struct InputNlist {
+  int inum;
+  int *ilist;
+  int *numneigh;
+  int **firstneigh;
+  InputNlist()
+      : inum(0), ilist(nullptr), numneigh(nullptr), firstneigh(nullptr) {}
+  InputNlist(int inum_, int *ilist_, int *numneigh_, int **firstneigh_)
+      : inum(inum_), ilist(ilist_), numneigh(numneigh_),
+        firstneigh(firstneigh_) {}
+};
+
+inline void read_file_to_string(std::string model, std::string &file_content) {
+  std::ifstream in(model);
+  if (!in) throw deepmd_exception("cannot open model file " + model);
+  std::stringstream buffer;
+  buffer << in.rdbuf();
+  file_content = buffer.str();
+}
+
+class DeepPot {
+ public:
+  DeepPot()
+      : inited(false), rcut(0.), ntypes(0), ntypes_spin(0), alpha(1.),
+        r0(2.5), beta(1.), nloc_list(-1) {}
+
+  void init(const std::string &model, const int & /*gpu_rank*/ = 0,
+            const std::string &file_content = "") {
+    std::string content = file_content;
+    if (content.empty()) read_file_to_string(model, content);
+    parse(model, content);
+    inited = true;
+  }
+
+  void print_summary(const std::string &pre) const {
+    std::cout << pre << "DeePMD-kit reference backend, no TensorFlow"
+              << std::endl;
+    std::cout << pre << "analytic model, " << ntypes << " types, "
+              << ntypes_spin << " spin types" << std::endl;
+  }
+
+  double cutoff() const { return rcut; }
+  int numb_types() const { return ntypes; }
+  int numb_types_spin() const { return ntypes_spin; }
+  int dim_fparam() const { return 0; }
+  int dim_aparam() const { return 0; }
+  void get_type_map(std::string &type_map_str) {
+    type_map_str.clear();
+    for (size_t ii = 0; ii < type_map.size(); ++ii) {
+      if (ii) type_map_str += " ";
+      type_map_str += type_map[ii];
+    }
+  }
+
+  // evaluations without neighbor list are not used by pair_style deepmd
+
+  template <typename V>
+  void compute(ENERGYTYPE &, std::vector<V> &, std::vector<V> &,
+               const std::vector<V> &, const std::vector<int> &,
+               const std::vector<V> &,
+               const std::vector<V> & = std::vector<V>(),
+               const std::vector<V> & = std::vector<V>()) {
+    throw deepmd_exception("reference backend needs a neighbor list");
+  }
+
+  template <typename V>
+  void compute(ENERGYTYPE &, std::vector<V> &, std::vector<V> &,
+               std::vector<V> &, std::vector<V> &, const std::vector<V> &,
+               const std::vector<int> &, const std::vector<V> &,
+               const std::vector<V> & = std::vector<V>(),
+               const std::vector<V> & = std::vector<V>()) {
+    throw deepmd_exception("reference backend needs a neighbor list");
+  }
+
+  template <typename V>
+  void compute(ENERGYTYPE &ener, std::vector<V> &force,
+               std::vector<V> &virial, const std::vector<V> &coord,
+               const std::vector<int> &atype, const std::vector<V> & /*box*/,
+               const int /*nghost*/, const InputNlist &lmp_list, const int &ago,
+               const std::vector<V> & = std::vector<V>(),
+               const std::vector<V> & = std::vector<V>()) {
+    evaluate<V>(ener, force, virial, nullptr, nullptr, coord, atype,
+                lmp_list, ago);
+  }
+
+  template <typename V>
+  void compute(ENERGYTYPE &ener, std::vector<V> &force,
+               std::vector<V> &virial, std::vector<V> &atom_energy,
+               std::vector<V> &atom_virial, const std::vector<V> &coord,
+               const std::vector<int> &atype, const std::vector<V> & /*box*/,
+               const int /*nghost*/, const InputNlist &lmp_list, const int &ago,
+               const std::vector<V> & = std::vector<V>(),
+               const std::vector<V> & = std::vector<V>()) {
+    evaluate(ener, force, virial, &atom_energy, &atom_virial, coord, atype,
+             lmp_list, ago);
+  }
+
+ private:
+  bool inited;
+  double rcut;
+  int ntypes, ntypes_spin;
+  double alpha, r0, beta;
+  std::vector<double> depth, embed, weight;
+  std::vector<std::string> type_map;
+
+  // copy of the neighbor list, it is only passed when ago == 0
+  int nloc_list;
+  std::vector<int> ilist, numneigh, offset, neigh;
+
+  void parse(const std::string &model, const std::string &content) {
+    std::istringstream in(content);
+    std::string line;
+    while (std::getline(in, line)) {
+      line = line.substr(0, line.find('#'));
+      std::istringstream words(line);
+      std::string key;
+      if (!(words >> key)) continue;
+      if (key == "rcut") {
+        words >> rcut;
+      } else if (key == "type_map") {
+        std::string name;
+        type_map.clear();
+        while (words >> name) type_map.push_back(name);
+        ntypes = type_map.size();
+      } else if (key == "ntypes_spin") {
+        words >> ntypes_spin;
+      } else if (key == "alpha") {
+        words >> alpha;
+      } else if (key == "r0") {
+        words >> r0;
+      } else if (key == "beta") {
+        words >> beta;
+      } else if (key == "depth" || key == "embed" || key == "weight") {
+        std::vector<double> &values =
+            (key == "depth") ? depth : ((key == "embed") ? embed : weight);
+        double value;
+        values.clear();
+        while (words >> value) values.push_back(value);
+      } else {
+        throw deepmd_exception("unknown keyword " + key + " in model " +
+                               model);
+      }
+      if (words.fail() && !words.eof())
+        throw deepmd_exception("bad value of " + key + " in model " + model);
+    }
+    if (rcut <= 0. || ntypes == 0)
+      throw deepmd_exception("model " + model + " needs rcut and type_map");
+    if (2 * ntypes_spin > ntypes || ntypes_spin < 0)
+      throw deepmd_exception("bad ntypes_spin in model " + model);
+    if (depth.empty()) depth.assign(ntypes, 0.);
+    if (embed.empty()) embed.assign(ntypes, 0.);
+    if (weight.empty()) weight.assign(ntypes, 1.);
+    if (depth.size() != (size_t)ntypes || embed.size() != (size_t)ntypes ||
+        weight.size() != (size_t)ntypes)
+      throw deepmd_exception("per-type values of model " + model +
+                             " do not match type_map");
+  }
+
+  // smooth cutoff and its derivative
+  void switching(const double r, double &sw, double &dsw) const {
+    double ss = 1. - r * r / (rcut * rcut);
+    sw = ss * ss;
+    dsw = -4. * r * ss / (rcut * rcut);
+  }
+
+  template <typename V>
+  void evaluate(ENERGYTYPE &ener, std::vector<V> &force,
+                std::vector<V> &virial, std::vector<V> *atom_energy,
+                std::vector<V> *atom_virial, const std::vector<V> &coord,
+                const std::vector<int> &atype, const InputNlist &lmp_list,
+                const int ago) {
+    if (!inited) throw deepmd_exception("model is not initialized");
+    const int nall = atype.size();
+    if (ago == 0) {
+      nloc_list = lmp_list.inum;
+      ilist.assign(lmp_list.ilist, lmp_list.ilist + nloc_list);
+      numneigh.resize(nloc_list);
+      offset.assign(nloc_list + 1, 0);
+      for (int ii = 0; ii < nloc_list; ++ii) {
+        numneigh[ii] = lmp_list.numneigh[ilist[ii]];
+        offset[ii + 1] = offset[ii] + numneigh[ii];
+      }
+      neigh.resize(offset[nloc_list]);
+      for (int ii = 0; ii < nloc_list; ++ii)
+        for (int jj = 0; jj < numneigh[ii]; ++jj)
+          neigh[offset[ii] + jj] = lmp_list.firstneigh[ilist[ii]][jj];
+    } else if (nloc_list < 0) {
+      throw deepmd_exception("first evaluation needs ago == 0");
+    }
+
+    const double rc2 = rcut * rcut;
+    ener = 0.;
+    force.assign(nall * 3, 0);
+    virial.assign(9, 0);
+    if (atom_energy) atom_energy->assign(nall, 0);
+    if (atom_virial) atom_virial->assign(nall * 9, 0);
+
+    for (int ii = 0; ii < nloc_list; ++ii) {
+      const int i = ilist[ii];
+      const int ti = atype[i];
+      const int *jlist = &neigh[offset[ii]];
+
+      // embedding density
+      double rho = 0.;
+      for (int jj = 0; jj < numneigh[ii]; ++jj) {
+        const int j = jlist[jj];
+        double rsq = 0.;
+        for (int dd = 0; dd < 3; ++dd) {
+          double del = coord[3 * j + dd] - coord[3 * i + dd];
+          rsq += del * del;
+        }
+        if (rsq >= rc2) continue;
+        double r = sqrt(rsq), sw, dsw;
+        switching(r, sw, dsw);
+        rho += weight[atype[j]] * exp(-beta * (r - r0)) * sw;
+      }
+      double sq = sqrt(1. + rho);
+      double ei = -embed[ti] * (sq - 1.);
+      double dfdrho = -embed[ti] * 0.5 / sq;
+
+      for (int jj = 0; jj < numneigh[ii]; ++jj) {
+        const int j = jlist[jj];
+        const int tj = atype[j];
+        double del[3], rsq = 0.;
+        for (int dd = 0; dd < 3; ++dd) {
+          del[dd] = coord[3 * j + dd] - coord[3 * i + dd];
+          rsq += del[dd] * del[dd];
+        }
+        if (rsq >= rc2) continue;
+        double r = sqrt(rsq), sw, dsw;
+        switching(r, sw, dsw);
+        double dij = sqrt(depth[ti] * depth[tj]);
+        double ex = exp(-alpha * (r - r0));
+        double morse = dij * (ex * ex - 2. * ex);
+        double dmorse = dij * 2. * alpha * (ex - ex * ex);
+        double ed = exp(-beta * (r - r0));
+        double drho = weight[tj] * (-beta * ed * sw + ed * dsw);
+        ei += 0.5 * morse * sw;
+        double dedr = 0.5 * (dmorse * sw + morse * dsw) + dfdrho * drho;
+
+        // E_i depends on x_j - x_i: g goes to i, -g to j
+        double gg[3];
+        for (int dd = 0; dd < 3; ++dd) {
+          gg[dd] = dedr * del[dd] / r;
+          force[3 * i + dd] += gg[dd];
+          force[3 * j + dd] -= gg[dd];
+        }
+        for (int aa = 0; aa < 3; ++aa) {
+          for (int bb = 0; bb < 3; ++bb) {
+            virial[3 * aa + bb] -= del[aa] * gg[bb];
+            // the per-atom virial has the sign pair_style deepmd expects
+            if (atom_virial)
+              (*atom_virial)[9 * i + 3 * aa + bb] += del[aa] * gg[bb];
+          }
+        }
+      }
+      ener += ei;
+      if (atom_energy) (*atom_energy)[i] = ei;
+    }
+
+    if (ntypes_spin > 0) {
+      fold_pseudo(force, atype, 0, nloc_list);
+      fold_pseudo(force, atype, nloc_list, nall);
+    }
+  }
+
+  // add the forces on the pseudo atoms in [lo,hi) to their hosts, the
+  // k-th atom of spin type t is the host of the k-th atom of type t's
+  // pseudo type. the forces on the pseudo atoms are left unchanged.
+  // as for a DeepSPIN model, each host must come with its pseudo atom
+  template <typename V>
+  void fold_pseudo(std::vector<V> &force, const std::vector<int> &atype,
+                   const int lo, const int hi) const {
+    const int ntypes_real = ntypes - ntypes_spin;
+    for (int tt = 0; tt < ntypes_spin; ++tt) {
+      int nhost = 0, npseudo = 0;
+      for (int ii = lo; ii < hi; ++ii) {
+        if (atype[ii] == tt) nhost++;
+        if (atype[ii] == ntypes_real + tt) npseudo++;
+      }
+      if (nhost != npseudo)
+        throw deepmd_exception("pseudo atoms do not match their hosts");
+      int jj = lo;
+      for (int ii = lo; ii < hi; ++ii) {
+        if (atype[ii] != tt) continue;
+        while (atype[jj] != ntypes_real + tt) ++jj;
+        for (int dd = 0; dd < 3; ++dd)
+          force[3 * ii + dd] += force[3 * jj + dd];
+        ++jj;
+      }
+    }
+  }
+};
+
+class DeepPotModelDevi {
+ public:
+  void init(const std::vector<std::string> &models, const int &gpu_rank = 0,
+            const std::vector<std::string> &file_contents =
+                std::vector<std::string>()) {
+    dps.resize(models.size());
+    for (size_t ii = 0; ii < models.size(); ++ii) {
+      dps[ii].init(models[ii], gpu_rank,
+                   ii < file_contents.size() ? file_contents[ii] : "");
+      if (dps[ii].cutoff() != dps[0].cutoff() ||
+          dps[ii].numb_types() != dps[0].numb_types() ||
+          dps[ii].numb_types_spin() != dps[0].numb_types_spin())
+        throw deepmd_exception("models of the committee do not match");
+    }
+  }
+
+  double cutoff() const { return dps[0].cutoff(); }
+  int numb_types() const { return dps[0].numb_types(); }
+  int numb_types_spin() const { return dps[0].numb_types_spin(); }
+  int dim_fparam() const { return 0; }
+  int dim_aparam() const { return 0; }
+
+  template <typename V>
+  void compute(std::vector<ENERGYTYPE> &all_energy,
+               std::vector<std::vector<V>> &all_force,
+               std::vector<std::vector<V>> &all_virial,
+               const std::vector<V> &coord, const std::vector<int> &atype,
+               const std::vector<V> &box, const int nghost,
+               const InputNlist &lmp_list, const int &ago,
+               const std::vector<V> &fparam = std::vector<V>(),
+               const std::vector<V> &aparam = std::vector<V>()) {
+    size_t nmodel = dps.size();
+    all_energy.resize(nmodel);
+    all_force.resize(nmodel);
+    all_virial.resize(nmodel);
+    for (size_t ii = 0; ii < nmodel; ++ii)
+      dps[ii].compute(all_energy[ii], all_force[ii], all_virial[ii], coord,
+                      atype, box, nghost, lmp_list, ago, fparam, aparam);
+  }
+
+  template <typename V>
+  void compute(std::vector<ENERGYTYPE> &all_energy,
+               std::vector<std::vector<V>> &all_force,
+               std::vector<std::vector<V>> &all_virial,
+               std::vector<std::vector<V>> &all_atom_energy,
+               std::vector<std::vector<V>> &all_atom_virial,
+               const std::vector<V> &coord, const std::vector<int> &atype,
+               const std::vector<V> &box, const int nghost,
+               const InputNlist &lmp_list, const int &ago,
+               const std::vector<V> &fparam = std::vector<V>(),
+               const std::vector<V> &aparam = std::vector<V>()) {
+    size_t nmodel = dps.size();
+    all_energy.resize(nmodel);
+    all_force.resize(nmodel);
+    all_virial.resize(nmodel);
+    all_atom_energy.resize(nmodel);
+    all_atom_virial.resize(nmodel);
+    for (size_t ii = 0; ii < nmodel; ++ii)
+      dps[ii].compute(all_energy[ii], all_force[ii], all_virial[ii],
+                      all_atom_energy[ii], all_atom_virial[ii], coord, atype,
+                      box, nghost, lmp_list, ago, fparam, aparam);
+  }
+
+  // statistics of the committee, as in deepmd-kit
+
+  template <typename V>
+  void compute_avg(V &avg, const std::vector<V> &xx) {
+    avg = 0;
+    if (xx.empty()) return;
+    for (size_t ii = 0; ii < xx.size(); ++ii) avg += xx[ii];
+    avg /= xx.size();
+  }
+
+  template <typename V>
+  void compute_avg(std::vector<V> &avg, const std::vector<std::vector<V>> &xx) {
+    avg.clear();
+    if (xx.empty()) return;
+    avg.assign(xx[0].size(), 0);
+    for (size_t ii = 0; ii < xx.size(); ++ii)
+      for (size_t jj = 0; jj < avg.size(); ++jj) avg[jj] += xx[ii][jj];
+    for (size_t jj = 0; jj < avg.size(); ++jj) avg[jj] /= xx.size();
+  }
+
+  template <typename V>
+  void compute_std(std::vector<V> &std, const std::vector<V> &avg,
+                   const std::vector<std::vector<V>> &xx, const int &stride) {
+    size_t nloc = avg.size() / stride;
+    std.assign(nloc, 0);
+    for (size_t ii = 0; ii < xx.size(); ++ii) {
+      for (size_t jj = 0; jj < nloc; ++jj) {
+        for (int dd = 0; dd < stride; ++dd) {
+          V vdiff = xx[ii][jj * stride + dd] - avg[jj * stride + dd];
+          std[jj] += vdiff * vdiff;
+        }
+      }
+    }
+    for (size_t jj = 0; jj < nloc; ++jj) std[jj] = sqrt(std[jj] / xx.size());
+  }
+
+  template <typename V>
+  void compute_std_e(std::vector<V> &std, const std::vector<V> &avg,
+                     const std::vector<std::vector<V>> &xx) {
+    compute_std(std, avg, xx, 1);
+  }
+
+  template <typename V>
+  void compute_std_f(std::vector<V> &std, const std::vector<V> &avg,
+                     const std::vector<std::vector<V>> &xx) {
+    compute_std(std, avg, xx, 3);
+  }
+
+  template <typename V>
+  void compute_relative_std(std::vector<V> &std, const std::vector<V> &avg,
+                            const V eps, const int &stride) {
+    size_t nloc = std.size();
+    for (size_t jj = 0; jj < nloc; ++jj) {
+      V norm = 0;
+      for (int dd = 0; dd < stride; ++dd)
+        norm += avg[jj * stride + dd] * avg[jj * stride + dd];
+      std[jj] /= sqrt(norm) + eps;
+    }
+  }
+
+  template <typename V>
+  void compute_relative_std_f(std::vector<V> &std, const std::vector<V> &avg,
+                              const V eps) {
+    compute_relative_std(std, avg, eps, 3);
+  }
+
+ private:
+  std::vector<DeepPot> dps;
+};
+
+}    // namespace deepmd
+
+#endif
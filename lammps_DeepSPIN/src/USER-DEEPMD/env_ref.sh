@@ -0,0 +1,9 @@
+# reference backend of pair_style deepmd, no deepmd-kit and TensorFlow
+# needed. select it with: DEEPMD_ENV=env_ref.sh make yes-user-deepmd
+
+NNP_INC=" -std=c++11 -DHIGH_PREC -DDEEPMD_REF -DLAMMPS_VERSION_NUMBER=$(./lmp_version.sh) "
+NNP_PATH=""
+NNP_LIB=""
+
+# styles that need other parts of deepmd-kit are not installed
+NNP_SKIP="compute_deeptensor_atom.cpp compute_deeptensor_atom.h fix_dplr.cpp fix_dplr.h pppm_dplr.cpp pppm_dplr.h"
@@ -1,5 +1,6 @@
 #include <string.h>
 
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <limits>
@@ -20,6 +21,7 @@
 #include "neigh_request.h"
 #include "neighbor.h"
 #include "output.h"
+#include "timer.h"
 #include "update.h"
 #if LAMMPS_VERSION_NUMBER >= 20210831
 // in lammps #2902, fix_ttm members turns from private to protected
@@ -48,6 +50,9 @@ static const char cite_user_deepmd_package[] =
     "  pages = {178--184}\n"
     "}\n\n";
 
+// hbar in eV*ps, converts the force on a pseudo atom to a magnetic force
+static const double hbar = 6.5821191e-04;
+
 static int stringCmp(const void *a, const void *b) {
   char *m = (char *)a;
   char *n = (char *)b;
@@ -63,13 +68,21 @@ static int stringCmp(const void *a, const void *b) {
   return sum;
 }
 
+// models are broadcast in chunks, MPI counts are ints
+static const bigint BCAST_CHUNK = 1 << 30;
+
+/* ----------------------------------------------------------------------
+   rank of this proc on its node, the node communicator is built once
+------------------------------------------------------------------------- */
+
 int PairDeepMD::get_node_rank() {
+  if (node_comm != MPI_COMM_NULL) return node_rank;
+
   char host_name[MPI_MAX_PROCESSOR_NAME];
   memset(host_name, '\0', sizeof(char) * MPI_MAX_PROCESSOR_NAME);
   char(*host_names)[MPI_MAX_PROCESSOR_NAME];
-  int n, namelen, color, rank, nprocs, myrank;
+  int n, namelen, color, rank, nprocs;
   size_t bytes;
-  MPI_Comm nodeComm;
 
   MPI_Comm_rank(MPI_COMM_WORLD, &rank);
   MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
@@ -77,15 +90,8 @@ int PairDeepMD::get_node_rank() {
 
   bytes = nprocs * sizeof(char[MPI_MAX_PROCESSOR_NAME]);
   host_names = (char(*)[MPI_MAX_PROCESSOR_NAME])malloc(bytes);
-  for (int ii = 0; ii < nprocs; ii++) {
-    memset(host_names[ii], '\0', sizeof(char) * MPI_MAX_PROCESSOR_NAME);
-  }
-
-  strcpy(host_names[rank], host_name);
-
-  for (n = 0; n < nprocs; n++)
-    MPI_Bcast(&(host_names[n]), MPI_MAX_PROCESSOR_NAME, MPI_CHAR, n,
-              MPI_COMM_WORLD);
+  MPI_Allgather(host_name, MPI_MAX_PROCESSOR_NAME, MPI_CHAR, host_names,
+                MPI_MAX_PROCESSOR_NAME, MPI_CHAR, MPI_COMM_WORLD);
   qsort(host_names, nprocs, sizeof(char[MPI_MAX_PROCESSOR_NAME]), stringCmp);
 
   color = 0;
@@ -98,37 +104,64 @@ int PairDeepMD::get_node_rank() {
     }
   }
 
-  MPI_Comm_split(MPI_COMM_WORLD, color, 0, &nodeComm);
-  MPI_Comm_rank(nodeComm, &myrank);
+  // key 0 keeps the world order, so world rank 0 is rank 0 of its node
+  MPI_Comm_split(MPI_COMM_WORLD, color, 0, &node_comm);
+  MPI_Comm_rank(node_comm, &node_rank);
 
-  MPI_Barrier(MPI_COMM_WORLD);
-  int looprank = myrank;
   // printf (" Assigning device %d  to process on node %s rank %d,
-  // OK\n",looprank,  host_name, rank );
+  // OK\n",node_rank,  host_name, rank );
   free(host_names);
-  return looprank;
+  return node_rank;
 }
 
+/* ----------------------------------------------------------------------
+   read a model on world rank 0 and hand its bytes to all procs
+   the bytes travel once per node: node leaders receive them in a window
+   shared with the other procs of their node, which copy from it
+------------------------------------------------------------------------- */
+
 std::string PairDeepMD::get_file_content(const std::string &model) {
   int myrank = 0, root = 0;
   MPI_Comm_rank(MPI_COMM_WORLD, &myrank);
-  int nchar = 0;
+  double time0 = MPI_Wtime();
+  int noderank = get_node_rank();
+
+  bigint nchar = 0;
   std::string file_content;
   if (myrank == root) {
     deepmd::read_file_to_string(model, file_content);
     nchar = file_content.size();
   }
-  MPI_Bcast(&nchar, 1, MPI_INT, root, MPI_COMM_WORLD);
-  char *buff = (char *)malloc(sizeof(char) * nchar);
-  if (myrank == root) {
-    memcpy(buff, file_content.c_str(), sizeof(char) * nchar);
+  MPI_Bcast(&nchar, 1, MPI_LMP_BIGINT, root, MPI_COMM_WORLD);
+
+  char *buff = nullptr;
+  MPI_Win win;
+  MPI_Aint winsize = (noderank == 0) ? nchar : 0;
+  MPI_Win_allocate_shared(winsize, 1, MPI_INFO_NULL, node_comm, &buff, &win);
+  if (noderank != 0) {
+    int disp_unit;
+    MPI_Win_shared_query(win, 0, &winsize, &disp_unit, &buff);
   }
-  MPI_Bcast(buff, nchar, MPI_CHAR, root, MPI_COMM_WORLD);
-  file_content.resize(nchar);
-  for (unsigned ii = 0; ii < nchar; ++ii) {
-    file_content[ii] = buff[ii];
+
+  MPI_Win_fence(0, win);
+  MPI_Comm leader_comm;
+  MPI_Comm_split(MPI_COMM_WORLD, noderank == 0 ? 0 : MPI_UNDEFINED, myrank,
+                 &leader_comm);
+  if (noderank == 0) {
+    if (myrank == root) memcpy(buff, file_content.data(), nchar);
+    for (bigint offset = 0; offset < nchar; offset += BCAST_CHUNK) {
+      int nchunk = MIN(BCAST_CHUNK, nchar - offset);
+      MPI_Bcast(buff + offset, nchunk, MPI_CHAR, 0, leader_comm);
+    }
+    MPI_Comm_free(&leader_comm);
   }
-  free(buff);
+  MPI_Win_fence(0, win);
+
+  if (myrank != root) file_content.assign(buff, nchar);
+  MPI_Win_free(&win);
+
+  load_time += MPI_Wtime() - time0;
+  load_bytes += nchar;
   return file_content;
 }
 
@@ -295,7 +328,9 @@ void PairDeepMD::make_ttm_aparam(
 }
 #endif
 
-void PairDeepMD::cum_sum(std::map<int, int> &sum, std::map<int, int> &vec) {
+void PairDeepMD::cum_sum(std::vector<int> &sum, const std::vector<int> &vec) {
+  sum.resize(vec.size());
+  if (vec.empty()) return;
   sum[0] = 0;
   for (int ii = 1; ii < vec.size(); ++ii) {
     sum[ii] = sum[ii - 1] + vec[ii - 1];
@@ -325,6 +360,21 @@ PairDeepMD::PairDeepMD(LAMMPS *lmp)
   respa_enable = 0;
   writedata = 0;
   cutoff = 0.;
+  cut_spin = 0.;
+  node_comm = MPI_COMM_NULL;
+  node_rank = 0;
+  atomic_fh = MPI_FILE_NULL;
+  atomic_offset = 0;
+  out_atomic_binary = 0;
+  out_atomic_thresh = 0.;
+  nmax_devi = 0;
+  emag = nullptr;
+  nmax_emag = 0;
+  counts = displacements = nullptr;
+  tagsend = tagrecv = nullptr;
+  stdfsend = stdfrecv = nullptr;
+  load_time = 0.;
+  load_bytes = 0;
   numb_types = 0;
   numb_types_spin = 0;
   numb_models = 0;
@@ -340,6 +390,15 @@ PairDeepMD::PairDeepMD(LAMMPS *lmp)
   multi_models_mod_devi = false;
   multi_models_no_mod_devi = false;
   is_restart = false;
+  extend_inum = 0;
+  extend_nghost = 0;
+  extend_stamp = -1;
+  extend_nloc_real = -1;
+  extend_nghost_real = -1;
+  cluster_bin_stale = true;
+  model_nlist_stale = false;
+  single_spin_enable = 1;
+  t_pack = t_eval = t_scatter = t_devi = t_output = -1;
   // set comm size needed by this Pair
   comm_reverse = 1;
 
@@ -364,9 +423,13 @@ void PairDeepMD::print_summary(const string pre) const {
     cout << pre << "source commit:      " << STR_GIT_HASH << endl;
     cout << pre << "source commit at:   " << STR_GIT_DATE << endl;
     cout << pre << "build float prec:   " << STR_FLOAT_PREC << endl;
+#ifdef DEEPMD_REF
+    cout << pre << "build with tf:      no, reference backend" << endl;
+#else
     cout << pre << "build with tf inc:  " << STR_TensorFlow_INCLUDE_DIRS
          << endl;
     cout << pre << "build with tf lib:  " << STR_TensorFlow_LIBRARY << endl;
+#endif
 
     std::cout.rdbuf(sbuf);
     utils::logmesg(lmp, buffer.str());
@@ -374,6 +437,15 @@ void PairDeepMD::print_summary(const string pre) const {
 }
 
 PairDeepMD::~PairDeepMD() {
+  if (node_comm != MPI_COMM_NULL) MPI_Comm_free(&node_comm);
+  if (atomic_fh != MPI_FILE_NULL) MPI_File_close(&atomic_fh);
+  memory->destroy(counts);
+  memory->destroy(displacements);
+  memory->destroy(tagsend);
+  memory->destroy(tagrecv);
+  memory->destroy(stdfsend);
+  memory->destroy(stdfrecv);
+  memory->destroy(emag);
   if (allocated) {
     memory->destroy(setflag);
     memory->destroy(cutsq);
@@ -401,40 +473,12 @@ void PairDeepMD::compute(int eflag, int vflag) {
   int nall = nlocal + nghost;
   int newton_pair = force->newton_pair;
 
-  vector<double> dspin(nall * 3, 0.);
-  vector<double> dspin_norm(nall, 0.);
-  vector<double> dfm(nall * 3, 0.);
   double **sp = atom->sp;
   double **fm = atom->fm;
-
-  vector<int> dtype(nall);
-  for (int ii = 0; ii < nall; ++ii) {
-    dtype[ii] = type_idx_map[type[ii] - 1];
-  }
-
-  // spin initialize
-  if (atom->sp_flag) {
-    // get spin
-    for (int ii = 0; ii < nall; ++ii) {
-      for (int dd = 0; dd < 3; ++dd) {
-        dspin[ii * 3 + dd] = sp[ii][dd];
-      }
-      dspin_norm[ii] = sp[ii][3] / spin_norm[dtype[ii]];
-    }
-  }
-
-  double dener(0);
-  vector<double> dforce(nall * 3);
-  vector<double> dvirial(9, 0);
-  vector<double> dcoord(nall * 3, 0.);
-  vector<double> dbox(9, 0);
-#ifdef HIGH_PREC
-  vector<double> daparam;
-#else
-  vector<float> daparam;
-#endif
+  double *boxlo = domain->boxlo;
 
   // get box
+  dbox.assign(9, 0);
   dbox[0] = domain->h[0];  // xx
   dbox[4] = domain->h[1];  // yy
   dbox[8] = domain->h[2];  // zz
@@ -442,13 +486,6 @@ void PairDeepMD::compute(int eflag, int vflag) {
   dbox[6] = domain->h[4];  // zx
   dbox[3] = domain->h[5];  // yx
 
-  // get coord
-  for (int ii = 0; ii < nall; ++ii) {
-    for (int dd = 0; dd < 3; ++dd) {
-      dcoord[ii * 3 + dd] = x[ii][dd] - domain->boxlo[dd];
-    }
-  }
-
   // uniform aparam
   if (aparam.size() > 0) {
     make_uniform_aparam(daparam, aparam, nlocal);
@@ -483,144 +520,128 @@ void PairDeepMD::compute(int eflag, int vflag) {
       (numb_models > 1 && (out_freq == 0 || update->ntimestep % out_freq != 0));
   multi_models_mod_devi =
       (numb_models > 1 && (out_freq > 0 && update->ntimestep % out_freq == 0));
+
+  deepmd::InputNlist lmp_list;
   if (do_ghost) {
-    deepmd::InputNlist lmp_list(list->inum, list->ilist, list->numneigh,
-                                list->firstneigh);
-    deepmd::InputNlist extend_lmp_list;
-    if (atom->sp_flag) {
+    lmp_list = deepmd::InputNlist(list->inum, list->ilist, list->numneigh,
+                                  list->firstneigh);
+  }
+  deepmd::InputNlist extend_lmp_list;
+  bool do_extend = atom->sp_flag && do_ghost;
+
+  timer->sub_start(t_pack);
+
+  // the pseudo-atom topology only changes when lammps reneighbors,
+  // in between only the pseudo-atom coordinates follow the spins
+  // keyed on the list build, so that the repeated force calls of
+  // fix nve/spin on a reneighboring step do not rebuild it again
+  if (do_extend) {
+    if (neighbor->ncalls != extend_stamp || extend_nloc_real != nlocal ||
+        extend_nghost_real != nghost) {
+      dtype.resize(nall);
+      for (int ii = 0; ii < nall; ++ii) {
+        dtype[ii] = type_idx_map[type[ii] - 1];
+      }
       extend(extend_inum, extend_ilist, extend_numneigh, extend_neigh,
              extend_firstneigh, extend_dcoord, extend_dtype, extend_nghost,
-             new_idx_map, old_idx_map, lmp_list, dcoord, dtype, nghost, dspin,
-             numb_types, numb_types_spin, virtual_len, dspin_norm);
-      extend_lmp_list.inum = extend_inum;
-      extend_lmp_list.ilist = &extend_ilist[0];
-      extend_lmp_list.numneigh = &extend_numneigh[0];
-      extend_lmp_list.firstneigh = &extend_firstneigh[0];
+             new_idx_map, old_idx_map, lmp_list, dtype, nghost, numb_types,
+             numb_types_spin);
+      extend_stamp = neighbor->ncalls;
+      extend_nloc_real = nlocal;
+      extend_nghost_real = nghost;
+      cluster_bin_stale = true;
+      // the model must rebuild its copy of the extended list as well
+      ago = 0;
+    }
+    // single-spin evaluations overwrite the list cached in the model
+    if (model_nlist_stale) {
+      ago = 0;
+      model_nlist_stale = false;
+    }
+    extend_lmp_list.inum = extend_inum;
+    extend_lmp_list.ilist = &extend_ilist[0];
+    extend_lmp_list.numneigh = &extend_numneigh[0];
+    extend_lmp_list.firstneigh = &extend_firstneigh[0];
+  }
+
+  // gather types and coordinates in one pass, straight into the persistent
+  // buffers in the precision of the model. pseudo atoms of spin systems
+  // sit at x + s * virtual_len * |s| in the extended system
+  if (do_extend) {
+    for (int ii = 0; ii < nall; ++ii) {
+      int itype = type_idx_map[type[ii] - 1];
+      int new_idx = new_idx_map[ii];
+      dtype[ii] = itype;
+      if (itype < numb_types_spin) {
+        int virt_idx = new_idx + (ii < nlocal ? nlocal : nghost);
+        double dspin_norm = sp[ii][3] / spin_norm[itype];
+        for (int dd = 0; dd < 3; ++dd) {
+          double xdd = x[ii][dd] - boxlo[dd];
+          extend_dcoord[new_idx * 3 + dd] = xdd;
+          extend_dcoord[virt_idx * 3 + dd] =
+              xdd + sp[ii][dd] * virtual_len[itype] * dspin_norm;
+        }
+      } else {
+        for (int dd = 0; dd < 3; ++dd) {
+          extend_dcoord[new_idx * 3 + dd] = x[ii][dd] - boxlo[dd];
+        }
+      }
+    }
+  } else {
+    dtype.resize(nall);
+    dcoord.resize(nall * 3);
+    for (int ii = 0; ii < nall; ++ii) {
+      dtype[ii] = type_idx_map[type[ii] - 1];
+      for (int dd = 0; dd < 3; ++dd) {
+        dcoord[ii * 3 + dd] = x[ii][dd] - boxlo[dd];
+      }
     }
+  }
+  timer->sub_stop(t_pack);
+
+  double dener(0);
+  if (do_ghost) {
     if (single_model || multi_models_no_mod_devi) {
       // cvflag_atom is the right flag for the cvatom matrix
       if (!(eflag_atom || cvflag_atom)) {
-#ifdef HIGH_PREC
-        if (!atom->sp_flag) {
-          try {
+        timer->sub_start(t_eval);
+        try {
+          if (!do_extend) {
             deep_pot.compute(dener, dforce, dvirial, dcoord, dtype, dbox,
                              nghost, lmp_list, ago, fparam, daparam);
-          } catch (deepmd::deepmd_exception &e) {
-            error->all(FLERR, e.what());
-          }
-        } else {
-          dforce.resize((extend_inum + extend_nghost) * 3);
-          try {
+          } else {
             deep_pot.compute(dener, dforce, dvirial, extend_dcoord,
                              extend_dtype, dbox, extend_nghost, extend_lmp_list,
                              ago, fparam, daparam);
-          } catch (deepmd::deepmd_exception &e) {
-            error->all(FLERR, e.what());
           }
+        } catch (deepmd::deepmd_exception &e) {
+          error->all(FLERR, e.what());
         }
-#else
-        vector<float> dcoord_(dcoord.size());
-        vector<float> dbox_(dbox.size());
-        for (unsigned dd = 0; dd < dcoord.size(); ++dd)
-          dcoord_[dd] = dcoord[dd];
-        for (unsigned dd = 0; dd < dbox.size(); ++dd) dbox_[dd] = dbox[dd];
-        vector<float> dforce_(dforce.size(), 0);
-        vector<float> dvirial_(dvirial.size(), 0);
-        double dener_ = 0;
-        if (!atom->sp_flag) {
-          try {
-            deep_pot.compute(dener_, dforce_, dvirial_, dcoord_, dtype, dbox_,
-                             nghost, lmp_list, ago, fparam, daparam);
-          } catch (deepmd::deepmd_exception &e) {
-            error->all(FLERR, e.what());
-          }
-        } else {
-          vector<float> extend_dcoord_(extend_dcoord.size());
-          for (unsigned dd = 0; dd < extend_dcoord.size(); ++dd)
-            extend_dcoord_[dd] = extend_dcoord[dd];
-          dforce.resize((extend_inum + extend_nghost) * 3);
-          dforce_.resize((extend_inum + extend_nghost) * 3);
-          try {
-            deep_pot.compute(dener_, dforce_, dvirial_, extend_dcoord_,
-                             extend_dtype, dbox_, extend_nghost,
-                             extend_lmp_list, ago, fparam, daparam);
-          } catch (deepmd::deepmd_exception &e) {
-            error->all(FLERR, e.what());
-          }
-        }
-        for (unsigned dd = 0; dd < dforce.size(); ++dd)
-          dforce[dd] = dforce_[dd];
-        for (unsigned dd = 0; dd < dvirial.size(); ++dd)
-          dvirial[dd] = dvirial_[dd];
-        dener = dener_;
-#endif
+        timer->sub_stop(t_eval);
       }
       // do atomic energy and virial
       else {
-        vector<double> deatom(nall * 1, 0);
-        vector<double> dvatom(nall * 9, 0);
-#ifdef HIGH_PREC
-        if (!atom->sp_flag) {
-          try {
+        timer->sub_start(t_eval);
+        try {
+          if (!do_extend) {
             deep_pot.compute(dener, dforce, dvirial, deatom, dvatom, dcoord,
                              dtype, dbox, nghost, lmp_list, ago, fparam,
                              daparam);
-          } catch (deepmd::deepmd_exception &e) {
-            error->all(FLERR, e.what());
-          }
-        } else {
-          dforce.resize((extend_inum + extend_nghost) * 3);
-          try {
-            deep_pot.compute(dener, dforce, dvirial, extend_dcoord,
-                             extend_dtype, dbox, extend_nghost, extend_lmp_list,
-                             ago, fparam, daparam);
-          } catch (deepmd::deepmd_exception &e) {
-            error->all(FLERR, e.what());
-          }
-        }
-#else
-        vector<float> dcoord_(dcoord.size());
-        vector<float> dbox_(dbox.size());
-        for (unsigned dd = 0; dd < dcoord.size(); ++dd)
-          dcoord_[dd] = dcoord[dd];
-        for (unsigned dd = 0; dd < dbox.size(); ++dd) dbox_[dd] = dbox[dd];
-        vector<float> dforce_(dforce.size(), 0);
-        vector<float> dvirial_(dvirial.size(), 0);
-        vector<float> deatom_(dforce.size(), 0);
-        vector<float> dvatom_(dforce.size(), 0);
-        double dener_ = 0;
-        if (!atom->sp_flag) {
-          try {
-            deep_pot.compute(dener_, dforce_, dvirial_, deatom_, dvatom_,
-                             dcoord_, dtype, dbox_, nghost, lmp_list, ago,
-                             fparam, daparam);
-          } catch (deepmd::deepmd_exception &e) {
-            error->all(FLERR, e.what());
-          }
-        } else {
-          vector<float> extend_dcoord_(extend_dcoord.size());
-          for (unsigned dd = 0; dd < extend_dcoord.size(); ++dd)
-            extend_dcoord_[dd] = extend_dcoord[dd];
-          dforce.resize((extend_inum + extend_nghost) * 3);
-          dforce_.resize((extend_inum + extend_nghost) * 3);
-          try {
-            deep_pot.compute(dener_, dforce_, dvirial_, deatom_, dvatom_,
-                             extend_dcoord_, extend_dtype, dbox_, extend_nghost,
-                             extend_lmp_list, ago, fparam, daparam);
-          } catch (deepmd::deepmd_exception &e) {
-            error->all(FLERR, e.what());
+          } else {
+            // per-atom energies and virials of pseudo atoms go to their
+            // hosts, the magnetic energy is local to the atom carrying it
+            deep_pot.compute(dener, dforce, dvirial, extend_deatom,
+                             extend_dvatom, extend_dcoord, extend_dtype, dbox,
+                             extend_nghost, extend_lmp_list, ago, fparam,
+                             daparam);
+            fold_extend(deatom, extend_deatom, 1, nlocal, nghost);
+            fold_extend(dvatom, extend_dvatom, 9, nlocal, nghost);
+            if (eflag_atom) pseudo_energy(extend_deatom, nlocal);
           }
+        } catch (deepmd::deepmd_exception &e) {
+          error->all(FLERR, e.what());
         }
-        for (unsigned dd = 0; dd < dforce.size(); ++dd)
-          dforce[dd] = dforce_[dd];
-        for (unsigned dd = 0; dd < dvirial.size(); ++dd)
-          dvirial[dd] = dvirial_[dd];
-        for (unsigned dd = 0; dd < deatom.size(); ++dd)
-          deatom[dd] = deatom_[dd];
-        for (unsigned dd = 0; dd < dvatom.size(); ++dd)
-          dvatom[dd] = dvatom_[dd];
-        dener = dener_;
-#endif
+        timer->sub_stop(t_eval);
         if (eflag_atom) {
           for (int ii = 0; ii < nlocal; ++ii) eatom[ii] += deatom[ii];
         }
@@ -648,19 +669,51 @@ void PairDeepMD::compute(int eflag, int vflag) {
         }
       }
     } else if (multi_models_mod_devi) {
-      vector<double> deatom(nall * 1, 0);
-      vector<double> dvatom(nall * 9, 0);
-      vector<vector<double>> all_virial;
-#ifdef HIGH_PREC
       vector<double> all_energy;
-      vector<vector<double>> all_atom_energy;
-      vector<vector<double>> all_atom_virial;
-      try {
-        deep_pot_model_devi.compute(
-            all_energy, all_force, all_virial, all_atom_energy, all_atom_virial,
-            dcoord, dtype, dbox, nghost, lmp_list, ago, fparam, daparam);
-      } catch (deepmd::deepmd_exception &e) {
-        error->all(FLERR, e.what());
+      vector<vector<FLOAT_PREC>> all_virial;
+      vector<vector<FLOAT_PREC>> all_atom_energy;
+      vector<vector<FLOAT_PREC>> all_atom_virial;
+      if (!do_extend) {
+        timer->sub_start(t_eval);
+        try {
+          deep_pot_model_devi.compute(all_energy, all_force, all_virial,
+                                      all_atom_energy, all_atom_virial, dcoord,
+                                      dtype, dbox, nghost, lmp_list, ago,
+                                      fparam, daparam);
+        } catch (deepmd::deepmd_exception &e) {
+          error->all(FLERR, e.what());
+        }
+        timer->sub_stop(t_eval);
+        dforce = all_force[0];
+      } else {
+        // evaluate the extended system, then bring the deviations back to
+        // the real atoms: forces on the pseudo atoms become magnetic forces,
+        // per-atom energies and virials of pseudo atoms go to their hosts
+        vector<vector<FLOAT_PREC>> all_extend_force;
+        vector<vector<FLOAT_PREC>> all_extend_atom_energy;
+        vector<vector<FLOAT_PREC>> all_extend_atom_virial;
+        timer->sub_start(t_eval);
+        try {
+          deep_pot_model_devi.compute(
+              all_energy, all_extend_force, all_virial, all_extend_atom_energy,
+              all_extend_atom_virial, extend_dcoord, extend_dtype, dbox,
+              extend_nghost, extend_lmp_list, ago, fparam, daparam);
+        } catch (deepmd::deepmd_exception &e) {
+          error->all(FLERR, e.what());
+        }
+        timer->sub_stop(t_eval);
+        all_atom_energy.resize(numb_models);
+        all_atom_virial.resize(numb_models);
+        for (unsigned kk = 0; kk < numb_models; ++kk) {
+          split_extend_force(all_force[kk], all_force_mag[kk],
+                             all_extend_force[kk], nlocal, nghost);
+          fold_extend(all_atom_energy[kk], all_extend_atom_energy[kk], 1,
+                      nlocal, nghost);
+          fold_extend(all_atom_virial[kk], all_extend_atom_virial[kk], 9,
+                      nlocal, nghost);
+        }
+        if (eflag_atom) pseudo_energy(all_extend_atom_energy[0], nlocal);
+        dforce = all_extend_force[0];
       }
       // deep_pot_model_devi.compute_avg (dener, all_energy);
       // deep_pot_model_devi.compute_avg (dforce, all_force);
@@ -668,64 +721,9 @@ void PairDeepMD::compute(int eflag, int vflag) {
       // deep_pot_model_devi.compute_avg (deatom, all_atom_energy);
       // deep_pot_model_devi.compute_avg (dvatom, all_atom_virial);
       dener = all_energy[0];
-      dforce = all_force[0];
       dvirial = all_virial[0];
       deatom = all_atom_energy[0];
       dvatom = all_atom_virial[0];
-#else
-      vector<float> dcoord_(dcoord.size());
-      vector<float> dbox_(dbox.size());
-      for (unsigned dd = 0; dd < dcoord.size(); ++dd) dcoord_[dd] = dcoord[dd];
-      for (unsigned dd = 0; dd < dbox.size(); ++dd) dbox_[dd] = dbox[dd];
-      vector<float> dforce_(dforce.size(), 0);
-      vector<float> dvirial_(dvirial.size(), 0);
-      vector<float> deatom_(dforce.size(), 0);
-      vector<float> dvatom_(dforce.size(), 0);
-      double dener_ = 0;
-      vector<double> all_energy_;
-      vector<vector<float>> all_force_;
-      vector<vector<float>> all_virial_;
-      vector<vector<float>> all_atom_energy_;
-      vector<vector<float>> all_atom_virial_;
-      try {
-        deep_pot_model_devi.compute(all_energy_, all_force_, all_virial_,
-                                    all_atom_energy_, all_atom_virial_, dcoord_,
-                                    dtype, dbox_, nghost, lmp_list, ago, fparam,
-                                    daparam);
-      } catch (deepmd::deepmd_exception &e) {
-        error->all(FLERR, e.what());
-      }
-      // deep_pot_model_devi.compute_avg (dener_, all_energy_);
-      // deep_pot_model_devi.compute_avg (dforce_, all_force_);
-      // deep_pot_model_devi.compute_avg (dvirial_, all_virial_);
-      // deep_pot_model_devi.compute_avg (deatom_, all_atom_energy_);
-      // deep_pot_model_devi.compute_avg (dvatom_, all_atom_virial_);
-      dener_ = all_energy_[0];
-      dforce_ = all_force_[0];
-      dvirial_ = all_virial_[0];
-      deatom_ = all_atom_energy_[0];
-      dvatom_ = all_atom_virial_[0];
-      dener = dener_;
-      for (unsigned dd = 0; dd < dforce.size(); ++dd) dforce[dd] = dforce_[dd];
-      for (unsigned dd = 0; dd < dvirial.size(); ++dd)
-        dvirial[dd] = dvirial_[dd];
-      for (unsigned dd = 0; dd < deatom.size(); ++dd) deatom[dd] = deatom_[dd];
-      for (unsigned dd = 0; dd < dvatom.size(); ++dd) dvatom[dd] = dvatom_[dd];
-      all_force.resize(all_force_.size());
-      for (unsigned ii = 0; ii < all_force_.size(); ++ii) {
-        all_force[ii].resize(all_force_[ii].size());
-        for (unsigned jj = 0; jj < all_force_[ii].size(); ++jj) {
-          all_force[ii][jj] = all_force_[ii][jj];
-        }
-      }
-      all_virial.resize(all_virial_.size());
-      for (unsigned ii = 0; ii < all_virial_.size(); ++ii) {
-        all_virial[ii].resize(all_virial_[ii].size());
-        for (unsigned jj = 0; jj < all_virial_[ii].size(); ++jj) {
-          all_virial[ii][jj] = all_virial_[ii][jj];
-        }
-      }
-#endif
       if (eflag_atom) {
         for (int ii = 0; ii < nlocal; ++ii) eatom[ii] += deatom[ii];
       }
@@ -753,6 +751,7 @@ void PairDeepMD::compute(int eflag, int vflag) {
       }
       if (out_freq > 0 && update->ntimestep % out_freq == 0) {
         int rank = comm->me;
+        timer->sub_start(t_devi);
         // std force
         if (newton_pair) {
 #if LAMMPS_VERSION_NUMBER >= 20220324
@@ -761,29 +760,13 @@ void PairDeepMD::compute(int eflag, int vflag) {
           comm->reverse_comm_pair(this);
 #endif
         }
-        vector<double> std_f;
-#ifdef HIGH_PREC
-        vector<double> tmp_avg_f;
+        vector<FLOAT_PREC> tmp_avg_f, std_f_;
         deep_pot_model_devi.compute_avg(tmp_avg_f, all_force);
-        deep_pot_model_devi.compute_std_f(std_f, tmp_avg_f, all_force);
+        deep_pot_model_devi.compute_std_f(std_f_, tmp_avg_f, all_force);
         if (out_rel == 1) {
-          deep_pot_model_devi.compute_relative_std_f(std_f, tmp_avg_f, eps);
+          deep_pot_model_devi.compute_relative_std_f(std_f_, tmp_avg_f, eps);
         }
-#else
-        vector<float> tmp_avg_f_, std_f_;
-        for (unsigned ii = 0; ii < all_force_.size(); ++ii) {
-          for (unsigned jj = 0; jj < all_force_[ii].size(); ++jj) {
-            all_force_[ii][jj] = all_force[ii][jj];
-          }
-        }
-        deep_pot_model_devi.compute_avg(tmp_avg_f_, all_force_);
-        deep_pot_model_devi.compute_std_f(std_f_, tmp_avg_f_, all_force_);
-        std_f.resize(std_f_.size());
-        if (out_rel == 1) {
-          deep_pot_model_devi.compute_relative_std_f(std_f_, tmp_avg_f_, eps);
-        }
-        for (int dd = 0; dd < std_f_.size(); ++dd) std_f[dd] = std_f_[dd];
-#endif
+        vector<double> std_f(std_f_.begin(), std_f_.end());
         double min = numeric_limits<double>::max(), max = 0, avg = 0;
         ana_st(max, min, avg, std_f, nlocal);
         int all_nlocal = 0;
@@ -793,19 +776,37 @@ void PairDeepMD::compute(int eflag, int vflag) {
         MPI_Reduce(&max, &all_f_max, 1, MPI_DOUBLE, MPI_MAX, 0, world);
         MPI_Reduce(&avg, &all_f_avg, 1, MPI_DOUBLE, MPI_SUM, 0, world);
         all_f_avg /= double(all_nlocal);
+        // std magnetic force, over the atoms carrying a spin only
+        double all_fm_min = 0, all_fm_max = 0, all_fm_avg = 0;
+        vector<double> std_fm;
+        if (do_extend) {
+          vector<FLOAT_PREC> tmp_avg_fm, std_fm_;
+          deep_pot_model_devi.compute_avg(tmp_avg_fm, all_force_mag);
+          deep_pot_model_devi.compute_std_f(std_fm_, tmp_avg_fm, all_force_mag);
+          std_fm.assign(std_fm_.begin(), std_fm_.begin() + nlocal);
+          vector<double> std_fm_mag;
+          for (int ii = 0; ii < nlocal; ++ii) {
+            if (dtype[ii] < numb_types_spin) std_fm_mag.push_back(std_fm[ii]);
+          }
+          int nmag = std_fm_mag.size(), all_nmag = 0;
+          max = avg = 0;
+          min = numeric_limits<double>::max();
+          ana_st(max, min, avg, std_fm_mag, nmag);
+          MPI_Reduce(&nmag, &all_nmag, 1, MPI_INT, MPI_SUM, 0, world);
+          MPI_Reduce(&min, &all_fm_min, 1, MPI_DOUBLE, MPI_MIN, 0, world);
+          MPI_Reduce(&max, &all_fm_max, 1, MPI_DOUBLE, MPI_MAX, 0, world);
+          MPI_Reduce(&avg, &all_fm_avg, 1, MPI_DOUBLE, MPI_SUM, 0, world);
+          if (all_nmag > 0) {
+            all_fm_avg /= double(all_nmag);
+          } else {
+            all_fm_min = 0;
+          }
+        }
         // std energy
-        vector<double> std_e;
-#ifdef HIGH_PREC
-        vector<double> tmp_avg_e;
+        vector<FLOAT_PREC> tmp_avg_e, std_e_;
         deep_pot_model_devi.compute_avg(tmp_avg_e, all_atom_energy);
-        deep_pot_model_devi.compute_std_e(std_e, tmp_avg_e, all_atom_energy);
-#else
-        vector<float> tmp_avg_e_, std_e_;
-        deep_pot_model_devi.compute_avg(tmp_avg_e_, all_atom_energy_);
-        deep_pot_model_devi.compute_std_e(std_e_, tmp_avg_e_, all_atom_energy_);
-        std_e.resize(std_e_.size());
-        for (int dd = 0; dd < std_e_.size(); ++dd) std_e[dd] = std_e_[dd];
-#endif
+        deep_pot_model_devi.compute_std_e(std_e_, tmp_avg_e, all_atom_energy);
+        vector<double> std_e(std_e_.begin(), std_e_.end());
         max = avg = 0;
         min = numeric_limits<double>::max();
         ana_st(max, min, avg, std_e, nlocal);
@@ -824,13 +825,8 @@ void PairDeepMD::compute(int eflag, int vflag) {
         }
         MPI_Reduce(&send_v[0], &recv_v[0], 9 * numb_models, MPI_DOUBLE, MPI_SUM,
                    0, world);
-#ifdef HIGH_PREC
-        std::vector<std::vector<double>> all_virial_1(numb_models);
-        std::vector<double> avg_virial, std_virial;
-#else
-        std::vector<std::vector<float>> all_virial_1(numb_models);
-        std::vector<float> avg_virial, std_virial;
-#endif
+        std::vector<std::vector<FLOAT_PREC>> all_virial_1(numb_models);
+        std::vector<FLOAT_PREC> avg_virial, std_virial;
         for (int kk = 0; kk < numb_models; ++kk) {
           all_virial_1[kk].resize(9);
           for (int ii = 0; ii < 9; ++ii) {
@@ -858,6 +854,8 @@ void PairDeepMD::compute(int eflag, int vflag) {
           }
           all_v_avg = sqrt(all_v_avg / 9);
         }
+        timer->sub_stop(t_devi);
+        timer->sub_start(t_output);
         // // total e
         // vector<double > sum_e(numb_models, 0.);
         // MPI_Reduce (&all_energy[0], &sum_e[0], numb_models, MPI_DOUBLE,
@@ -871,14 +869,23 @@ void PairDeepMD::compute(int eflag, int vflag) {
              << " " << setw(18) << all_v_min << " " << setw(18) << all_v_avg
              << " " << setw(18) << all_f_max << " " << setw(18) << all_f_min
              << " " << setw(18) << all_f_avg;
+          if (do_extend) {
+            fp << " " << setw(18) << all_fm_max << " " << setw(18)
+               << all_fm_min << " " << setw(18) << all_fm_avg;
+          }
           // << " " << setw(18) << avg_e
           // << " " << setw(18) << std_e_1 / all_nlocal
         }
         if (out_each == 1) {
-          vector<double> std_f_all(all_nlocal);
+          vector<double> std_f_all(rank == 0 ? all_nlocal : 0);
           // Gather std_f and tags
           tagint *tag = atom->tag;
           int nprocs = comm->nprocs;
+          if (nlocal > nmax_devi) {
+            nmax_devi = atom->nmax;
+            memory->grow(tagsend, nmax_devi, "deepmd:tagsend");
+            memory->grow(stdfsend, nmax_devi, "deepmd:stdfsend");
+          }
           for (int ii = 0; ii < nlocal; ii++) {
             tagsend[ii] = tag[ii];
             stdfsend[ii] = std_f[ii];
@@ -903,43 +910,29 @@ void PairDeepMD::compute(int eflag, int vflag) {
         if (rank == 0) {
           fp << endl;
         }
+        if (out_atomic_binary) write_atomic_devi(std_f, std_fm);
+        timer->sub_stop(t_output);
       }
     } else {
       error->all(FLERR, "unknown computational branch");
     }
   } else {
     if (numb_models == 1) {
-#ifdef HIGH_PREC
+      timer->sub_start(t_eval);
       try {
         deep_pot.compute(dener, dforce, dvirial, dcoord, dtype, dbox);
       } catch (deepmd::deepmd_exception &e) {
         error->all(FLERR, e.what());
       }
-#else
-      vector<float> dcoord_(dcoord.size());
-      vector<float> dbox_(dbox.size());
-      for (unsigned dd = 0; dd < dcoord.size(); ++dd) dcoord_[dd] = dcoord[dd];
-      for (unsigned dd = 0; dd < dbox.size(); ++dd) dbox_[dd] = dbox[dd];
-      vector<float> dforce_(dforce.size(), 0);
-      vector<float> dvirial_(dvirial.size(), 0);
-      double dener_ = 0;
-      try {
-        deep_pot.compute(dener_, dforce_, dvirial_, dcoord_, dtype, dbox_);
-      } catch (deepmd::deepmd_exception &e) {
-        error->all(FLERR, e.what());
-      }
-      for (unsigned dd = 0; dd < dforce.size(); ++dd) dforce[dd] = dforce_[dd];
-      for (unsigned dd = 0; dd < dvirial.size(); ++dd)
-        dvirial[dd] = dvirial_[dd];
-      dener = dener_;
-#endif
+      timer->sub_stop(t_eval);
     } else {
       error->all(FLERR, "Serial version does not support model devi");
     }
   }
 
-  // get force
-  if (!atom->sp_flag) {
+  // scatter force and magnetic force back in one pass
+  timer->sub_start(t_scatter);
+  if (!do_extend) {
     for (int ii = 0; ii < nall; ++ii) {
       for (int dd = 0; dd < 3; ++dd) {
         f[ii][dd] += scale[1][1] * dforce[3 * ii + dd];
@@ -947,28 +940,21 @@ void PairDeepMD::compute(int eflag, int vflag) {
     }
   } else {
     // unit_factor = hbar / spin_norm;
-    const double hbar = 6.5821191e-04;
     for (int ii = 0; ii < nall; ++ii) {
+      int new_idx = new_idx_map[ii];
       for (int dd = 0; dd < 3; ++dd) {
-        int new_idx = new_idx_map[ii];
         f[ii][dd] += scale[1][1] * dforce[3 * new_idx + dd];
-        if (dtype[ii] < numb_types_spin && ii < nlocal) {
-          fm[ii][dd] += scale[1][1] * dforce[3 * (new_idx + nlocal) + dd] /
-                        (hbar / spin_norm[dtype[ii]]);
-        } else if (dtype[ii] < numb_types_spin) {
-          fm[ii][dd] += scale[1][1] * dforce[3 * (new_idx + nghost) + dd] /
+      }
+      if (dtype[ii] < numb_types_spin) {
+        int virt_idx = new_idx + (ii < nlocal ? nlocal : nghost);
+        for (int dd = 0; dd < 3; ++dd) {
+          fm[ii][dd] += scale[1][1] * dforce[3 * virt_idx + dd] /
                         (hbar / spin_norm[dtype[ii]]);
         }
       }
     }
   }
 
-  if (atom->sp_flag) {
-    std::map<int, int>().swap(new_idx_map);
-    std::map<int, int>().swap(old_idx_map);
-    // malloc_trim(0);
-  }
-
   // accumulate energy and virial
   if (eflag) eng_vdwl += scale[1][1] * dener;
   if (vflag) {
@@ -979,6 +965,271 @@ void PairDeepMD::compute(int eflag, int vflag) {
     virial[4] += 1.0 * dvirial[6] * scale[1][1];
     virial[5] += 1.0 * dvirial[7] * scale[1][1];
   }
+  timer->sub_stop(t_scatter);
+}
+
+/* ----------------------------------------------------------------------
+   magnetic force of the pseudo atom of local atom i only, for sequential
+   spin integrators. the energies depending on the pseudo atom are those
+   of the positions within cutoff of it, so the model is evaluated on
+   those positions as centers with their environments as ghosts.
+   the cluster has the layout of the extended system of compute(): the
+   real centers sorted by type, then the pseudo atoms of the spin centers
+   in the same order, then the same for the ghosts. a real atom is a
+   center or a ghost together with its pseudo atom
+------------------------------------------------------------------------- */
+
+void PairDeepMD::compute_single_spin(int i, double *fmi) {
+  if (numb_models == 0) return;
+  int itype = type_idx_map[atom->type[i] - 1];
+  if (itype < 0 || itype >= numb_types_spin) return;
+  if (extend_nloc_real < 0)
+    error->one(FLERR,
+               "Pair deepmd single-spin evaluation requires a prior force "
+               "computation");
+
+  double **x = atom->x;
+  int *type = atom->type;
+  double cutsq_model = cutoff * cutoff;
+  double cutsq_env = 4.0 * cutoff * cutoff;
+
+  if (cluster_bin_stale) cluster_bin();
+
+  // real atoms with their own or their pseudo position within cutoff of
+  // the pseudo atom of i are centers, within 2*cutoff they are ghosts
+
+  double xi[3], xk[3], delx, dely, delz, rsq;
+  pseudo_coord(i, xi);
+
+  int blo[3], bhi[3];
+  for (int dd = 0; dd < 3; ++dd) {
+    int ibin = static_cast<int>((x[i][dd] - cluster_binlo[dd]) /
+                                cluster_binsize);
+    ibin = MAX(0, MIN(ibin, cluster_nbin[dd] - 1));
+    blo[dd] = MAX(0, ibin - 1);
+    bhi[dd] = MIN(cluster_nbin[dd] - 1, ibin + 1);
+  }
+
+  cluster_center.clear();
+  cluster_env.clear();
+  for (int bz = blo[2]; bz <= bhi[2]; ++bz)
+    for (int by = blo[1]; by <= bhi[1]; ++by)
+      for (int bx = blo[0]; bx <= bhi[0]; ++bx) {
+        int ib = (bz * cluster_nbin[1] + by) * cluster_nbin[0] + bx;
+        for (int k = cluster_binhead[ib]; k >= 0; k = cluster_next[k]) {
+          int ktype = type_idx_map[type[k] - 1];
+          if (ktype < 0) continue;
+          double rsqmin = cutsq_env;
+          for (int virt = 0; virt < 2; ++virt) {
+            if (virt) {
+              if (ktype >= numb_types_spin) break;
+              pseudo_coord(k, xk);
+            } else {
+              for (int dd = 0; dd < 3; ++dd) xk[dd] = x[k][dd];
+            }
+            delx = xk[0] - xi[0];
+            dely = xk[1] - xi[1];
+            delz = xk[2] - xi[2];
+            rsq = delx * delx + dely * dely + delz * delz;
+            rsqmin = MIN(rsqmin, rsq);
+          }
+          if (rsqmin < cutsq_model)
+            cluster_center.push_back(k);
+          else if (rsqmin < cutsq_env)
+            cluster_env.push_back(k);
+        }
+      }
+
+  // positions in the extended layout, ipseudo = index of the pseudo atom
+  // of i among the centers
+
+  int ipseudo = -1;
+  cluster_dcoord.clear();
+  cluster_dtype.clear();
+  int ncenter = cluster_extend(cluster_center, i, ipseudo);
+  int nenv = cluster_extend(cluster_env, -1, ipseudo);
+  int ncluster = ncenter + nenv;
+
+  // neighbor lists of the centers within the cluster
+
+  cluster_ilist.resize(ncenter);
+  cluster_numneigh.resize(ncenter);
+  cluster_firstneigh.resize(ncenter);
+  cluster_neigh.clear();
+  for (int ii = 0; ii < ncenter; ++ii) {
+    cluster_ilist[ii] = ii;
+    int nneigh = 0;
+    const FLOAT_PREC *ci = &cluster_dcoord[3 * ii];
+    for (int jj = 0; jj < ncluster; ++jj) {
+      if (jj == ii) continue;
+      delx = cluster_dcoord[3 * jj + 0] - ci[0];
+      dely = cluster_dcoord[3 * jj + 1] - ci[1];
+      delz = cluster_dcoord[3 * jj + 2] - ci[2];
+      rsq = delx * delx + dely * dely + delz * delz;
+      if (rsq < cutsq_model) {
+        cluster_neigh.push_back(jj);
+        nneigh++;
+      }
+    }
+    cluster_numneigh[ii] = nneigh;
+  }
+  for (int ii = 0, offset = 0; ii < ncenter; ++ii) {
+    cluster_firstneigh[ii] = &cluster_neigh[offset];
+    offset += cluster_numneigh[ii];
+  }
+  deepmd::InputNlist cluster_list(ncenter, &cluster_ilist[0],
+                                  &cluster_numneigh[0], &cluster_firstneigh[0]);
+
+  dbox.assign(9, 0);
+  dbox[0] = domain->h[0];  // xx
+  dbox[4] = domain->h[1];  // yy
+  dbox[8] = domain->h[2];  // zz
+  dbox[7] = domain->h[3];  // zy
+  dbox[6] = domain->h[4];  // zx
+  dbox[3] = domain->h[5];  // yx
+
+  if (aparam.size() > 0) {
+    make_uniform_aparam(daparam, aparam, ncenter);
+  } else if (do_ttm && dim_aparam > 0) {
+    error->one(FLERR,
+               "Pair deepmd single-spin evaluation does not support ttm "
+               "aparam");
+  }
+
+  double dener = 0;
+  // the model rebuilds its list from the cluster, ago is always 0 here
+  const int ago = 0;
+  try {
+    deep_pot.compute(dener, dforce, dvirial, cluster_dcoord, cluster_dtype,
+                     dbox, nenv, cluster_list, ago, fparam, daparam);
+  } catch (deepmd::deepmd_exception &e) {
+    error->one(FLERR, e.what());
+  }
+  model_nlist_stale = true;
+
+  for (int dd = 0; dd < 3; ++dd) {
+    fmi[dd] += scale[1][1] * dforce[3 * ipseudo + dd] /
+               (hbar / spin_norm[itype]);
+  }
+}
+
+/* ----------------------------------------------------------------------
+   append the real atoms in list, sorted by type, and then the pseudo
+   atoms of those of a spin type in the same order, to the cluster.
+   the k-th real atom of a spin type is the host of the k-th pseudo atom,
+   as in extend(). sets ipseudo if atom i is in list.
+   returns the # of appended positions
+------------------------------------------------------------------------- */
+
+int PairDeepMD::cluster_extend(std::vector<int> &list, const int i,
+                               int &ipseudo) {
+  double **x = atom->x;
+  int *type = atom->type;
+  double *boxlo = domain->boxlo;
+  int numb_types_real = numb_types - numb_types_spin;
+  int nlist = list.size();
+  double xk[3];
+
+  // stable sort by type, spin types come first
+
+  std::stable_sort(list.begin(), list.end(), [&](int a, int b) {
+    return type_idx_map[type[a] - 1] < type_idx_map[type[b] - 1];
+  });
+
+  int nvirt = 0;
+  int start = cluster_dtype.size();
+  for (int kk = 0; kk < nlist; ++kk) {
+    int k = list[kk];
+    int ktype = type_idx_map[type[k] - 1];
+    for (int dd = 0; dd < 3; ++dd)
+      cluster_dcoord.push_back(x[k][dd] - boxlo[dd]);
+    cluster_dtype.push_back(ktype);
+    if (ktype < numb_types_spin) nvirt++;
+  }
+  for (int kk = 0; kk < nvirt; ++kk) {
+    int k = list[kk];
+    pseudo_coord(k, xk);
+    for (int dd = 0; dd < 3; ++dd)
+      cluster_dcoord.push_back(xk[dd] - boxlo[dd]);
+    cluster_dtype.push_back(type_idx_map[type[k] - 1] + numb_types_real);
+    if (k == i) ipseudo = start + nlist + kk;
+  }
+  return nlist + nvirt;
+}
+
+/* ----------------------------------------------------------------------
+   position of the pseudo atom of atom i
+------------------------------------------------------------------------- */
+
+void PairDeepMD::pseudo_coord(int i, double *xp) {
+  double **x = atom->x;
+  double **sp = atom->sp;
+  int itype = type_idx_map[atom->type[i] - 1];
+  double len = virtual_len[itype] * (sp[i][3] / spin_norm[itype]);
+  for (int dd = 0; dd < 3; ++dd) {
+    xp[dd] = x[i][dd] + sp[i][dd] * len;
+  }
+}
+
+/* ----------------------------------------------------------------------
+   bin owned and ghost atoms for collecting single-spin clusters
+   bins are 2*cutoff + 2*virtual_len + skin wide, so the 27 bins around
+   an atom hold its cluster as long as atoms stay within the skin
+------------------------------------------------------------------------- */
+
+void PairDeepMD::cluster_bin() {
+  double **x = atom->x;
+  int nall = atom->nlocal + atom->nghost;
+
+  double vmax = 0.0;
+  for (int ii = 0; ii < virtual_len.size(); ++ii)
+    vmax = MAX(vmax, virtual_len[ii]);
+  double cutcluster = 2.0 * cutoff + 2.0 * vmax;
+  if (MAX(comm->cutghostuser, neighbor->cutneighmax) < cutcluster)
+    error->one(FLERR,
+               "Pair deepmd single-spin evaluation requires a ghost cutoff "
+               "of at least 2*(rcut + virtual_len), see comm_modify cutoff");
+  cluster_binsize = cutcluster + neighbor->skin;
+
+  // the cluster moves only the pseudo atom, not its periodic images, so
+  // no center may see two images of it
+  for (int dd = 0; dd < 3; ++dd)
+    if (domain->periodicity[dd] && domain->prd[dd] < 2.0 * cutoff)
+      error->one(FLERR,
+                 "Pair deepmd single-spin evaluation requires periodic box "
+                 "lengths of at least 2*rcut");
+
+  double binhi[3];
+  for (int dd = 0; dd < 3; ++dd) {
+    cluster_binlo[dd] = domain->sublo[dd];
+    binhi[dd] = domain->subhi[dd];
+  }
+  for (int ii = 0; ii < nall; ++ii) {
+    for (int dd = 0; dd < 3; ++dd) {
+      cluster_binlo[dd] = MIN(cluster_binlo[dd], x[ii][dd]);
+      binhi[dd] = MAX(binhi[dd], x[ii][dd]);
+    }
+  }
+  for (int dd = 0; dd < 3; ++dd) {
+    cluster_nbin[dd] = static_cast<int>((binhi[dd] - cluster_binlo[dd]) /
+                                        cluster_binsize) + 1;
+  }
+
+  cluster_binhead.assign(cluster_nbin[0] * cluster_nbin[1] * cluster_nbin[2],
+                         -1);
+  cluster_next.resize(nall);
+  int ibin[3];
+  for (int ii = nall - 1; ii >= 0; --ii) {
+    for (int dd = 0; dd < 3; ++dd) {
+      ibin[dd] = static_cast<int>((x[ii][dd] - cluster_binlo[dd]) /
+                                  cluster_binsize);
+      ibin[dd] = MIN(ibin[dd], cluster_nbin[dd] - 1);
+    }
+    int ib = (ibin[2] * cluster_nbin[1] + ibin[1]) * cluster_nbin[0] + ibin[0];
+    cluster_next[ii] = cluster_binhead[ib];
+    cluster_binhead[ib] = ii;
+  }
+  cluster_bin_stale = false;
 }
 
 void PairDeepMD::allocate() {
@@ -1014,6 +1265,8 @@ static bool is_key(const string &input) {
   keys.push_back("fparam_from_compute");
   keys.push_back("ttm");
   keys.push_back("atomic");
+  keys.push_back("atomic_file");
+  keys.push_back("atomic_thresh");
   keys.push_back("relative");
   keys.push_back("relative_v");
   keys.push_back("virtual_len");
@@ -1055,9 +1308,10 @@ void PairDeepMD::settings(int narg, char **arg) {
     dim_aparam = deep_pot.dim_aparam();
   } else {
     try {
-      deep_pot.init(arg[0], get_node_rank(), get_file_content(arg[0]));
-      deep_pot_model_devi.init(models, get_node_rank(),
-                               get_file_content(models));
+      // the first model of the committee is only read once
+      std::vector<std::string> file_contents = get_file_content(models);
+      deep_pot.init(arg[0], get_node_rank(), file_contents[0]);
+      deep_pot_model_devi.init(models, get_node_rank(), file_contents);
     } catch (deepmd::deepmd_exception &e) {
       error->all(FLERR, e.what());
     }
@@ -1076,6 +1330,8 @@ void PairDeepMD::settings(int narg, char **arg) {
   out_freq = 100;
   out_file = "model_devi.out";
   out_each = 0;
+  out_atomic_binary = 0;
+  out_atomic_thresh = 0.;
   out_rel = 0;
   eps = 0.;
   fparam.clear();
@@ -1152,6 +1408,17 @@ void PairDeepMD::settings(int narg, char **arg) {
     else if (string(arg[iarg]) == string("atomic")) {
       out_each = 1;
       iarg += 1;
+    } else if (string(arg[iarg]) == string("atomic_file")) {
+      if (iarg + 1 >= narg)
+        error->all(FLERR, "Illegal atomic_file, not provided");
+      out_atomic_binary = 1;
+      out_atomic_file = string(arg[iarg + 1]);
+      iarg += 2;
+    } else if (string(arg[iarg]) == string("atomic_thresh")) {
+      if (iarg + 1 >= narg)
+        error->all(FLERR, "Illegal atomic_thresh, not provided");
+      out_atomic_thresh = atof(arg[iarg + 1]);
+      iarg += 2;
     } else if (string(arg[iarg]) == string("relative")) {
       out_rel = 1;
 #ifdef HIGH_PREC
@@ -1193,6 +1460,23 @@ void PairDeepMD::settings(int narg, char **arg) {
         "fparam and fparam_from_compute should NOT be set simultaneously");
   }
 
+  // binary per-atom deviations, all procs open the file, on restart new
+  // frames are appended
+  if (atomic_fh != MPI_FILE_NULL) MPI_File_close(&atomic_fh);
+  if (numb_models > 1 && out_freq > 0 && out_atomic_binary) {
+    int err = MPI_File_open(world, out_atomic_file.c_str(),
+                            MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL,
+                            &atomic_fh);
+    if (err != MPI_SUCCESS)
+      error->all(FLERR, "Cannot open atomic_file " + out_atomic_file);
+    if (is_restart) {
+      MPI_File_get_size(atomic_fh, &atomic_offset);
+    } else {
+      MPI_File_set_size(atomic_fh, 0);
+      atomic_offset = 0;
+    }
+  }
+
   if (comm->me == 0) {
     if (numb_models > 1 && out_freq > 0) {
       if (!is_restart) {
@@ -1201,7 +1485,12 @@ void PairDeepMD::settings(int narg, char **arg) {
         fp << "#" << setw(12 - 1) << "step" << setw(18 + 1) << "max_devi_v"
            << setw(18 + 1) << "min_devi_v" << setw(18 + 1) << "avg_devi_v"
            << setw(18 + 1) << "max_devi_f" << setw(18 + 1) << "min_devi_f"
-           << setw(18 + 1) << "avg_devi_f" << endl;
+           << setw(18 + 1) << "avg_devi_f";
+        if (atom->sp_flag) {
+          fp << setw(18 + 1) << "max_devi_fm" << setw(18 + 1) << "min_devi_fm"
+             << setw(18 + 1) << "avg_devi_fm";
+        }
+        fp << endl;
       } else {
         fp.open(out_file, std::ofstream::out | std::ofstream::app);
         fp << scientific;
@@ -1219,7 +1508,9 @@ void PairDeepMD::settings(int narg, char **arg) {
     }
     cout << endl
          << pre << "rcut in model:      " << cutoff << endl
-         << pre << "ntypes in model:    " << numb_types << endl;
+         << pre << "ntypes in model:    " << numb_types << endl
+         << pre << "model(s) loaded in: " << load_time << " s, "
+         << load_bytes << " bytes" << endl;
     if (fparam.size() > 0) {
       cout << pre << "using fparam(s):    ";
       for (int ii = 0; ii < dim_fparam; ++ii) {
@@ -1249,8 +1540,10 @@ void PairDeepMD::settings(int narg, char **arg) {
     }
   }
 
-  comm_reverse = numb_models * 3;
+  // with spins, the magnetic forces are reverse communicated as well
+  comm_reverse = numb_models * (atom->sp_flag ? 6 : 3);
   all_force.resize(numb_models);
+  all_force_mag.resize(numb_models);
 }
 
 void PairDeepMD::read_restart(FILE *) { is_restart = true; }
@@ -1355,16 +1648,75 @@ void PairDeepMD::init_style() {
   neighbor->requests[irequest]->full = 1;
   // neighbor->requests[irequest]->newton = 2;
 #endif
+  // send buffers grow with nlocal when used, only rank 0 receives all atoms
   if (out_each == 1) {
-    int ntotal = atom->natoms;
+    int ntotal = (comm->me == 0) ? atom->natoms : 0;
     int nprocs = comm->nprocs;
-    memory->create(counts, nprocs, "deepmd:counts");
-    memory->create(displacements, nprocs, "deepmd:displacements");
-    memory->create(stdfsend, ntotal, "deepmd:stdfsendall");
-    memory->create(stdfrecv, ntotal, "deepmd:stdfrecvall");
-    memory->create(tagsend, ntotal, "deepmd:tagsendall");
-    memory->create(tagrecv, ntotal, "deepmd:tagrecvall");
+    memory->grow(counts, nprocs, "deepmd:counts");
+    memory->grow(displacements, nprocs, "deepmd:displacements");
+    memory->grow(stdfrecv, ntotal, "deepmd:stdfrecvall");
+    memory->grow(tagrecv, ntotal, "deepmd:tagrecvall");
+  }
+
+  // stages of compute() reported in the timing breakdown
+  t_pack = timer->add_sub("DeepMD pack/extend");
+  t_eval = timer->add_sub("DeepMD model eval");
+  t_scatter = timer->add_sub("DeepMD scatter");
+  t_devi = timer->add_sub("DeepMD model devi");
+  t_output = timer->add_sub("DeepMD devi output");
+}
+
+/* ----------------------------------------------------------------------
+   write per-atom force deviations of this step to the binary file, each
+   proc writes its own atoms at its offset in the frame with MPI-IO
+   frame = header (bigint step, bigint nrecords, int ncols) followed by
+   nrecords records (bigint tag, ncols doubles: std_f [, std_fm])
+   only atoms with std_f >= out_atomic_thresh are written
+------------------------------------------------------------------------- */
+
+void PairDeepMD::write_atomic_devi(const std::vector<double> &std_f,
+                                   const std::vector<double> &std_fm) {
+  int nlocal = atom->nlocal;
+  tagint *tag = atom->tag;
+  int ncols = std_fm.empty() ? 1 : 2;
+  int recsize = sizeof(bigint) + ncols * sizeof(double);
+  const int headersize = 2 * sizeof(bigint) + sizeof(int);
+
+  atomic_buf.resize((size_t)nlocal * recsize);
+  char *ptr = atomic_buf.data();
+  bigint nme = 0;
+  for (int ii = 0; ii < nlocal; ++ii) {
+    if (std_f[ii] < out_atomic_thresh) continue;
+    bigint itag = tag[ii];
+    memcpy(ptr, &itag, sizeof(bigint));
+    ptr += sizeof(bigint);
+    memcpy(ptr, &std_f[ii], sizeof(double));
+    ptr += sizeof(double);
+    if (ncols == 2) {
+      memcpy(ptr, &std_fm[ii], sizeof(double));
+      ptr += sizeof(double);
+    }
+    nme++;
   }
+
+  bigint incprefix = 0, nrecords = 0;
+  MPI_Scan(&nme, &incprefix, 1, MPI_LMP_BIGINT, MPI_SUM, world);
+  MPI_Allreduce(&nme, &nrecords, 1, MPI_LMP_BIGINT, MPI_SUM, world);
+
+  if (comm->me == 0) {
+    char header[headersize];
+    bigint step = update->ntimestep;
+    memcpy(header, &step, sizeof(bigint));
+    memcpy(header + sizeof(bigint), &nrecords, sizeof(bigint));
+    memcpy(header + 2 * sizeof(bigint), &ncols, sizeof(int));
+    MPI_File_write_at(atomic_fh, atomic_offset, header, headersize, MPI_BYTE,
+                      MPI_STATUS_IGNORE);
+  }
+  MPI_Offset offset =
+      atomic_offset + headersize + (MPI_Offset)(incprefix - nme) * recsize;
+  MPI_File_write_at_all(atomic_fh, offset, atomic_buf.data(), nme * recsize,
+                        MPI_BYTE, MPI_STATUS_IGNORE);
+  atomic_offset += headersize + (MPI_Offset)nrecords * recsize;
 }
 
 double PairDeepMD::init_one(int i, int j) {
@@ -1381,6 +1733,14 @@ double PairDeepMD::init_one(int i, int j) {
   if (setflag[i][j] == 0) scale[i][j] = 1.0;
   scale[j][i] = scale[i][j];
 
+  // the force on a pseudo atom depends on all pseudo atoms within 2*cutoff,
+  // so two spins are independent only beyond 2*(cutoff + virtual_len)
+
+  double vmax = 0.0;
+  for (int ii = 0; ii < virtual_len.size(); ++ii)
+    vmax = MAX(vmax, virtual_len[ii]);
+  cut_spin = 2.0 * (cutoff + vmax);
+
   return cutoff;
 }
 
@@ -1396,6 +1756,11 @@ int PairDeepMD::pack_reverse_comm(int n, int first, double *buf) {
       buf[m++] = all_force[dd][3 * i + 0];
       buf[m++] = all_force[dd][3 * i + 1];
       buf[m++] = all_force[dd][3 * i + 2];
+      if (atom->sp_flag) {
+        buf[m++] = all_force_mag[dd][3 * i + 0];
+        buf[m++] = all_force_mag[dd][3 * i + 1];
+        buf[m++] = all_force_mag[dd][3 * i + 2];
+      }
     }
   }
   return m;
@@ -1413,6 +1778,11 @@ void PairDeepMD::unpack_reverse_comm(int n, int *list, double *buf) {
       all_force[dd][3 * j + 0] += buf[m++];
       all_force[dd][3 * j + 1] += buf[m++];
       all_force[dd][3 * j + 2] += buf[m++];
+      if (atom->sp_flag) {
+        all_force_mag[dd][3 * j + 0] += buf[m++];
+        all_force_mag[dd][3 * j + 1] += buf[m++];
+        all_force_mag[dd][3 * j + 2] += buf[m++];
+      }
     }
   }
 }
@@ -1426,95 +1796,83 @@ void *PairDeepMD::extract(const char *str, int &dim) {
     dim = 2;
     return (void *)scale;
   }
+  if (strcmp(str, "cut_spin") == 0) {
+    dim = 0;
+    return (void *)&cut_spin;
+  }
+  if (strcmp(str, "emag") == 0) {
+    dim = 0;
+    return (void *)emag;
+  }
   return NULL;
 }
 
+/* ----------------------------------------------------------------------
+   build the topology of the extended system (real + pseudo atoms)
+   atoms are sorted by type, local spin atom ii gets its pseudo atom at
+   new_idx_map[ii] + nloc, ghost spin atom ii at new_idx_map[ii] + nghost
+   only depends on the lammps neighbor list, so it is kept between calls
+------------------------------------------------------------------------- */
+
 void PairDeepMD::extend(int &extend_inum,
                         std::vector<int> &extend_ilist,
                         std::vector<int> &extend_numneigh,
-                        std::vector<vector<int>> &extend_neigh,
+                        std::vector<int> &extend_neigh,
                         std::vector<int *> &extend_firstneigh,
-                        std::vector<double> &extend_dcoord,
+                        std::vector<FLOAT_PREC> &extend_dcoord,
                         std::vector<int> &extend_atype,
                         int &extend_nghost,
-                        std::map<int, int> &new_idx_map,
-                        std::map<int, int> &old_idx_map,
+                        std::vector<int> &new_idx_map,
+                        std::vector<int> &old_idx_map,
                         const deepmd::InputNlist &lmp_list,
-                        const std::vector<double> &dcoord,
                         const std::vector<int> &atype,
                         const int nghost,
-                        const std::vector<double> &spin,
                         const int numb_types,
-                        const int numb_types_spin,
-                        const std::vector<double> &virtual_len,
-                        const std::vector<double> &dspin_norm) {
-  extend_ilist.clear();
-  extend_numneigh.clear();
-  extend_neigh.clear();
-  extend_firstneigh.clear();
-  extend_dcoord.clear();
-  extend_atype.clear();
-
-  int nall = dcoord.size() / 3;
+                        const int numb_types_spin) {
+  int nall = atype.size();
   int nloc = nall - nghost;
   assert(nloc == lmp_list.inum);
 
   // record numb_types_real and nloc_virt
   int numb_types_real = numb_types - numb_types_spin;
-  std::map<int, int> loc_type_count;
-  std::map<int, int>::iterator iter = loc_type_count.begin();
-  for (int i = 0; i < nloc; i++) {
-    iter = loc_type_count.find(atype[i]);
-    if (iter != loc_type_count.end())
-      iter->second += 1;
+  std::vector<int> loc_type_count(numb_types_real, 0);
+  std::vector<int> ghost_type_count(numb_types_real, 0);
+  for (int ii = 0; ii < nall; ii++) {
+    if (atype[ii] < 0 || atype[ii] >= numb_types_real)
+      error->one(FLERR, "Atom type is not a real atom type of the spin model");
+    if (ii < nloc)
+      loc_type_count[atype[ii]]++;
     else
-      loc_type_count.insert(pair<int, int>(atype[i], 1));
+      ghost_type_count[atype[ii]]++;
   }
-  assert(numb_types_real - 1 == loc_type_count.rbegin()->first);
   int nloc_virt = 0;
-  for (int i = 0; i < numb_types_spin; i++) {
-    nloc_virt += loc_type_count[i];
-  }
-
-  // record nghost_virt
-  std::map<int, int> ghost_type_count;
-  for (int i = nloc; i < nall; i++) {
-    iter = ghost_type_count.find(atype[i]);
-    if (iter != ghost_type_count.end())
-      iter->second += 1;
-    else
-      ghost_type_count.insert(pair<int, int>(atype[i], 1));
-  }
   int nghost_virt = 0;
-  for (int i = 0; i < numb_types_spin; i++) {
-    nghost_virt += ghost_type_count[i];
+  for (int ii = 0; ii < numb_types_spin; ii++) {
+    nloc_virt += loc_type_count[ii];
+    nghost_virt += ghost_type_count[ii];
   }
 
   // for extended system, search new index by old index, and vice versa
   extend_nghost = nghost + nghost_virt;
   int extend_nloc = nloc + nloc_virt;
   int extend_nall = extend_nloc + extend_nghost;
-  std::map<int, int> cum_loc_type_count;
-  std::map<int, int> cum_ghost_type_count;
+  std::vector<int> cum_loc_type_count;
+  std::vector<int> cum_ghost_type_count;
   cum_sum(cum_loc_type_count, loc_type_count);
   cum_sum(cum_ghost_type_count, ghost_type_count);
-  std::vector<int> loc_type_reset(numb_types_real, 0);
-  std::vector<int> ghost_type_reset(numb_types_real, 0);
 
-  new_idx_map.clear();
-  old_idx_map.clear();
+  // old_idx_map keeps the real ghosts right after the real locals
+  new_idx_map.resize(nall);
+  old_idx_map.resize(nall);
   for (int ii = 0; ii < nloc; ii++) {
-    int new_idx = cum_loc_type_count[atype[ii]] + loc_type_reset[atype[ii]];
+    int new_idx = cum_loc_type_count[atype[ii]]++;
     new_idx_map[ii] = new_idx;
     old_idx_map[new_idx] = ii;
-    loc_type_reset[atype[ii]]++;
   }
   for (int ii = nloc; ii < nall; ii++) {
-    int new_idx = cum_ghost_type_count[atype[ii]] +
-                  ghost_type_reset[atype[ii]] + extend_nloc;
+    int new_idx = cum_ghost_type_count[atype[ii]]++ + extend_nloc;
     new_idx_map[ii] = new_idx;
-    old_idx_map[new_idx] = ii;
-    ghost_type_reset[atype[ii]]++;
+    old_idx_map[new_idx - nloc_virt] = ii;
   }
 
   // extend lmp_list
@@ -1525,71 +1883,145 @@ void PairDeepMD::extend(int &extend_inum,
     extend_ilist[ii] = ii;
   }
 
-  extend_neigh.resize(extend_nloc);
+  // count the neighbors first, so all lists fit in one contiguous array
+  extend_numneigh.resize(extend_nloc);
   for (int ii = 0; ii < nloc; ii++) {
-    int jnum = lmp_list.numneigh[old_idx_map[ii]];
-    const int *jlist = lmp_list.firstneigh[old_idx_map[ii]];
-    if (atype[old_idx_map[ii]] < numb_types_spin) {
-      extend_neigh[ii].push_back(ii + nloc);
-    }
+    int old_idx = old_idx_map[ii];
+    int jnum = lmp_list.numneigh[old_idx];
+    const int *jlist = lmp_list.firstneigh[old_idx];
+    int nneigh = jnum;
+    if (atype[old_idx] < numb_types_spin) nneigh++;
     for (int jj = 0; jj < jnum; jj++) {
-      int new_idx = new_idx_map[jlist[jj]];
-      extend_neigh[ii].push_back(new_idx);
-      if (atype[jlist[jj]] < numb_types_spin && jlist[jj] < nloc) {
-        extend_neigh[ii].push_back(new_idx + nloc);
-      } else if (atype[jlist[jj]] < numb_types_spin && jlist[jj] < nall) {
-        extend_neigh[ii].push_back(new_idx + nghost);
-      }
+      if (atype[jlist[jj]] < numb_types_spin) nneigh++;
     }
+    extend_numneigh[ii] = nneigh;
   }
   for (int ii = nloc; ii < extend_nloc; ii++) {
-    extend_neigh[ii].assign(extend_neigh[ii - nloc].begin(),
-                            extend_neigh[ii - nloc].end());
-    std::vector<int>::iterator it =
-        find(extend_neigh[ii].begin(), extend_neigh[ii].end(), ii);
-    *it = ii - nloc;
+    extend_numneigh[ii] = extend_numneigh[ii - nloc];
   }
 
-  extend_firstneigh.resize(extend_nloc);
-  extend_numneigh.resize(extend_nloc);
+  std::vector<int> extend_offset(extend_nloc + 1, 0);
   for (int ii = 0; ii < extend_nloc; ii++) {
-    extend_firstneigh[ii] = &extend_neigh[ii][0];
-    extend_numneigh[ii] = extend_neigh[ii].size();
+    extend_offset[ii + 1] = extend_offset[ii] + extend_numneigh[ii];
   }
+  extend_neigh.resize(extend_offset[extend_nloc]);
 
-  // extend coord
-  extend_dcoord.resize(extend_nall * 3);
   for (int ii = 0; ii < nloc; ii++) {
-    for (int jj = 0; jj < 3; jj++) {
-      extend_dcoord[new_idx_map[ii] * 3 + jj] = dcoord[ii * 3 + jj];
-      if (atype[ii] < numb_types_spin) {
-        double temp_dcoord =
-            dcoord[ii * 3 + jj] + spin[ii * 3 + jj] * virtual_len[atype[ii]] * dspin_norm[ii];
-        extend_dcoord[(new_idx_map[ii] + nloc) * 3 + jj] = temp_dcoord;
-      }
+    int old_idx = old_idx_map[ii];
+    int jnum = lmp_list.numneigh[old_idx];
+    const int *jlist = lmp_list.firstneigh[old_idx];
+    int *neigh = &extend_neigh[extend_offset[ii]];
+    int kk = 0;
+    if (atype[old_idx] < numb_types_spin) {
+      neigh[kk++] = ii + nloc;
     }
-  }
-  for (int ii = nloc; ii < nall; ii++) {
-    for (int jj = 0; jj < 3; jj++) {
-      extend_dcoord[new_idx_map[ii] * 3 + jj] = dcoord[ii * 3 + jj];
-      if (atype[ii] < numb_types_spin) {
-        double temp_dcoord =
-            dcoord[ii * 3 + jj] + spin[ii * 3 + jj] * virtual_len[atype[ii]] * dspin_norm[ii];
-        extend_dcoord[(new_idx_map[ii] + nghost) * 3 + jj] = temp_dcoord;
+    for (int jj = 0; jj < jnum; jj++) {
+      int jold = jlist[jj];
+      int new_idx = new_idx_map[jold];
+      neigh[kk++] = new_idx;
+      if (atype[jold] < numb_types_spin) {
+        neigh[kk++] = new_idx + (jold < nloc ? nloc : nghost);
       }
     }
   }
 
+  // a pseudo atom sees the neighbors of its host, the host's own pseudo
+  // atom (always first in the host list) is replaced by the host itself
+  for (int ii = nloc; ii < extend_nloc; ii++) {
+    const int *host = &extend_neigh[extend_offset[ii - nloc]];
+    int *neigh = &extend_neigh[extend_offset[ii]];
+    std::copy(host, host + extend_numneigh[ii], neigh);
+    neigh[0] = ii - nloc;
+  }
+
+  extend_firstneigh.resize(extend_nloc);
+  for (int ii = 0; ii < extend_nloc; ii++) {
+    extend_firstneigh[ii] = &extend_neigh[extend_offset[ii]];
+  }
+
   // extend atype
   extend_atype.resize(extend_nall);
   for (int ii = 0; ii < nall; ii++) {
     extend_atype[new_idx_map[ii]] = atype[ii];
     if (atype[ii] < numb_types_spin) {
-      if (ii < nloc) {
-        extend_atype[new_idx_map[ii] + nloc] = atype[ii] + numb_types_real;
-      } else {
-        extend_atype[new_idx_map[ii] + nghost] = atype[ii] + numb_types_real;
+      int virt_idx = new_idx_map[ii] + (ii < nloc ? nloc : nghost);
+      extend_atype[virt_idx] = atype[ii] + numb_types_real;
+    }
+  }
+
+  extend_dcoord.resize(extend_nall * 3);
+}
+
+/* ----------------------------------------------------------------------
+   split forces of the extended system into forces on the real atoms and
+   magnetic forces of their spins, both in lammps order
+------------------------------------------------------------------------- */
+
+void PairDeepMD::split_extend_force(std::vector<FLOAT_PREC> &force,
+                                    std::vector<FLOAT_PREC> &force_mag,
+                                    const std::vector<FLOAT_PREC> &extend_force,
+                                    const int nloc,
+                                    const int nghost) {
+  int nall = nloc + nghost;
+  force.resize(nall * 3);
+  force_mag.assign(nall * 3, 0);
+  for (int ii = 0; ii < nall; ++ii) {
+    int new_idx = new_idx_map[ii];
+    for (int dd = 0; dd < 3; ++dd) {
+      force[3 * ii + dd] = extend_force[3 * new_idx + dd];
+    }
+    if (dtype[ii] < numb_types_spin) {
+      int virt_idx = new_idx + (ii < nloc ? nloc : nghost);
+      for (int dd = 0; dd < 3; ++dd) {
+        force_mag[3 * ii + dd] =
+            extend_force[3 * virt_idx + dd] / (hbar / spin_norm[dtype[ii]]);
       }
     }
   }
 }
+
+/* ----------------------------------------------------------------------
+   per-atom quantity of the extended system in lammps order, the value of
+   a pseudo atom is added to the one of its host
+------------------------------------------------------------------------- */
+
+void PairDeepMD::fold_extend(std::vector<FLOAT_PREC> &out,
+                             const std::vector<FLOAT_PREC> &extend_in,
+                             const int ncomp,
+                             const int nloc,
+                             const int nghost) {
+  int nall = nloc + nghost;
+  out.resize(nall * ncomp);
+  for (int ii = 0; ii < nall; ++ii) {
+    int new_idx = new_idx_map[ii];
+    for (int dd = 0; dd < ncomp; ++dd) {
+      out[ncomp * ii + dd] = extend_in[ncomp * new_idx + dd];
+    }
+    if (dtype[ii] < numb_types_spin) {
+      int virt_idx = new_idx + (ii < nloc ? nloc : nghost);
+      for (int dd = 0; dd < ncomp; ++dd) {
+        out[ncomp * ii + dd] += extend_in[ncomp * virt_idx + dd];
+      }
+    }
+  }
+}
+
+/* ----------------------------------------------------------------------
+   energy of the pseudo atom of each local spin atom in the per-atom
+   energies of the extended system, the magnetic energy of the spin
+------------------------------------------------------------------------- */
+
+void PairDeepMD::pseudo_energy(const std::vector<FLOAT_PREC> &extend_in,
+                               const int nloc) {
+  if (atom->nmax > nmax_emag) {
+    nmax_emag = atom->nmax;
+    memory->destroy(emag);
+    memory->create(emag, nmax_emag, "deepmd:emag");
+  }
+  for (int ii = 0; ii < nloc; ++ii) {
+    emag[ii] = 0.;
+    if (dtype[ii] < numb_types_spin) {
+      emag[ii] = extend_in[new_idx_map[ii] + nloc];
+    }
+  }
+}
@@ -338,6 +338,50 @@ void Finish::end(int flag)
         utils::logmesg(lmp,"Other   |            | {:<10.4g} |            |  "
                        "     |{:6.2f}\n",time,time/time_loop*100.0);
     }
+
+    // named sub-timers of styles, they are part of the sections above
+
+    const int nsub = timer->get_num_sub();
+    if (nsub > 0) {
+      if (me == 0)
+        utils::logmesg(lmp,"\nSub-timer breakdown:\nName                  |  min time  "
+                       "|  avg time  |  max time  | calls/task | time/call  | %total\n"
+                       "---------------------------------------------------------------"
+                       "------------------------------\n");
+      for (int i = 0; i < nsub; i++) {
+        double tmin,tmax,tsum;
+        bigint calls;
+        time = timer->get_sub_wall(i);
+        bigint count = timer->get_sub_count(i);
+        MPI_Allreduce(&count,&calls,1,MPI_LMP_BIGINT,MPI_SUM,world);
+        if (calls == 0) continue;
+        MPI_Allreduce(&time,&tmin,1,MPI_DOUBLE,MPI_MIN,world);
+        MPI_Allreduce(&time,&tmax,1,MPI_DOUBLE,MPI_MAX,world);
+        MPI_Allreduce(&time,&tsum,1,MPI_DOUBLE,MPI_SUM,world);
+        const double percall = calls ? tsum/calls : 0.0;
+        if (me == 0)
+          utils::logmesg(lmp,"{:<21s} | {:<10.4g} | {:<10.4g} | {:<10.4g} | {:>10} | "
+                         "{:<10.4g} |{:6.2f}\n",timer->get_sub_name(i),tmin,tsum/nprocs,
+                         tmax,calls/nprocs,percall,tsum/nprocs/time_loop*100.0);
+      }
+
+      bigint hist[Timer::NUM_SUB_BINS];
+      if (me == 0)
+        utils::logmesg(lmp,"\nSub-timer calls per latency (all tasks):\nName                  "
+                       "|   <1us   |  <10us   |  <100us  |   <1ms   |  <10ms   |  <100ms  "
+                       "|   <1s    |   <10s   |  >=10s\n");
+      for (int i = 0; i < nsub; i++) {
+        MPI_Allreduce(timer->get_sub_hist(i),hist,Timer::NUM_SUB_BINS,MPI_LMP_BIGINT,
+                      MPI_SUM,world);
+        bigint calls = 0;
+        for (int j = 0; j < Timer::NUM_SUB_BINS; j++) calls += hist[j];
+        if ((me == 0) && (calls > 0)) {
+          std::string mesg = fmt::format("{:<21s}",timer->get_sub_name(i));
+          for (int j = 0; j < Timer::NUM_SUB_BINS; j++) mesg += fmt::format(" | {:>8}",hist[j]);
+          utils::logmesg(lmp,mesg+"\n");
+        }
+      }
+    }
   }
 
 #ifdef LMP_OPENMP
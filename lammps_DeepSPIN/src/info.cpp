@@ -40,6 +40,7 @@
 #include "pair.h"
 #include "pair_hybrid.h"
 #include "region.h"
+#include "timer.h"
 #include "update.h"
 #include "variable.h"
 #include "fmt/chrono.h"
@@ -637,6 +638,7 @@ void Info::command(int narg, char **arg)
                "  CPU time: {:4d}:{:02d}:{:02d}\n"
                " Wall time: {:4d}:{:02d}:{:02d}\n",
                cpuh,cpum,cpus,wallh,wallm,walls);
+    timer->print_sub(out);
   }
 
   if (flags & STYLES) {
@@ -35,7 +35,7 @@ class Min : protected Pointers {
   virtual void setup_minimal(int);
   virtual void run(int);
   virtual void force_clear();
-  void cleanup();
+  virtual void cleanup();
   int request(class Pair *, int, double);
   virtual double memory_usage() { return 0; }
   void modify_params(int, char **);
@@ -60,6 +60,7 @@ Pair::Pair(LAMMPS *lmp) : Pointers(lmp)
   single_enable = 1;
   born_matrix_enable = 0;
   single_hessian_enable = 0;
+  single_spin_enable = 0;
   restartinfo = 1;
   respa_enable = 0;
   one_coeff = 0;
@@ -12,7 +12,9 @@ PairStyle(deepmd,PairDeepMD)
 #define LMP_PAIR_NNP_H
 
 #include "pair.h"
-#ifdef LMPPLUGIN
+#if defined(DEEPMD_REF)
+#include "deepmd_ref.h"
+#elif defined(LMPPLUGIN)
 #include "DeepPot.h"
 #else
 #include "deepmd/DeepPot.h"
@@ -51,6 +53,7 @@ class PairDeepMD : public Pair {
   PairDeepMD(class LAMMPS *);
   ~PairDeepMD() override;
   void compute(int, int) override;
+  void compute_single_spin(int, double *) override;
   void *extract(const char *, int &) override;
   void settings(int, char **) override;
   void coeff(int, char **) override;
@@ -62,26 +65,36 @@ class PairDeepMD : public Pair {
   void unpack_reverse_comm(int, int *, double *) override;
   void print_summary(const std::string pre) const;
   int get_node_rank();
+  MPI_Comm node_comm;    // procs sharing a node, built by get_node_rank()
+  int node_rank;
+  double load_time;      // wall time and bytes of model loading
+  bigint load_bytes;
   void extend(int &                             extend_inum,
                 std::vector<int> &                extend_ilist,
                 std::vector<int> &                extend_numneigh,
-                std::vector<std::vector<int>> &   extend_neigh,
+                std::vector<int> &                extend_neigh,
                 std::vector<int *> &              extend_firstneigh,
-                std::vector<double> &	            extend_coord,
+                std::vector<FLOAT_PREC> &	        extend_coord,
                 std::vector<int> &		        extend_atype,
                 int &			                    extend_nghost,
-                std::map<int, int> &              new_idx_map,
-                std::map<int, int> &              old_idx_map,
+                std::vector<int> &                new_idx_map,
+                std::vector<int> &                old_idx_map,
                 const deepmd::InputNlist &	    lmp_list,
-                const std::vector<double> &	    coord,
                 const std::vector<int> &		    atype,
                 const int			                nghost,
-                const std::vector<double> &	    spin,
                 const int                         numb_types,
-                const int                         numb_types_spin,
-                const std::vector<double> &       virtual_len,
-                const std::vector<double> &       dspin_norm);
-  void cum_sum (std::map<int, int> &, std::map<int, int> &);
+                const int                         numb_types_spin);
+  void cum_sum (std::vector<int> &, const std::vector<int> &);
+  void split_extend_force(std::vector<FLOAT_PREC> &,
+                          std::vector<FLOAT_PREC> &,
+                          const std::vector<FLOAT_PREC> &,
+                          const int, const int);
+  void fold_extend(std::vector<FLOAT_PREC> &,
+                   const std::vector<FLOAT_PREC> &,
+                   const int, const int, const int);
+  void cluster_bin();
+  int cluster_extend(std::vector<int> &, const int, int &);
+  void pseudo_coord(int, double *);
 
   std::string get_file_content(const std::string & model);
   std::vector<std::string> get_file_content(const std::vector<std::string> & models);
@@ -94,9 +107,11 @@ private:
   deepmd::DeepPotModelDevi deep_pot_model_devi;
   unsigned numb_models;
   double cutoff;
+  double cut_spin;    // range over which two spins share a force evaluation
   int numb_types;
   int numb_types_spin;
-  std::vector<std::vector<double > > all_force;
+  std::vector<std::vector<FLOAT_PREC > > all_force;
+  std::vector<std::vector<FLOAT_PREC > > all_force_mag;
   std::ofstream fp;
   int out_freq;
   std::string out_file;
@@ -114,14 +129,48 @@ private:
   int extend_inum;
   std::vector<int> extend_ilist;
   std::vector<int> extend_numneigh;
-  std::vector<std::vector<int> > extend_neigh;
+  std::vector<int> extend_neigh;
   std::vector<int *> extend_firstneigh;
-  std::vector<double> extend_dcoord;
+  std::vector<FLOAT_PREC> extend_dcoord;
   std::vector<int> extend_dtype;
+  // model inputs and outputs of compute(), kept between calls so that
+  // repeated evaluations do not reallocate, in the precision of the model
+  std::vector<int> dtype;
+  std::vector<FLOAT_PREC> dcoord;
+  std::vector<FLOAT_PREC> dbox;
+  std::vector<FLOAT_PREC> daparam;
+  std::vector<FLOAT_PREC> dforce;
+  std::vector<FLOAT_PREC> dvirial;
+  std::vector<FLOAT_PREC> deatom;
+  std::vector<FLOAT_PREC> dvatom;
+  std::vector<FLOAT_PREC> extend_deatom;
+  std::vector<FLOAT_PREC> extend_dvatom;
   int extend_nghost;
+  // neighbor list build and real-atom counts the cached extended topology
+  // was built for, it is only rebuilt together with the lammps neighbor list
+  bigint extend_stamp;
+  int extend_nloc_real;
+  int extend_nghost_real;
   // for spin systems, search new index of atoms by their old index
-  std::map<int, int> new_idx_map;
-  std::map<int, int> old_idx_map;
+  std::vector<int> new_idx_map;
+  std::vector<int> old_idx_map;
+  // for single-spin updates, the cluster of positions around one pseudo atom
+  // the model is evaluated on, and the bins used to collect it
+  bool cluster_bin_stale;
+  bool model_nlist_stale;
+  int cluster_nbin[3];
+  double cluster_binlo[3];
+  double cluster_binsize;
+  std::vector<int> cluster_binhead;
+  std::vector<int> cluster_next;
+  std::vector<FLOAT_PREC> cluster_dcoord;
+  std::vector<int> cluster_dtype;
+  std::vector<int> cluster_center;
+  std::vector<int> cluster_env;
+  std::vector<int> cluster_ilist;
+  std::vector<int> cluster_numneigh;
+  std::vector<int> cluster_neigh;
+  std::vector<int *> cluster_firstneigh;
 #ifdef HIGH_PREC
   std::vector<double > fparam;
   std::vector<double > aparam;
@@ -164,6 +213,22 @@ private:
   int *counts,*displacements;
   tagint *tagsend, *tagrecv;
   double *stdfsend, *stdfrecv;
+  int nmax_devi;
+  // energy of the pseudo atom of each local spin, set with the per-atom
+  // energies and returned by extract("emag")
+  double *emag;
+  int nmax_emag;
+  void pseudo_energy(const std::vector<FLOAT_PREC> &, const int);
+  int t_pack, t_eval, t_scatter, t_devi, t_output;    // sub-timer ids
+  // binary per-atom deviations, written in parallel with MPI-IO
+  int out_atomic_binary;
+  std::string out_atomic_file;
+  double out_atomic_thresh;
+  MPI_File atomic_fh;
+  MPI_Offset atomic_offset;
+  std::vector<char> atomic_buf;
+  void write_atomic_devi(const std::vector<double> &,
+                         const std::vector<double> &);
   std::vector<int> type_idx_map;
 };
 
@@ -26,12 +26,14 @@ namespace LAMMPS_NS {
 
 class PairHybrid : public Pair {
   friend class ComputeSpin;
+  friend class ComputeSpinChunk;
   friend class FixGPU;
   friend class FixIntel;
   friend class FixNVESpin;
   friend class FixOMP;
   friend class Force;
   friend class Info;
+  friend class MinSpinLattice;
   friend class Neighbor;
   friend class PairDeprecated;
   friend class Respa;
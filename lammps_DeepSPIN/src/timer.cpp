@@ -17,6 +17,7 @@
 #include "error.h"
 #include "fmt/chrono.h"
 
+#include <algorithm>
 #include <cstring>
 
 using namespace LAMMPS_NS;
@@ -42,6 +43,67 @@ void Timer::init()
     cpu_array[i] = 0.0;
     wall_array[i] = 0.0;
   }
+  std::fill(sub_wall.begin(), sub_wall.end(), 0.0);
+  std::fill(sub_count.begin(), sub_count.end(), 0);
+  std::fill(sub_hist.begin(), sub_hist.end(), 0);
+}
+
+/* ----------------------------------------------------------------------
+   return index of the sub-timer with this name, create it if needed
+   all procs must add the same sub-timers in the same order
+------------------------------------------------------------------------- */
+
+int Timer::add_sub(const std::string &name)
+{
+  for (std::size_t i = 0; i < sub_name.size(); i++)
+    if (sub_name[i] == name) return i;
+
+  sub_name.push_back(name);
+  sub_wall.push_back(0.0);
+  sub_begin.push_back(0.0);
+  sub_count.push_back(0);
+  sub_hist.resize(sub_hist.size() + NUM_SUB_BINS, 0);
+  return sub_name.size() - 1;
+}
+
+/* ---------------------------------------------------------------------- */
+
+void Timer::_sub_stamp(int id, int start)
+{
+  const double current_wall = platform::walltime();
+
+  if (start) {
+    sub_begin[id] = current_wall;
+    return;
+  }
+
+  const double delta = current_wall - sub_begin[id];
+  sub_wall[id] += delta;
+  sub_count[id]++;
+
+  int bin = 0;
+  for (double edge = 1.0e-6; (bin < NUM_SUB_BINS - 1) && (delta >= edge); edge *= 10.0) bin++;
+  sub_hist[id * NUM_SUB_BINS + bin]++;
+}
+
+/* ----------------------------------------------------------------------
+   print the sub-timers of this proc
+------------------------------------------------------------------------- */
+
+void Timer::print_sub(FILE *fp)
+{
+  if (sub_name.empty()) return;
+
+  fmt::print(fp,
+             "\nSub-timers (MPI rank {}):\n"
+             "Name                  |   time   |   calls   | time/call\n"
+             "--------------------------------------------------------\n",
+             comm->me);
+  for (std::size_t i = 0; i < sub_name.size(); i++) {
+    const double percall = sub_count[i] ? sub_wall[i] / sub_count[i] : 0.0;
+    fmt::print(fp, "{:<21s} | {:<8.4g} | {:>9} | {:<10.4g}\n", sub_name[i], sub_wall[i],
+               sub_count[i], percall);
+  }
 }
 
 /* ---------------------------------------------------------------------- */
@@ -16,6 +16,9 @@
 
 #include "pointers.h"
 
+#include <string>
+#include <vector>
+
 namespace LAMMPS_NS {
 
 class Timer : protected Pointers {
@@ -103,6 +106,29 @@ class Timer : protected Pointers {
 
   void modify_params(int, char **);
 
+  // named sub-timers for stages inside a style, e.g. the parts of a pair
+  // compute(). they are accumulated with timer level normal or full,
+  // cleared with the other timers and reported by Finish and info time
+
+  enum { NUM_SUB_BINS = 9 };    // latency histogram: <1us, decades, >=10s
+
+  int add_sub(const std::string &);
+  void sub_start(int id)
+  {
+    if (_level > LOOP) _sub_stamp(id, 1);
+  }
+  void sub_stop(int id)
+  {
+    if (_level > LOOP) _sub_stamp(id, 0);
+  }
+
+  int get_num_sub() const { return sub_name.size(); }
+  const std::string &get_sub_name(int id) const { return sub_name[id]; }
+  double get_sub_wall(int id) const { return sub_wall[id]; }
+  bigint get_sub_count(int id) const { return sub_count[id]; }
+  const bigint *get_sub_hist(int id) const { return &sub_hist[id * NUM_SUB_BINS]; }
+  void print_sub(FILE *);
+
  private:
   double cpu_array[NUM_TIMER];
   double wall_array[NUM_TIMER];
@@ -116,9 +142,16 @@ class Timer : protected Pointers {
   int _checkfreq;    // frequency of timeout checking
   int _nextcheck;    // loop number of next timeout check
 
+  std::vector<std::string> sub_name;
+  std::vector<double> sub_wall, sub_begin;
+  std::vector<bigint> sub_count, sub_hist;
+
   // update one specific timer array
   void _stamp(enum ttype);
 
+  // start or stop one sub-timer
+  void _sub_stamp(int, int);
+
   // check for timeout
   bool _check_timeout();
 };
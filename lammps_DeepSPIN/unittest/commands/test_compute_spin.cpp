@@ -0,0 +1,182 @@
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   https://www.lammps.org/, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+// unit tests for the magnetic energies of compute spin and compute spin/chunk
+
+#include "../testing/core.h"
+#include "atom.h"
+#include "compute.h"
+#include "force.h"
+#include "info.h"
+#include "input.h"
+#include "lammps.h"
+#include "library.h"
+#include "modify.h"
+#include "pair.h"
+#include "utils.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <cstring>
+#include <mpi.h>
+#include <vector>
+
+// whether to print verbose output (i.e. not capturing LAMMPS screen output).
+bool verbose = false;
+
+using LAMMPS_NS::utils::split_words;
+
+#define STRINGIFY(val) XSTR(val)
+#define XSTR(val) #val
+
+namespace LAMMPS_NS {
+
+class ComputeSpinTest : public LAMMPSTest {
+protected:
+    void SetUp() override
+    {
+        testbinary = "ComputeSpinTest";
+        LAMMPSTest::SetUp();
+        if (!info->has_style("atom", "spin")) GTEST_SKIP();
+    }
+
+    // the Fe/Co system of the force style tests with pair style ps
+
+    void InitSystem(const std::string &ps)
+    {
+        const std::string input_dir = STRINGIFY(TEST_INPUT_FOLDER);
+        BEGIN_HIDE_OUTPUT();
+        command("variable input_dir index " + input_dir);
+        command("variable pair_style index '" + ps + "'");
+        command("include " + input_dir + "/in.spin");
+        END_HIDE_OUTPUT();
+    }
+
+    // one chunk holding all atoms and two chunks along x, with the global
+    // values evaluated by thermo on the setup step
+
+    void RunComputes()
+    {
+        BEGIN_HIDE_OUTPUT();
+        command("fix spin all nve/spin lattice moving");
+        command("compute one all chunk/atom bin/1d x lower 1.0 units reduced");
+        command("compute two all chunk/atom bin/1d x lower 0.5 units reduced");
+        command("compute mag all spin");
+        command("compute mag1 all spin/chunk one");
+        command("compute mag2 all spin/chunk two");
+        command("thermo_style custom step c_mag[*] c_mag1[1][5] c_mag2[1][5] c_mag2[2][5]");
+        command("run 0 post no");
+        END_HIDE_OUTPUT();
+    }
+
+    double *get_vector(const char *id)
+    {
+        return (double *)lammps_extract_compute(lmp, id, LMP_STYLE_GLOBAL, LMP_TYPE_VECTOR);
+    }
+
+    double **get_array(const char *id)
+    {
+        return (double **)lammps_extract_compute(lmp, id, LMP_STYLE_GLOBAL, LMP_TYPE_ARRAY);
+    }
+
+    // the values of the chunks must add up to those of compute spin
+
+    void CompareChunks()
+    {
+        auto mag  = get_vector("mag");
+        auto mag1 = get_array("mag1");
+        auto mag2 = get_array("mag2");
+
+        for (int k = 0; k < 6; ++k)
+            EXPECT_NEAR(mag1[0][k], mag[k], 1.0e-12 * (1.0 + std::fabs(mag[k])));
+        EXPECT_NEAR(mag2[0][4] + mag2[1][4], mag[4], 1.0e-12 * (1.0 + std::fabs(mag[4])));
+        EXPECT_NE(mag2[0][4], 0.0);
+        EXPECT_NE(mag2[1][4], 0.0);
+    }
+};
+
+TEST_F(ComputeSpinTest, pair_spin)
+{
+    InitSystem("hybrid/overlay spin/exchange 3.0 spin/dmi 3.0");
+    BEGIN_HIDE_OUTPUT();
+    command("pair_coeff * * spin/exchange exchange 3.0 0.02726 0.2171 1.841");
+    command("pair_coeff * * spin/dmi dmi 3.0 0.001 1.0 0.0 0.0");
+    command("fix prec all precession/spin zeeman 1.0 0.0 0.0 1.0");
+    END_HIDE_OUTPUT();
+    RunComputes();
+    CompareChunks();
+}
+
+TEST_F(ComputeSpinTest, pair_deepmd)
+{
+    if (!info->has_style("pair", "deepmd")) GTEST_SKIP();
+
+    const std::string input_dir = STRINGIFY(TEST_INPUT_FOLDER);
+    InitSystem("deepmd " + input_dir + "/deepmd_ref.FeCo virtual_len 0.4 spin_norm 2.2");
+    BEGIN_HIDE_OUTPUT();
+    command("pair_coeff * *");
+    END_HIDE_OUTPUT();
+    RunComputes();
+    CompareChunks();
+
+    // the magnetic energy is that of the pseudo atoms of pair deepmd
+
+    int dim;
+    auto emag   = (double *)lmp->force->pair->extract("emag", dim);
+    double esum = 0.0;
+    for (int i = 0; i < lmp->atom->nlocal; ++i) esum += emag[i];
+    auto mag = get_vector("mag");
+    EXPECT_NE(esum, 0.0);
+    EXPECT_NEAR(mag[4], esum, 1.0e-12 * (1.0 + std::fabs(esum)));
+}
+
+TEST_F(ComputeSpinTest, stale_energy)
+{
+    // the magnetic energies are only tallied on timesteps where energies
+    // are requested, compute spin must not use those of another timestep
+
+    if (!Info::has_exceptions()) GTEST_SKIP();
+    InitSystem("spin/exchange 3.0");
+    BEGIN_HIDE_OUTPUT();
+    command("pair_coeff * * exchange 3.0 0.02726 0.2171 1.841");
+    command("fix spin all nve/spin lattice moving");
+    command("compute mag all spin");
+    command("run 1 post no");
+    END_HIDE_OUTPUT();
+    TEST_FAILURE(".*ERROR.*Per-atom energy was not tallied on needed timestep.*",
+                 lmp->modify->get_compute_by_id("mag")->compute_vector(););
+}
+} // namespace LAMMPS_NS
+
+int main(int argc, char **argv)
+{
+    MPI_Init(&argc, &argv);
+    ::testing::InitGoogleMock(&argc, argv);
+
+    // handle arguments passed via environment variable
+    if (const char *var = getenv("TEST_ARGS")) {
+        std::vector<std::string> env = split_words(var);
+        for (auto arg : env) {
+            if (arg == "-v") {
+                verbose = true;
+            }
+        }
+    }
+
+    if ((argc > 1) && (strcmp(argv[1], "-v") == 0)) verbose = true;
+
+    int rv = RUN_ALL_TESTS();
+    MPI_Finalize();
+    return rv;
+}
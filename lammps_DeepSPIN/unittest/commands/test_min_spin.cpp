@@ -0,0 +1,313 @@
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   https://www.lammps.org/, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+// unit tests for the minimizers of the SPIN package
+
+#include "../testing/core.h"
+#include "atom.h"
+#include "info.h"
+#include "input.h"
+#include "lammps.h"
+#include "update.h"
+#include "utils.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mpi.h>
+#include <sstream>
+#include <vector>
+
+// whether to print verbose output (i.e. not capturing LAMMPS screen output).
+bool verbose = false;
+
+using LAMMPS_NS::utils::split_words;
+using ::testing::ContainsRegex;
+using ::testing::Not;
+
+namespace LAMMPS_NS {
+
+class MinSpinTest : public LAMMPSTest {
+protected:
+    void SetUp() override
+    {
+        testbinary = "MinSpinTest";
+        LAMMPSTest::SetUp();
+        if (!info->has_style("atom", "spin")) GTEST_SKIP();
+
+        // distorted bcc iron, the morse pair style binds the lattice and
+        // spin/exchange adds a position dependent magnetic energy
+
+        BEGIN_HIDE_OUTPUT();
+        command("units           metal");
+        command("atom_style      spin");
+        command("atom_modify     map array");
+        command("boundary        p p p");
+        command("lattice         bcc 2.8665");
+        command("region          box block 0 3 0 3 0 3");
+        command("create_box      1 box");
+        command("create_atoms    1 box");
+        command("mass            1 55.845");
+        command("displace_atoms  all random 0.1 0.1 0.1 4123");
+        command("set             group all spin/random 31 2.2");
+        command("pair_style      hybrid/overlay morse 4.5 spin/exchange 3.5");
+        command("pair_coeff      * * morse 0.4174 1.3885 2.845");
+        command("pair_coeff      * * spin/exchange exchange 3.5 0.02726 0.2171 1.841");
+        command("neighbor        0.1 bin");
+        command("variable        pe equal pe");
+        command("thermo_style    custom step pe");
+        END_HIDE_OUTPUT();
+    }
+
+    double get_energy()
+    {
+        BEGIN_HIDE_OUTPUT();
+        command("run 0 post no");
+        END_HIDE_OUTPUT();
+        return get_variable_value("pe");
+    }
+
+    // forces of the last evaluation, indexed by atom ID
+
+    std::vector<double> get_forces()
+    {
+        std::vector<double> f(3 * lmp->atom->natoms);
+        for (int i = 0; i < lmp->atom->nlocal; ++i)
+            for (int k = 0; k < 3; ++k)
+                f[3 * (lmp->atom->tag[i] - 1) + k] = lmp->atom->f[i][k];
+        return f;
+    }
+
+    // spins, indexed by atom ID
+
+    std::vector<double> get_spins()
+    {
+        std::vector<double> sp(3 * lmp->atom->natoms);
+        for (int i = 0; i < lmp->atom->nlocal; ++i)
+            for (int k = 0; k < 3; ++k)
+                sp[3 * (lmp->atom->tag[i] - 1) + k] = lmp->atom->sp[i][k];
+        return sp;
+    }
+
+    // pair spin/exchange does not write its coefficients to restart
+    // files, so they are set again
+
+    void read_restart(const std::string &file)
+    {
+        command("clear");
+        command("read_restart " + file);
+        command("pair_coeff * * morse 0.4174 1.3885 2.845");
+        command("pair_coeff * * spin/exchange exchange 3.5 0.02726 0.2171 1.841");
+        command("min_style spin/lbfgs");
+    }
+
+    // central difference of the energy along direction dim of atom with ID tag
+
+    double fd_force(int tag, int dim, double delta)
+    {
+        const char *dirs[3] = {"{} 0 0", "0 {} 0", "0 0 {}"};
+        BEGIN_HIDE_OUTPUT();
+        command(fmt::format("group fd_one id {}", tag));
+        command("displace_atoms fd_one move " + fmt::format(dirs[dim], delta) + " units box");
+        END_HIDE_OUTPUT();
+        const double eplus = get_energy();
+        BEGIN_HIDE_OUTPUT();
+        command("displace_atoms fd_one move " + fmt::format(dirs[dim], -2.0 * delta) +
+                " units box");
+        END_HIDE_OUTPUT();
+        const double eminus = get_energy();
+        BEGIN_HIDE_OUTPUT();
+        command("displace_atoms fd_one move " + fmt::format(dirs[dim], delta) + " units box");
+        command("group fd_one delete");
+        END_HIDE_OUTPUT();
+        return -(eplus - eminus) / (2.0 * delta);
+    }
+};
+
+TEST_F(MinSpinTest, lattice_energy)
+{
+    const double einit = get_energy();
+
+    BEGIN_HIDE_OUTPUT();
+    command("min_style spin/lattice");
+    command("minimize 0.0 1.0e-8 50 1000");
+    END_HIDE_OUTPUT();
+    EXPECT_LT(get_energy(), einit - 1.0e-3);
+}
+
+TEST_F(MinSpinTest, lattice_forces)
+{
+    // forces of the setup of a minimization without iterations, they
+    // include the mechanical forces of spin/exchange
+
+    BEGIN_HIDE_OUTPUT();
+    command("min_style spin/lattice");
+    command("minimize 0.0 0.0 0 0");
+    END_HIDE_OUTPUT();
+    std::vector<double> f = get_forces();
+
+    for (int tag : {1, 17, 40}) {
+        for (int k = 0; k < 3; ++k) {
+            EXPECT_NEAR(fd_force(tag, k, 1.0e-4), f[3 * (tag - 1) + k], 1.0e-6);
+        }
+    }
+
+    // spin/exchange is back to a frozen lattice after the minimization,
+    // so it adds no force to those of the morse pair style
+
+    get_energy();
+    std::vector<double> fhybrid = get_forces();
+    BEGIN_HIDE_OUTPUT();
+    command("pair_style morse 4.5");
+    command("pair_coeff * * 0.4174 1.3885 2.845");
+    END_HIDE_OUTPUT();
+    get_energy();
+    std::vector<double> fmorse = get_forces();
+    for (std::size_t i = 0; i < fmorse.size(); ++i)
+        EXPECT_NEAR(fhybrid[i], fmorse[i], 1.0e-12);
+}
+
+TEST_F(MinSpinTest, fire_maxrot)
+{
+    // spins of every iteration, with the default limit of the rotation
+    // of a spin in one step of 2pi/100, without the half steps back
+    // so that each iteration rotates the spins once
+
+    BEGIN_HIDE_OUTPUT();
+    command("fix zeeman all precession/spin zeeman 1.0 0.0 0.0 1.0");
+    command("compute sp all property/atom spx spy spz");
+    command("dump spins all custom 1 min_spin_fire.dump id c_sp[1] c_sp[2] c_sp[3]");
+    command("dump_modify spins sort id format float %20.15g");
+    command("min_style spin/fire");
+    command("min_modify halfstepback no");
+    command("minimize 0.0 1.0e-8 200 1000");
+    command("undump spins");
+    END_HIDE_OUTPUT();
+
+    std::vector<std::vector<double>> frames;
+    std::ifstream dump("min_spin_fire.dump");
+    std::string line;
+    while (std::getline(dump, line)) {
+        if (line != "ITEM: ATOMS id c_sp[1] c_sp[2] c_sp[3]") continue;
+        frames.emplace_back();
+        for (int i = 0; i < lmp->atom->natoms; ++i) {
+            std::getline(dump, line);
+            std::istringstream values(line);
+            double tag, s[3];
+            values >> tag >> s[0] >> s[1] >> s[2];
+            frames.back().insert(frames.back().end(), s, s + 3);
+        }
+    }
+    dump.close();
+    remove("min_spin_fire.dump");
+    ASSERT_GT(frames.size(), 20);
+
+    const double maxrot = 2.0 * M_PI / 100.0;
+    double rotmax       = 0.0;
+    for (std::size_t n = 1; n < frames.size(); ++n) {
+        for (std::size_t i = 0; i < frames[n].size(); i += 3) {
+            double sdots = 0.0;
+            for (int k = 0; k < 3; ++k) sdots += frames[n][i + k] * frames[n - 1][i + k];
+            rotmax = std::max(rotmax, std::acos(std::min(sdots, 1.0)));
+        }
+    }
+    EXPECT_LE(rotmax, maxrot * (1.0 + 1.0e-6));
+
+    // the limit is reached in the course of the minimization
+
+    EXPECT_GT(rotmax, 0.5 * maxrot);
+}
+
+TEST_F(MinSpinTest, lbfgs_restart)
+{
+    // spins after 40 iterations of an uninterrupted minimization
+
+    BEGIN_HIDE_OUTPUT();
+    command("write_restart min_spin_lbfgs_0.restart");
+    command("min_style spin/lbfgs");
+    command("minimize 0.0 0.0 40 1000");
+    END_HIDE_OUTPUT();
+    ASSERT_EQ(lmp->update->ntimestep, 40);
+    std::vector<double> ref = get_spins();
+
+    // the same minimization stopped after 20 iterations and continued
+    // from a restart file, which holds the L-BFGS history
+
+    BEGIN_HIDE_OUTPUT();
+    read_restart("min_spin_lbfgs_0.restart");
+    command("minimize 0.0 0.0 20 1000");
+    command("write_restart min_spin_lbfgs_1.restart");
+    END_HIDE_OUTPUT();
+    std::vector<double> half = get_spins();
+
+    BEGIN_HIDE_OUTPUT();
+    read_restart("min_spin_lbfgs_1.restart");
+    END_HIDE_OUTPUT();
+    ::testing::internal::CaptureStdout();
+    command("minimize 0.0 0.0 20 1000");
+    auto mesg = ::testing::internal::GetCapturedStdout();
+    if (verbose) std::cout << mesg;
+    EXPECT_THAT(mesg, ContainsRegex(".*Resuming spin/lbfgs from.*"));
+    ASSERT_EQ(lmp->update->ntimestep, 40);
+    std::vector<double> spins = get_spins();
+
+    double dmax = 0.0;
+    for (std::size_t i = 0; i < ref.size(); ++i) {
+        EXPECT_NEAR(spins[i], ref[i], 1.0e-12);
+        dmax = std::max(dmax, std::fabs(half[i] - ref[i]));
+    }
+    EXPECT_GT(dmax, 1.0e-4);
+
+    // a restart file written before the first minimization holds no
+    // history, the minimization starts over as in the first part
+
+    BEGIN_HIDE_OUTPUT();
+    read_restart("min_spin_lbfgs_0.restart");
+    END_HIDE_OUTPUT();
+    ::testing::internal::CaptureStdout();
+    command("minimize 0.0 0.0 20 1000");
+    mesg = ::testing::internal::GetCapturedStdout();
+    if (verbose) std::cout << mesg;
+    EXPECT_THAT(mesg, Not(ContainsRegex(".*Resuming spin/lbfgs.*")));
+    spins = get_spins();
+    for (std::size_t i = 0; i < half.size(); ++i) EXPECT_NEAR(spins[i], half[i], 1.0e-12);
+
+    remove("min_spin_lbfgs_0.restart");
+    remove("min_spin_lbfgs_1.restart");
+}
+} // namespace LAMMPS_NS
+
+int main(int argc, char **argv)
+{
+    MPI_Init(&argc, &argv);
+    ::testing::InitGoogleMock(&argc, argv);
+
+    // handle arguments passed via environment variable
+    if (const char *var = getenv("TEST_ARGS")) {
+        std::vector<std::string> env = split_words(var);
+        for (auto arg : env) {
+            if (arg == "-v") {
+                verbose = true;
+            }
+        }
+    }
+
+    if ((argc > 1) && (strcmp(argv[1], "-v") == 0)) verbose = true;
+
+    int rv = RUN_ALL_TESTS();
+    MPI_Finalize();
+    return rv;
+}
@@ -0,0 +1,171 @@
+// unit tests for checking that the random field of fix langevin/spin
+// does not depend on the number of MPI processes
+
+#define LAMMPS_LIB_MPI 1
+#include "atom.h"
+#include "comm.h"
+#include "info.h"
+#include "input.h"
+#include "lammps.h"
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "../testing/test_mpi_main.h"
+
+using ::testing::ContainsRegex;
+
+namespace LAMMPS_NS {
+
+class MPILangevinSpinTest : public ::testing::Test {
+protected:
+    const char *testbinary = "LAMMPSTest";
+    LAMMPS *lmp;
+
+    void command(const std::string &line) { lmp->input->one(line); }
+
+    void SetUp() override
+    {
+        if (!LAMMPS::is_installed_pkg("SPIN")) GTEST_SKIP();
+    }
+
+    void CreateLammps(MPI_Comm comm)
+    {
+        const char *args[] = {testbinary, "-log", "none", "-echo", "screen", "-nocite"};
+        char **argv        = (char **)args;
+        int argc           = sizeof(args) / sizeof(char *);
+        if (!verbose) ::testing::internal::CaptureStdout();
+        lmp = new LAMMPS(argc, argv, comm);
+        if (!verbose) ::testing::internal::GetCapturedStdout();
+    }
+
+    void DeleteLammps()
+    {
+        if (!verbose) ::testing::internal::CaptureStdout();
+        delete lmp;
+        lmp = nullptr;
+        if (!verbose) ::testing::internal::GetCapturedStdout();
+    }
+
+    void InitSystem(bool ids = true)
+    {
+        command("units           metal");
+        command("atom_style      spin");
+        if (ids)
+            command("atom_modify     map array");
+        else
+            command("atom_modify     id no");
+        command("boundary        p p p");
+        command("lattice         bcc 2.8665");
+        command("region          box block 0 4 0 4 0 4");
+        command("create_box      1 box");
+        command("create_atoms    1 box");
+        command("mass            1 55.845");
+        command("set             group all spin 2.2 0.0 0.0 1.0");
+        if (ids) {
+            command("set             atom 1*40 spin 2.2 1.0 0.0 0.0");
+            command("set             atom 80*128 spin 2.2 0.0 1.0 1.0");
+        }
+
+        // with a zero exchange the spins evolve independently, so the
+        // trajectory does not depend on the order of the spin advances
+
+        command("pair_style      spin/exchange 3.5");
+        command("pair_coeff      * * exchange 3.5 0.0 0.2171 1.841");
+        command("neighbor        0.1 bin");
+    }
+
+    // spins after a short noise-driven run, indexed by atom ID
+
+    std::vector<double> RunSpins(MPI_Comm comm, const std::string &update)
+    {
+        CreateLammps(comm);
+        if (!verbose) ::testing::internal::CaptureStdout();
+        InitSystem();
+        command("fix             1 all precession/spin zeeman 1.0 0.0 0.0 1.0");
+        command("fix             2 all langevin/spin 300.0 0.1 21");
+        command("fix             3 all nve/spin lattice frozen update " + update);
+        command("run             20 post no");
+        if (!verbose) ::testing::internal::GetCapturedStdout();
+
+        std::vector<double> local(3 * lmp->atom->natoms, 0.0);
+        std::vector<double> spins(3 * lmp->atom->natoms, 0.0);
+        for (int i = 0; i < lmp->atom->nlocal; ++i) {
+            const int itag = lmp->atom->tag[i] - 1;
+            for (int k = 0; k < 3; ++k) local[3 * itag + k] = lmp->atom->sp[i][k];
+        }
+        MPI_Allreduce(local.data(), spins.data(), local.size(), MPI_DOUBLE, MPI_SUM, comm);
+        DeleteLammps();
+        return spins;
+    }
+
+    void CompareDecomposition(const std::string &update)
+    {
+        int me, nprocs;
+        MPI_Comm_rank(MPI_COMM_WORLD, &me);
+        MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+        ASSERT_EQ(nprocs, 4);
+
+        // reference run on a single process, broadcast to all
+
+        MPI_Comm single;
+        MPI_Comm_split(MPI_COMM_WORLD, (me == 0) ? 0 : MPI_UNDEFINED, 0, &single);
+        std::vector<double> ref;
+        int nref = 0;
+        if (me == 0) {
+            ref   = RunSpins(single, update);
+            nref  = ref.size();
+            MPI_Comm_free(&single);
+        }
+        MPI_Bcast(&nref, 1, MPI_INT, 0, MPI_COMM_WORLD);
+        ref.resize(nref);
+        MPI_Bcast(ref.data(), nref, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+        std::vector<double> spins = RunSpins(MPI_COMM_WORLD, update);
+        ASSERT_EQ(spins.size(), ref.size());
+        for (std::size_t i = 0; i < spins.size(); ++i)
+            EXPECT_DOUBLE_EQ(spins[i], ref[i]);
+
+        // the noise must have moved the spins away from the initial state
+
+        EXPECT_GT(std::abs(ref[0] - 1.0), 1.0e-3);
+    }
+};
+
+TEST_F(MPILangevinSpinTest, sequential)
+{
+    CompareDecomposition("sequential");
+}
+
+TEST_F(MPILangevinSpinTest, color)
+{
+    CompareDecomposition("color");
+}
+
+TEST_F(MPILangevinSpinTest, no_atom_ids)
+{
+    if (!Info::has_exceptions()) GTEST_SKIP();
+    CreateLammps(MPI_COMM_WORLD);
+    if (!verbose) ::testing::internal::CaptureStdout();
+    InitSystem(false);
+
+    // fix nve/spin needs an atom map, so integrate with fix nve
+    // to reach the check of fix langevin/spin
+
+    command("fix             1 all nve");
+    command("fix             2 all langevin/spin 300.0 0.1 21");
+    if (!verbose) ::testing::internal::GetCapturedStdout();
+
+    // the error message is only printed by the first process
+
+    ::testing::internal::CaptureStdout();
+    EXPECT_ANY_THROW(command("run 0 post no"););
+    auto mesg = ::testing::internal::GetCapturedStdout();
+    if (lmp->comm->me == 0)
+        EXPECT_THAT(mesg, ContainsRegex(".*ERROR: Fix langevin/spin requires atoms with IDs.*"));
+    DeleteLammps();
+}
+} // namespace LAMMPS_NS
@@ -0,0 +1,265 @@
+// unit tests for geodesic nudged elastic band calculations of neb/spin
+// on multiple partitions
+
+#define LAMMPS_LIB_MPI 1
+#include "atom.h"
+#include "comm.h"
+#include "fix_neb_spin.h"
+#include "info.h"
+#include "input.h"
+#include "lammps.h"
+#include "modify.h"
+#include "universe.h"
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "../testing/test_mpi_main.h"
+
+namespace LAMMPS_NS {
+
+// values of fix neb/spin kept for each replica
+
+enum { VENG, PLEN, NLEN, DOTPATH, DOTTANGRAD, GRADLEN, NVALUES };
+
+class MPINEBSpinTest : public ::testing::Test {
+protected:
+    const char *testbinary = "LAMMPSTest";
+    const char *inputfile  = "in.neb_spin";
+    const char *finalfile  = "neb_spin.final";
+    LAMMPS *lmp;
+
+    void command(const std::string &line) { lmp->input->one(line); }
+
+    void SetUp() override
+    {
+        if (!LAMMPS::is_installed_pkg("SPIN")) GTEST_SKIP();
+    }
+
+    void CreateLammps(MPI_Comm comm, const std::string &partition)
+    {
+        // multiple partitions need an input file, the commands are
+        // issued through the library interface instead
+
+        std::vector<std::string> words = {testbinary, "-in",     inputfile, "-log",  "none",
+                                          "-plog",    "none",    "-pscreen", "none", "-echo",
+                                          "none",     "-nocite", "-partition"};
+        auto sizes = utils::split_words(partition);
+        words.insert(words.end(), sizes.begin(), sizes.end());
+        std::vector<char *> argv;
+        for (auto &w : words) argv.push_back((char *)w.c_str());
+        if (!verbose) ::testing::internal::CaptureStdout();
+        lmp = new LAMMPS(argv.size(), argv.data(), comm);
+        if (!verbose) ::testing::internal::GetCapturedStdout();
+    }
+
+    void DeleteLammps()
+    {
+        if (!verbose) ::testing::internal::CaptureStdout();
+        delete lmp;
+        lmp = nullptr;
+        if (!verbose) ::testing::internal::GetCapturedStdout();
+    }
+
+    // an empty input file and the end point of the path: all spins
+    // reversed and tilted in different directions, so that the exchange
+    // pulls the replicas away from the initial path
+
+    void WriteFiles(MPI_Comm comm)
+    {
+        int me;
+        MPI_Comm_rank(comm, &me);
+        if (me == 0) {
+            FILE *fp = fopen(inputfile, "w");
+            fclose(fp);
+            fp = fopen(finalfile, "w");
+            fprintf(fp, "16\n");
+            for (int i = 0; i < 16; ++i) {
+                const double sx   = 0.3 * cos(0.4 * i);
+                const double sy   = 0.3 * sin(0.4 * i);
+                const double norm = 1.0 / sqrt(sx * sx + sy * sy + 1.0);
+                fprintf(fp, "%d 2.2 0.0 0.0 0.0 %.15g %.15g %.15g\n", i + 1, sx * norm,
+                        sy * norm, -norm);
+            }
+            fclose(fp);
+        }
+        MPI_Barrier(comm);
+    }
+
+    // 16 bcc Fe spins with ferromagnetic exchange and an easy z axis,
+    // so that the path is a coherent rotation over the anisotropy barrier
+
+    void InitSystem(const std::string &minstyle)
+    {
+        command("units           metal");
+        command("atom_style      spin");
+        command("atom_modify     map array");
+        command("boundary        p p p");
+        command("lattice         bcc 2.8665");
+        command("region          box block 0 2 0 2 0 2");
+        command("create_box      1 box");
+        command("create_atoms    1 box");
+        command("mass            1 55.845");
+        command("set             group all spin 2.2 -0.2 0.0 1.0");
+        command("pair_style      spin/exchange 3.5");
+        command("pair_coeff      * * exchange 3.5 0.02726 0.2171 1.841");
+        command("neighbor        0.1 bin");
+        command("fix             1 all precession/spin anisotropy 0.01 0.0 0.0 1.0");
+        command("fix_modify      1 energy yes");
+        command("fix             2 all neb/spin 1.0");
+        command("timestep        0.0001");
+        command("thermo          10");
+        command("min_style       " + minstyle);
+        command("min_modify      line spin_none");
+    }
+
+    // fix neb/spin values, spins and GNEB forces of all replicas after a
+    // GNEB run. the values are followed by the spins and the forces, both
+    // indexed by replica and atom ID
+
+    std::vector<double> RunNEB(MPI_Comm comm, const std::string &partition,
+                               const std::string &minstyle, int nsteps)
+    {
+        WriteFiles(comm);
+        CreateLammps(comm, partition);
+        if (!verbose) ::testing::internal::CaptureStdout();
+        InitSystem(minstyle);
+        command(fmt::format("neb/spin 0.0 0.0 {} 0 {} final {}", nsteps, nsteps, finalfile));
+        if (!verbose) ::testing::internal::GetCapturedStdout();
+
+        const int nreplica = lmp->universe->nworlds;
+        const int iworld   = lmp->universe->iworld;
+        const int natoms   = lmp->atom->natoms;
+        auto fneb          = dynamic_cast<FixNEBSpin *>(lmp->modify->get_fix_by_id("2"));
+        const int nvalues  = nreplica * NVALUES;
+
+        const int nspins          = 3 * nreplica * natoms;
+
+        std::vector<double> local(nvalues + 2 * nspins, 0.0);
+        std::vector<double> all(local.size(), 0.0);
+        if (lmp->comm->me == 0) {
+            double *v       = &local[iworld * NVALUES];
+            v[VENG]       = fneb->veng;
+            v[PLEN]       = fneb->plen;
+            v[NLEN]       = fneb->nlen;
+            v[DOTPATH]    = fneb->dotpath;
+            v[DOTTANGRAD] = fneb->dottangrad;
+            v[GRADLEN]    = fneb->gradlen;
+        }
+        for (int i = 0; i < lmp->atom->nlocal; ++i) {
+            const int itag = lmp->atom->tag[i] - 1;
+            for (int k = 0; k < 3; ++k) {
+                local[nvalues + 3 * (iworld * natoms + itag) + k]          = lmp->atom->sp[i][k];
+                local[nvalues + nspins + 3 * (iworld * natoms + itag) + k] = lmp->atom->fm[i][k];
+            }
+        }
+        MPI_Allreduce(local.data(), all.data(), local.size(), MPI_DOUBLE, MPI_SUM, comm);
+        DeleteLammps();
+
+        int me;
+        MPI_Comm_rank(comm, &me);
+        if (me == 0) {
+            remove(inputfile);
+            remove(finalfile);
+        }
+        return all;
+    }
+
+    // norms of the GNEB forces of each replica, which are projected
+    // with the tangent of the path
+
+    std::vector<double> ForceNorms(const std::vector<double> &all, int nreplica, int natoms)
+    {
+        const int nspins = 3 * nreplica * natoms;
+        const double *fm = &all[nreplica * NVALUES + nspins];
+        std::vector<double> norms(nreplica, 0.0);
+        for (int i = 0; i < nspins; ++i) norms[i / (3 * natoms)] += fm[i] * fm[i];
+        for (auto &norm : norms) norm = sqrt(norm);
+        return norms;
+    }
+
+    // values of the end points that are not defined by the method
+    // (e.g. the length to the previous replica of the first one) are zero
+
+    void CompareValues(const std::vector<double> &values, const double *ref, int nref,
+                       double epsilon)
+    {
+        ASSERT_GE(values.size(), (std::size_t)nref);
+        for (int i = 0; i < nref; ++i)
+            EXPECT_NEAR(values[i], ref[i], epsilon * (1.0 + std::fabs(ref[i])))
+                << "value " << i % NVALUES << " of replica " << i / NVALUES;
+    }
+};
+
+// spin/lbfgs on four single process replicas. the reference values were
+// obtained with the per-product reductions of spin/lbfgs, before they were
+// batched into a Gram matrix. in both the end points do not contribute to
+// any of the dot products, or the path is a different one after a few steps
+
+TEST_F(MPINEBSpinTest, lbfgs)
+{
+    int nprocs;
+    MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+    ASSERT_EQ(nprocs, 4);
+
+    const double ref[4 * NVALUES] = {
+        -1.9324922309022021, 0.0, 3.6260016784984308, 0.0, -0.013822785478918421,
+        1468.1724381395502,
+        -1.8110706408992878, 3.6260016784984308, 4.1713506532935982, 0.71943000933080437,
+        -0.035490539954827767, 1376.6178746257449,
+        -1.825919648397039, 4.1713506532935982, 4.1505379581970612, 0.64196186453825888,
+        0.041095436979747012, 1388.2049952724119,
+        -1.7737630297059521, 4.1505379581970612, 0.0, 0.0, -0.046757243464525228,
+        1411.4339541228608};
+
+    auto values = RunNEB(MPI_COMM_WORLD, "4x1", "spin/lbfgs", 20);
+    CompareValues(values, ref, 4 * NVALUES, 1.0e-10);
+}
+
+// the default GNEB minimizer on three replicas, once with a single process
+// per replica and once with two processes for the middle replica. the
+// reference values were obtained with the former blocking exchange between
+// single process replicas. the tangent of the path enters the GNEB forces,
+// so their norms are compared as well. with two processes per replica, the
+// former exchange gave the middle replica a force norm of 6.66
+
+TEST_F(MPINEBSpinTest, spin)
+{
+    int nprocs, me;
+    MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &me);
+    ASSERT_EQ(nprocs, 4);
+
+    const double ref[3 * NVALUES] = {
+        -1.9378882261997301, 0.0, 6.0687080640072066, 0.0, -0.0037138859820455166,
+        1472.1090073375105,
+        -1.7786817980744596, 6.0687080640072066, 6.2309463663770055, 0.42247247646238856,
+        0.0013439544600389805, 1351.14799486677,
+        -1.9386455085468874, 6.2309463663770055, 0.0, 0.0, -9.9756308330666078e-05,
+        1472.6606295393647};
+    const double fmref[3] = {1472.1090073375103, 1.8163532496870787, 1472.6606295393647};
+
+    // three replicas on the first three procs
+
+    MPI_Comm comm;
+    MPI_Comm_split(MPI_COMM_WORLD, (me < 3) ? 0 : MPI_UNDEFINED, me, &comm);
+    if (comm != MPI_COMM_NULL) {
+        auto values = RunNEB(comm, "3x1", "spin", 20);
+        CompareValues(values, ref, 3 * NVALUES, 1.0e-10);
+        auto fmnorms = ForceNorms(values, 3, 16);
+        for (int i = 0; i < 3; ++i)
+            EXPECT_NEAR(fmnorms[i], fmref[i], 1.0e-10 * fmref[i]) << "replica " << i;
+        MPI_Comm_free(&comm);
+    }
+
+    auto values = RunNEB(MPI_COMM_WORLD, "1 2 1", "spin", 20);
+    CompareValues(values, ref, 3 * NVALUES, 1.0e-10);
+    auto fmnorms = ForceNorms(values, 3, 16);
+    for (int i = 0; i < 3; ++i)
+        EXPECT_NEAR(fmnorms[i], fmref[i], 1.0e-10 * fmref[i]) << "replica " << i;
+}
+} // namespace LAMMPS_NS
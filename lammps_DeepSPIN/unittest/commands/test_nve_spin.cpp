@@ -0,0 +1,523 @@
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   https://www.lammps.org/, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+// unit tests for the force keyword of fix nve/spin with pair style deepmd
+// and for fix nve/spin/midpoint, the substeps of fix nve/spin and the
+// fields and energies of fix precession/spin on its timesteps
+
+#include "../testing/core.h"
+#include "atom.h"
+#include "fix.h"
+#include "fix_precession_spin.h"
+#include "force.h"
+#include "info.h"
+#include "input.h"
+#include "lammps.h"
+#include "math_const.h"
+#include "modify.h"
+#include "output.h"
+#include "update.h"
+#include "utils.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <cstring>
+#include <mpi.h>
+#include <vector>
+
+// whether to print verbose output (i.e. not capturing LAMMPS screen output).
+bool verbose = false;
+
+using LAMMPS_NS::utils::split_words;
+using ::testing::ContainsRegex;
+using ::testing::Not;
+
+#define STRINGIFY(val) XSTR(val)
+#define XSTR(val) #val
+
+namespace LAMMPS_NS {
+
+class NVESpinTest : public LAMMPSTest {
+protected:
+    void SetUp() override
+    {
+        testbinary = "NVESpinTest";
+        LAMMPSTest::SetUp();
+        if (!info->has_style("atom", "spin")) GTEST_SKIP();
+    }
+
+    // the Fe/Co system of the force style tests with ferromagnetic exchange
+    // and a Zeeman field, both included in the potential energy, or with
+    // no magnetic pair interaction and a Zeeman field and an anisotropy
+
+    void InitSpin(bool exchange = true)
+    {
+        const std::string input_dir = STRINGIFY(TEST_INPUT_FOLDER);
+        BEGIN_HIDE_OUTPUT();
+        command("clear");
+        command("variable input_dir index " + input_dir);
+
+        // variables are kept by clear, a string variable can be set again
+
+        if (exchange) {
+            command("variable pair_style string 'spin/exchange 3.0'");
+            command("include " + input_dir + "/in.spin");
+            command("pair_coeff * * exchange 3.0 0.02726 0.2171 1.841");
+            command("fix prec all precession/spin zeeman 1.0 0.0 0.0 1.0");
+        } else {
+            command("variable pair_style string 'zero 8.0'");
+            command("include " + input_dir + "/in.spin");
+            command("pair_coeff * *");
+            command("fix prec all precession/spin zeeman 1.0 0.0 0.0 1.0 "
+                    "anisotropy 0.01 1.0 1.0 0.0");
+        }
+        command("fix_modify prec energy yes");
+        command("variable pe equal pe");
+        command("thermo_style custom step pe");
+        END_HIDE_OUTPUT();
+    }
+
+    // spins, indexed by atom ID
+
+    std::vector<double> GetSpins()
+    {
+        auto atom = lmp->atom;
+        std::vector<double> sp(3 * atom->natoms);
+        for (int i = 0; i < atom->nlocal; ++i)
+            for (int k = 0; k < 3; ++k) sp[3 * (atom->tag[i] - 1) + k] = atom->sp[i][k];
+        return sp;
+    }
+
+    // largest deviation of the potential energy from its initial value,
+    // sampled every 10 steps of a run of nsteps with a frozen lattice
+
+    double EnergyDrift(const std::string &style, double dt, int nsteps)
+    {
+        InitSpin();
+        BEGIN_HIDE_OUTPUT();
+        command("fix spin all " + style + " lattice frozen");
+        command(fmt::format("timestep {}", dt));
+        command("fix pe all vector 10 v_pe");
+        command(fmt::format("run {} post no", nsteps));
+        END_HIDE_OUTPUT();
+
+        auto fix         = lmp->modify->get_fix_by_id("pe");
+        const double pe0 = fix->compute_vector(0);
+        double drift     = 0.0;
+        for (int n = 1; n <= nsteps / 10; ++n)
+            drift = std::max(drift, std::fabs(fix->compute_vector(n) - pe0));
+        return drift;
+    }
+
+    // the magnetic forces and energies of fix prec of InitSpin(false) must
+    // be those of its Zeeman and anisotropy terms for the current spins,
+    // the energies only if they are tallied
+
+    void CheckPrecession(bool energy)
+    {
+        const double hbar = lmp->force->hplanck / MathConst::MY_2PI;
+        const double mub  = 5.78901e-5;
+        const double ka   = 0.01;
+        const double ax   = sqrt(0.5);
+        const double ay   = sqrt(0.5);
+
+        auto atom  = lmp->atom;
+        auto prec  = dynamic_cast<FixPrecessionSpin *>(lmp->modify->get_fix_by_id("prec"));
+        double sum = 0.0;
+        for (int i = 0; i < atom->nlocal; ++i) {
+            const double *s     = atom->sp[i];
+            const double scalar = ax * s[0] + ay * s[1];
+            const double fx     = 2.0 * ka / hbar * scalar * ax;
+            const double fy     = 2.0 * ka / hbar * scalar * ay;
+            const double fz     = s[3] * 2.0 * mub / hbar;
+            const double ei     = -2.0 * mub * s[3] * s[2] - ka * scalar * scalar;
+            EXPECT_NEAR(atom->fm[i][0], fx, 1.0e-12 * (1.0 + std::fabs(fx)));
+            EXPECT_NEAR(atom->fm[i][1], fy, 1.0e-12 * (1.0 + std::fabs(fy)));
+            EXPECT_NEAR(atom->fm[i][2], fz, 1.0e-12 * (1.0 + std::fabs(fz)));
+            if (energy) EXPECT_NEAR(prec->emag[i], ei, 1.0e-14);
+            sum += ei;
+        }
+        if (energy) EXPECT_NEAR(prec->compute_scalar(), sum, 1.0e-12);
+    }
+
+    double GetScalar(const char *id)
+    {
+        return lmp->modify->get_fix_by_id(id)->compute_scalar();
+    }
+
+    // the Fe/Co system of the force style tests with the analytic spin
+    // model of the reference deepmd backend of cutoff rcut
+
+    void InitDeepSpin(const std::string &model, double cutghost)
+    {
+        const std::string input_dir = STRINGIFY(TEST_INPUT_FOLDER);
+        BEGIN_HIDE_OUTPUT();
+        command("clear");
+        command("variable input_dir index " + input_dir);
+        command("variable pair_style index 'deepmd " + input_dir + "/" + model +
+                " virtual_len 0.4 spin_norm 2.2'");
+        command("include " + input_dir + "/in.spin");
+        command("pair_coeff * *");
+        command(fmt::format("comm_modify cutoff {}", cutghost));
+        END_HIDE_OUTPUT();
+    }
+
+    // positions, velocities and spins after a run, indexed by atom ID
+
+    std::vector<double> RunState(const std::string &force, int nsteps)
+    {
+        InitDeepSpin("deepmd_ref.FeCo_r35", 8.0);
+        BEGIN_HIDE_OUTPUT();
+        command("fix spin all nve/spin lattice moving force " + force);
+        command(fmt::format("run {} post no", nsteps));
+        END_HIDE_OUTPUT();
+
+        auto atom = lmp->atom;
+        std::vector<double> state(9 * atom->natoms);
+        for (int i = 0; i < atom->nlocal; ++i) {
+            double *si = &state[9 * (atom->tag[i] - 1)];
+            for (int k = 0; k < 3; ++k) {
+                si[k]     = atom->x[i][k];
+                si[3 + k] = atom->v[i][k];
+                si[6 + k] = atom->sp[i][k];
+            }
+        }
+        return state;
+    }
+
+    // velocities after one step of the Co atoms, integrated by fix nve
+    // after the Fe atoms and their spins, indexed by atom ID
+
+    std::vector<double> RunOtherVelocities(const std::string &force)
+    {
+        InitDeepSpin("deepmd_ref.FeCo_r35", 8.0);
+        BEGIN_HIDE_OUTPUT();
+        command("group fe type 1");
+        command("group co type 2");
+        command("fix spin fe nve/spin lattice moving force " + force);
+        command("fix nve co nve");
+        command("run 1 post no");
+        END_HIDE_OUTPUT();
+
+        auto atom = lmp->atom;
+        std::vector<double> v(3 * atom->natoms, 0.0);
+        for (int i = 0; i < atom->nlocal; ++i)
+            if (atom->type[i] == 2)
+                for (int k = 0; k < 3; ++k) v[3 * (atom->tag[i] - 1) + k] = atom->v[i][k];
+        return v;
+    }
+};
+
+TEST_F(NVESpinTest, force_local)
+{
+    if (!info->has_style("pair", "deepmd")) GTEST_SKIP();
+
+    // the single-spin evaluations of the model must give the magnetic
+    // forces of the full evaluations, so both trajectories are the same
+
+    std::vector<double> init = RunState("full", 0);
+    std::vector<double> full = RunState("full", 10);
+    std::vector<double> local = RunState("local", 10);
+    ASSERT_EQ(full.size(), local.size());
+    for (std::size_t i = 0; i < full.size(); ++i)
+        EXPECT_NEAR(full[i], local[i], 1.0e-10);
+
+    // the spins must have moved
+
+    double rotmax = 0.0;
+    for (std::size_t i = 0; i < full.size(); i += 9) {
+        double sdots = 0.0;
+        for (int k = 6; k < 9; ++k) sdots += full[i + k] * init[i + k];
+        rotmax = std::max(rotmax, std::acos(std::min(sdots, 1.0)));
+    }
+    EXPECT_GT(rotmax, 1.0e-3);
+}
+
+TEST_F(NVESpinTest, force_full_cleared)
+{
+    if (!info->has_style("pair", "deepmd")) GTEST_SKIP();
+
+    // with force full, every spin advance evaluates the forces again, they
+    // must not pile up in the forces that fix nve uses next. with force
+    // local, fix nve uses those of the previous step, which only differ
+    // by the motion of the atoms and spins within the step
+
+    std::vector<double> full  = RunOtherVelocities("full");
+    std::vector<double> local = RunOtherVelocities("local");
+    ASSERT_EQ(full.size(), local.size());
+    for (std::size_t i = 0; i < full.size(); ++i)
+        EXPECT_NEAR(full[i], local[i], 1.0e-4);
+}
+
+TEST_F(NVESpinTest, force_local_small_box)
+{
+    if (!info->has_style("pair", "deepmd")) GTEST_SKIP();
+    if (!Info::has_exceptions()) GTEST_SKIP();
+
+    // the cluster of a single-spin evaluation holds one image of each atom,
+    // so the periodic box must not be shorter than twice the model cutoff
+
+    InitDeepSpin("deepmd_ref.FeCo", 10.0);
+    BEGIN_HIDE_OUTPUT();
+    command("fix spin all nve/spin lattice moving force local");
+    END_HIDE_OUTPUT();
+    TEST_FAILURE(".*ERROR.*Pair deepmd single-spin evaluation requires periodic box "
+                 "lengths of at least 2\\*rcut.*",
+                 command("run 1 post no"););
+}
+
+TEST_F(NVESpinTest, midpoint_keywords)
+{
+    // the keywords of the midpoint style may be mixed with those of
+    // fix nve/spin. a single iteration is the explicit step with the
+    // field at the start of each advance, one force evaluation per
+    // advance, and there are two advances per substep
+
+    InitSpin();
+    BEGIN_HIDE_OUTPUT();
+    command("fix spin all nve/spin/midpoint iterations 1 lattice frozen tolerance 1.0 substeps 3");
+    command("run 1 post no");
+    END_HIDE_OUTPUT();
+    EXPECT_DOUBLE_EQ(GetScalar("spin"), 6.0);
+
+    if (!Info::has_exceptions()) return;
+    BEGIN_HIDE_OUTPUT();
+    command("unfix spin");
+    END_HIDE_OUTPUT();
+    TEST_FAILURE(".*ERROR: Illegal fix/nve/spin/midpoint command.*",
+                 command("fix spin all nve/spin/midpoint lattice frozen iterations 0"););
+    TEST_FAILURE(".*ERROR: Illegal fix/nve/spin/midpoint command.*",
+                 command("fix spin all nve/spin/midpoint lattice frozen tolerance 0.0"););
+    TEST_FAILURE(".*ERROR: Illegal fix/nve/spin command.*",
+                 command("fix spin all nve/spin/midpoint lattice frozen iterations"););
+    TEST_FAILURE(".*ERROR: Fix nve/spin/midpoint does not support the update, sectors and "
+                 "refresh keywords.*",
+                 command("fix spin all nve/spin/midpoint update color"););
+    TEST_FAILURE(".*ERROR: Fix nve/spin/midpoint does not support the update, sectors and "
+                 "refresh keywords.*",
+                 command("fix spin all nve/spin/midpoint refresh 2"););
+}
+
+TEST_F(NVESpinTest, midpoint_convergence)
+{
+    // the fixed-point iterations converge to the midpoint spins: the
+    // trajectory does not change when the tolerance is tightened, and
+    // the iteration limit is not reached
+
+    InitSpin();
+    BEGIN_HIDE_OUTPUT();
+    command("fix spin all nve/spin/midpoint lattice moving iterations 50 tolerance 1.0e-12");
+    END_HIDE_OUTPUT();
+    ::testing::internal::CaptureStdout();
+    command("run 10 post no");
+    auto mesg = ::testing::internal::GetCapturedStdout();
+    if (verbose) std::cout << mesg;
+    EXPECT_THAT(mesg, Not(ContainsRegex(".*did not converge.*")));
+    const double nforce = GetScalar("spin");
+    EXPECT_GT(nforce, 4.0);
+    EXPECT_LT(nforce, 100.0);
+    std::vector<double> sp = GetSpins();
+
+    InitSpin();
+    BEGIN_HIDE_OUTPUT();
+    command("fix spin all nve/spin/midpoint lattice moving iterations 50 tolerance 1.0e-14");
+    command("run 10 post no");
+    END_HIDE_OUTPUT();
+    EXPECT_GE(GetScalar("spin"), nforce);
+    std::vector<double> ref = GetSpins();
+    for (std::size_t i = 0; i < ref.size(); ++i) EXPECT_NEAR(sp[i], ref[i], 1.0e-11);
+
+    // too few iterations are reported once, and the count is the limit
+
+    InitSpin();
+    BEGIN_HIDE_OUTPUT();
+    command("fix spin all nve/spin/midpoint lattice moving iterations 2 tolerance 1.0e-14");
+    END_HIDE_OUTPUT();
+    ::testing::internal::CaptureStdout();
+    command("run 10 post no");
+    mesg = ::testing::internal::GetCapturedStdout();
+    if (verbose) std::cout << mesg;
+    EXPECT_THAT(mesg, ContainsRegex(".*WARNING: Fix nve/spin/midpoint did not converge in 2 "
+                                    "iterations on step 1.*"));
+    EXPECT_THAT(mesg, Not(ContainsRegex(".*on step 2 .*")));
+    EXPECT_DOUBLE_EQ(GetScalar("spin"), 4.0);
+}
+
+TEST_F(NVESpinTest, midpoint_conservation)
+{
+    // the midpoint rule rotates each spin, so its norm is kept
+
+    InitSpin();
+    BEGIN_HIDE_OUTPUT();
+    command("fix spin all nve/spin/midpoint lattice moving");
+    command("run 100 post no");
+    END_HIDE_OUTPUT();
+    std::vector<double> sp = GetSpins();
+    for (std::size_t i = 0; i < sp.size(); i += 3)
+        EXPECT_NEAR(sp[i] * sp[i] + sp[i + 1] * sp[i + 1] + sp[i + 2] * sp[i + 2], 1.0,
+                    1.0e-12);
+
+    // exchange and Zeeman energies are quadratic and linear in the spins,
+    // which the midpoint rule conserves up to the tolerance, while the
+    // sequential update conserves the energy only on average
+
+    const double midpoint   = EnergyDrift("nve/spin/midpoint tolerance 1.0e-12", 0.001, 200);
+    const double sequential = EnergyDrift("nve/spin", 0.001, 200);
+    if (verbose)
+        std::cout << "energy drift: midpoint " << midpoint << " sequential " << sequential
+                  << std::endl;
+    EXPECT_GT(sequential, 0.0);
+    EXPECT_LT(midpoint, 0.1 * sequential);
+}
+
+TEST_F(NVESpinTest, substeps)
+{
+    // on a frozen lattice, N substeps of a timestep make the same sweeps
+    // as N timesteps of a single substep, with a N times shorter timestep
+
+    InitSpin();
+    BEGIN_HIDE_OUTPUT();
+    command("fix spin all nve/spin lattice frozen substeps 4");
+    command("run 5 post no");
+    END_HIDE_OUTPUT();
+    std::vector<double> sub = GetSpins();
+
+    InitSpin();
+    BEGIN_HIDE_OUTPUT();
+    command("fix spin all nve/spin lattice frozen");
+    command("timestep 0.000025");
+    command("run 20 post no");
+    END_HIDE_OUTPUT();
+    std::vector<double> ref = GetSpins();
+    for (std::size_t i = 0; i < ref.size(); ++i) EXPECT_NEAR(sub[i], ref[i], 1.0e-12);
+}
+
+TEST_F(NVESpinTest, refresh)
+{
+    // without a magnetic pair interaction the stored field is that of the
+    // pair style, zero, and the precession terms are recomputed for each
+    // spin, so skipping force evaluations does not change the trajectory
+
+    InitSpin(false);
+    BEGIN_HIDE_OUTPUT();
+    command("fix spin all nve/spin lattice moving substeps 3 refresh 3");
+    command("run 10 post no");
+    END_HIDE_OUTPUT();
+    std::vector<double> sp = GetSpins();
+
+    InitSpin(false);
+    BEGIN_HIDE_OUTPUT();
+    command("fix spin all nve/spin lattice moving substeps 3");
+    command("run 10 post no");
+    END_HIDE_OUTPUT();
+    std::vector<double> ref = GetSpins();
+    for (std::size_t i = 0; i < ref.size(); ++i) EXPECT_NEAR(sp[i], ref[i], 1.0e-14);
+
+    // the exchange field of the stored evaluation lags behind the spins
+    // advanced since then, the trajectory deviates slightly
+
+    InitSpin();
+    BEGIN_HIDE_OUTPUT();
+    command("fix spin all nve/spin lattice moving substeps 3 refresh 3");
+    command("run 10 post no");
+    END_HIDE_OUTPUT();
+    sp = GetSpins();
+
+    InitSpin();
+    BEGIN_HIDE_OUTPUT();
+    command("fix spin all nve/spin lattice moving substeps 3");
+    command("run 10 post no");
+    END_HIDE_OUTPUT();
+    ref = GetSpins();
+    double dmax = 0.0;
+    for (std::size_t i = 0; i < ref.size(); ++i) dmax = std::max(dmax, std::fabs(sp[i] - ref[i]));
+    if (verbose) std::cout << "refresh deviation " << dmax << std::endl;
+    EXPECT_GT(dmax, 1.0e-12);
+    EXPECT_LT(dmax, 1.0e-4);
+
+    // refresh skips full force evaluations
+
+    if (!Info::has_exceptions()) return;
+    TEST_FAILURE(".*ERROR: Fix nve/spin refresh requires force full.*",
+                 command("fix spin all nve/spin force local refresh 2"););
+}
+
+TEST_F(NVESpinTest, precession_steps)
+{
+    // fields and energies of the setup and of the thermo steps of two
+    // runs, with the pair style zero the magnetic forces are those of the
+    // precession only
+
+    InitSpin(false);
+    BEGIN_HIDE_OUTPUT();
+    command("fix spin all nve/spin lattice moving");
+    command("thermo 5");
+    command("run 0 post no");
+    END_HIDE_OUTPUT();
+    CheckPrecession(true);
+
+    BEGIN_HIDE_OUTPUT();
+    command("run 5 post no");
+    END_HIDE_OUTPUT();
+    CheckPrecession(true);
+
+    BEGIN_HIDE_OUTPUT();
+    command("run 5 post no");
+    END_HIDE_OUTPUT();
+    CheckPrecession(true);
+
+    // on other timesteps the fields follow the spins, but the energies
+    // are kept from the last timestep they were tallied on
+
+    auto atom = lmp->atom;
+    auto prec = dynamic_cast<FixPrecessionSpin *>(lmp->modify->get_fix_by_id("prec"));
+    std::vector<double> emag(prec->emag, prec->emag + atom->nlocal);
+    const double eprec = prec->compute_scalar();
+
+    BEGIN_HIDE_OUTPUT();
+    command("reset_timestep 11");
+    command("set group all spin/random 11 2.2");
+    END_HIDE_OUTPUT();
+    ASSERT_NE(lmp->output->next_thermo, 11);
+    ASSERT_NE(lmp->update->eflag_global, 11);
+    for (int i = 0; i < atom->nlocal; ++i)
+        for (int k = 0; k < 3; ++k) atom->fm[i][k] = 0.0;
+    prec->post_force(0);
+    CheckPrecession(false);
+    for (int i = 0; i < atom->nlocal; ++i) EXPECT_DOUBLE_EQ(prec->emag[i], emag[i]);
+    EXPECT_DOUBLE_EQ(prec->compute_scalar(), eprec);
+}
+} // namespace LAMMPS_NS
+
+int main(int argc, char **argv)
+{
+    MPI_Init(&argc, &argv);
+    ::testing::InitGoogleMock(&argc, argv);
+
+    // handle arguments passed via environment variable
+    if (const char *var = getenv("TEST_ARGS")) {
+        std::vector<std::string> env = split_words(var);
+        for (auto arg : env) {
+            if (arg == "-v") {
+                verbose = true;
+            }
+        }
+    }
+
+    if ((argc > 1) && (strcmp(argv[1], "-v") == 0)) verbose = true;
+
+    int rv = RUN_ALL_TESTS();
+    MPI_Finalize();
+    return rv;
+}
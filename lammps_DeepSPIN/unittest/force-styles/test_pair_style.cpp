@@ -204,7 +204,16 @@ void data_lammps(LAMMPS *lmp, const TestConfig &cfg)
         command(pre_command);
     }
 
-    command("variable pair_style index '" + cfg.pair_style + "'");
+    // variables are not expanded within the quoted pair style,
+    // so substitute the input folder of file arguments here
+
+    std::string pair_style = cfg.pair_style;
+    const std::string input_dir = "${input_dir}";
+    for (auto pos = pair_style.find(input_dir); pos != std::string::npos;
+         pos = pair_style.find(input_dir, pos + INPUT_FOLDER.size()))
+        pair_style.replace(pos, input_dir.size(), INPUT_FOLDER);
+
+    command("variable pair_style index '" + pair_style + "'");
     command("variable data_file index " + cfg.basename + ".data");
 
     std::string input_file = platform::path_join(INPUT_FOLDER, cfg.input_file);